@@ -927,6 +927,15 @@ sync_pipe_start(capture_options *capture_opts, GPtrArray *capture_comments,
             argv = sync_pipe_add_arg(argv, &argc, "--time-stamp-type");
             argv = sync_pipe_add_arg(argv, &argc, interface_opts->timestamp_type);
         }
+
+#ifdef CAN_USE_TPACKET_V3
+        if (interface_opts->tpacket_v3_threads > 0) {
+            char threads[ARGV_NUMBER_LEN];
+            argv = sync_pipe_add_arg(argv, &argc, "--tpacket-v3");
+            snprintf(threads, ARGV_NUMBER_LEN, "%d", interface_opts->tpacket_v3_threads);
+            argv = sync_pipe_add_arg(argv, &argc, threads);
+        }
+#endif
     }
 
 #ifndef DEBUG_CHILD
@@ -97,6 +97,9 @@ capture_opts_init(capture_options *capture_opts, GList *(*get_iface_list)(int *,
     capture_opts->default_options.sampling_param  = 0;
 #endif
     capture_opts->default_options.timestamp_type  = NULL;
+#ifdef CAN_USE_TPACKET_V3
+    capture_opts->default_options.tpacket_v3_threads = 0;
+#endif
     capture_opts->saving_to_file                  = false;
     capture_opts->save_file                       = NULL;
     capture_opts->group_read_access               = false;
@@ -234,6 +237,9 @@ capture_opts_log(const char *log_domain, enum ws_log_level log_level, capture_op
         ws_log(log_domain, log_level, "Sampling param.[%02d] : %d", i, interface_opts->sampling_param);
 #endif
         ws_log(log_domain, log_level, "Timestamp type [%02d] : %s", i, interface_opts->timestamp_type);
+#ifdef CAN_USE_TPACKET_V3
+        ws_log(log_domain, log_level, "TPACKET_V3 [%02d]     : %d thread(s)", i, interface_opts->tpacket_v3_threads);
+#endif
     }
     ws_log(log_domain, log_level, "Interface name[df]  : %s", capture_opts->default_options.name ? capture_opts->default_options.name : "(unspecified)");
     ws_log(log_domain, log_level, "Interface Descr[df] : %s", capture_opts->default_options.descr ? capture_opts->default_options.descr : "(unspecified)");
@@ -275,6 +281,9 @@ capture_opts_log(const char *log_domain, enum ws_log_level log_level, capture_op
     ws_log(log_domain, log_level, "Sampling param.[df] : %d", capture_opts->default_options.sampling_param);
 #endif
     ws_log(log_domain, log_level, "Timestamp type [df] : %s", capture_opts->default_options.timestamp_type ? capture_opts->default_options.timestamp_type : "(unspecified)");
+#ifdef CAN_USE_TPACKET_V3
+    ws_log(log_domain, log_level, "TPACKET_V3 [df]     : %d thread(s)", capture_opts->default_options.tpacket_v3_threads);
+#endif
     ws_log(log_domain, log_level, "SavingToFile        : %u", capture_opts->saving_to_file);
     ws_log(log_domain, log_level, "SaveFile            : %s", (capture_opts->save_file) ? capture_opts->save_file : "");
     ws_log(log_domain, log_level, "GroupReadAccess     : %u", capture_opts->group_read_access);
@@ -650,6 +659,9 @@ fill_in_interface_opts_defaults(interface_options *interface_opts, const capture
     interface_opts->sampling_param  = capture_opts->default_options.sampling_param;
 #endif
     interface_opts->timestamp_type  = capture_opts->default_options.timestamp_type;
+#ifdef CAN_USE_TPACKET_V3
+    interface_opts->tpacket_v3_threads = capture_opts->default_options.tpacket_v3_threads;
+#endif
 }
 
 static void
@@ -1195,6 +1207,18 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
     case LONGOPT_UPDATE_INTERVAL:  /* capture update interval */
         capture_opts->update_interval = get_natural_int(optarg_str_p, "update interval");
         break;
+#ifdef CAN_USE_TPACKET_V3
+    case LONGOPT_TPACKET_V3:  /* capture with a TPACKET_V3 ring */
+        if (capture_opts->ifaces->len > 0) {
+            interface_options *interface_opts;
+
+            interface_opts = &g_array_index(capture_opts->ifaces, interface_options, capture_opts->ifaces->len - 1);
+            interface_opts->tpacket_v3_threads = get_natural_int(optarg_str_p, "TPACKET_V3 thread count");
+        } else {
+            capture_opts->default_options.tpacket_v3_threads = get_natural_int(optarg_str_p, "TPACKET_V3 thread count");
+        }
+        break;
+#endif
     default:
         /* the caller is responsible to send us only the right opt's */
         ws_assert_not_reached();
@@ -1557,6 +1581,9 @@ collect_ifaces(capture_options *capture_opts)
 #ifdef HAVE_PCAP_SETSAMPLING
             interface_opts.sampling_method = device->remote_opts.sampling_method;
             interface_opts.sampling_param  = device->remote_opts.sampling_param;
+#endif
+#ifdef CAN_USE_TPACKET_V3
+            interface_opts.tpacket_v3_threads = capture_opts->default_options.tpacket_v3_threads;
 #endif
             g_array_append_val(capture_opts->ifaces, interface_opts);
         } else {
@@ -50,6 +50,7 @@ extern "C" {
 #define LONGOPT_COMPRESS_TYPE     LONGOPT_BASE_CAPTURE+3
 #define LONGOPT_CAPTURE_TMPDIR    LONGOPT_BASE_CAPTURE+4
 #define LONGOPT_UPDATE_INTERVAL   LONGOPT_BASE_CAPTURE+5
+#define LONGOPT_TPACKET_V3        LONGOPT_BASE_CAPTURE+6
 
 /*
  * Options for capturing common to all capturing programs.
@@ -77,6 +78,19 @@ extern "C" {
 #define OPTSTRING_I
 #endif
 
+/*
+ * On Linux, dumpcap can capture from its own AF_PACKET TPACKET_V3 ring,
+ * optionally spread over several sockets in a fanout group, rather than
+ * through libpcap.
+ */
+#ifdef __linux__
+#define CAN_USE_TPACKET_V3
+#define LONGOPT_TPACKET_V3_OPT \
+    {"tpacket-v3",            ws_required_argument, NULL, LONGOPT_TPACKET_V3},
+#else
+#define LONGOPT_TPACKET_V3_OPT
+#endif
+
 #define LONGOPT_CAPTURE_COMMON \
     {"autostop",              ws_required_argument, NULL, 'a'}, \
     {"ring-buffer",           ws_required_argument, NULL, 'b'}, \
@@ -92,7 +106,8 @@ extern "C" {
     {"time-stamp-type",       ws_required_argument, NULL, LONGOPT_SET_TSTAMP_TYPE}, \
     {"compress-type",         ws_required_argument, NULL, LONGOPT_COMPRESS_TYPE}, \
     {"temp-dir",              ws_required_argument, NULL, LONGOPT_CAPTURE_TMPDIR},\
-    {"update-interval",       ws_required_argument, NULL, LONGOPT_UPDATE_INTERVAL},
+    {"update-interval",       ws_required_argument, NULL, LONGOPT_UPDATE_INTERVAL}, \
+    LONGOPT_TPACKET_V3_OPT
 
 
 #define OPTSTRING_CAPTURE_COMMON \
@@ -242,6 +257,11 @@ typedef struct interface_options_tag {
     char             *timestamp_type;       /* requested timestamp as string */
     int               timestamp_type_id;    /* Timestamp type to pass to pcap_set_tstamp_type.
                                                only valid if timestamp_type != NULL */
+#ifdef CAN_USE_TPACKET_V3
+    int               tpacket_v3_threads;   /* if > 0, capture with a TPACKET_V3 ring
+                                               on this many fanout sockets, each read
+                                               by its own thread, instead of libpcap */
+#endif
 } interface_options;
 
 /** Capture options coming from user interface */
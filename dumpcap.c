@@ -72,6 +72,17 @@
 #include <capture/capture_session.h>
 #include <capture/capture_sync.h>
 
+#ifdef CAN_USE_TPACKET_V3
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+#endif
+
 #include "wsutil/tempfile.h"
 #include "wsutil/file_util.h"
 #include "wsutil/cpu_info.h"
@@ -121,11 +132,10 @@ FILE *debug_log;   /* for logging debug messages to  */
 #include <stdarg.h> /* va_copy */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static int64_t pcap_queue_bytes;
-static int64_t pcap_queue_packets;
 static int64_t pcap_queue_byte_limit;
 static int64_t pcap_queue_packet_limit;
+static GMutex pcap_queue_mtx;          /* for waiting on pcap_queue_cond */
+static GCond pcap_queue_cond;          /* signaled when a ring becomes non-empty */
 
 static bool capture_child; /* false: standalone call, true: this is an Wireshark capture child */
 static const char *report_capture_filename; /* capture child file name */
@@ -268,6 +278,34 @@ typedef struct _pcapng_pipe_info {
 
 struct _loop_data; /* forward declaration so we can use it in the cap_pipe_dispatch function pointer */
 
+/*
+ * Queue of packets between the capture threads and the writer when
+ * capturing with threads.
+ *
+ * Each source has a single-producer, single-consumer ring of
+ * variable-size entries, allocated when the capture starts. The
+ * capture thread copies a packet straight into its ring and the writer
+ * writes it from there, so there is no allocation per packet and the
+ * capture threads don't contend with each other. The writer takes
+ * entries from the rings in time stamp order.
+ *
+ * Each entry is a pcap_queue_element followed by the packet data,
+ * padded to a multiple of 8 bytes. An entry with a size of 0 means the
+ * next entry is at the start of the buffer; there is always room for
+ * one at the end. read_pos is only changed by the writer and write_pos
+ * only by the capture thread; the ring is empty when they are equal.
+ */
+typedef struct _pcap_queue_ring {
+    uint8_t                     *buf;
+    int                          size;
+    int                          read_pos;               /**< accessed atomically */
+    int                          write_pos;              /**< accessed atomically */
+    int                          byte_limit;             /**< This source's share of the queue byte limit, or 0 */
+    int                          packet_limit;           /**< This source's share of the queue packet limit, or 0 */
+    int                          bytes;                  /**< Bytes of packet data queued; accessed atomically */
+    int                          packets;                /**< Packets queued; accessed atomically */
+} pcap_queue_ring;
+
 /*
  * A source of packets from which we're capturing.
  */
@@ -283,6 +321,17 @@ typedef struct _capture_src {
     unsigned                     interface_id;
     unsigned                     idb_id;                 /**< If from_pcapng is false, the output IDB interface ID. Otherwise the mapping in src_iface_to_global is used. */
     GThread                     *tid;
+    pcap_queue_ring              queue;                  /**< Packets queued for the writer, if use_threads */
+#ifdef CAN_USE_TPACKET_V3
+    int                          tp_fd;                  /**< AF_PACKET socket if capturing from a TPACKET_V3 ring, -1 otherwise */
+    uint8_t                     *tp_ring;                /**< The mmap()ed TPACKET_V3 block ring */
+    unsigned                     tp_block_size;          /**< Size of a block in the ring */
+    unsigned                     tp_block_nr;            /**< Number of blocks in the ring */
+    unsigned                     tp_block_idx;           /**< Next block to read */
+    int                          tp_blocks_held;         /**< Blocks queued for the writer and not yet given back to the kernel; accessed atomically */
+    int                          tp_fanout_id;           /**< PACKET_FANOUT group ID, or -1 if none */
+    uint8_t                     *tp_vlan_buf;            /**< Buffer for putting a stripped VLAN tag back into a packet */
+#endif
     int                          snaplen;
     int                          linktype;
     bool                         ts_nsec;                /**< true if we're using nanosecond precision. */
@@ -359,14 +408,26 @@ typedef struct _loop_data {
 } loop_data;
 
 typedef struct _pcap_queue_element {
-    capture_src        *pcap_src;
     union {
         struct pcap_pkthdr  phdr;
         pcapng_block_header_t  bh;
     } u;
-    uint8_t             *pd;
+    int64_t             ts;     /* time stamp in nanoseconds, for ordering */
+    uint32_t            size;   /* size of the entry, including the data */
+    uint32_t            len;    /* length of the data */
 } pcap_queue_element;
 
+#define PCAP_QUEUE_ALIGN(n)         (((n) + 7U) & ~7U)
+#define PCAP_QUEUE_HDR_SIZE         PCAP_QUEUE_ALIGN((unsigned)sizeof(pcap_queue_element))
+#define PCAP_QUEUE_DATA(elem)       ((uint8_t *)(elem) + PCAP_QUEUE_HDR_SIZE)
+/* Size of all the rings together if only a packet limit was given */
+#define PCAP_QUEUE_RING_DEFAULT_SIZE (64 * 1024 * 1024)
+/*
+ * Room for the packet that may take the queue past the byte limit, and
+ * for the space left unused at the end of the buffer when wrapping around
+ */
+#define PCAP_QUEUE_RING_SLACK        (PCAP_QUEUE_HDR_SIZE + 2 * WTAP_MAX_PACKET_SIZE_STANDARD)
+
 /*
  * This needs to be static, so that the SIGINT handler can clear the "go"
  * flag and for saved_shb_idb_lock.
@@ -429,6 +490,10 @@ static void capture_loop_queue_packet_cb(uint8_t *pcap_src_p, const struct pcap_
                                          const uint8_t *pd);
 static void capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, uint8_t *pd);
 static void capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, uint8_t *pd);
+#ifdef CAN_USE_TPACKET_V3
+static pcap_queue_element *capture_loop_queue_reserve(capture_src *pcap_src, uint32_t len, int *pos);
+static void pcap_queue_ring_commit(pcap_queue_ring *ring, pcap_queue_element *queue_element, int pos);
+#endif
 static void capture_loop_get_errmsg(char *errmsg, size_t errmsglen,
                                     char *secondary_errmsg,
                                     size_t secondary_errmsglen,
@@ -484,6 +549,10 @@ print_usage(FILE *output)
     fprintf(output, "  -y <link type>, --linktype <link type>\n");
     fprintf(output, "                           link layer type (def: first appropriate)\n");
     fprintf(output, "  --time-stamp-type <type> timestamp method for interface\n");
+#ifdef CAN_USE_TPACKET_V3
+    fprintf(output, "  --tpacket-v3 <threads>   capture from a TPACKET_V3 ring read by <threads>\n");
+    fprintf(output, "                           fanout threads instead of libpcap (def: 0, off)\n");
+#endif
     fprintf(output, "  -D, --list-interfaces    print list of interfaces and exit\n");
     fprintf(output, "  -L, --list-data-link-types\n");
     fprintf(output, "                           print list of link-layer types of iface and exit\n");
@@ -3086,6 +3155,570 @@ pcapng_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t
     return -1;
 }
 
+#ifdef CAN_USE_TPACKET_V3
+/*
+ * Capturing from our own TPACKET_V3 ring.
+ *
+ * The kernel fills whole blocks of packets and hands each one to us once
+ * it's full or once CAP_READ_TIMEOUT has passed, so we get one wakeup
+ * per block rather than a libpcap callback per packet.  We write the
+ * packets straight out of the ring and then give the block back to the
+ * kernel; if we're using threads, the reader thread queues a pointer to
+ * the block, and the writer thread gives it back once it's written it.
+ *
+ * With more than one thread, the interface gets one socket per thread,
+ * all in the same PACKET_FANOUT group, so the kernel spreads the flows
+ * across the threads; the extra sockets are extra capture sources with
+ * the same interface ID and IDB.
+ */
+#define TPACKET_V3_BLOCK_SIZE   (1024 * 1024)
+#define TPACKET_V3_FRAME_SIZE   2048
+#define TPACKET_V3_MIN_BLOCKS   4
+#define TPACKET_V3_VLAN_TAG_LEN 4
+
+/*
+ * A socket filter that drops every packet.  Sockets get it before
+ * they're bound, and keep it until the capture filter replaces it, so
+ * no packet the capture filter would have dropped gets into the ring
+ * in between.
+ */
+static struct sock_filter tpacket_drop_all_insns[] = {
+    { BPF_RET | BPF_K, 0, 0, 0 }
+};
+static const struct sock_fprog tpacket_drop_all = {
+    G_N_ELEMENTS(tpacket_drop_all_insns), tpacket_drop_all_insns
+};
+
+/* Open a TPACKET_V3 socket on an interface and map its ring. */
+static bool
+capture_loop_open_tpacket(capture_src *pcap_src, interface_options *interface_opts,
+                          int *fanout_id, char *errmsg, size_t errmsg_len)
+{
+    struct tpacket_req3 req;
+    struct sockaddr_ll  sll;
+    socklen_t           sll_len;
+    int                 version = TPACKET_V3;
+    unsigned            ifindex;
+    int                 buffer_size;
+
+    ifindex = if_nametoindex(interface_opts->name);
+    if (ifindex == 0) {
+        snprintf(errmsg, errmsg_len,
+                 "The capture session could not be initiated on interface '%s' (%s).",
+                 interface_opts->name, g_strerror(errno));
+        return false;
+    }
+
+    pcap_src->tp_fd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (pcap_src->tp_fd == -1) {
+        snprintf(errmsg, errmsg_len,
+                 "Couldn't open an AF_PACKET socket for interface '%s': %s.",
+                 interface_opts->name, g_strerror(errno));
+        return false;
+    }
+    if (setsockopt(pcap_src->tp_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof version) == -1) {
+        snprintf(errmsg, errmsg_len,
+                 "This kernel doesn't support TPACKET_V3 capture: %s.",
+                 g_strerror(errno));
+        return false;
+    }
+
+    /* Give each socket a ring of the requested kernel buffer size. */
+#ifdef CAN_SET_CAPTURE_BUFFER_SIZE
+    buffer_size = interface_opts->buffer_size;
+#else
+    buffer_size = DEFAULT_CAPTURE_BUFFER_SIZE;
+#endif
+    memset(&req, 0, sizeof req);
+    req.tp_block_size = TPACKET_V3_BLOCK_SIZE;
+    req.tp_block_nr = MAX((unsigned)buffer_size * 1024 * 1024 / TPACKET_V3_BLOCK_SIZE, TPACKET_V3_MIN_BLOCKS);
+    req.tp_frame_size = TPACKET_V3_FRAME_SIZE;
+    req.tp_frame_nr = (TPACKET_V3_BLOCK_SIZE / TPACKET_V3_FRAME_SIZE) * req.tp_block_nr;
+    req.tp_retire_blk_tov = CAP_READ_TIMEOUT;
+    if (setsockopt(pcap_src->tp_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof req) == -1) {
+        snprintf(errmsg, errmsg_len,
+                 "Couldn't set up a %u MiB TPACKET_V3 ring for interface '%s': %s.",
+                 req.tp_block_nr * (TPACKET_V3_BLOCK_SIZE / (1024 * 1024)),
+                 interface_opts->name, g_strerror(errno));
+        return false;
+    }
+    pcap_src->tp_block_size = req.tp_block_size;
+    pcap_src->tp_block_nr = req.tp_block_nr;
+    pcap_src->tp_block_idx = 0;
+    pcap_src->tp_blocks_held = 0;
+    pcap_src->tp_ring = mmap(NULL, (size_t)req.tp_block_size * req.tp_block_nr,
+                             PROT_READ | PROT_WRITE, MAP_SHARED, pcap_src->tp_fd, 0);
+    if (pcap_src->tp_ring == MAP_FAILED) {
+        pcap_src->tp_ring = NULL;
+        snprintf(errmsg, errmsg_len,
+                 "Couldn't map the TPACKET_V3 ring for interface '%s': %s.",
+                 interface_opts->name, g_strerror(errno));
+        return false;
+    }
+
+    if (setsockopt(pcap_src->tp_fd, SOL_SOCKET, SO_ATTACH_FILTER,
+                   &tpacket_drop_all, sizeof tpacket_drop_all) == -1) {
+        snprintf(errmsg, errmsg_len,
+                 "Couldn't attach a filter to the socket for interface '%s': %s.",
+                 interface_opts->name, g_strerror(errno));
+        return false;
+    }
+
+    memset(&sll, 0, sizeof sll);
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex = (int)ifindex;
+    if (bind(pcap_src->tp_fd, (struct sockaddr *)&sll, sizeof sll) == -1) {
+        snprintf(errmsg, errmsg_len,
+                 "The capture session could not be initiated on interface '%s' (%s).",
+                 interface_opts->name, g_strerror(errno));
+        return false;
+    }
+    sll_len = sizeof sll;
+    if (getsockname(pcap_src->tp_fd, (struct sockaddr *)&sll, &sll_len) == -1) {
+        snprintf(errmsg, errmsg_len,
+                 "Couldn't get the link-layer type of interface '%s': %s.",
+                 interface_opts->name, g_strerror(errno));
+        return false;
+    }
+    if (sll.sll_hatype != ARPHRD_ETHER && sll.sll_hatype != ARPHRD_LOOPBACK) {
+        snprintf(errmsg, errmsg_len,
+                 "TPACKET_V3 capture is only supported on Ethernet and loopback interfaces; "
+                 "'%s' is neither.", interface_opts->name);
+        return false;
+    }
+
+    if (interface_opts->promisc_mode) {
+        struct packet_mreq mreq;
+
+        memset(&mreq, 0, sizeof mreq);
+        mreq.mr_ifindex = (int)ifindex;
+        mreq.mr_type = PACKET_MR_PROMISC;
+        if (setsockopt(pcap_src->tp_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof mreq) == -1) {
+            snprintf(errmsg, errmsg_len,
+                     "Couldn't put interface '%s' into promiscuous mode: %s.",
+                     interface_opts->name, g_strerror(errno));
+            return false;
+        }
+    }
+
+    if (interface_opts->tpacket_v3_threads > 1) {
+        /*
+         * Spread packets across the group by flow, reassembling IP
+         * fragments first so they all go to the same socket.  The
+         * first socket asks the kernel for an unused group ID if it
+         * can; the rest join that group.
+         */
+        int       fanout_arg;
+        socklen_t fanout_len = sizeof fanout_arg;
+
+        fanout_arg = (PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16;
+        if (*fanout_id >= 0) {
+            fanout_arg |= *fanout_id;
+        } else {
+#ifdef PACKET_FANOUT_FLAG_UNIQUEID
+            fanout_arg |= PACKET_FANOUT_FLAG_UNIQUEID << 16;
+#else
+            fanout_arg |= (getpid() ^ (int)ifindex) & 0xffff;
+#endif
+        }
+        if (setsockopt(pcap_src->tp_fd, SOL_PACKET, PACKET_FANOUT, &fanout_arg, sizeof fanout_arg) == -1) {
+            snprintf(errmsg, errmsg_len,
+                     "Couldn't add a socket for interface '%s' to a fanout group: %s.",
+                     interface_opts->name, g_strerror(errno));
+            return false;
+        }
+        if (*fanout_id < 0) {
+            if (getsockopt(pcap_src->tp_fd, SOL_PACKET, PACKET_FANOUT, &fanout_arg, &fanout_len) == -1) {
+                snprintf(errmsg, errmsg_len,
+                         "Couldn't get the fanout group of interface '%s': %s.",
+                         interface_opts->name, g_strerror(errno));
+                return false;
+            }
+            *fanout_id = fanout_arg & 0xffff;
+        }
+    }
+
+    pcap_src->linktype = dlt_to_linktype(DLT_EN10MB);
+    pcap_src->snaplen = interface_opts->snaplen;
+    pcap_src->ts_nsec = true;
+    pcap_src->tp_vlan_buf = g_malloc(pcap_src->snaplen + TPACKET_V3_VLAN_TAG_LEN);
+    return true;
+}
+
+/* Open an interface as a TPACKET_V3 capture source. */
+static bool
+capture_loop_open_tpacket_input(capture_src *pcap_src, interface_options *interface_opts,
+                                char *errmsg, size_t errmsg_len)
+{
+    if (interface_opts->tpacket_v3_threads > 1 && !use_threads) {
+        snprintf(errmsg, errmsg_len,
+                   "Using threads is required for capturing with more than one TPACKET_V3 thread.");
+        return false;
+    }
+
+    pcap_src->tp_fanout_id = -1;
+    if (!capture_loop_open_tpacket(pcap_src, interface_opts, &pcap_src->tp_fanout_id,
+                                   errmsg, errmsg_len)) {
+        return false;
+    }
+    /* We get the snapshot length and error messages with this. */
+    pcap_src->pcap_h = pcap_open_dead(DLT_EN10MB, pcap_src->snaplen);
+    if (pcap_src->pcap_h == NULL) {
+        snprintf(errmsg, errmsg_len,
+                   "Could not allocate memory.");
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Add a capture source for each extra fanout thread of each TPACKET_V3
+ * interface.  They go after all the interfaces' own capture sources,
+ * as those are indexed by interface ID.
+ */
+static bool
+capture_loop_open_tpacket_fanout(capture_options *capture_opts, loop_data *ld,
+                                 char *errmsg, size_t errmsg_len)
+{
+    interface_options *interface_opts;
+    capture_src       *pcap_src, *fanout_src;
+    unsigned           i;
+
+    for (i = 0; i < capture_opts->ifaces->len; i++) {
+        interface_opts = &g_array_index(capture_opts->ifaces, interface_options, i);
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (pcap_src->tp_fd == -1) {
+            continue;
+        }
+        for (int t = 1; t < interface_opts->tpacket_v3_threads; t++) {
+            fanout_src = g_new0(capture_src, 1);
+#ifdef MUST_DO_SELECT
+            fanout_src->pcap_fd = -1;
+#endif
+            fanout_src->interface_id = i;
+            fanout_src->idb_id = pcap_src->idb_id;
+#ifdef _WIN32
+            fanout_src->cap_pipe_h = INVALID_HANDLE_VALUE;
+#endif
+            fanout_src->cap_pipe_fd = -1;
+            fanout_src->cap_pipe_err = PIPOK;
+            fanout_src->tp_fd = -1;
+            fanout_src->tp_fanout_id = -1;
+            g_array_append_val(ld->pcaps, fanout_src);
+            ws_debug("capture_loop_open_tpacket_fanout : %s thread %d", interface_opts->name, t);
+            if (!capture_loop_open_tpacket(fanout_src, interface_opts, &pcap_src->tp_fanout_id,
+                                           errmsg, errmsg_len)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Install a capture filter on all the sockets of a TPACKET_V3 capture
+ * source, replacing the filter that drops everything.
+ */
+static initfilter_status_t
+capture_loop_init_tpacket_filter(loop_data *ld, capture_src *pcap_src,
+                                 const char *name, const char *cfilter)
+{
+    struct bpf_program fcode;
+    struct sock_fprog  fprog;
+    pcap_t            *live_h;
+    char               open_err_str[PCAP_ERRBUF_SIZE];
+    capture_src       *fanout_src;
+    unsigned           i;
+    int                dummy = 0;
+    bool               have_fcode = false;
+    initfilter_status_t status = INITFILTER_NO_ERROR;
+
+    ws_debug("capture_loop_init_tpacket_filter: %s", cfilter);
+
+    if (cfilter != NULL && *cfilter != '\0') {
+        /*
+         * The kernel takes VLAN tags out of packets before the filter
+         * sees them.  A live libpcap handle knows that, and compiles
+         * "vlan" tests into loads of the tag the kernel kept aside;
+         * the handle we made with pcap_open_dead() doesn't.
+         */
+        live_h = pcap_open_live(name, pcap_src->snaplen, 0, CAP_READ_TIMEOUT, open_err_str);
+        if (live_h == NULL) {
+            ws_warning("Couldn't open %s to compile the capture filter: %s", name, open_err_str);
+            return INITFILTER_OTHER_ERROR;
+        }
+        if (!compile_capture_filter(name, live_h, &fcode, cfilter)) {
+            /* Keep it, so the caller can get the error message. */
+            pcap_close(pcap_src->pcap_h);
+            pcap_src->pcap_h = live_h;
+            return INITFILTER_BAD_FILTER;
+        }
+        pcap_close(live_h);
+        have_fcode = true;
+        /* libpcap's struct bpf_insn has the same layout as the kernel's struct sock_filter. */
+        fprog.len = (unsigned short)fcode.bf_len;
+        fprog.filter = (struct sock_filter *)fcode.bf_insns;
+    }
+    for (i = 0; i < ld->pcaps->len; i++) {
+        fanout_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (fanout_src->interface_id != pcap_src->interface_id) {
+            continue;
+        }
+        if (have_fcode) {
+            if (setsockopt(fanout_src->tp_fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof fprog) == -1) {
+                ws_warning("Couldn't attach the capture filter to %s: %s", name, g_strerror(errno));
+                status = INITFILTER_OTHER_ERROR;
+                break;
+            }
+        } else {
+            if (setsockopt(fanout_src->tp_fd, SOL_SOCKET, SO_DETACH_FILTER, &dummy, sizeof dummy) == -1) {
+                ws_warning("Couldn't remove the filter from %s: %s", name, g_strerror(errno));
+                status = INITFILTER_OTHER_ERROR;
+                break;
+            }
+        }
+    }
+#ifdef HAVE_PCAP_FREECODE
+    if (have_fcode) {
+        pcap_freecode(&fcode);
+    }
+#endif
+    return status;
+}
+
+/* Is the next block in the ring ours to read? */
+static bool
+capture_loop_tpacket_block_ready(capture_src *pcap_src, struct tpacket_block_desc *pbd)
+{
+    /*
+     * Blocks we've queued for the writer stay ours until it's written
+     * them, so if all of them are queued, the next one is one of those
+     * rather than a new one.
+     */
+    if (g_atomic_int_get(&pcap_src->tp_blocks_held) == (int)pcap_src->tp_block_nr) {
+        return false;
+    }
+    return (g_atomic_int_get((int *)&pbd->hdr.bh1.block_status) & TP_STATUS_USER) != 0;
+}
+
+/* Write the packets in a block, and give the block back to the kernel. */
+static void
+capture_loop_write_tpacket_block(capture_src *pcap_src, struct tpacket_block_desc *pbd)
+{
+    struct tpacket3_hdr *ppd;
+    struct pcap_pkthdr   phdr;
+    const uint8_t       *pd;
+    uint32_t             num_pkts = pbd->hdr.bh1.num_pkts;
+    uint32_t             i;
+
+    ppd = (struct tpacket3_hdr *)((uint8_t *)pbd + pbd->hdr.bh1.offset_to_first_pkt);
+    for (i = 0; i < num_pkts; i++) {
+        /* ts_nsec is set, so this is in nanoseconds. */
+        phdr.ts.tv_sec = ppd->tp_sec;
+        phdr.ts.tv_usec = ppd->tp_nsec;
+        phdr.caplen = MIN(ppd->tp_snaplen, (uint32_t)pcap_src->snaplen);
+        phdr.len = ppd->tp_len;
+        pd = (const uint8_t *)ppd + ppd->tp_mac;
+        if ((ppd->tp_status & TP_STATUS_VLAN_VALID) && phdr.caplen >= 2 * ETH_ALEN) {
+            /* The kernel took the VLAN tag out of the packet; put it back. */
+            uint16_t tpid = ETH_P_8021Q;
+
+#ifdef TP_STATUS_VLAN_TPID_VALID
+            if (ppd->tp_status & TP_STATUS_VLAN_TPID_VALID) {
+                tpid = ppd->hv1.tp_vlan_tpid;
+            }
+#endif
+            memcpy(pcap_src->tp_vlan_buf, pd, 2 * ETH_ALEN);
+            pcap_src->tp_vlan_buf[2 * ETH_ALEN] = tpid >> 8;
+            pcap_src->tp_vlan_buf[2 * ETH_ALEN + 1] = tpid & 0xff;
+            pcap_src->tp_vlan_buf[2 * ETH_ALEN + 2] = ppd->hv1.tp_vlan_tci >> 8;
+            pcap_src->tp_vlan_buf[2 * ETH_ALEN + 3] = ppd->hv1.tp_vlan_tci & 0xff;
+            memcpy(pcap_src->tp_vlan_buf + 2 * ETH_ALEN + TPACKET_V3_VLAN_TAG_LEN,
+                   pd + 2 * ETH_ALEN, phdr.caplen - 2 * ETH_ALEN);
+            phdr.caplen += TPACKET_V3_VLAN_TAG_LEN;
+            phdr.len += TPACKET_V3_VLAN_TAG_LEN;
+            pd = pcap_src->tp_vlan_buf;
+        }
+        capture_loop_write_packet_cb((uint8_t *)pcap_src, &phdr, pd);
+        ppd = (struct tpacket3_hdr *)((uint8_t *)ppd + ppd->tp_next_offset);
+    }
+
+    g_atomic_int_set((int *)&pbd->hdr.bh1.block_status, TP_STATUS_KERNEL);
+    if (use_threads) {
+        g_atomic_int_add(&pcap_src->tp_blocks_held, -1);
+    }
+}
+
+/*
+ * Queue a block for the writer thread.
+ * Returns false if the queue is full; the block stays in the ring.
+ */
+static bool
+capture_loop_queue_tpacket_block(capture_src *pcap_src, struct tpacket_block_desc *pbd)
+{
+    pcap_queue_element *queue_element;
+    uint32_t            num_pkts = pbd->hdr.bh1.num_pkts;
+    int                 pos;
+
+    queue_element = capture_loop_queue_reserve(pcap_src, (uint32_t)sizeof pbd, &pos);
+    if (queue_element == NULL) {
+        return false;
+    }
+    memset(&queue_element->u, 0, sizeof queue_element->u);
+    queue_element->ts = (int64_t)pbd->hdr.bh1.ts_first_pkt.ts_sec * 1000000000 +
+                        pbd->hdr.bh1.ts_first_pkt.ts_nsec;
+    memcpy(PCAP_QUEUE_DATA(queue_element), &pbd, sizeof pbd);
+    g_atomic_int_inc(&pcap_src->tp_blocks_held);
+    pcap_queue_ring_commit(&pcap_src->queue, queue_element, pos);
+    pcap_src->received += num_pkts;
+    ws_info("Queued a block of %u packets captured on interface %u.",
+          num_pkts, pcap_src->interface_id);
+    return true;
+}
+
+/*
+ * Wait for blocks in a TPACKET_V3 ring, and write or queue them.
+ * Returns the number of packets in them.
+ */
+static int
+capture_loop_dispatch_tpacket(loop_data *ld, capture_src *pcap_src,
+                              char *errmsg, int errmsg_len)
+{
+    struct tpacket_block_desc *pbd;
+    struct pollfd              pfd;
+    int                        inpkts = 0;
+    int                        ret;
+
+    pbd = (struct tpacket_block_desc *)(pcap_src->tp_ring +
+                                        (size_t)pcap_src->tp_block_idx * pcap_src->tp_block_size);
+    if (!capture_loop_tpacket_block_ready(pcap_src, pbd)) {
+        if (g_atomic_int_get(&pcap_src->tp_blocks_held) == (int)pcap_src->tp_block_nr) {
+            /* Wait for the writer to give some blocks back. */
+            g_usleep(1000);
+            return 0;
+        }
+        pfd.fd = pcap_src->tp_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        ret = poll(&pfd, 1, CAP_READ_TIMEOUT);
+        if (ret < 0) {
+            if (errno != EINTR) {
+                snprintf(errmsg, errmsg_len,
+                        "Unexpected error from poll: %s", g_strerror(errno));
+                report_capture_error(errmsg, please_report_bug());
+                ld->go = false;
+            }
+            return 0;
+        }
+        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            int       sock_err = 0;
+            socklen_t sock_err_len = sizeof sock_err;
+
+            getsockopt(pcap_src->tp_fd, SOL_SOCKET, SO_ERROR, &sock_err, &sock_err_len);
+            if (sock_err == ENETDOWN) {
+                snprintf(errmsg, errmsg_len,
+                        "The network adapter on which the capture was being done "
+                        "is no longer running; the capture has stopped.");
+                report_capture_error(errmsg, "");
+            } else {
+                snprintf(errmsg, errmsg_len,
+                        "Error while capturing packets: %s",
+                        g_strerror(sock_err ? sock_err : EIO));
+                report_capture_error(errmsg, please_report_bug());
+            }
+            ld->go = false;
+            return 0;
+        }
+    }
+
+    while (ld->go && capture_loop_tpacket_block_ready(pcap_src, pbd)) {
+        int num_pkts = (int)pbd->hdr.bh1.num_pkts;
+
+        if (use_threads) {
+            if (!capture_loop_queue_tpacket_block(pcap_src, pbd)) {
+                /* The queue is full; leave the block until there's room. */
+                g_usleep(1000);
+                break;
+            }
+        } else {
+            capture_loop_write_tpacket_block(pcap_src, pbd);
+        }
+        inpkts += num_pkts;
+        pcap_src->tp_block_idx = (pcap_src->tp_block_idx + 1) % pcap_src->tp_block_nr;
+        pbd = (struct tpacket_block_desc *)(pcap_src->tp_ring +
+                                            (size_t)pcap_src->tp_block_idx * pcap_src->tp_block_size);
+    }
+    return inpkts;
+}
+
+/*
+ * Get the packet counts for all the sockets of a TPACKET_V3 capture
+ * source, and the number of packets the kernel dropped for them.
+ */
+static void
+capture_loop_tpacket_stats(loop_data *ld, capture_src *pcap_src, uint32_t *received,
+                           uint32_t *dropped, uint32_t *flushed, struct pcap_stat *stats)
+{
+    struct tpacket_stats_v3 tp_stats;
+    socklen_t               tp_stats_len;
+    capture_src            *fanout_src;
+    unsigned                i;
+
+    *received = 0;
+    *dropped = 0;
+    *flushed = 0;
+    stats->ps_recv = 0;
+    stats->ps_drop = 0;
+    stats->ps_ifdrop = 0;
+    for (i = 0; i < ld->pcaps->len; i++) {
+        fanout_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (fanout_src->interface_id != pcap_src->interface_id) {
+            continue;
+        }
+        *received += fanout_src->received;
+        *dropped += fanout_src->dropped;
+        *flushed += fanout_src->flushed;
+        tp_stats_len = sizeof tp_stats;
+        if (fanout_src->tp_fd != -1 &&
+            getsockopt(fanout_src->tp_fd, SOL_PACKET, PACKET_STATISTICS, &tp_stats, &tp_stats_len) == 0) {
+            stats->ps_recv += tp_stats.tp_packets;
+            stats->ps_drop += tp_stats.tp_drops;
+        }
+    }
+}
+
+/* Unmap a TPACKET_V3 ring and close its socket. */
+static void
+capture_loop_close_tpacket(capture_src *pcap_src)
+{
+    if (pcap_src->tp_ring != NULL) {
+        munmap(pcap_src->tp_ring, (size_t)pcap_src->tp_block_size * pcap_src->tp_block_nr);
+        pcap_src->tp_ring = NULL;
+    }
+    if (pcap_src->tp_fd != -1) {
+        ws_close(pcap_src->tp_fd);
+        pcap_src->tp_fd = -1;
+    }
+    g_free(pcap_src->tp_vlan_buf);
+    pcap_src->tp_vlan_buf = NULL;
+}
+#endif /* CAN_USE_TPACKET_V3 */
+
+/* Add our pcapng interface entry for a capture source. */
+static void
+capture_loop_add_idb(loop_data *ld, capture_src *pcap_src, unsigned interface_id)
+{
+    saved_idb_t idb_source = { 0 };
+    idb_source.interface_id = interface_id;
+    g_rw_lock_writer_lock (&ld->saved_shb_idb_lock);
+    pcap_src->idb_id = global_ld.saved_idbs->len;
+    g_array_append_val(global_ld.saved_idbs, idb_source);
+    g_rw_lock_writer_unlock (&ld->saved_shb_idb_lock);
+    ws_debug("%s: saved capture_opts %u to IDB %u",
+          G_STRFUNC, interface_id, pcap_src->idb_id);
+}
+
 /** Open the capture input sources; each one is either a pcap device,
  *  a capture pipe, or a capture socket.
  *  Returns true if it succeeds, false otherwise. */
@@ -3130,6 +3763,9 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
         pcap_src->cap_pipe_dispatch = pcap_pipe_dispatch;
         pcap_src->cap_pipe_state = STATE_EXPECT_REC_HDR;
         pcap_src->cap_pipe_err = PIPOK;
+#ifdef CAN_USE_TPACKET_V3
+        pcap_src->tp_fd = -1;
+#endif
 #ifdef _WIN32
         pcap_src->cap_pipe_read_mtx = g_new(GMutex, 1);
         g_mutex_init(pcap_src->cap_pipe_read_mtx);
@@ -3139,6 +3775,15 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
         g_array_append_val(ld->pcaps, pcap_src);
 
         ws_debug("capture_loop_open_input : %s", interface_opts->name);
+#ifdef CAN_USE_TPACKET_V3
+        if (interface_opts->tpacket_v3_threads > 0) {
+            if (!capture_loop_open_tpacket_input(pcap_src, interface_opts, errmsg, errmsg_len)) {
+                return false;
+            }
+            capture_loop_add_idb(ld, pcap_src, i);
+            continue;
+        }
+#endif
         pcap_src->pcap_h = open_capture_device(capture_opts, interface_opts,
             CAP_READ_TIMEOUT, &open_status, &open_status_str);
 
@@ -3264,20 +3909,16 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
              */
             pcapng_src_count++;
         } else {
-            /*
-             * Add our pcapng interface entry.
-             */
-            saved_idb_t idb_source = { 0 };
-            idb_source.interface_id = i;
-            g_rw_lock_writer_lock (&ld->saved_shb_idb_lock);
-            pcap_src->idb_id = global_ld.saved_idbs->len;
-            g_array_append_val(global_ld.saved_idbs, idb_source);
-            g_rw_lock_writer_unlock (&ld->saved_shb_idb_lock);
-            ws_debug("%s: saved capture_opts %u to IDB %u",
-                  G_STRFUNC, i, pcap_src->idb_id);
+            capture_loop_add_idb(ld, pcap_src, i);
         }
     }
 
+#ifdef CAN_USE_TPACKET_V3
+    if (!capture_loop_open_tpacket_fanout(capture_opts, ld, errmsg, errmsg_len)) {
+        return false;
+    }
+#endif
+
     /*
      * Are we capturing from one source that is providing pcapng
      * information?
@@ -3340,6 +3981,9 @@ static void capture_loop_close_input(loop_data *ld)
                 pcap_src->cap_pipe_info.pcapng.src_iface_to_global = NULL;
             }
         } else {
+#ifdef CAN_USE_TPACKET_V3
+            capture_loop_close_tpacket(pcap_src);
+#endif
             /* Capture device.  If open, close the pcap_t. */
             if (pcap_src->pcap_h != NULL) {
                 ws_debug("capture_loop_close_input: closing %p", (void *)pcap_src->pcap_h);
@@ -3693,6 +4337,13 @@ capture_loop_dispatch(loop_data *ld,
             }
         }
     }
+#ifdef CAN_USE_TPACKET_V3
+    else if (pcap_src->tp_fd != -1)
+    {
+        /* dispatch from our TPACKET_V3 ring */
+        inpkts = capture_loop_dispatch_tpacket(ld, pcap_src, errmsg, errmsg_len);
+    }
+#endif
     else
     {
         /* dispatch from pcap */
@@ -4131,44 +4782,219 @@ pcap_read_handler(void* arg)
     return (NULL);
 }
 
-/* Try to pop an item off the packet queue and if it exists, write it */
+/*
+ * Set up a source's ring, giving it an equal share of the queue limits,
+ * so that the capture threads needn't share any counts.
+ * Returns false if we couldn't allocate it.
+ */
 static bool
-capture_loop_dequeue_packet(void) {
-    pcap_queue_element *queue_element;
+pcap_queue_ring_init(pcap_queue_ring *ring, unsigned num_sources)
+{
+    int64_t byte_limit = (pcap_queue_byte_limit + num_sources - 1) / num_sources;
+    int64_t packet_limit = (pcap_queue_packet_limit + num_sources - 1) / num_sources;
+    int64_t size;
+
+    /* Leave room for the packet that takes the count past the limit. */
+    ring->byte_limit = (int)MIN(byte_limit, INT_MAX / 2);
+    ring->packet_limit = (int)MIN(packet_limit, INT_MAX);
+    if (ring->byte_limit > 0) {
+        size = ring->byte_limit + PCAP_QUEUE_RING_SLACK;
+        if (ring->packet_limit > 0)
+            size += (int64_t)ring->packet_limit * PCAP_QUEUE_HDR_SIZE;
+    } else {
+        size = MAX(PCAP_QUEUE_RING_DEFAULT_SIZE / num_sources, 2 * PCAP_QUEUE_RING_SLACK);
+    }
+    size = MIN((size + 7) & ~INT64_C(7), INT_MAX & ~7);
+    ring->size = (int)size;
+    ring->buf = (uint8_t *)g_try_malloc(size);
+    if (ring->buf == NULL)
+        return false;
+    ring->read_pos = 0;
+    ring->write_pos = 0;
+    ring->bytes = 0;
+    ring->packets = 0;
+    return true;
+}
 
-    g_async_queue_lock(pcap_queue);
-    queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-        } else {
-            pcap_queue_bytes -= queue_element->u.phdr.caplen;
+static void
+pcap_queue_ring_free(pcap_queue_ring *ring)
+{
+    g_free(ring->buf);
+    ring->buf = NULL;
+}
+
+/*
+ * Get space for an entry of the given size at the write position.
+ * Returns NULL if the ring is full; otherwise the entry is queued by
+ * pcap_queue_ring_commit().
+ */
+static pcap_queue_element *
+pcap_queue_ring_reserve(pcap_queue_ring *ring, uint32_t size, int *pos)
+{
+    int w = ring->write_pos;
+    int r = g_atomic_int_get(&ring->read_pos);
+
+    if (w >= r) {
+        if (size + PCAP_QUEUE_HDR_SIZE <= (unsigned)(ring->size - w)) {
+            *pos = w;
+            return (pcap_queue_element *)(ring->buf + w);
         }
-        pcap_queue_packets -= 1;
+        /* No room at the end; wrap around if there's room at the start. */
+        if (size < (unsigned)r) {
+            ((pcap_queue_element *)(ring->buf + w))->size = 0;
+            *pos = 0;
+            return (pcap_queue_element *)ring->buf;
+        }
+        return NULL;
+    }
+    if (size < (unsigned)(r - w)) {
+        *pos = w;
+        return (pcap_queue_element *)(ring->buf + w);
     }
-    g_async_queue_unlock(pcap_queue);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            ws_info("Dequeued a block of type 0x%08x of length %d captured on interface %d.",
-                  queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
-                  queue_element->pcap_src->interface_id);
+    return NULL;
+}
 
-            capture_loop_write_pcapng_cb(queue_element->pcap_src,
-                                        &queue_element->u.bh,
-                                        queue_element->pd);
-        } else {
-            ws_info("Dequeued a packet of length %d captured on interface %d.",
-                queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
+static void
+pcap_queue_ring_commit(pcap_queue_ring *ring, pcap_queue_element *queue_element, int pos)
+{
+    int old_w = ring->write_pos;
+
+    g_atomic_int_set(&ring->write_pos, pos + (int)queue_element->size);
+
+    /*
+     * If the writer had caught up with us, it might be waiting
+     * for a packet. (It checks for packets with pcap_queue_mtx held,
+     * so it can't miss this.)
+     */
+    if (g_atomic_int_get(&ring->read_pos) == old_w) {
+        g_mutex_lock(&pcap_queue_mtx);
+        g_cond_signal(&pcap_queue_cond);
+        g_mutex_unlock(&pcap_queue_mtx);
+    }
+}
+
+/* Return the oldest entry in a ring, or NULL if it's empty. */
+static pcap_queue_element *
+pcap_queue_ring_peek(pcap_queue_ring *ring)
+{
+    int r = ring->read_pos;
+    pcap_queue_element *queue_element;
+
+    if (r == g_atomic_int_get(&ring->write_pos))
+        return NULL;
+    queue_element = (pcap_queue_element *)(ring->buf + r);
+    if (queue_element->size == 0) {
+        /* Wrapped around. */
+        g_atomic_int_set(&ring->read_pos, 0);
+        if (g_atomic_int_get(&ring->write_pos) == 0)
+            return NULL;
+        queue_element = (pcap_queue_element *)ring->buf;
+    }
+    return queue_element;
+}
+
+static void
+pcap_queue_ring_pop(pcap_queue_ring *ring, pcap_queue_element *queue_element)
+{
+    g_atomic_int_set(&ring->read_pos, (int)((uint8_t *)queue_element - ring->buf) + (int)queue_element->size);
+}
+
+/* Stop counting a packet of the given length against its source's queue limits. */
+static void
+capture_loop_queue_limits_release(pcap_queue_ring *ring, uint32_t len)
+{
+    g_atomic_int_add(&ring->bytes, -(int)len);
+    g_atomic_int_add(&ring->packets, -1);
+}
+
+static void
+capture_loop_queue_log_size(void)
+{
+    int64_t bytes = 0, packets = 0;
+    capture_src *pcap_src;
 
-            capture_loop_write_packet_cb((uint8_t *) queue_element->pcap_src,
-                                        &queue_element->u.phdr,
-                                        queue_element->pd);
+    if (!ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_INFO))
+        return;
+    for (unsigned i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        bytes += g_atomic_int_get(&pcap_src->queue.bytes);
+        packets += g_atomic_int_get(&pcap_src->queue.packets);
+    }
+    /* The queue size may have changed by the time it's logged. */
+    ws_info("Queue size is now %" PRId64 " bytes (%" PRId64 " packets)",
+          bytes, packets);
+}
+
+/* Find the source whose oldest queued packet has the earliest time stamp. */
+static capture_src *
+capture_loop_queue_earliest(pcap_queue_element **queue_elementp)
+{
+    capture_src        *pcap_src, *earliest_src = NULL;
+    pcap_queue_element *queue_element, *earliest = NULL;
+    unsigned            i;
+
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        queue_element = pcap_queue_ring_peek(&pcap_src->queue);
+        if (queue_element && (!earliest || queue_element->ts < earliest->ts)) {
+            earliest = queue_element;
+            earliest_src = pcap_src;
         }
-        g_free(queue_element->pd);
-        g_free(queue_element);
-        return true;
     }
-    return false;
+    *queue_elementp = earliest;
+    return earliest_src;
+}
+
+/* Try to take a packet off the packet queues and if there is one, write it */
+static bool
+capture_loop_dequeue_packet(void) {
+    capture_src        *pcap_src;
+    pcap_queue_element *queue_element;
+
+    pcap_src = capture_loop_queue_earliest(&queue_element);
+    if (!pcap_src) {
+        g_mutex_lock(&pcap_queue_mtx);
+        pcap_src = capture_loop_queue_earliest(&queue_element);
+        if (!pcap_src) {
+            g_cond_wait_until(&pcap_queue_cond, &pcap_queue_mtx,
+                              g_get_monotonic_time() + WRITER_THREAD_TIMEOUT);
+        }
+        g_mutex_unlock(&pcap_queue_mtx);
+        if (!pcap_src)
+            pcap_src = capture_loop_queue_earliest(&queue_element);
+        if (!pcap_src)
+            return false;
+    }
+
+    if (pcap_src->from_pcapng) {
+        ws_info("Dequeued a block of type 0x%08x of length %d captured on interface %d.",
+              queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
+              pcap_src->interface_id);
+
+        capture_loop_write_pcapng_cb(pcap_src,
+                                    &queue_element->u.bh,
+                                    PCAP_QUEUE_DATA(queue_element));
+#ifdef CAN_USE_TPACKET_V3
+    } else if (pcap_src->tp_fd != -1) {
+        struct tpacket_block_desc *pbd;
+
+        memcpy(&pbd, PCAP_QUEUE_DATA(queue_element), sizeof pbd);
+        ws_info("Dequeued a block of %u packets captured on interface %d.",
+            pbd->hdr.bh1.num_pkts, pcap_src->interface_id);
+
+        capture_loop_write_tpacket_block(pcap_src, pbd);
+#endif
+    } else {
+        ws_info("Dequeued a packet of length %d captured on interface %d.",
+            queue_element->u.phdr.caplen, pcap_src->interface_id);
+
+        capture_loop_write_packet_cb((uint8_t *) pcap_src,
+                                    &queue_element->u.phdr,
+                                    PCAP_QUEUE_DATA(queue_element));
+    }
+    capture_loop_queue_limits_release(&pcap_src->queue, queue_element->len);
+    pcap_queue_ring_pop(&pcap_src->queue, queue_element);
+    return true;
 }
 
 /*
@@ -4222,6 +5048,7 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
     char              secondary_errmsg[MSG_MAX_LENGTH+1];
     capture_src      *pcap_src;
     interface_options *interface_opts;
+    initfilter_status_t filter_status;
     unsigned          i, error_index        = 0;
 
     *errmsg           = '\0';
@@ -4263,9 +5090,17 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
          * is NULL. This might be a bug in WPCap. Therefore we provide an empty
          * string.
          */
-        switch (capture_loop_init_filter(pcap_src->pcap_h, pcap_src->from_cap_pipe,
-                                         interface_opts->name,
-                                         interface_opts->cfilter?interface_opts->cfilter:"")) {
+#ifdef CAN_USE_TPACKET_V3
+        if (pcap_src->tp_fd != -1) {
+            filter_status = capture_loop_init_tpacket_filter(&global_ld, pcap_src,
+                                                             interface_opts->name,
+                                                             interface_opts->cfilter);
+        } else
+#endif
+        filter_status = capture_loop_init_filter(pcap_src->pcap_h, pcap_src->from_cap_pipe,
+                                                 interface_opts->name,
+                                                 interface_opts->cfilter?interface_opts->cfilter:"");
+        switch (filter_status) {
 
         case INITFILTER_NO_ERROR:
             break;
@@ -4284,6 +5119,19 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
         }
     }
 
+    /* Set up the queues the capture threads hand packets to the writer in. */
+    if (use_threads) {
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            if (!pcap_queue_ring_init(&pcap_src->queue, global_ld.pcaps->len)) {
+                snprintf(errmsg, sizeof(errmsg),
+                         "Couldn't allocate a %d MiB capture queue for interface %d.",
+                         (int)(pcap_src->queue.size / (1024 * 1024)), pcap_src->interface_id);
+                goto error;
+            }
+        }
+    }
+
     /* If we're supposed to write to a capture file, open it for output
        (temporary/specified name/ringbuffer) */
     if (capture_opts->saving_to_file) {
@@ -4348,9 +5196,6 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
-        pcap_queue_bytes = 0;
-        pcap_queue_packets = 0;
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             /* XXX - Add an interface name here? */
@@ -4485,6 +5330,10 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
                 fflush(global_ld.pdh);
             }
         }
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            pcap_queue_ring_free(&pcap_src->queue);
+        }
     }
 
 
@@ -4660,10 +5509,21 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
     for (i = 0; i < capture_opts->ifaces->len; i++) {
         uint32_t received;
         uint32_t pcap_dropped = 0;
+        uint32_t dropped;
+        uint32_t flushed;
 
         pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
         interface_opts = &g_array_index(capture_opts->ifaces, interface_options, i);
         received = pcap_src->received;
+        dropped = pcap_src->dropped;
+        flushed = pcap_src->flushed;
+#ifdef CAN_USE_TPACKET_V3
+        if (pcap_src->tp_fd != -1) {
+            capture_loop_tpacket_stats(&global_ld, pcap_src, &received, &dropped, &flushed, stats);
+            *stats_known = true;
+            pcap_dropped += stats->ps_drop;
+        } else
+#endif
         if (pcap_src->pcap_h != NULL) {
             ws_assert(!pcap_src->from_cap_pipe);
             /* Get the capture statistics, so we know how many packets were dropped. */
@@ -4678,7 +5538,7 @@ capture_loop_start(capture_options *capture_opts, bool *stats_known, struct pcap
                 report_capture_error(errmsg, please_report_bug());
             }
         }
-        report_packet_drops(received, pcap_dropped, pcap_src->dropped, pcap_src->flushed, stats->ps_ifdrop, interface_opts->display_name);
+        report_packet_drops(received, pcap_dropped, dropped, flushed, stats->ps_ifdrop, interface_opts->display_name);
     }
 
     /* close the input file (pcap or capture pipe) */
@@ -4711,6 +5571,11 @@ error:
     else
         report_capture_error(errmsg, secondary_errmsg);
 
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        pcap_queue_ring_free(&pcap_src->queue);
+    }
+
     /* close the input file (pcap or cap_pipe) */
     capture_loop_close_input(&global_ld);
 
@@ -4946,6 +5811,47 @@ capture_loop_write_packet_cb(uint8_t *pcap_src_p, const struct pcap_pkthdr *phdr
     }
 }
 
+/*
+ * Count a packet of the given length against its source's queue limits.
+ * Returns false, without counting it, if the source's queue is full.
+ */
+static bool
+capture_loop_queue_limits_reserve(pcap_queue_ring *ring, uint32_t len)
+{
+    /*
+     * Only this source's capture thread adds to the counts, so they can
+     * only have gone down since we looked at them.
+     */
+    if (((ring->byte_limit != 0) && (g_atomic_int_get(&ring->bytes) >= ring->byte_limit)) ||
+        ((ring->packet_limit != 0) && (g_atomic_int_get(&ring->packets) >= ring->packet_limit))) {
+        return false;
+    }
+    g_atomic_int_add(&ring->bytes, (int)len);
+    g_atomic_int_add(&ring->packets, 1);
+    return true;
+}
+
+/*
+ * Get space for a packet of the given length in the source's queue.
+ * Returns NULL if the packet has to be dropped.
+ */
+static pcap_queue_element *
+capture_loop_queue_reserve(capture_src *pcap_src, uint32_t len, int *pos)
+{
+    pcap_queue_element *queue_element;
+
+    if (!capture_loop_queue_limits_reserve(&pcap_src->queue, len))
+        return NULL;
+    queue_element = pcap_queue_ring_reserve(&pcap_src->queue, PCAP_QUEUE_ALIGN(PCAP_QUEUE_HDR_SIZE + len), pos);
+    if (queue_element == NULL) {
+        capture_loop_queue_limits_release(&pcap_src->queue, len);
+        return NULL;
+    }
+    queue_element->size = PCAP_QUEUE_ALIGN(PCAP_QUEUE_HDR_SIZE + len);
+    queue_element->len = len;
+    return queue_element;
+}
+
 /* one packet was captured, queue it */
 static void
 capture_loop_queue_packet_cb(uint8_t *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -4953,7 +5859,7 @@ capture_loop_queue_packet_cb(uint8_t *pcap_src_p, const struct pcap_pkthdr *phdr
 {
     capture_src        *pcap_src = (capture_src *) (void *) pcap_src_p;
     pcap_queue_element *queue_element;
-    bool                limit_reached;
+    int                 pos;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4963,46 +5869,22 @@ capture_loop_queue_packet_cb(uint8_t *pcap_src_p, const struct pcap_pkthdr *phdr
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
+    queue_element = capture_loop_queue_reserve(pcap_src, phdr->caplen, &pos);
     if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.phdr = *phdr;
-    queue_element->pd = (uint8_t *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
         pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = false;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = true;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
-        pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         ws_info("Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        ws_info("Queued a packet of length %d captured on interface %u.",
-              phdr->caplen, pcap_src->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
-    ws_info("Queue size is now %" PRId64 " bytes (%" PRId64 " packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+    queue_element->u.phdr = *phdr;
+    queue_element->ts = (int64_t)phdr->ts.tv_sec * 1000000000 +
+                        (int64_t)phdr->ts.tv_usec * (pcap_src->ts_nsec ? 1 : 1000);
+    memcpy(PCAP_QUEUE_DATA(queue_element), pd, phdr->caplen);
+    pcap_queue_ring_commit(&pcap_src->queue, queue_element, pos);
+    pcap_src->received++;
+    ws_info("Queued a packet of length %d captured on interface %u.",
+          phdr->caplen, pcap_src->interface_id);
+    capture_loop_queue_log_size();
 }
 
 /* one pcapng block was captured, queue it */
@@ -5010,7 +5892,7 @@ static void
 capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, uint8_t *pd)
 {
     pcap_queue_element *queue_element;
-    bool                limit_reached;
+    int                 pos;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -5020,46 +5902,25 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
+    queue_element = capture_loop_queue_reserve(pcap_src, bh->block_total_length, &pos);
     if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.bh = *bh;
-    queue_element->pd = (uint8_t *)g_malloc(bh->block_total_length);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, bh->block_total_length);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = false;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += bh->block_total_length;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = true;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         ws_info("Dropped a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        ws_info("Queued a block of type 0x%08x of length %d captured on interface %u.",
-              bh->block_type, bh->block_total_length, pcap_src->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
-    ws_info("Queue size is now %" PRId64 " bytes (%" PRId64 " packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+    queue_element->u.bh = *bh;
+    /*
+     * Blocks from a pcapng pipe aren't all packets, so order them
+     * by when they arrived.
+     */
+    queue_element->ts = g_get_real_time() * 1000;
+    memcpy(PCAP_QUEUE_DATA(queue_element), pd, bh->block_total_length);
+    pcap_queue_ring_commit(&pcap_src->queue, queue_element, pos);
+    pcap_src->received++;
+    ws_info("Queued a block of type 0x%08x of length %d captured on interface %u.",
+          bh->block_type, bh->block_total_length, pcap_src->interface_id);
+    capture_loop_queue_log_size();
 }
 
 static int
@@ -5517,6 +6378,9 @@ main(int argc, char *argv[])
         case LONGOPT_COMPRESS_TYPE:        /* compress type */
         case LONGOPT_CAPTURE_TMPDIR:       /* capture temp directory */
         case LONGOPT_UPDATE_INTERVAL:      /* sync pipe update interval */
+#ifdef CAN_USE_TPACKET_V3
+        case LONGOPT_TPACKET_V3:           /* capture with a TPACKET_V3 ring */
+#endif
             status = capture_opts_add_opt(&global_capture_opts, opt, ws_optarg);
             if (status != 0) {
                 exit_main(status);
@@ -91,6 +91,8 @@ typedef struct _fd_hash_t {
     uint8_t    digest[16];
     uint32_t   len;
     nstime_t   frame_time;
+    int        next;        /* next entry in the same dup_index chain, or -1 */
+    bool       indexed;     /* entry is in dup_index */
 } fd_hash_t;
 
 #define DEFAULT_DUP_DEPTH       5   /* Used with -d */
@@ -100,6 +102,15 @@ static fd_hash_t fd_hash[MAX_DUP_DEPTH];
 static int       dup_window    = DEFAULT_DUP_DEPTH;
 static int       cur_dup_entry;
 
+/*
+ * Hash index over the entries of fd_hash[] in the current window, so
+ * that looking for a duplicate doesn't have to compare against every
+ * entry in the window. Each bucket holds the first fd_hash[] entry of a
+ * chain of entries linked through fd_hash_t.next, or -1.
+ */
+static int      *dup_index;
+static unsigned  dup_index_mask;
+
 static uint32_t  ignored_bytes;  /* Used with -I */
 
 #define ONE_BILLION 1000000000
@@ -659,9 +670,73 @@ set_unused_info(const wtap_packet_header *phdr, uint8_t* fd) {
     }
 }
 
+static void
+dup_index_init(void)
+{
+    unsigned size = 16;
+
+    while (size < 2 * (unsigned)dup_window)
+        size <<= 1;
+    dup_index = g_new(int, size);
+    memset(dup_index, -1, size * sizeof(int));
+    dup_index_mask = size - 1;
+}
+
+static inline unsigned
+dup_index_bucket(const fd_hash_t *entry)
+{
+    uint32_t h;
+
+    /* The digest is already well distributed. */
+    memcpy(&h, entry->digest, sizeof h);
+    return (h ^ entry->len) & dup_index_mask;
+}
+
+static void
+dup_index_remove(int entry)
+{
+    int *link;
+
+    if (!fd_hash[entry].indexed)
+        return;
+
+    for (link = &dup_index[dup_index_bucket(&fd_hash[entry])]; *link != -1; link = &fd_hash[*link].next) {
+        if (*link == entry) {
+            *link = fd_hash[entry].next;
+            break;
+        }
+    }
+    fd_hash[entry].indexed = false;
+}
+
+static void
+dup_index_add(int entry)
+{
+    unsigned bucket = dup_index_bucket(&fd_hash[entry]);
+
+    fd_hash[entry].next = dup_index[bucket];
+    dup_index[bucket] = entry;
+    fd_hash[entry].indexed = true;
+}
+
+/* Is there an entry other than entry in the index with the same digest? */
+static bool
+dup_index_lookup(int entry)
+{
+    int i;
+
+    for (i = dup_index[dup_index_bucket(&fd_hash[entry])]; i != -1; i = fd_hash[i].next) {
+        if (i != entry
+            && fd_hash[i].len == fd_hash[entry].len
+            && memcmp(fd_hash[i].digest, fd_hash[entry].digest, 16) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static bool
 is_duplicate(uint8_t* fd, uint32_t len) {
-    int i;
     const struct ieee80211_radiotap_header* tap_header;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
@@ -688,23 +763,18 @@ is_duplicate(uint8_t* fd, uint32_t len) {
     if (cur_dup_entry >= dup_window)
         cur_dup_entry = 0;
 
+    /* The oldest entry leaves the window */
+    dup_index_remove(cur_dup_entry);
+
     /* Calculate our digest */
     gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
 
     fd_hash[cur_dup_entry].len = len;
 
-    /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
-
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return true;
-        }
-    }
+    dup_index_add(cur_dup_entry);
 
-    return false;
+    /* Look for duplicates */
+    return dup_index_lookup(cur_dup_entry);
 }
 
 static bool
@@ -727,6 +797,8 @@ is_duplicate_rel_time(uint8_t* fd, uint32_t len, const nstime_t *current) {
     if (cur_dup_entry >= dup_window)
         cur_dup_entry = 0;
 
+    dup_index_remove(cur_dup_entry);
+
     /* Calculate our digest */
     gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
 
@@ -734,6 +806,15 @@ is_duplicate_rel_time(uint8_t* fd, uint32_t len, const nstime_t *current) {
     fd_hash[cur_dup_entry].frame_time.secs = current->secs;
     fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
 
+    dup_index_add(cur_dup_entry);
+
+    /*
+     * If no other packet in the cache has the same digest, there's
+     * no need to walk the cache by time.
+     */
+    if (!dup_index_lookup(cur_dup_entry))
+        return false;
+
     /*
      * Look for relative time related duplicates.
      * This is hopefully a reasonably efficient mechanism for
@@ -752,7 +833,8 @@ is_duplicate_rel_time(uint8_t* fd, uint32_t len, const nstime_t *current) {
      * The fd_hash[] table was deliberately created large (1,000,000).
      * Looking for time related duplicates in large trace files with
      * non-fractional dup time window values can potentially take
-     * a long time to complete.
+     * a long time to complete; the dup_index check above limits
+     * that to packets that have a matching digest in the cache.
      */
 
     for (i = cur_dup_entry - 1;; i--) {
@@ -2056,7 +2138,10 @@ main(int argc, char *argv[])
             memset(&fd_hash[i].digest, 0, 16);
             fd_hash[i].len = 0;
             nstime_set_unset(&fd_hash[i].frame_time);
+            fd_hash[i].next = -1;
+            fd_hash[i].indexed = false;
         }
+        dup_index_init();
     }
 
     /* Set up an array of all IDBs seen */
@@ -2683,6 +2768,7 @@ main(int argc, char *argv[])
 clean_exit:
     g_free(fprefix);
     g_free(fsuffix);
+    g_free(dup_index);
 
     if (filename) {
         g_free(filename);
@@ -56,6 +56,7 @@ typedef struct {
   int                 col_fence;            /**< Stuff in column buffer before this index is immutable */
   bool                writable;             /**< writable or not */
   int                 hf_id;
+  bool                col_pending;          /**< Still to be filled in, see col_fill_in_lazy() */
 } col_item_t;
 
 /** Column info */
@@ -68,6 +69,9 @@ struct epan_column_info {
   col_expr_t          col_expr;             /**< Column expressions and values */
   bool                writable;             /**< writable or not @todo Are we still writing to the columns? */
   GRegex             *prime_regex;          /**< Used to prime custom columns */
+  packet_info        *lazy_pinfo;           /**< Packet that pending columns are filled in from */
+  struct epan_dissect *lazy_edt;            /**< Dissection that pending custom columns are filled in from */
+  bool                lazy_fill_col_exprs;  /**< Whether to fill in expressions of pending columns */
 };
 
 /** Allocate all the data structures for constructing column data, given
@@ -92,6 +96,23 @@ WS_DLL_PUBLIC void col_fill_in_frame_data(const frame_data *fd, column_info *cin
  */
 WS_DLL_PUBLIC void col_fill_in(packet_info *pinfo, const bool fill_col_exprs, const bool fill_fd_colums);
 
+/** Like col_fill_in(), but only marks the columns as pending: each one
+ * is filled in when its text is first asked for, with get_column_text()
+ * or col_get_text(). That must be done before the packet's dissection is
+ * reset or cleaned up. If needed isn't NULL, only the columns for which it
+ * is true are filled in at all; it must have an entry for each column.
+ */
+WS_DLL_PUBLIC void col_fill_in_lazy(packet_info *pinfo, const bool fill_col_exprs, const bool fill_fd_colums, const bool *needed);
+
+/** Fill in a column marked as pending by col_fill_in_lazy().
+ */
+extern void col_fill_in_pending(column_info *cinfo, const int col);
+
+/** Forget about the columns still pending, leaving them empty, when the
+ * packet they were to be filled in from goes away.
+ */
+extern void col_fill_in_lazy_cleanup(column_info *cinfo);
+
 /** Fill in columns if we got an error reading the packet.
  * We set most columns to "???", and set the Info column to an error
  * message.
@@ -104,6 +125,11 @@ WS_DLL_PUBLIC bool      col_data_changed(void);
 
 void col_custom_set_edt(struct epan_dissect *edt, column_info *cinfo);
 
+/** Like col_custom_set_edt(), but marks the custom columns as pending, as
+ * col_fill_in_lazy() does for the others.
+ */
+void col_custom_set_edt_lazy(struct epan_dissect *edt, column_info *cinfo, const bool *needed);
+
 WS_DLL_PUBLIC
 void col_custom_prime_edt(struct epan_dissect *edt, column_info *cinfo);
 
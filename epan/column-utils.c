@@ -69,7 +69,10 @@ col_setup(column_info *cinfo, const int num_cols)
   cinfo->col_last              = g_new(int, NUM_COL_FMTS);
   for (i = 0; i < num_cols; i++) {
     cinfo->columns[i].col_custom_fields_ids = NULL;
+    cinfo->columns[i].col_pending = false;
   }
+  cinfo->lazy_pinfo = NULL;
+  cinfo->lazy_edt = NULL;
   cinfo->col_expr.col_expr     = g_new(const char*, num_cols + 1);
   cinfo->col_expr.col_expr_val = g_new(char*, num_cols + 1);
 
@@ -155,11 +158,14 @@ col_init(column_info *cinfo, const struct epan_session *epan)
     col_item->col_data = col_item->col_buf;
     col_item->col_fence = 0;
     col_item->writable = true;
+    col_item->col_pending = false;
     cinfo->col_expr.col_expr[i] = "";
     cinfo->col_expr.col_expr_val[i][0] = '\0';
   }
   cinfo->writable = true;
   cinfo->epan = epan;
+  cinfo->lazy_pinfo = NULL;
+  cinfo->lazy_edt = NULL;
 }
 
 bool
@@ -265,6 +271,8 @@ col_get_text(column_info *cinfo, const int el)
   for (i = cinfo->col_first[el]; i <= cinfo->col_last[el]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[el]) {
+      if (col_item->col_pending)
+        col_fill_in_pending(cinfo, i);
       text = (col_item->col_data);
     }
   }
@@ -353,28 +361,53 @@ have_field_extractors(void)
 #endif
 }
 
+/* search in edt tree custom fields for one column */
+static void
+col_custom_set_column(epan_dissect_t *edt, column_info *cinfo, const int col)
+{
+  col_item_t* col_item = &cinfo->columns[col];
+
+  if (col_item->fmt_matx[COL_CUSTOM] &&
+      col_item->col_custom_fields &&
+      col_item->col_custom_fields_ids) {
+      col_item->col_data = col_item->col_buf;
+      cinfo->col_expr.col_expr[col] = epan_custom_set(edt, col_item->col_custom_fields_ids,
+                                   col_item->col_custom_occurrence,
+                                   col_item->col_buf,
+                                   cinfo->col_expr.col_expr_val[col],
+                                   COL_MAX_LEN);
+  }
+}
+
 /* search in edt tree custom fields */
 void col_custom_set_edt(epan_dissect_t *edt, column_info *cinfo)
 {
   int i;
-  col_item_t* col_item;
 
   if (!HAVE_CUSTOM_COLS(cinfo))
       return;
 
   for (i = cinfo->col_first[COL_CUSTOM];
        i <= cinfo->col_last[COL_CUSTOM]; i++) {
-    col_item = &cinfo->columns[i];
-    if (col_item->fmt_matx[COL_CUSTOM] &&
-        col_item->col_custom_fields &&
-        col_item->col_custom_fields_ids) {
-        col_item->col_data = col_item->col_buf;
-        cinfo->col_expr.col_expr[i] = epan_custom_set(edt, col_item->col_custom_fields_ids,
-                                     col_item->col_custom_occurrence,
-                                     col_item->col_buf,
-                                     cinfo->col_expr.col_expr_val[i],
-                                     COL_MAX_LEN);
-    }
+    col_custom_set_column(edt, cinfo, i);
+  }
+}
+
+/* like col_custom_set_edt(), but leave the columns to be filled in when
+   their text is asked for */
+void col_custom_set_edt_lazy(epan_dissect_t *edt, column_info *cinfo, const bool *needed)
+{
+  int i;
+
+  if (!HAVE_CUSTOM_COLS(cinfo))
+      return;
+
+  cinfo->lazy_edt = edt;
+  for (i = cinfo->col_first[COL_CUSTOM];
+       i <= cinfo->col_last[COL_CUSTOM]; i++) {
+    /* Other columns can be in between custom ones. */
+    if (cinfo->columns[i].fmt_matx[COL_CUSTOM] && (!needed || needed[i]))
+      cinfo->columns[i].col_pending = true;
   }
 }
 
@@ -1900,119 +1933,180 @@ col_fill_in_frame_data(const frame_data *fd, column_info *cinfo, const int col,
   }
 }
 
-void
-col_fill_in(packet_info *pinfo, const bool fill_col_exprs, const bool fill_fd_colums)
+/* Fills in one column of the given packet */
+static void
+col_fill_in_column(packet_info *pinfo, const int i, const bool fill_col_exprs, const bool fill_fd_colums)
 {
-  int i;
-  col_item_t* col_item;
+  col_item_t* col_item = &pinfo->cinfo->columns[i];
 
-  if (!pinfo->cinfo)
-    return;
-
-  for (i = 0; i < pinfo->cinfo->num_cols; i++) {
-    col_item = &pinfo->cinfo->columns[i];
-    if (col_based_on_frame_data(pinfo->cinfo, i)) {
-      if (fill_fd_colums)
-        col_fill_in_frame_data(pinfo->fd, pinfo->cinfo, i, fill_col_exprs);
-    } else {
-      switch (col_item->col_fmt) {
-      case COL_DEF_SRC:
-      case COL_RES_SRC:   /* COL_DEF_SRC is currently just like COL_RES_SRC */
-        col_set_addr(pinfo, i, &pinfo->src, true, fill_col_exprs, true);
-        break;
+  if (col_based_on_frame_data(pinfo->cinfo, i)) {
+    if (fill_fd_colums)
+      col_fill_in_frame_data(pinfo->fd, pinfo->cinfo, i, fill_col_exprs);
+  } else {
+    switch (col_item->col_fmt) {
+    case COL_DEF_SRC:
+    case COL_RES_SRC:   /* COL_DEF_SRC is currently just like COL_RES_SRC */
+      col_set_addr(pinfo, i, &pinfo->src, true, fill_col_exprs, true);
+      break;
 
-      case COL_UNRES_SRC:
-        col_set_addr(pinfo, i, &pinfo->src, true, fill_col_exprs, false);
-        break;
+    case COL_UNRES_SRC:
+      col_set_addr(pinfo, i, &pinfo->src, true, fill_col_exprs, false);
+      break;
 
-      case COL_DEF_DL_SRC:
-      case COL_RES_DL_SRC:
-        col_set_addr(pinfo, i, &pinfo->dl_src, true, fill_col_exprs, true);
-        break;
+    case COL_DEF_DL_SRC:
+    case COL_RES_DL_SRC:
+      col_set_addr(pinfo, i, &pinfo->dl_src, true, fill_col_exprs, true);
+      break;
 
-      case COL_UNRES_DL_SRC:
-        col_set_addr(pinfo, i, &pinfo->dl_src, true, fill_col_exprs, false);
-        break;
+    case COL_UNRES_DL_SRC:
+      col_set_addr(pinfo, i, &pinfo->dl_src, true, fill_col_exprs, false);
+      break;
 
-      case COL_DEF_NET_SRC:
-      case COL_RES_NET_SRC:
-        col_set_addr(pinfo, i, &pinfo->net_src, true, fill_col_exprs, true);
-        break;
+    case COL_DEF_NET_SRC:
+    case COL_RES_NET_SRC:
+      col_set_addr(pinfo, i, &pinfo->net_src, true, fill_col_exprs, true);
+      break;
 
-      case COL_UNRES_NET_SRC:
-        col_set_addr(pinfo, i, &pinfo->net_src, true, fill_col_exprs, false);
-        break;
+    case COL_UNRES_NET_SRC:
+      col_set_addr(pinfo, i, &pinfo->net_src, true, fill_col_exprs, false);
+      break;
 
-      case COL_DEF_DST:
-      case COL_RES_DST:   /* COL_DEF_DST is currently just like COL_RES_DST */
-        col_set_addr(pinfo, i, &pinfo->dst, false, fill_col_exprs, true);
-        break;
+    case COL_DEF_DST:
+    case COL_RES_DST:   /* COL_DEF_DST is currently just like COL_RES_DST */
+      col_set_addr(pinfo, i, &pinfo->dst, false, fill_col_exprs, true);
+      break;
 
-      case COL_UNRES_DST:
-        col_set_addr(pinfo, i, &pinfo->dst, false, fill_col_exprs, false);
-        break;
+    case COL_UNRES_DST:
+      col_set_addr(pinfo, i, &pinfo->dst, false, fill_col_exprs, false);
+      break;
 
-      case COL_DEF_DL_DST:
-      case COL_RES_DL_DST:
-        col_set_addr(pinfo, i, &pinfo->dl_dst, false, fill_col_exprs, true);
-        break;
+    case COL_DEF_DL_DST:
+    case COL_RES_DL_DST:
+      col_set_addr(pinfo, i, &pinfo->dl_dst, false, fill_col_exprs, true);
+      break;
 
-      case COL_UNRES_DL_DST:
-        col_set_addr(pinfo, i, &pinfo->dl_dst, false, fill_col_exprs, false);
-        break;
+    case COL_UNRES_DL_DST:
+      col_set_addr(pinfo, i, &pinfo->dl_dst, false, fill_col_exprs, false);
+      break;
 
-      case COL_DEF_NET_DST:
-      case COL_RES_NET_DST:
-        col_set_addr(pinfo, i, &pinfo->net_dst, false, fill_col_exprs, true);
-        break;
+    case COL_DEF_NET_DST:
+    case COL_RES_NET_DST:
+      col_set_addr(pinfo, i, &pinfo->net_dst, false, fill_col_exprs, true);
+      break;
 
-      case COL_UNRES_NET_DST:
-        col_set_addr(pinfo, i, &pinfo->net_dst, false, fill_col_exprs, false);
-        break;
+    case COL_UNRES_NET_DST:
+      col_set_addr(pinfo, i, &pinfo->net_dst, false, fill_col_exprs, false);
+      break;
 
-      case COL_DEF_SRC_PORT:
-      case COL_RES_SRC_PORT:  /* COL_DEF_SRC_PORT is currently just like COL_RES_SRC_PORT */
-        col_set_port(pinfo, i, true, true, fill_col_exprs);
-        break;
+    case COL_DEF_SRC_PORT:
+    case COL_RES_SRC_PORT:  /* COL_DEF_SRC_PORT is currently just like COL_RES_SRC_PORT */
+      col_set_port(pinfo, i, true, true, fill_col_exprs);
+      break;
 
-      case COL_UNRES_SRC_PORT:
-        col_set_port(pinfo, i, false, true, fill_col_exprs);
-        break;
+    case COL_UNRES_SRC_PORT:
+      col_set_port(pinfo, i, false, true, fill_col_exprs);
+      break;
 
-      case COL_DEF_DST_PORT:
-      case COL_RES_DST_PORT:  /* COL_DEF_DST_PORT is currently just like COL_RES_DST_PORT */
-        col_set_port(pinfo, i, true, false, fill_col_exprs);
-        break;
+    case COL_DEF_DST_PORT:
+    case COL_RES_DST_PORT:  /* COL_DEF_DST_PORT is currently just like COL_RES_DST_PORT */
+      col_set_port(pinfo, i, true, false, fill_col_exprs);
+      break;
 
-      case COL_UNRES_DST_PORT:
-        col_set_port(pinfo, i, false, false, fill_col_exprs);
-        break;
+    case COL_UNRES_DST_PORT:
+      col_set_port(pinfo, i, false, false, fill_col_exprs);
+      break;
 
-      case COL_CUSTOM:
-        /* Formatting handled by col_custom_set_edt() / col_custom_get_filter() */
-        break;
+    case COL_CUSTOM:
+      /* Formatting handled by col_custom_set_edt() / col_custom_get_filter() */
+      break;
 
-      case NUM_COL_FMTS:  /* keep compiler happy - shouldn't get here */
+    case NUM_COL_FMTS:  /* keep compiler happy - shouldn't get here */
+      ws_assert_not_reached();
+      break;
+    default:
+      if (col_item->col_fmt >= NUM_COL_FMTS) {
         ws_assert_not_reached();
-        break;
-      default:
-        if (col_item->col_fmt >= NUM_COL_FMTS) {
-          ws_assert_not_reached();
-        }
-        /*
-         * Formatting handled by expert.c (COL_EXPERT), or individual
-         * dissectors. Fill in from the text using the internal hfid.
-         */
-        if (fill_col_exprs) {
-          pinfo->cinfo->col_expr.col_expr[i] = proto_registrar_get_nth(col_item->hf_id)->abbrev;
-          (void) g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[i], pinfo->cinfo->columns[i].col_data, (col_item->col_fmt == COL_INFO) ? COL_MAX_INFO_LEN : COL_MAX_LEN);
-        }
-        break;
       }
+      /*
+       * Formatting handled by expert.c (COL_EXPERT), or individual
+       * dissectors. Fill in from the text using the internal hfid.
+       */
+      if (fill_col_exprs) {
+        pinfo->cinfo->col_expr.col_expr[i] = proto_registrar_get_nth(col_item->hf_id)->abbrev;
+        (void) g_strlcpy(pinfo->cinfo->col_expr.col_expr_val[i], pinfo->cinfo->columns[i].col_data, (col_item->col_fmt == COL_INFO) ? COL_MAX_INFO_LEN : COL_MAX_LEN);
+      }
+      break;
+    }
+  }
+}
+
+void
+col_fill_in(packet_info *pinfo, const bool fill_col_exprs, const bool fill_fd_colums)
+{
+  int i;
+
+  if (!pinfo->cinfo)
+    return;
+
+  for (i = 0; i < pinfo->cinfo->num_cols; i++) {
+    col_fill_in_column(pinfo, i, fill_col_exprs, fill_fd_colums);
+  }
+}
+
+void
+col_fill_in_lazy(packet_info *pinfo, const bool fill_col_exprs, const bool fill_fd_colums, const bool *needed)
+{
+  column_info *cinfo = pinfo->cinfo;
+  col_item_t* col_item;
+  int i;
+
+  if (!cinfo)
+    return;
+
+  cinfo->lazy_pinfo = pinfo;
+  cinfo->lazy_fill_col_exprs = fill_col_exprs;
+
+  for (i = 0; i < cinfo->num_cols; i++) {
+    col_item = &cinfo->columns[i];
+    if (needed && !needed[i])
+      continue;
+    if (col_based_on_frame_data(cinfo, i)) {
+      if (fill_fd_colums)
+        col_item->col_pending = true;
+    } else if (col_item->col_fmt != COL_CUSTOM) {
+      col_item->col_pending = true;
     }
   }
 }
 
+void
+col_fill_in_pending(column_info *cinfo, const int col)
+{
+  col_item_t* col_item = &cinfo->columns[col];
+
+  col_item->col_pending = false;
+  if (col_item->col_fmt == COL_CUSTOM) {
+    col_custom_set_column(cinfo->lazy_edt, cinfo, col);
+  } else {
+    col_fill_in_column(cinfo->lazy_pinfo, col, cinfo->lazy_fill_col_exprs, true);
+  }
+}
+
+void
+col_fill_in_lazy_cleanup(column_info *cinfo)
+{
+  int i;
+
+  if (!cinfo || (!cinfo->lazy_pinfo && !cinfo->lazy_edt))
+    return;
+
+  for (i = 0; i < cinfo->num_cols; i++) {
+    cinfo->columns[i].col_pending = false;
+  }
+  cinfo->lazy_pinfo = NULL;
+  cinfo->lazy_edt = NULL;
+}
+
 /*
  * Fill in columns if we got an error reading the packet.
  * We set most columns to "???", fill in columns that don't need data read
@@ -2088,12 +2182,14 @@ col_dissect(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
   if (proto_field_is_referenced(tree, proto_cols)) {
     // XXX: Needed if we also create _ws.col.custom
     //col_custom_set(tree, cinfo);
-    col_fill_in(pinfo, false, true);
     ti = proto_tree_add_item(tree, proto_cols, tvb, 0, 0, ENC_NA);
     proto_item_set_hidden(ti);
     col_tree = proto_item_add_subtree(ti, ett_cols);
     for (int i = 0; i < cinfo->num_cols; ++i) {
-      if (cinfo->columns[i].hf_id != -1) {
+      /* Only format the columns a filter actually asks for. */
+      if (cinfo->columns[i].hf_id != -1 &&
+          proto_field_is_referenced(tree, cinfo->columns[i].hf_id)) {
+        col_fill_in_column(pinfo, i, false, true);
         if (cinfo->columns[i].col_fmt == COL_CUSTOM) {
           ti = proto_tree_add_string_format(col_tree, cinfo->columns[i].hf_id, tvb, 0, 0, get_column_text(cinfo, i), "%s: %s", get_column_title(i), get_column_text(cinfo, i));
         } else {
@@ -996,6 +996,10 @@ get_column_text(column_info *cinfo, const int col)
   ws_assert(cinfo);
   ws_assert(col < cinfo->num_cols);
 
+  if (cinfo->columns[col].col_pending) {
+      col_fill_in_pending(cinfo, col);
+  }
+
   if (!get_column_resolved(col) && cinfo->col_expr.col_expr_val[col]) {
       /* Use the unresolved value in col_expr_val */
       return cinfo->col_expr.col_expr_val[col];
@@ -113,6 +113,18 @@ static const char *type_names[] = {
  */
 static wmem_map_t *conversation_hashtable_element_list;
 
+/*
+ * Conversation "shapes". Each distinct sequence of element types is
+ * interned once and given a small integer id, which indexes
+ * conversation_shape_maps directly. This lets the per-packet paths find
+ * the hash table for an element list without formatting its name.
+ *
+ * conversation_shape_ids maps a packed element type sequence (see
+ * conversation_element_list_shape_key()) to its shape id.
+ */
+static wmem_map_t *conversation_shape_ids;
+static wmem_array_t *conversation_shape_maps;
+
 /*
  * Hash table for conversations based on addresses only
  */
@@ -208,6 +220,64 @@ conversation_element_list_name(wmem_allocator_t *allocator, conversation_element
     return wmem_strbuf_finalize(conv_hash_group);
 }
 
+/*
+ * Pack the element types of an element list, excluding the terminating
+ * CE_CONVERSATION_TYPE, into an integer. Every other type is non-zero
+ * and fits in CONV_SHAPE_TYPE_BITS bits, and there are fewer than
+ * MAX_CONVERSATION_ELEMENTS of them, so the packed value is unique for
+ * each type sequence.
+ */
+#define CONV_SHAPE_TYPE_BITS 4
+static uint32_t
+conversation_element_list_shape_key(const conversation_element_t *elements)
+{
+    uint32_t key = 0;
+    size_t count = 0;
+    while (elements[count].type != CE_CONVERSATION_TYPE) {
+        DISSECTOR_ASSERT(elements[count].type < array_length(type_names));
+        key = (key << CONV_SHAPE_TYPE_BITS) | elements[count].type;
+        count++;
+        DISSECTOR_ASSERT(count < MAX_CONVERSATION_ELEMENTS);
+    }
+    // Keying on the endpoint type alone isn't very useful.
+    DISSECTOR_ASSERT(count > 0);
+    return key;
+}
+
+/* Return the hash table for a shape id. */
+static inline wmem_map_t *
+conversation_shape_map(unsigned shape)
+{
+    DISSECTOR_ASSERT(shape > 0 && shape < wmem_array_get_count(conversation_shape_maps));
+    return *(wmem_map_t **)wmem_array_index(conversation_shape_maps, shape);
+}
+
+/* Return the id of an element list's shape, or 0 if it hasn't been seen yet. */
+static unsigned
+conversation_find_shape(const conversation_element_t *elements)
+{
+    uint32_t key = conversation_element_list_shape_key(elements);
+    return GPOINTER_TO_UINT(wmem_map_lookup(conversation_shape_ids, GUINT_TO_POINTER(key)));
+}
+
+/*
+ * Register the hash table for an element list's shape. It is also added
+ * to conversation_hashtable_element_list under its name, which is what
+ * get_conversation_hashtables() hands out.
+ */
+static unsigned
+conversation_add_shape(conversation_element_t *elements, wmem_map_t *el_list_map)
+{
+    uint32_t key = conversation_element_list_shape_key(elements);
+    unsigned shape = wmem_array_get_count(conversation_shape_maps);
+
+    wmem_map_insert(conversation_hashtable_element_list,
+                    conversation_element_list_name(wmem_epan_scope(), elements), el_list_map);
+    wmem_array_append_one(conversation_shape_maps, el_list_map);
+    wmem_map_insert(conversation_shape_ids, GUINT_TO_POINTER(key), GUINT_TO_POINTER(shape));
+    return shape;
+}
+
 #if 0 // debugging
 static char* conversation_element_list_values(conversation_element_t *elements) {
     char *sep = "";
@@ -547,6 +617,11 @@ conversation_init(void)
      * above.
      */
     conversation_hashtable_element_list = wmem_map_new(wmem_epan_scope(), wmem_str_hash, g_str_equal);
+    conversation_shape_ids = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
+    conversation_shape_maps = wmem_array_new(wmem_epan_scope(), sizeof(wmem_map_t *));
+    /* Shape id 0 means "none". */
+    wmem_map_t *no_shape_map = NULL;
+    wmem_array_append_one(conversation_shape_maps, no_shape_map);
 
     conversation_element_t exact_elements[EXACT_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
@@ -555,24 +630,20 @@ conversation_init(void)
         { CE_PORT, .port_val = 0 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *exact_map_key = conversation_element_list_name(wmem_epan_scope(), exact_elements);
     conversation_hashtable_exact_addr_port = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), exact_map_key),
-                    conversation_hashtable_exact_addr_port);
+    conversation_add_shape(exact_elements, conversation_hashtable_exact_addr_port);
 
     conversation_element_t addrs_elements[ADDRS_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *addrs_map_key = conversation_element_list_name(wmem_epan_scope(), addrs_elements);
     conversation_hashtable_exact_addr = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), addrs_map_key),
-                    conversation_hashtable_exact_addr);
+    conversation_add_shape(addrs_elements, conversation_hashtable_exact_addr);
 
     conversation_element_t no_addr2_elements[NO_ADDR2_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
@@ -580,12 +651,10 @@ conversation_init(void)
         { CE_PORT, .port_val = 0 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *no_addr2_map_key = conversation_element_list_name(wmem_epan_scope(), no_addr2_elements);
     conversation_hashtable_no_addr2 = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                        conversation_hash_element_list,
                                                        conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), no_addr2_map_key),
-                    conversation_hashtable_no_addr2);
+    conversation_add_shape(no_addr2_elements, conversation_hashtable_no_addr2);
 
     conversation_element_t no_port2_elements[NO_PORT2_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
@@ -593,35 +662,29 @@ conversation_init(void)
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *no_port2_map_key = conversation_element_list_name(wmem_epan_scope(), no_port2_elements);
     conversation_hashtable_no_port2 = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                        conversation_hash_element_list,
                                                        conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), no_port2_map_key),
-                    conversation_hashtable_no_port2);
+    conversation_add_shape(no_port2_elements, conversation_hashtable_no_port2);
 
     conversation_element_t no_addr2_or_port2_elements[NO_ADDR2_PORT2_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
         { CE_PORT, .port_val = 0 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *no_addr2_or_port2_map_key = conversation_element_list_name(wmem_epan_scope(), no_addr2_or_port2_elements);
     conversation_hashtable_no_addr2_or_port2 = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), no_addr2_or_port2_map_key),
-                    conversation_hashtable_no_addr2_or_port2);
+    conversation_add_shape(no_addr2_or_port2_elements, conversation_hashtable_no_addr2_or_port2);
 
     conversation_element_t id_elements[2] = {
         { CE_UINT, .uint_val = 0 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *id_map_key = conversation_element_list_name(wmem_epan_scope(), id_elements);
     conversation_hashtable_id = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                        conversation_hash_element_list,
                                                        conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), id_map_key),
-                    conversation_hashtable_id);
+    conversation_add_shape(id_elements, conversation_hashtable_id);
 
     /*
      * Initialize the "deinterlacer" table, which is used as the basis for the
@@ -645,12 +708,10 @@ conversation_init(void)
         { CE_UINT, .uint_val = 0 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *deinterlacer_map_key = conversation_element_list_name(wmem_epan_scope(), deinterlacer_elements);
     conversation_hashtable_deinterlacer = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), deinterlacer_map_key),
-                    conversation_hashtable_deinterlacer);
+    conversation_add_shape(deinterlacer_elements, conversation_hashtable_deinterlacer);
 
     /*
      * Initialize the "_anc" tables, which are very similar to their standard counterparts
@@ -669,12 +730,10 @@ conversation_init(void)
         { CE_UINT, .uint_val = 0 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *exact_anc_map_key = conversation_element_list_name(wmem_epan_scope(), exact_elements_anc);
     conversation_hashtable_exact_addr_port_anc = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), exact_anc_map_key),
-                    conversation_hashtable_exact_addr_port_anc);
+    conversation_add_shape(exact_elements_anc, conversation_hashtable_exact_addr_port_anc);
 
     conversation_element_t addrs_elements_anc[ADDRS_IDX_COUNT+1] = {
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
@@ -682,12 +741,10 @@ conversation_init(void)
         { CE_UINT, .uint_val = 0 },
         { CE_CONVERSATION_TYPE, .conversation_type_val = CONVERSATION_NONE }
     };
-    char *addrs_anc_map_key = conversation_element_list_name(wmem_epan_scope(), addrs_elements_anc);
     conversation_hashtable_exact_addr_anc = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
                                                                     conversation_hash_element_list,
                                                                     conversation_match_element_list);
-    wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), addrs_anc_map_key),
-                    conversation_hashtable_exact_addr_anc);
+    conversation_add_shape(addrs_elements_anc, conversation_hashtable_exact_addr_anc);
 
 }
 
@@ -822,17 +879,25 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
     }
 }
 
-conversation_t *conversation_new_full(const uint32_t setup_frame, conversation_element_t *elements)
+unsigned
+conversation_element_list_shape(conversation_element_t *elements)
 {
     DISSECTOR_ASSERT(elements);
 
-    char *el_list_map_key = conversation_element_list_name(wmem_epan_scope(), elements);
-    wmem_map_t *el_list_map = (wmem_map_t *) wmem_map_lookup(conversation_hashtable_element_list, el_list_map_key);
-    if (!el_list_map) {
-        el_list_map = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_element_list,
+    unsigned shape = conversation_find_shape(elements);
+    if (!shape) {
+        wmem_map_t *el_list_map = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_element_list,
                 conversation_match_element_list);
-        wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), el_list_map_key), el_list_map);
+        shape = conversation_add_shape(elements, el_list_map);
     }
+    return shape;
+}
+
+conversation_t *conversation_new_full(const uint32_t setup_frame, conversation_element_t *elements)
+{
+    DISSECTOR_ASSERT(elements);
+
+    wmem_map_t *el_list_map = conversation_shape_map(conversation_element_list_shape(elements));
 
     size_t element_count = conversation_element_count(elements);
     conversation_element_t *conv_key = wmem_memdup(wmem_file_scope(), elements, sizeof(conversation_element_t) * element_count);
@@ -1357,14 +1422,17 @@ static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_ha
 
 conversation_t *find_conversation_full(const uint32_t frame_num, conversation_element_t *elements)
 {
-    char *el_list_map_key = conversation_element_list_name(NULL, elements);
-    wmem_map_t *el_list_map = (wmem_map_t *) wmem_map_lookup(conversation_hashtable_element_list, el_list_map_key);
-    g_free(el_list_map_key);
-    if (!el_list_map) {
+    unsigned shape = conversation_find_shape(elements);
+    if (!shape) {
         return NULL;
     }
 
-    return conversation_lookup_hashtable(el_list_map, frame_num, elements);
+    return conversation_lookup_hashtable(conversation_shape_map(shape), frame_num, elements);
+}
+
+conversation_t *find_conversation_by_shape(const uint32_t frame_num, unsigned shape, conversation_element_t *elements)
+{
+    return conversation_lookup_hashtable(conversation_shape_map(shape), frame_num, elements);
 }
 
 /*
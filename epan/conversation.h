@@ -358,6 +358,27 @@ WS_DLL_PUBLIC WS_RETNONNULL conversation_t *conversation_new_strat(packet_info *
  */
 WS_DLL_PUBLIC conversation_t *find_conversation_full(const uint32_t frame_num, conversation_element_t *elements);
 
+/**
+ * Get the shape id of an element list. Element lists with the same sequence
+ * of element types share a shape id, which remains valid for the lifetime
+ * of the epan library. Dissectors that look up the same kind of element list
+ * for every packet can get the shape id once and pass it to
+ * find_conversation_by_shape().
+ * @param elements An array of element types and values. Must not be NULL. Must be terminated with a CE_CONVERSATION_TYPE element.
+ * @return The shape id.
+ */
+WS_DLL_PUBLIC unsigned conversation_element_list_shape(conversation_element_t *elements);
+
+/**
+ * Search for a conversation based on the values of an element list with a known shape.
+ * This does not allocate memory, so the element list can be on the stack.
+ * @param frame_num Frame number. Must be greater than or equal to the conversation's initial frame number.
+ * @param shape A shape id returned by conversation_element_list_shape() for an element list of the same types.
+ * @param elements An array of element types and values. Must not be NULL. Must be terminated with a CE_CONVERSATION_TYPE element.
+ * @return The matching conversation if found, otherwise NULL.
+ */
+WS_DLL_PUBLIC conversation_t *find_conversation_by_shape(const uint32_t frame_num, unsigned shape, conversation_element_t *elements);
+
 /**
  * Given two address/port pairs for a packet, search for a conversation
  * containing packets between those address/port pairs.  Returns NULL if
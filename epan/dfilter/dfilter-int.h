@@ -47,6 +47,9 @@ struct epan_dfilter {
 	/* Used to pass arguments to functions. List of Lists (list of registers). */
 	GSList		*function_stack;
 	GSList		*set_stack;
+	/* Tests that can be made before the packet is dissected (frame_check_t),
+	 * or NULL if there are none. */
+	GPtrArray	*frame_checks;
 };
 
 typedef struct {
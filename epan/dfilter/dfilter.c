@@ -14,11 +14,14 @@
 
 #include "dfilter-int.h"
 #include "syntax-tree.h"
+#include "sttype-field.h"
+#include "sttype-op.h"
 #include "gencode.h"
 #include "semcheck.h"
 #include "dfvm.h"
 #include <epan/epan_dissect.h>
 #include <epan/exceptions.h>
+#include <wiretap/wtap.h>
 #include "dfilter.h"
 #include "dfunctions.h"
 #include "dfilter-macro.h"
@@ -198,12 +201,192 @@ dfilter_free(dfilter_t *df)
 	if (df->warnings)
 		g_slist_free_full(df->warnings, g_free);
 
+	if (df->frame_checks)
+		g_ptr_array_free(df->frame_checks, true);
+
 	g_free(df->registers);
 	g_free(df->expanded_text);
 	g_free(df->syntax_tree_str);
 	g_free(df);
 }
 
+/*
+ * Fields of the "frame" protocol that the frame dissector fills in from
+ * the frame_data and the record alone. A comparison of one of them with
+ * a constant can be made before the packet is dissected.
+ */
+typedef enum {
+	FRAME_CHECK_NUMBER,
+	FRAME_CHECK_LEN,
+	FRAME_CHECK_CAP_LEN,
+	FRAME_CHECK_TIME,
+	FRAME_CHECK_INTERFACE_ID,
+} frame_check_field_t;
+
+static const struct {
+	const char		*abbrev;
+	frame_check_field_t	field;
+} frame_check_fields[] = {
+	{ "frame.number",	FRAME_CHECK_NUMBER },
+	{ "frame.len",		FRAME_CHECK_LEN },
+	{ "frame.cap_len",	FRAME_CHECK_CAP_LEN },
+	{ "frame.time",		FRAME_CHECK_TIME },
+	{ "frame.time_utc",	FRAME_CHECK_TIME },
+	{ "frame.time_epoch",	FRAME_CHECK_TIME },
+	{ "frame.interface_id",	FRAME_CHECK_INTERFACE_ID },
+};
+
+typedef struct {
+	frame_check_field_t	field;
+	stnode_op_t		op;
+	fvalue_t		*value;		/* The constant compared with. */
+	fvalue_t		*frame_value;	/* Set for each frame checked. */
+} frame_check_t;
+
+static void
+frame_check_free(void *data)
+{
+	frame_check_t *check = data;
+
+	fvalue_free(check->value);
+	fvalue_free(check->frame_value);
+	g_free(check);
+}
+
+/* Returns a check for a comparison of a frame field with a constant,
+ * or NULL if the test isn't one. */
+static frame_check_t *
+frame_check_new(stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_field, *st_value, *st_tmp;
+	header_field_info *hfinfo;
+	fvalue_t	*fv;
+	frame_check_t	*check;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return NULL;
+
+	sttype_oper_get(st_node, &st_op, &st_field, &st_value);
+
+	if (stnode_type_id(st_field) == STTYPE_FVALUE) {
+		/* The constant is on the left; mirror the comparison. */
+		st_tmp = st_field;
+		st_field = st_value;
+		st_value = st_tmp;
+		switch (st_op) {
+			case STNODE_OP_GT:	st_op = STNODE_OP_LT;	break;
+			case STNODE_OP_GE:	st_op = STNODE_OP_LE;	break;
+			case STNODE_OP_LT:	st_op = STNODE_OP_GT;	break;
+			case STNODE_OP_LE:	st_op = STNODE_OP_GE;	break;
+			default:					break;
+		}
+	}
+
+	switch (st_op) {
+		case STNODE_OP_ALL_EQ:
+		case STNODE_OP_ANY_EQ:
+		case STNODE_OP_ALL_NE:
+		case STNODE_OP_ANY_NE:
+		case STNODE_OP_GT:
+		case STNODE_OP_GE:
+		case STNODE_OP_LT:
+		case STNODE_OP_LE:
+			break;
+		default:
+			return NULL;
+	}
+
+	if (st_value == NULL || stnode_type_id(st_value) != STTYPE_FVALUE ||
+			stnode_type_id(st_field) != STTYPE_FIELD)
+		return NULL;
+	/* The check is made on the field as the frame dissector adds it, once
+	 * per frame, so a layer operator (frame.number#2), which picks out
+	 * occurrences from the protocol stack that can't be known before the
+	 * packet is dissected, or a raw or value-string field, isn't one. */
+	if (sttype_field_drange(st_field) != NULL || sttype_field_raw(st_field) ||
+			sttype_field_value_string(st_field))
+		return NULL;
+
+	hfinfo = sttype_field_hfinfo(st_field);
+	fv = stnode_data(st_value);
+	if (fvalue_type_ftenum(fv) != hfinfo->type)
+		return NULL;
+
+	for (size_t i = 0; i < G_N_ELEMENTS(frame_check_fields); i++) {
+		if (strcmp(hfinfo->abbrev, frame_check_fields[i].abbrev) == 0) {
+			check = g_new(frame_check_t, 1);
+			check->field = frame_check_fields[i].field;
+			/* The frame dissector adds each of these fields at
+			 * most once, so "all" and "any" are the same. */
+			check->op = st_op;
+			check->value = fvalue_dup(fv);
+			check->frame_value = fvalue_new(hfinfo->type);
+			return check;
+		}
+	}
+	return NULL;
+}
+
+/* Collect the comparisons of frame fields with constants that are
+ * operands of the top-level chain of "and"s. If any of them is false,
+ * so is the filter. */
+static void
+dfw_frame_checks(dfwork_t *dfw, dfilter_t *df)
+{
+	GSList		*todo;
+	stnode_t	*st_node, *st_arg1, *st_arg2;
+	frame_check_t	*check;
+
+	if (!(dfw->flags & DF_OPTIMIZE) || (dfw->flags & DF_RETURN_VALUES))
+		return;
+
+	todo = g_slist_prepend(NULL, dfw->st_root);
+	while (todo != NULL) {
+		st_node = todo->data;
+		todo = g_slist_delete_link(todo, todo);
+
+		if (stnode_type_id(st_node) == STTYPE_TEST &&
+				sttype_oper_get_op(st_node) == STNODE_OP_AND) {
+			sttype_oper_get(st_node, NULL, &st_arg1, &st_arg2);
+			todo = g_slist_prepend(todo, st_arg2);
+			todo = g_slist_prepend(todo, st_arg1);
+			continue;
+		}
+
+		check = frame_check_new(st_node);
+		if (check == NULL)
+			continue;
+		if (df->frame_checks == NULL)
+			df->frame_checks = g_ptr_array_new_with_free_func(frame_check_free);
+		g_ptr_array_add(df->frame_checks, check);
+	}
+}
+
+static bool
+frame_check_compare(const frame_check_t *check)
+{
+	switch (check->op) {
+		case STNODE_OP_ALL_EQ:
+		case STNODE_OP_ANY_EQ:
+			return fvalue_eq(check->frame_value, check->value);
+		case STNODE_OP_ALL_NE:
+		case STNODE_OP_ANY_NE:
+			return fvalue_ne(check->frame_value, check->value);
+		case STNODE_OP_GT:
+			return fvalue_gt(check->frame_value, check->value);
+		case STNODE_OP_GE:
+			return fvalue_ge(check->frame_value, check->value);
+		case STNODE_OP_LT:
+			return fvalue_lt(check->frame_value, check->value);
+		case STNODE_OP_LE:
+			return fvalue_le(check->frame_value, check->value);
+		default:
+			ASSERT_STNODE_OP_NOT_REACHED(check->op);
+	}
+	return true;
+}
+
 static void free_refs_array(void *data)
 {
 	/* Array data must be freed. */
@@ -484,11 +667,15 @@ dfwork_build(dfwork_t *dfw)
 		tree_str = dump_syntax_tree_str(dfw->st_root);
 	}
 
+	/* Code generation takes the constants out of the syntax tree,
+	 * so copy those the frame checks need first. */
+	dfilter = dfilter_new(dfw->deprecated);
+	dfw_frame_checks(dfw, dfilter);
+
 	/* Create bytecode */
 	dfw_gencode(dfw);
 
 	/* Tuck away the bytecode in the dfilter_t */
-	dfilter = dfilter_new(dfw->deprecated);
 	dfilter->insns = dfw->insns;
 	dfw->insns = NULL;
 	dfilter->interesting_fields = dfw_interesting_fields(dfw,
@@ -772,6 +959,59 @@ dfilter_requires_columns(const dfilter_t *df)
 	return dfilter_interested_in_proto(df, proto_cols);
 }
 
+bool
+dfilter_has_frame_checks(const dfilter_t *df)
+{
+	return df != NULL && df->frame_checks != NULL;
+}
+
+bool
+dfilter_apply_frame_checks(const dfilter_t *df, const frame_data *fd, const wtap_rec *rec)
+{
+	frame_check_t	*check;
+
+	if (df == NULL || df->frame_checks == NULL)
+		return true;
+
+	for (unsigned i = 0; i < df->frame_checks->len; i++) {
+		check = g_ptr_array_index(df->frame_checks, i);
+
+		/* Set the field the way the frame dissector would. A field
+		 * it wouldn't add fails any comparison. */
+		switch (check->field) {
+			case FRAME_CHECK_NUMBER:
+				fvalue_set_uinteger(check->frame_value, fd->num);
+				break;
+			case FRAME_CHECK_LEN:
+				fvalue_set_uinteger(check->frame_value,
+						fd->pkt_len > INT_MAX ? INT_MAX : fd->pkt_len);
+				break;
+			case FRAME_CHECK_CAP_LEN:
+				fvalue_set_uinteger(check->frame_value, fd->cap_len);
+				break;
+			case FRAME_CHECK_TIME:
+				if (!fd->has_ts)
+					return false;
+				fvalue_set_time(check->frame_value, &fd->abs_ts);
+				break;
+			case FRAME_CHECK_INTERFACE_ID:
+				if (rec == NULL)
+					continue;
+				/* Only packet records have an interface. */
+				if (rec->rec_type != REC_TYPE_PACKET ||
+						!(rec->presence_flags & WTAP_HAS_INTERFACE_ID))
+					return false;
+				fvalue_set_uinteger(check->frame_value,
+						rec->rec_header.packet_header.interface_id);
+				break;
+		}
+
+		if (!frame_check_compare(check))
+			return false;
+	}
+	return true;
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
@@ -155,6 +155,7 @@ dfilter_has_interesting_fields(const dfilter_t *df);
  * @param hfid The header field info ID to check
  * @return true if the field is interesting to the dfilter
  */
+WS_DLL_PUBLIC
 bool
 dfilter_interested_in_field(const dfilter_t *df, int hfid);
 
@@ -172,6 +173,27 @@ WS_DLL_PUBLIC
 bool
 dfilter_requires_columns(const dfilter_t *df);
 
+/* Check if some of the dfilter's tests only compare fields of the
+ * "frame" protocol that are set from the frame_data and the record
+ * (frame.number, frame.len, frame.cap_len, frame.time and
+ * frame.interface_id) with constants, so that they can be made with
+ * dfilter_apply_frame_checks() before the packet is dissected. */
+WS_DLL_PUBLIC
+bool
+dfilter_has_frame_checks(const dfilter_t *df);
+
+/* Make the dfilter's frame checks.
+ *
+ * @param df The dfilter
+ * @param fd The frame_data of the packet
+ * @param rec The packet's record, or NULL if it isn't at hand
+ * @return false if the packet can't match the dfilter, so that it
+ * needn't be dissected to apply it, true if it might
+ */
+WS_DLL_PUBLIC
+bool
+dfilter_apply_frame_checks(const dfilter_t *df, const frame_data *fd, const wtap_rec *rec);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
@@ -57,6 +57,10 @@ dfvm_opcode_tostr(dfvm_opcode_t code)
 		case DFVM_SET_ADD:		return "SET_ADD";
 		case DFVM_SET_ADD_RANGE:	return "SET_ADD_RANGE";
 		case DFVM_SET_CLEAR:		return "SET_CLEAR";
+		case DFVM_LOOKUP_ALL_IN:	return "LOOKUP_ALL_IN";
+		case DFVM_LOOKUP_ANY_IN:	return "LOOKUP_ANY_IN";
+		case DFVM_LOOKUP_ALL_NOT_IN:	return "LOOKUP_ALL_NOT_IN";
+		case DFVM_LOOKUP_ANY_NOT_IN:	return "LOOKUP_ANY_NOT_IN";
 		case DFVM_SLICE:		return "SLICE";
 		case DFVM_LENGTH:		return "LENGTH";
 		case DFVM_VALUE_STRING:		return "VALUE_STRING";
@@ -76,6 +80,9 @@ dfvm_opcode_tostr(dfvm_opcode_t code)
 	return "(fix-opcode-string)";
 }
 
+static void
+dfvm_set_free(dfvm_set_t *set);
+
 static void
 dfvm_value_free(dfvm_value_t *v)
 {
@@ -89,6 +96,9 @@ dfvm_value_free(dfvm_value_t *v)
 		case PCRE:
 			ws_regex_free(v->value.pcre);
 			break;
+		case FVALUE_SET:
+			dfvm_set_free(v->value.set);
+			break;
 		case EMPTY:
 		case HFINFO:
 		case RAW_HFINFO:
@@ -240,6 +250,318 @@ dfvm_value_new_uint(unsigned num)
 	return v;
 }
 
+/*
+ * Sets of constant values are indexed when the filter is compiled so that
+ * membership tests don't need to compare every element of the set:
+ *
+ *  - single values of types where equality matches the hash function
+ *    go in a hash table;
+ *  - ranges (and single values, including IP subnets, of types that are
+ *    totally ordered but can't be hashed) are merged into a sorted array
+ *    of disjoint intervals that is binary searched;
+ *  - anything else is tested one by one, as before.
+ */
+
+typedef struct {
+	fvalue_t	*low;
+	fvalue_t	*high;	/* NULL for a single value */
+} set_range_t;
+
+struct _dfvm_set {
+	ftenum_t	ftype;		/* Type of the first value */
+	bool		mixed;		/* Values of more than one type */
+	GPtrArray	*values;	/* Owns all the values */
+	GArray		*elements;	/* set_range_t, in filter order */
+	GHashTable	*hashed;	/* Single values */
+	GArray		*ranges;	/* set_range_t, sorted and disjoint */
+	GArray		*linear;	/* set_range_t, tested one by one */
+};
+
+dfvm_set_t*
+dfvm_set_new(void)
+{
+	dfvm_set_t *set = g_new0(dfvm_set_t, 1);
+	set->ftype = FT_NONE;
+	set->values = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
+	set->elements = g_array_new(false, false, sizeof(set_range_t));
+	return set;
+}
+
+static void
+dfvm_set_free(dfvm_set_t *set)
+{
+	if (set->hashed)
+		g_hash_table_destroy(set->hashed);
+	if (set->ranges)
+		g_array_free(set->ranges, true);
+	if (set->linear)
+		g_array_free(set->linear, true);
+	g_array_free(set->elements, true);
+	g_ptr_array_free(set->values, true);
+	g_free(set);
+}
+
+static void
+set_take_value(dfvm_set_t *set, fvalue_t *fv)
+{
+	ftenum_t ftype = fvalue_type_ftenum(fv);
+
+	if (set->values->len == 0)
+		set->ftype = ftype;
+	else if (ftype != set->ftype)
+		set->mixed = true;
+	g_ptr_array_add(set->values, fv);
+}
+
+void
+dfvm_set_add(dfvm_set_t *set, fvalue_t *fv)
+{
+	set_range_t elem = { fv, NULL };
+
+	set_take_value(set, fv);
+	g_array_append_val(set->elements, elem);
+}
+
+void
+dfvm_set_add_range(dfvm_set_t *set, fvalue_t *low, fvalue_t *high)
+{
+	set_range_t elem = { low, high };
+
+	set_take_value(set, low);
+	set_take_value(set, high);
+	g_array_append_val(set->elements, elem);
+}
+
+/* Returns true if the value is a single address (not a subnet) or isn't an
+ * address. Comparisons between subnets use the shortest prefix, so they
+ * can't be hashed or ordered. */
+static bool
+set_value_is_host(const fvalue_t *fv)
+{
+	switch (fvalue_type_ftenum(fv)) {
+		case FT_IPv4:
+			return fvalue_get_ipv4((fvalue_t *)fv)->nmask == 0xffffffff;
+		case FT_IPv6:
+			return fvalue_get_ipv6((fvalue_t *)fv)->prefix == 128;
+		default:
+			break;
+	}
+	return true;
+}
+
+/* Types where two values compare equal if and only if they hash the same. */
+static bool
+set_value_is_hashable(const fvalue_t *fv)
+{
+	ftenum_t ftype = fvalue_type_ftenum(fv);
+
+	if (FT_IS_INTEGER(ftype) || FT_IS_STRING(ftype))
+		return true;
+	switch (ftype) {
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+		case FT_ETHER:
+		case FT_GUID:
+			return true;
+		case FT_IPv4:
+		case FT_IPv6:
+			return set_value_is_host(fv);
+		default:
+			break;
+	}
+	return false;
+}
+
+/* Types with a total order. */
+static bool
+set_value_is_ordered(const fvalue_t *fv)
+{
+	ftenum_t ftype = fvalue_type_ftenum(fv);
+
+	if (FT_IS_INTEGER(ftype) || FT_IS_TIME(ftype))
+		return true;
+	if (FT_IS_FLOATING(ftype))
+		/* NaN isn't equal to itself. */
+		return fvalue_eq(fv, fv) == FT_TRUE;
+	return ftype == FT_IPv4 || ftype == FT_IPv6;
+}
+
+static unsigned
+set_value_hash(const void *key)
+{
+	return fvalue_hash(key);
+}
+
+static gboolean
+set_value_equal(const void *a, const void *b)
+{
+	return fvalue_eq(a, b) == FT_TRUE;
+}
+
+static int
+set_value_cmp(const fvalue_t *a, const fvalue_t *b)
+{
+	if (fvalue_lt(a, b) == FT_TRUE)
+		return -1;
+	if (fvalue_gt(a, b) == FT_TRUE)
+		return 1;
+	return 0;
+}
+
+static int
+set_range_cmp(const void *a, const void *b)
+{
+	return set_value_cmp(((const set_range_t *)a)->low,
+				((const set_range_t *)b)->low);
+}
+
+/* Converts an IP subnet to the range of host addresses it contains. */
+static set_range_t
+set_subnet_to_range(dfvm_set_t *set, fvalue_t *fv)
+{
+	set_range_t range;
+
+	if (fvalue_type_ftenum(fv) == FT_IPv4) {
+		const ipv4_addr_and_mask *net = fvalue_get_ipv4(fv);
+		ipv4_addr_and_mask low, high;
+
+		low.addr = net->addr & net->nmask;
+		low.nmask = 0xffffffff;
+		high.addr = net->addr | ~net->nmask;
+		high.nmask = 0xffffffff;
+		range.low = fvalue_new(FT_IPv4);
+		fvalue_set_ipv4(range.low, &low);
+		range.high = fvalue_new(FT_IPv4);
+		fvalue_set_ipv4(range.high, &high);
+	}
+	else {
+		const ipv6_addr_and_prefix *net = fvalue_get_ipv6(fv);
+		ipv6_addr_and_prefix low, high;
+		uint32_t prefix = MIN(net->prefix, 128);
+		uint8_t mask;
+
+		for (unsigned i = 0; i < 16; i++) {
+			if (prefix >= 8 * (i + 1))
+				mask = 0xff;
+			else if (prefix <= 8 * i)
+				mask = 0x00;
+			else
+				mask = (uint8_t)(0xff << (8 - (prefix - 8 * i)));
+			low.addr.bytes[i] = net->addr.bytes[i] & mask;
+			high.addr.bytes[i] = net->addr.bytes[i] | (uint8_t)~mask;
+		}
+		low.prefix = 128;
+		high.prefix = 128;
+		range.low = fvalue_new(FT_IPv6);
+		fvalue_set_ipv6(range.low, &low);
+		range.high = fvalue_new(FT_IPv6);
+		fvalue_set_ipv6(range.high, &high);
+	}
+	/* Owned by the set. */
+	g_ptr_array_add(set->values, range.low);
+	g_ptr_array_add(set->values, range.high);
+	return range;
+}
+
+static void
+set_build_index(dfvm_set_t *set)
+{
+	set_range_t *elem, range;
+	unsigned i, j;
+
+	if (set->mixed) {
+		/* No index, every element is compared. */
+		return;
+	}
+
+	set->hashed = g_hash_table_new(set_value_hash, set_value_equal);
+	set->ranges = g_array_new(false, false, sizeof(set_range_t));
+	set->linear = g_array_new(false, false, sizeof(set_range_t));
+
+	for (i = 0; i < set->elements->len; i++) {
+		elem = &g_array_index(set->elements, set_range_t, i);
+		if (elem->high == NULL) {
+			if (set_value_is_hashable(elem->low)) {
+				g_hash_table_add(set->hashed, elem->low);
+			}
+			else if (set_value_is_ordered(elem->low)) {
+				if (set_value_is_host(elem->low)) {
+					range.low = elem->low;
+					range.high = elem->low;
+				}
+				else {
+					range = set_subnet_to_range(set, elem->low);
+				}
+				g_array_append_val(set->ranges, range);
+			}
+			else {
+				g_array_append_val(set->linear, *elem);
+			}
+		}
+		else if (set_value_is_ordered(elem->low) && set_value_is_host(elem->low) &&
+				set_value_is_ordered(elem->high) && set_value_is_host(elem->high)) {
+			/* An empty range never matches. */
+			if (set_value_cmp(elem->low, elem->high) <= 0) {
+				g_array_append_val(set->ranges, *elem);
+			}
+		}
+		else {
+			g_array_append_val(set->linear, *elem);
+		}
+	}
+
+	/* Sort the ranges and merge those that overlap. */
+	g_array_sort(set->ranges, set_range_cmp);
+	for (i = 0, j = 0; i < set->ranges->len; i++) {
+		elem = &g_array_index(set->ranges, set_range_t, i);
+		if (j > 0) {
+			set_range_t *last = &g_array_index(set->ranges, set_range_t, j - 1);
+			if (set_value_cmp(elem->low, last->high) <= 0) {
+				if (set_value_cmp(elem->high, last->high) > 0)
+					last->high = elem->high;
+				continue;
+			}
+		}
+		g_array_index(set->ranges, set_range_t, j) = *elem;
+		j++;
+	}
+	g_array_set_size(set->ranges, j);
+}
+
+dfvm_value_t*
+dfvm_value_new_set(dfvm_set_t *set)
+{
+	dfvm_value_t *v = dfvm_value_new(FVALUE_SET);
+	set_build_index(set);
+	v->value.set = set;
+	return v;
+}
+
+static char *
+set_tostr(dfvm_set_t *set)
+{
+	wmem_strbuf_t	*buf;
+	set_range_t	*elem;
+	char		*s;
+
+	buf = wmem_strbuf_new(NULL, "{");
+	for (unsigned i = 0; i < set->elements->len; i++) {
+		elem = &g_array_index(set->elements, set_range_t, i);
+		if (i > 0)
+			wmem_strbuf_append(buf, ", ");
+		s = fvalue_to_debug_repr(NULL, elem->low);
+		wmem_strbuf_append(buf, s);
+		g_free(s);
+		if (elem->high) {
+			s = fvalue_to_debug_repr(NULL, elem->high);
+			wmem_strbuf_append_printf(buf, " .. %s", s);
+			g_free(s);
+		}
+	}
+	wmem_strbuf_append_c(buf, '}');
+	return wmem_strbuf_finalize(buf);
+}
+
 static char *
 dfvm_value_tostr(dfvm_value_t *v)
 {
@@ -264,6 +586,9 @@ dfvm_value_tostr(dfvm_value_t *v)
 		case PCRE:
 			s = ws_strdup(ws_regex_pattern(v->value.pcre));
 			break;
+		case FVALUE_SET:
+			s = set_tostr(v->value.set);
+			break;
 		case REGISTER:
 			s = ws_strdup_printf("R%"PRIu32, v->value.numeric);
 			break;
@@ -301,6 +626,9 @@ value_type_tostr(dfvm_value_t *v, bool show_ftype)
 		case FVALUE:
 			s = fvalue_type_name(dfvm_value_get_fvalue(v));
 			break;
+		case FVALUE_SET:
+			s = ftype_name(v->value.set->ftype);
+			break;
 		case FUNCTION_DEF:
 			if (v->value.funcdef->return_ftype != FT_NONE)
 				s = ftype_name(v->value.funcdef->return_ftype);
@@ -558,6 +886,18 @@ append_op_args(wmem_strbuf_t *buf, dfvm_insn_t *insn, GSList **stack_print,
 			wmem_strbuf_append_printf(buf, "%s%s", arg1_str, arg1_str_type);
 			break;
 
+		case DFVM_LOOKUP_ALL_IN:
+		case DFVM_LOOKUP_ANY_IN:
+			wmem_strbuf_append_printf(buf, "%s%s in %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
+		case DFVM_LOOKUP_ALL_NOT_IN:
+		case DFVM_LOOKUP_ANY_NOT_IN:
+			wmem_strbuf_append_printf(buf, "%s%s not in %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
 		case DFVM_SET_ADD_RANGE:
 			wmem_strbuf_append_printf(buf, "%s%s .. %s%s",
 						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
@@ -1240,6 +1580,98 @@ all_in(dfilter_t *df, dfvm_value_t *arg1)
 	return true;
 }
 
+static bool
+set_contains_linear(GArray *elements, fvalue_t *fv)
+{
+	set_range_t *elem;
+
+	for (unsigned i = 0; i < elements->len; i++) {
+		elem = &g_array_index(elements, set_range_t, i);
+		if (elem->high) {
+			if (fvalue_ge(fv, elem->low) == FT_TRUE &&
+					fvalue_le(fv, elem->high) == FT_TRUE) {
+				return true;
+			}
+		}
+		else if (fvalue_eq(fv, elem->low) == FT_TRUE) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+set_contains(dfvm_set_t *set, fvalue_t *fv)
+{
+	GArray *ranges;
+	unsigned lo, hi, mid;
+
+	if (set->mixed || fvalue_type_ftenum(fv) != set->ftype ||
+					!set_value_is_host(fv)) {
+		/* The index can't be used, compare everything. */
+		return set_contains_linear(set->elements, fv);
+	}
+
+	if (g_hash_table_contains(set->hashed, fv)) {
+		return true;
+	}
+
+	/* Find the last range starting at or below the value. */
+	ranges = set->ranges;
+	lo = 0;
+	hi = ranges->len;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (fvalue_le(g_array_index(ranges, set_range_t, mid).low, fv) == FT_TRUE)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo > 0 && fvalue_le(fv, g_array_index(ranges, set_range_t, lo - 1).high) == FT_TRUE) {
+		return true;
+	}
+
+	return set_contains_linear(set->linear, fv);
+}
+
+static bool
+any_in_set(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
+{
+	df_cell_t *rp = &df->registers[arg1->value.numeric];
+	dfvm_set_t *set = arg2->value.set;
+	GPtrArray *value;
+
+	/* If the read failed we jump over the membership test. */
+	ws_assert(!df_cell_is_empty(rp));
+	value = df_cell_ptr(rp);
+
+	for (size_t i = 0; i < value->len; i++) {
+		if (set_contains(set, value->pdata[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+all_in_set(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
+{
+	df_cell_t *rp = &df->registers[arg1->value.numeric];
+	dfvm_set_t *set = arg2->value.set;
+	GPtrArray *value;
+
+	/* If the read failed we jump over the membership test. */
+	ws_assert(!df_cell_is_empty(rp));
+	value = df_cell_ptr(rp);
+
+	for (size_t i = 0; i < value->len; i++) {
+		if (!set_contains(set, value->pdata[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
 /* Clear registers that were populated during evaluation.
  * If we created the values, then these will be freed as well. */
 static void
@@ -1844,6 +2276,22 @@ dfvm_apply_full(dfilter_t *df, proto_tree *tree, GPtrArray **fvals)
 				set_clear(df);
 				break;
 
+			case DFVM_LOOKUP_ALL_IN:
+				accum = all_in_set(df, arg1, arg2);
+				break;
+
+			case DFVM_LOOKUP_ANY_IN:
+				accum = any_in_set(df, arg1, arg2);
+				break;
+
+			case DFVM_LOOKUP_ALL_NOT_IN:
+				accum = !all_in_set(df, arg1, arg2);
+				break;
+
+			case DFVM_LOOKUP_ANY_NOT_IN:
+				accum = !any_in_set(df, arg1, arg2);
+				break;
+
 			case DFVM_UNARY_MINUS:
 				mk_minus(df, arg1, arg2);
 				break;
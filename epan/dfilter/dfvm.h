@@ -30,8 +30,13 @@ typedef enum {
 	DRANGE,
 	FUNCTION_DEF,
 	PCRE,
+	FVALUE_SET,
 } dfvm_value_type_t;
 
+/* A set of constant values (and ranges of values) indexed for fast
+ * membership tests. */
+typedef struct _dfvm_set dfvm_set_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -42,6 +47,7 @@ typedef struct {
 		header_field_info	*hfinfo;
 		df_func_def_t		*funcdef;
 		ws_regex_t		*pcre;
+		dfvm_set_t		*set;
 	} value;
 
 	int ref_count;
@@ -85,6 +91,10 @@ typedef enum {
 	DFVM_SET_ADD,
 	DFVM_SET_ADD_RANGE,
 	DFVM_SET_CLEAR,
+	DFVM_LOOKUP_ALL_IN,
+	DFVM_LOOKUP_ANY_IN,
+	DFVM_LOOKUP_ALL_NOT_IN,
+	DFVM_LOOKUP_ANY_NOT_IN,
 	DFVM_SLICE,
 	DFVM_LENGTH,
 	DFVM_VALUE_STRING,
@@ -152,6 +162,21 @@ dfvm_value_new_pcre(ws_regex_t *re);
 dfvm_value_t*
 dfvm_value_new_uint(unsigned num);
 
+dfvm_set_t*
+dfvm_set_new(void);
+
+/* The set takes ownership of the values. */
+void
+dfvm_set_add(dfvm_set_t *set, fvalue_t *fv);
+
+void
+dfvm_set_add_range(dfvm_set_t *set, fvalue_t *low, fvalue_t *high);
+
+/* Builds the lookup index and takes ownership of the set. No more
+ * values can be added after this. */
+dfvm_value_t*
+dfvm_value_new_set(dfvm_set_t *set);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df, uint16_t flags);
 
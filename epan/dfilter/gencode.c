@@ -45,6 +45,8 @@ select_opcode(dfvm_opcode_t op, stmatch_t how)
 		case DFVM_ALL_MATCHES:
 		case DFVM_SET_ALL_IN:
 		case DFVM_SET_ALL_NOT_IN:
+		case DFVM_LOOKUP_ALL_IN:
+		case DFVM_LOOKUP_ALL_NOT_IN:
 			return how == STNODE_MATCH_ALL ? op : op + 1;
 		case DFVM_ANY_EQ:
 		case DFVM_ANY_NE:
@@ -56,6 +58,8 @@ select_opcode(dfvm_opcode_t op, stmatch_t how)
 		case DFVM_ANY_MATCHES:
 		case DFVM_SET_ANY_IN:
 		case DFVM_SET_ANY_NOT_IN:
+		case DFVM_LOOKUP_ANY_IN:
+		case DFVM_LOOKUP_ANY_NOT_IN:
 			return how == STNODE_MATCH_ANY ? op : op - 1;
 		default:
 			ASSERT_DFVM_OP_NOT_REACHED(op);
@@ -459,6 +463,53 @@ fixup_jumps(void *data, void *user_data)
 	}
 }
 
+/* Returns true if every element of the set is a constant value. */
+static bool
+set_is_constant(GSList *nodelist)
+{
+	stnode_t	*node;
+
+	while (nodelist) {
+		node = nodelist->data;
+		if (node != NULL && stnode_type_id(node) != STTYPE_FVALUE) {
+			return false;
+		}
+		nodelist = g_slist_next(nodelist);
+	}
+	return true;
+}
+
+/* Generate the code for the in operator when the set only contains
+ * constants. The set is built here and indexed, so membership is
+ * evaluated in a single instruction without a set stack. */
+static void
+gen_relation_in_lookup(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
+				dfvm_value_t *val1, GSList *nodelist)
+{
+	dfvm_set_t	*set;
+	stnode_t	*node1, *node2;
+
+	set = dfvm_set_new();
+	while (nodelist) {
+		node1 = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+		node2 = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+
+		if (node2) {
+			/* Range element. */
+			dfvm_set_add_range(set, stnode_steal_data(node1),
+						stnode_steal_data(node2));
+		} else {
+			/* Normal element. */
+			dfvm_set_add(set, stnode_steal_data(node1));
+		}
+	}
+
+	gen_relation_insn(dfw, select_opcode(op, how), val1,
+					dfvm_value_new_set(set), NULL);
+}
+
 /* Generate the code for the in operator. Pushes set values into a stack
  * and then evaluates membership in a single instruction. */
 static void
@@ -475,8 +526,21 @@ gen_relation_in(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
 	/* Create code for the LHS of the relation */
 	val1 = gen_entity(dfw, st_arg1, &jumps);
 
-	/* Create code to populate the set stack */
 	nodelist_head = nodelist = stnode_steal_data(st_arg2);
+
+	if (set_is_constant(nodelist_head)) {
+		gen_relation_in_lookup(dfw,
+				op == DFVM_SET_ANY_IN ? DFVM_LOOKUP_ANY_IN : DFVM_LOOKUP_ANY_NOT_IN,
+				how, val1, nodelist_head);
+		set_nodelist_free(nodelist_head);
+
+		/* Jump here if the LHS entity was not present */
+		g_slist_foreach(jumps, fixup_jumps, dfw);
+		g_slist_free(jumps);
+		return;
+	}
+
+	/* Create code to populate the set stack */
 	while (nodelist) {
 		node1 = nodelist->data;
 		nodelist = g_slist_next(nodelist);
@@ -2102,6 +2102,210 @@ semcheck(dfwork_t *dfw, stnode_t *st_node)
 	}
 }
 
+/*
+ * Rough relative cost of evaluating a node, used to decide in which
+ * order the operands of "and" and "or" are tested. Reading a field
+ * from the tree is the baseline; comparing integers is cheaper than
+ * comparing strings or byte arrays, and matching a regular expression
+ * or calling a function is more expensive than either.
+ */
+#define COST_READ		1
+#define COST_CMP_INTEGER	1
+#define COST_CMP_OTHER		3
+#define COST_MATCHES		16
+#define COST_FUNCTION		16
+
+static unsigned
+estimate_cost(stnode_t *st_node);
+
+static unsigned
+compare_cost(stnode_t *st_arg)
+{
+	ftenum_t ftype;
+
+	switch (stnode_type_id(st_arg)) {
+		case STTYPE_FIELD:
+			ftype = sttype_field_ftenum(st_arg);
+			break;
+		case STTYPE_FVALUE:
+			ftype = fvalue_type_ftenum(stnode_data(st_arg));
+			break;
+		default:
+			return COST_CMP_OTHER;
+	}
+
+	if (FT_IS_INTEGER(ftype) || ftype == FT_BOOLEAN || ftype == FT_CHAR ||
+			ftype == FT_FRAMENUM || ftype == FT_IPv4)
+		return COST_CMP_INTEGER;
+	return COST_CMP_OTHER;
+}
+
+static unsigned
+estimate_cost(stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	unsigned	cost;
+
+	switch (stnode_type_id(st_node)) {
+		case STTYPE_FIELD:
+		case STTYPE_REFERENCE:
+			return COST_READ;
+		case STTYPE_SLICE:
+			return estimate_cost(sttype_slice_entity(st_node)) + COST_READ;
+		case STTYPE_FUNCTION:
+			cost = COST_FUNCTION;
+			for (GSList *l = sttype_function_params(st_node); l != NULL; l = l->next)
+				cost += estimate_cost(l->data);
+			return cost;
+		case STTYPE_SET:
+			/* Each element of the set is a (lower, upper) pair. */
+			return g_slist_length(stnode_data(st_node)) / 2 * COST_CMP_OTHER;
+		case STTYPE_ARITHMETIC:
+		case STTYPE_TEST:
+			break;
+		default:
+			/* Constants. */
+			return 0;
+	}
+
+	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case STNODE_OP_NOT:
+		case STNODE_OP_UNARY_MINUS:
+			return estimate_cost(st_arg1);
+		case STNODE_OP_AND:
+		case STNODE_OP_OR:
+			return estimate_cost(st_arg1) + estimate_cost(st_arg2);
+		case STNODE_OP_MATCHES:
+			return estimate_cost(st_arg1) + COST_MATCHES;
+		case STNODE_OP_IN:
+		case STNODE_OP_NOT_IN:
+			return estimate_cost(st_arg1) + estimate_cost(st_arg2);
+		case STNODE_OP_CONTAINS:
+			return estimate_cost(st_arg1) + estimate_cost(st_arg2) + COST_CMP_OTHER;
+		case STNODE_OP_ALL_EQ:
+		case STNODE_OP_ANY_EQ:
+		case STNODE_OP_ALL_NE:
+		case STNODE_OP_ANY_NE:
+		case STNODE_OP_GT:
+		case STNODE_OP_GE:
+		case STNODE_OP_LT:
+		case STNODE_OP_LE:
+			return estimate_cost(st_arg1) + estimate_cost(st_arg2) +
+				MAX(compare_cost(st_arg1), compare_cost(st_arg2));
+		case STNODE_OP_BITWISE_AND:
+		case STNODE_OP_ADD:
+		case STNODE_OP_SUBTRACT:
+		case STNODE_OP_MULTIPLY:
+		case STNODE_OP_DIVIDE:
+		case STNODE_OP_MODULO:
+			return estimate_cost(st_arg1) + estimate_cost(st_arg2) + COST_CMP_INTEGER;
+		case STNODE_OP_UNINITIALIZED:
+			break;
+	}
+	ASSERT_STNODE_OP_NOT_REACHED(st_op);
+}
+
+typedef struct {
+	stnode_t	*node;
+	unsigned	cost;
+} operand_cost_t;
+
+static int
+compare_operand_cost(const void *a, const void *b)
+{
+	const operand_cost_t *oa = a, *ob = b;
+
+	if (oa->cost < ob->cost)
+		return -1;
+	return oa->cost > ob->cost;
+}
+
+/* Collect the operands of a chain of the same logical operator, and
+ * the operator nodes themselves, from left to right. */
+static void
+flatten_logical(stnode_t *st_node, stnode_op_t op, GArray *operands, GPtrArray *opers)
+{
+	stnode_t	*st_arg1, *st_arg2;
+	operand_cost_t	operand;
+
+	if (stnode_type_id(st_node) == STTYPE_TEST &&
+			sttype_oper_get_op(st_node) == op) {
+		sttype_oper_get(st_node, NULL, &st_arg1, &st_arg2);
+		g_ptr_array_add(opers, st_node);
+		flatten_logical(st_arg1, op, operands, opers);
+		flatten_logical(st_arg2, op, operands, opers);
+		return;
+	}
+
+	operand.node = st_node;
+	operand.cost = 0;
+	g_array_append_val(operands, operand);
+}
+
+/* Reorder the operands of "and" and "or" so that the cheaper tests
+ * come first. Both operators short-circuit and have no side-effects,
+ * so the result is the same, but an expensive test is skipped
+ * whenever a cheap one decides the outcome. The sort is stable, so
+ * operands of equal cost keep the order they were written in. */
+static void
+reorder_by_cost(dfwork_t *dfw, stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	GArray		*operands;
+	GPtrArray	*opers;
+	stnode_t	*st_acc;
+	operand_cost_t	*operand;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return;
+
+	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	if (st_op == STNODE_OP_NOT) {
+		reorder_by_cost(dfw, st_arg1);
+		return;
+	}
+	if (st_op != STNODE_OP_AND && st_op != STNODE_OP_OR)
+		return;
+
+	operands = g_array_new(false, false, sizeof(operand_cost_t));
+	opers = g_ptr_array_new();
+	flatten_logical(st_node, st_op, operands, opers);
+	ws_assert(opers->len + 1 == operands->len);
+
+	for (unsigned i = 0; i < operands->len; i++) {
+		operand = &g_array_index(operands, operand_cost_t, i);
+		reorder_by_cost(dfw, operand->node);
+		operand->cost = estimate_cost(operand->node);
+	}
+	g_array_sort(operands, compare_operand_cost);
+
+	/* Rebuild the chain left-associative, reusing the operator nodes
+	 * and keeping st_node as its root. */
+	st_acc = g_array_index(operands, operand_cost_t, 0).node;
+	for (unsigned i = 1; i < operands->len; i++) {
+		stnode_t *st_oper = g_ptr_array_index(opers, opers->len - i);
+		sttype_oper_set2_args(st_oper, st_acc,
+				g_array_index(operands, operand_cost_t, i).node);
+		st_acc = st_oper;
+	}
+	ws_assert(st_acc == st_node);
+
+	if (ws_log_msg_is_active(LOG_DOMAIN_DFILTER, LOG_LEVEL_NOISY)) {
+		for (unsigned i = 0; i < operands->len; i++) {
+			operand = &g_array_index(operands, operand_cost_t, i);
+			ws_noisy("%s operand %u: cost %u, %s", stnode_todisplay(st_node),
+					i, operand->cost, stnode_todisplay(operand->node));
+		}
+	}
+
+	g_array_free(operands, true);
+	g_ptr_array_free(opers, true);
+}
 
 /* Check the syntax tree for semantic errors, and convert
  * some of the nodes into the form they need to be in order to
@@ -2124,6 +2328,10 @@ dfw_semcheck(dfwork_t *dfw)
 	}
 	ENDTRY;
 
+	if (ok_filter && (dfw->flags & DF_OPTIMIZE)) {
+		reorder_by_cost(dfw, dfw->st_root);
+	}
+
 	ws_debug("Semantic check (dfw = %p) returns %s",
 			dfw, ok_filter ? "TRUE" : "FALSE");
 
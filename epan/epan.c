@@ -110,7 +110,10 @@
 static GSList *epan_plugin_register_all_procotols;
 static GSList *epan_plugin_register_all_handoffs;
 
-static wmem_allocator_t *pinfo_pool_cache;
+/* A packet scope pool kept for the next packet dissected by the same
+ * thread, so that threads dissecting in parallel each reuse their own
+ * pool (and its blocks) instead of creating one per packet. */
+static GPrivate pinfo_pool_cache = G_PRIVATE_INIT((GDestroyNotify)wmem_destroy_allocator);
 
 /* Global variables holding the content of the corresponding environment variable
  * to save fetching it repeatedly.
@@ -448,10 +451,7 @@ epan_cleanup(void)
 
 	dfilter_translator_cleanup();
 
-	if (pinfo_pool_cache != NULL) {
-		wmem_destroy_allocator(pinfo_pool_cache);
-		pinfo_pool_cache = NULL;
-	}
+	g_private_replace(&pinfo_pool_cache, NULL);
 
 	wmem_cleanup_scopes();
 
@@ -564,9 +564,9 @@ epan_dissect_init(epan_dissect_t *edt, epan_t *session, const bool create_proto_
 	edt->session = session;
 
 	memset(&edt->pi, 0, sizeof(edt->pi));
-	if (pinfo_pool_cache != NULL) {
-		edt->pi.pool = pinfo_pool_cache;
-		pinfo_pool_cache = NULL;
+	edt->pi.pool = (wmem_allocator_t *)g_private_get(&pinfo_pool_cache);
+	if (edt->pi.pool != NULL) {
+		g_private_set(&pinfo_pool_cache, NULL);
 	}
 	else {
 		edt->pi.pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
@@ -593,6 +593,8 @@ epan_dissect_reset(epan_dissect_t *edt)
 
 	ws_assert(edt);
 
+	col_fill_in_lazy_cleanup(edt->pi.cinfo);
+
 	wtap_block_unref(edt->pi.rec->block);
 
 	g_slist_free(edt->pi.proto_data);
@@ -705,6 +707,8 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 
 	g_slist_foreach(epan_plugins, epan_plugin_dissect_cleanup, edt);
 
+	col_fill_in_lazy_cleanup(edt->pi.cinfo);
+
 	g_slist_free(edt->pi.proto_data);
 
 	/* Free the data sources list. */
@@ -719,9 +723,9 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 		proto_tree_free(edt->tree);
 	}
 
-	if (pinfo_pool_cache == NULL) {
+	if (g_private_get(&pinfo_pool_cache) == NULL) {
 		wmem_free_all(edt->pi.pool);
-		pinfo_pool_cache = edt->pi.pool;
+		g_private_set(&pinfo_pool_cache, edt->pi.pool);
 	}
 	else {
 		wmem_destroy_allocator(edt->pi.pool);
@@ -775,6 +779,13 @@ epan_dissect_fill_in_columns(epan_dissect_t *edt, const bool fill_col_exprs, con
 	col_fill_in(&edt->pi, fill_col_exprs, fill_fd_colums);
 }
 
+void
+epan_dissect_fill_in_columns_lazy(epan_dissect_t *edt, const bool fill_col_exprs, const bool fill_fd_colums, const bool *needed)
+{
+	col_custom_set_edt_lazy(edt, edt->pi.cinfo, needed);
+	col_fill_in_lazy(&edt->pi, fill_col_exprs, fill_fd_colums, needed);
+}
+
 bool
 epan_dissect_packet_contains_field(epan_dissect_t* edt,
 				   const char *field_name)
@@ -246,6 +246,14 @@ WS_DLL_PUBLIC
 void
 epan_dissect_fill_in_columns(epan_dissect_t *edt, const bool fill_col_exprs, const bool fill_fd_colums);
 
+/** like epan_dissect_fill_in_columns(), but each column is only formatted
+ *  when its text is first asked for, which must be before the dissection
+ *  is reset or cleaned up; if needed isn't NULL, columns for which it's
+ *  false are left empty */
+WS_DLL_PUBLIC
+void
+epan_dissect_fill_in_columns_lazy(epan_dissect_t *edt, const bool fill_col_exprs, const bool fill_fd_colums, const bool *needed);
+
 /** Check whether a dissected packet contains a given named field */
 WS_DLL_PUBLIC
 bool
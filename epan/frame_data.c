@@ -20,6 +20,15 @@
 #include <wiretap/wtap.h>
 #include <wsutil/ws_assert.h>
 
+/* Fields that are set for few frames, if any; kept out of frame_data so
+   that the per-frame structure stays small. */
+struct _frame_data_cold {
+  GHashTable  *dependent_frames;     /* A hash table of frames which this one depends on */
+  nstime_t     shift_offset;         /* How much the abs_tm of the frame is shifted */
+};
+
+static const nstime_t zero_shift_offset = NSTIME_INIT_ZERO;
+
 #define COMPARE_FRAME_NUM()     ((fdata1->num < fdata2->num) ? -1 : \
                                  (fdata1->num > fdata2->num) ? 1 : \
                                  0)
@@ -160,7 +169,7 @@ frame_data_init(frame_data *fdata, uint32_t num, const wtap_rec *rec,
   fdata->file_off = offset;
   fdata->passed_dfilter = 1;
   fdata->dependent_of_displayed = 0;
-  fdata->dependent_frames = NULL;
+  fdata->cold = NULL;
   fdata->encoding = PACKET_CHAR_ENC_CHAR_ASCII;
   fdata->visited = 0;
   fdata->marked = 0;
@@ -231,8 +240,6 @@ frame_data_init(frame_data *fdata, uint32_t num, const wtap_rec *rec,
   fdata->has_modified_block = 0;
   fdata->need_colorize = 0;
   fdata->color_filter = NULL;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
   fdata->frame_ref_num = 0;
   fdata->prev_dis_num = 0;
 }
@@ -313,9 +320,16 @@ frame_data_reset(frame_data *fdata)
     fdata->pfd = NULL;
   }
 
-  if (fdata->dependent_frames) {
-    g_hash_table_destroy(fdata->dependent_frames);
-    fdata->dependent_frames = NULL;
+  if (fdata->cold) {
+    if (fdata->cold->dependent_frames) {
+      g_hash_table_destroy(fdata->cold->dependent_frames);
+      fdata->cold->dependent_frames = NULL;
+    }
+    /* The time shift survives a redissection; keep it if it's set. */
+    if (nstime_is_zero(&fdata->cold->shift_offset)) {
+      g_free(fdata->cold);
+      fdata->cold = NULL;
+    }
   }
 }
 
@@ -327,10 +341,54 @@ frame_data_destroy(frame_data *fdata)
     fdata->pfd = NULL;
   }
 
-  if (fdata->dependent_frames) {
-    g_hash_table_destroy(fdata->dependent_frames);
-    fdata->dependent_frames = NULL;
+  if (fdata->cold) {
+    if (fdata->cold->dependent_frames) {
+      g_hash_table_destroy(fdata->cold->dependent_frames);
+    }
+    g_free(fdata->cold);
+    fdata->cold = NULL;
+  }
+}
+
+static frame_data_cold *
+frame_data_get_cold(frame_data *fdata)
+{
+  if (!fdata->cold) {
+    fdata->cold = g_new0(frame_data_cold, 1);
+  }
+  return fdata->cold;
+}
+
+GHashTable *
+frame_data_get_dependent_frames(const frame_data *fdata)
+{
+  return fdata->cold ? fdata->cold->dependent_frames : NULL;
+}
+
+void
+frame_data_add_dependent_frame(frame_data *fdata, uint32_t frame_num)
+{
+  frame_data_cold *cold = frame_data_get_cold(fdata);
+
+  if (!cold->dependent_frames) {
+    cold->dependent_frames = g_hash_table_new(g_direct_hash, g_direct_equal);
+  }
+  g_hash_table_add(cold->dependent_frames, GUINT_TO_POINTER(frame_num));
+}
+
+const nstime_t *
+frame_data_get_shift_offset(const frame_data *fdata)
+{
+  return fdata->cold ? &fdata->cold->shift_offset : &zero_shift_offset;
+}
+
+void
+frame_data_set_shift_offset(frame_data *fdata, const nstime_t *shift_offset)
+{
+  if (!fdata->cold && nstime_is_zero(shift_offset)) {
+    return;
   }
+  frame_data_get_cold(fdata)->shift_offset = *shift_offset;
 }
 
 /*
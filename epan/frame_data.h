@@ -22,6 +22,7 @@ extern "C" {
 typedef struct wtap_rec wtap_rec;
 struct _packet_info;
 struct epan_session;
+typedef struct _frame_data_cold frame_data_cold;
 
 #define PINFO_FD_VISITED(pinfo)   ((pinfo)->fd->visited)
 
@@ -55,6 +56,13 @@ typedef enum {
    Try to keep it close to, and less than or equal to, a power of 2.
    "Smaller than a power of 2" is OK for ILP32 platforms.
 
+   Fields that are set for only a few frames, if any, are kept in a
+   separately allocated frame_data_cold structure, allocated only for
+   the frames that need it; use the accessor functions below for them.
+   color_filter isn't one of them: when packets are colorized, as they
+   are in the packet list, it's set for nearly every frame, so moving it
+   would allocate a frame_data_cold for nearly every frame too.
+
    XXX - shuffle the fields to try to keep the most commonly-accessed
    fields within the first 16 or 32 bytes, so they all fit in a cache
    line? */
@@ -66,15 +74,14 @@ typedef struct _frame_data {
   uint32_t     cap_len;      /**< Amount actually captured */
   uint32_t     cum_bytes;    /**< Cumulative bytes into the capture */
   int64_t      file_off;     /**< File offset */
-  /* These two are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
+  /* These are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
      LLP64 (64-bit Windows) platforms.  Put them here, one after the
      other, so they don't require padding between them. */
   GSList      *pfd;          /**< Per frame proto data */
-  GHashTable  *dependent_frames;     /**< A hash table of frames which this one depends on */
+  frame_data_cold *cold;     /**< Rarely-set fields, or NULL if none of them are set */
   const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
-  uint8_t      tcp_snd_manual_analysis;   /**< TCP SEQ Analysis Overriding, 0 = none, 1 = OOO, 2 = RET , 3 = Fast RET, 4 = Spurious RET  */
-  /* Keep the bitfields below to 24 bits, so this plus the previous field
-     are 32 bits. (XXX - The previous field could be a bitfield too.) */
+  /* Keep the bitfields below to 32 bits. */
+  unsigned int tcp_snd_manual_analysis : 3; /**< TCP SEQ Analysis Overriding, 0 = none, 1 = OOO, 2 = RET , 3 = Fast RET, 4 = Spurious RET  */
   unsigned int passed_dfilter   : 1; /**< 1 = display, 0 = no display */
   unsigned int dependent_of_displayed : 1; /**< 1 if a displayed frame depends on this frame */
   /* Do NOT use packet_char_enc enum here: MSVC compiler does not handle an enum in a bit field properly */
@@ -87,9 +94,8 @@ typedef struct _frame_data {
   unsigned int has_modified_block : 1; /** 1 = block for this packet has been modified */
   unsigned int need_colorize    : 1; /**< 1 = need to (re-)calculate packet color */
   unsigned int tsprec           : 4; /**< Time stamp precision -2^tsprec gives up to femtoseconds */
-  nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
   uint32_t     frame_ref_num; /**< Previous reference frame (0 if this is one) */
+  nstime_t     abs_ts;       /**< Absolute timestamp */
   uint32_t     prev_dis_num; /**< Previous displayed frame (0 if first one) */
 } frame_data;
 DIAG_ON_PEDANTIC
@@ -118,6 +124,27 @@ WS_DLL_PUBLIC void frame_data_set_before_dissect(frame_data *fdata,
 WS_DLL_PUBLIC void frame_data_set_after_dissect(frame_data *fdata,
                 uint32_t *cum_bytes);
 
+/**
+ * Returns a hash table of the frames on which this frame depends, or
+ * NULL if it doesn't depend on any.
+ */
+WS_DLL_PUBLIC GHashTable *frame_data_get_dependent_frames(const frame_data *fdata);
+
+/**
+ * Adds a frame to the set of frames on which this frame depends.
+ */
+WS_DLL_PUBLIC void frame_data_add_dependent_frame(frame_data *fdata, uint32_t frame_num);
+
+/**
+ * Returns how much the frame's time stamp has been shifted.
+ */
+WS_DLL_PUBLIC const nstime_t *frame_data_get_shift_offset(const frame_data *fdata);
+
+/**
+ * Sets how much the frame's time stamp has been shifted.
+ */
+WS_DLL_PUBLIC void frame_data_set_shift_offset(frame_data *fdata, const nstime_t *shift_offset);
+
 /** @} */
 
 #ifdef __cplusplus
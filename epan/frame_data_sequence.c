@@ -328,8 +328,8 @@ find_and_mark_frame_depended_upon(void *key, void *value _U_, void *user_data)
      */
     if (!(dependent_fd->dependent_of_displayed || dependent_fd->passed_dfilter)) {
       dependent_fd->dependent_of_displayed = 1;
-      if (dependent_fd->dependent_frames) {
-        g_hash_table_foreach(dependent_fd->dependent_frames, find_and_mark_frame_depended_upon, frames);
+      if (frame_data_get_dependent_frames(dependent_fd)) {
+        g_hash_table_foreach(frame_data_get_dependent_frames(dependent_fd), find_and_mark_frame_depended_upon, frames);
       }
     }
   }
@@ -0,0 +1,147 @@
+/* frame_data_sequence_bench.c
+ * Standalone program to measure the memory footprint of a
+ * frame_data_sequence holding a large number of frames.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <glib.h>
+
+#include <epan/frame_data.h>
+#include <epan/frame_data_sequence.h>
+#include <wiretap/wtap.h>
+#include <wsutil/time_util.h>
+
+#define DEFAULT_FRAME_COUNT     50000000
+
+/*
+ * Every DEPENDENT_INTERVAL'th frame is made to depend on the frame
+ * before it, so that the sparse per-frame data is exercised too.
+ */
+#define DEPENDENT_INTERVAL      1000
+
+static long
+max_resident_kb(void)
+{
+#ifndef _WIN32
+    struct rusage ru;
+
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#ifdef __APPLE__
+        return ru.ru_maxrss / 1024;
+#else
+        return ru.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+int
+main(int argc, char **argv)
+{
+    frame_data_sequence *frames;
+    frame_data fdlocal;
+    frame_data *fdata;
+    wtap_rec rec;
+    uint32_t frame_count = DEFAULT_FRAME_COUNT;
+    uint32_t cum_bytes = 0;
+    int64_t offset = 24;
+    uint32_t framenum;
+    double start_user, start_sys, end_user, end_sys;
+    long start_rss, end_rss;
+
+    if (argc > 1) {
+        frame_count = (uint32_t)strtoul(argv[1], NULL, 10);
+        if (frame_count == 0) {
+            fprintf(stderr, "Usage: %s [frame count]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Synthesize records as if they had been read from a pcap file. */
+    wtap_rec_init(&rec);
+    rec.rec_type = REC_TYPE_PACKET;
+    rec.presence_flags = WTAP_HAS_TS | WTAP_HAS_CAP_LEN;
+    rec.tsprec = WTAP_TSPREC_USEC;
+    rec.ts.secs = 1700000000;
+    rec.ts.nsecs = 0;
+
+    start_rss = max_resident_kb();
+    get_resource_usage(&start_user, &start_sys);
+
+    frames = new_frame_data_sequence();
+    for (framenum = 1; framenum <= frame_count; framenum++) {
+        rec.rec_header.packet_header.len = 60 + (framenum % 1400);
+        rec.rec_header.packet_header.caplen = rec.rec_header.packet_header.len;
+        rec.ts.nsecs = (int)((framenum % 1000000) * 1000);
+        if (rec.ts.nsecs == 0)
+            rec.ts.secs++;
+
+        frame_data_init(&fdlocal, framenum, &rec, offset, cum_bytes);
+        fdata = frame_data_sequence_add(frames, &fdlocal);
+        cum_bytes = fdata->cum_bytes;
+        offset += 16 + rec.rec_header.packet_header.caplen;
+
+        if (framenum % DEPENDENT_INTERVAL == 0)
+            frame_data_add_dependent_frame(fdata, framenum - 1);
+    }
+
+    get_resource_usage(&end_user, &end_sys);
+    end_rss = max_resident_kb();
+
+    /* Make sure the frames can be found and look the way we stored them. */
+    for (framenum = 1; framenum <= frame_count; framenum++) {
+        fdata = frame_data_sequence_find(frames, framenum);
+        if (fdata == NULL || fdata->num != framenum ||
+            fdata->pkt_len != 60 + (framenum % 1400) ||
+            (frame_data_get_dependent_frames(fdata) != NULL) != (framenum % DEPENDENT_INTERVAL == 0)) {
+            fprintf(stderr, "Frame %u doesn't match what was added\n", framenum);
+            free_frame_data_sequence(frames);
+            wtap_rec_cleanup(&rec);
+            return 1;
+        }
+    }
+
+    printf("frames:              %u\n", frame_count);
+    printf("sizeof(frame_data):  %zu bytes\n", sizeof(frame_data));
+    printf("frame storage:       %.1f MiB\n",
+           (double)frame_count * sizeof(frame_data) / (1024.0 * 1024.0));
+    if (start_rss >= 0 && end_rss >= 0) {
+        printf("max resident growth: %.1f MiB (%.1f bytes/frame)\n",
+               (end_rss - start_rss) / 1024.0,
+               (end_rss - start_rss) * 1024.0 / frame_count);
+    }
+    printf("load time:           %.3f s user, %.3f s system\n",
+           end_user - start_user, end_sys - start_sys);
+
+    free_frame_data_sequence(frames);
+    wtap_rec_cleanup(&rec);
+    return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -63,11 +63,28 @@ typedef struct {
     bool            print_text;
     proto_node_children_grouper_func node_children_grouper;
     json_dumper    *dumper;
+    GPtrArray      *node_groups;  /* groups of nodes with the same key, each NULL-terminated, for every level being written */
+    GArray         *key_nodes;    /* scratch for grouping the nodes of a level */
 } write_json_data;
 
+/* A node of a level that's being grouped by key, see json_group_key_nodes() */
+typedef struct {
+    const char     *key;
+    proto_node     *node;
+    unsigned        order;        /* position among the nodes being grouped */
+    unsigned        group_order;  /* position of the first node with the same key */
+} json_key_node_t;
+
+/* Node "i" of the groups being written */
+#define JSON_GROUP_NODE(pdata, i) ((proto_node *)g_ptr_array_index((pdata)->node_groups, (i)))
+
+/* Enough for -2^63 in decimal */
+#define JSON_INTEGER_BUF_LEN 21
+
 typedef struct {
     output_fields_t *fields;
     epan_dissect_t  *edt;
+    size_t           walk_count;    /* entries of fields->field_walk in use */
 } write_field_data_t;
 
 struct _output_fields {
@@ -79,6 +96,8 @@ struct _output_fields {
     GPtrArray    *fields;
     GPtrArray    *field_dfilters;
     GHashTable   *field_indicies;
+    int          *field_hfids;
+    size_t       *field_walk;
     GPtrArray   **field_values;
     wmem_map_t   *protocolfilter;
     char          quote;
@@ -90,6 +109,8 @@ static char *get_field_hex_value(GSList *src_list, field_info *fi);
 static void proto_tree_print_node(proto_node *node, void *data);
 static void proto_tree_write_node_pdml(proto_node *node, void *data);
 static void proto_tree_write_node_ek(proto_node *node, write_json_data *data);
+static void json_data_init(write_json_data *data);
+static void json_data_cleanup(write_json_data *data);
 static const uint8_t *get_field_data(GSList *src_list, field_info *fi);
 static void pdml_write_field_hex_value(write_pdml_data *pdata, field_info *fi);
 static void json_write_field_hex_value(write_json_data *pdata, field_info *fi);
@@ -106,12 +127,12 @@ static void print_escaped_csv(FILE *fh, const char *unescaped_string, char delim
 
 typedef void (*proto_node_value_writer)(proto_node *, write_json_data *);
 static void write_json_index(json_dumper *dumper, epan_dissect_t *edt);
-static void write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *data);
-static void write_json_proto_node(GSList *node_values_head,
+static void write_json_proto_node_list(unsigned groups_start, write_json_data *data);
+static void write_json_proto_node(unsigned first, unsigned count,
                                   const char *suffix,
                                   proto_node_value_writer value_writer,
                                   write_json_data *data);
-static void write_json_proto_node_value_list(GSList *node_values_head,
+static void write_json_proto_node_value_list(unsigned first, unsigned count,
                                              proto_node_value_writer value_writer,
                                              write_json_data *data);
 static void write_json_proto_node_filtered(proto_node *node, write_json_data *data);
@@ -401,7 +422,9 @@ write_ek_proto_tree(output_fields_t* fields,
             data.src_list = edt->pi.data_src;
             data.filter = fields ? fields->protocolfilter : NULL;
             data.print_hex = print_hex;
+            json_data_init(&data);
             proto_tree_write_node_ek(edt->tree, &data);
+            json_data_cleanup(&data);
         } else {
             /* Write out specified fields */
             write_specified_fields(FORMAT_EK, fields, edt, cinfo, NULL, data.dumper);
@@ -768,8 +791,10 @@ write_json_proto_tree(output_fields_t* fields,
             data.print_text = false;
         }
         data.node_children_grouper = node_children_grouper;
+        json_data_init(&data);
 
         write_json_proto_node_children(edt->tree, &data);
+        json_data_cleanup(&data);
     } else {
         write_specified_fields(FORMAT_JSON, fields, edt, cinfo, NULL, dumper);
     }
@@ -779,18 +804,163 @@ write_json_proto_tree(output_fields_t* fields,
 }
 
 /**
- * Returns a boolean telling us whether that node list contains any node which has children
+ * Sets up the scratch arrays used for grouping nodes by key.
+ */
+static void
+json_data_init(write_json_data *data)
+{
+    data->node_groups = g_ptr_array_sized_new(256);
+    data->key_nodes = g_array_sized_new(false, false, sizeof(json_key_node_t), 64);
+}
+
+static void
+json_data_cleanup(write_json_data *data)
+{
+    g_ptr_array_free(data->node_groups, true);
+    g_array_free(data->key_nodes, true);
+}
+
+/**
+ * Adds a node to be grouped by json_group_key_nodes().
+ */
+static void
+json_add_key_node(write_json_data *pdata, const char *key, proto_node *node)
+{
+    json_key_node_t key_node;
+
+    key_node.key = key;
+    key_node.node = node;
+    key_node.order = pdata->key_nodes->len;
+    key_node.group_order = key_node.order;
+    g_array_append_val(pdata->key_nodes, key_node);
+}
+
+static int
+json_key_node_cmp_key(const void *a, const void *b)
+{
+    const json_key_node_t *key_node_a = (const json_key_node_t *)a;
+    const json_key_node_t *key_node_b = (const json_key_node_t *)b;
+
+    if (key_node_a->key != key_node_b->key) {
+        int ret = strcmp(key_node_a->key, key_node_b->key);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    return (key_node_a->order > key_node_b->order) - (key_node_a->order < key_node_b->order);
+}
+
+static int
+json_key_node_cmp_group(const void *a, const void *b)
+{
+    const json_key_node_t *key_node_a = (const json_key_node_t *)a;
+    const json_key_node_t *key_node_b = (const json_key_node_t *)b;
+
+    if (key_node_a->group_order != key_node_b->group_order) {
+        return key_node_a->group_order < key_node_b->group_order ? -1 : 1;
+    }
+    return (key_node_a->order > key_node_b->order) - (key_node_a->order < key_node_b->order);
+}
+
+/**
+ * Moves the nodes added with json_add_key_node() to the end of pdata->node_groups, as one NULL-terminated group of
+ * nodes per key. Keys are in the order they were first added, and the nodes of a key in the order they were added.
+ * Sorting the scratch array twice, rather than looking the keys up in a hash table, means nothing has to be allocated
+ * for every node.
+ */
+static void
+json_group_key_nodes(write_json_data *pdata)
+{
+    json_key_node_t *key_nodes = (json_key_node_t *)(void *)pdata->key_nodes->data;
+    unsigned count = pdata->key_nodes->len;
+    unsigned i;
+
+    if (count > 1) {
+        // Bring the nodes with the same key together, and have each of them remember where its key was first seen.
+        qsort(key_nodes, count, sizeof(json_key_node_t), json_key_node_cmp_key);
+        for (i = 1; i < count; i++) {
+            if (key_nodes[i].key == key_nodes[i - 1].key || strcmp(key_nodes[i].key, key_nodes[i - 1].key) == 0) {
+                key_nodes[i].group_order = key_nodes[i - 1].group_order;
+            }
+        }
+        qsort(key_nodes, count, sizeof(json_key_node_t), json_key_node_cmp_group);
+    }
+
+    for (i = 0; i < count; i++) {
+        if (i > 0 && key_nodes[i].group_order != key_nodes[i - 1].group_order) {
+            g_ptr_array_add(pdata->node_groups, NULL);
+        }
+        g_ptr_array_add(pdata->node_groups, key_nodes[i].node);
+    }
+    if (count > 0) {
+        g_ptr_array_add(pdata->node_groups, NULL);
+    }
+
+    g_array_set_size(pdata->key_nodes, 0);
+}
+
+/**
+ * Formats the value of an integer field like fvalue_to_string_repr() does, but into a buffer of at least
+ * JSON_INTEGER_BUF_LEN bytes rather than an allocated string. Returns false if the field isn't an integer, or is
+ * shown in hexadecimal (those are padded according to their type).
  */
 static bool
-any_has_children(GSList *node_values_list)
+json_format_integer_value(field_info *fi, char *buf)
+{
+    uint64_t uval;
+    int64_t sval;
+
+    switch (fvalue_type_ftenum(fi->value)) {
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+        case FT_FRAMENUM:
+            if (FIELD_DISPLAY(fi->hfinfo->display) == BASE_HEX || FIELD_DISPLAY(fi->hfinfo->display) == BASE_HEX_DEC) {
+                return false;
+            }
+            if (fvalue_to_uinteger64(fi->value, &uval) != FT_OK) {
+                return false;
+            }
+            uint64_to_str_buf(uval, buf, JSON_INTEGER_BUF_LEN);
+            return true;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+            if (fvalue_to_sinteger64(fi->value, &sval) != FT_OK) {
+                return false;
+            }
+            if (sval < 0) {
+                *buf = '-';
+                uint64_to_str_buf(0 - (uint64_t)sval, buf + 1, JSON_INTEGER_BUF_LEN - 1);
+            } else {
+                uint64_to_str_buf((uint64_t)sval, buf, JSON_INTEGER_BUF_LEN);
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Returns a boolean telling us whether that group contains any node which has children
+ */
+static bool
+any_has_children(unsigned first, unsigned count, write_json_data *pdata)
 {
-    GSList *current_node = node_values_list;
-    while (current_node != NULL) {
-        proto_node *current_value = (proto_node *) current_node->data;
-        if (current_value->first_child != NULL) {
+    for (unsigned i = first; i < first + count; i++) {
+        if (JSON_GROUP_NODE(pdata, i)->first_child != NULL) {
             return true;
         }
-        current_node = current_node->next;
     }
     return false;
 }
@@ -798,51 +968,63 @@ any_has_children(GSList *node_values_list)
 /**
  * Write a json object containing a list of key:value pairs where each key:value pair corresponds to a different json
  * key and its associated nodes in the proto_tree.
- * @param proto_node_list_head A 2-dimensional list containing a list of values for each different node json key. The
- * elements themselves are a linked list of values associated with the same json key.
+ * @param groups_start Index in pdata->node_groups of the first group of nodes of this object. Each group is a
+ * NULL-terminated run of nodes associated with the same json key, and the groups run to the end of the array.
  * @param pdata json writing metadata
  */
 static void
-write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
+write_json_proto_node_list(unsigned groups_start, write_json_data *pdata)
 {
-    GSList *current_node = proto_node_list_head;
+    // Writing the children of a node adds their groups to the end of the array, and removes them again when done.
+    unsigned groups_end = pdata->node_groups->len;
+    unsigned first = groups_start;
 
     json_dumper_begin_object(pdata->dumper);
 
-    // Loop over each list of nodes (differentiated by json key) and write the associated json key:value pair in the
+    // Loop over each group of nodes (differentiated by json key) and write the associated json key:value pair in the
     // output.
-    while (current_node != NULL) {
-        // Get the list of values for the current json key.
-        GSList *node_values_list = (GSList *) current_node->data;
+    while (first < groups_end) {
+        unsigned count = 0;
+
+        // Count the values for the current json key.
+        while (JSON_GROUP_NODE(pdata, first + count) != NULL) {
+            count++;
+        }
 
         // Retrieve the json key from the first value.
-        proto_node *first_value = (proto_node *) node_values_list->data;
+        proto_node *first_value = JSON_GROUP_NODE(pdata, first);
         const char *json_key = proto_node_to_json_key(first_value);
         // Check if the current json key is filtered from the output with the "-j" cli option.
         pf_flags filter_flags = PF_NONE;
         bool is_filtered = pdata->filter != NULL && !check_protocolfilter(pdata->filter, json_key, &filter_flags);
 
         field_info *fi = first_value->finfo;
-        char *value_string_repr = fvalue_to_string_repr(NULL, fi->value, FTREPR_JSON, fi->hfinfo->display);
-        bool has_children = any_has_children(node_values_list);
+        bool has_children = any_has_children(first, count, pdata);
 
         // We assume all values of a json key have roughly the same layout. Thus we can use the first value to derive
         // attributes of all the values.
-        bool has_value = value_string_repr != NULL;
+        bool has_value;
         bool is_pseudo_text_field = fi->hfinfo->id == hf_text_only;
+        char integer_buf[JSON_INTEGER_BUF_LEN];
 
-        wmem_free(NULL, value_string_repr); // fvalue_to_string_repr returns allocated buffer
+        if (json_format_integer_value(fi, integer_buf)) {
+            has_value = true;
+        } else {
+            char *value_string_repr = fvalue_to_string_repr(NULL, fi->value, FTREPR_JSON, fi->hfinfo->display);
+            has_value = value_string_repr != NULL;
+            wmem_free(NULL, value_string_repr); // fvalue_to_string_repr returns allocated buffer
+        }
 
         // "-x" command line option. A "_raw" suffix is added to the json key so the textual value can be printed
         // with the original json key. If both hex and text writing are enabled the raw information of fields whose
         // length is equal to 0 is not written to the output. If the field is a special text pseudo field no raw
         // information is written either.
         if (pdata->print_hex && (!pdata->print_text || fi->length > 0) && !is_pseudo_text_field) {
-            write_json_proto_node(node_values_list, "_raw", write_json_proto_node_hex_dump, pdata);
+            write_json_proto_node(first, count, "_raw", write_json_proto_node_hex_dump, pdata);
         }
 
         if (pdata->print_text && has_value) {
-            write_json_proto_node(node_values_list, "", write_json_proto_node_value, pdata);
+            write_json_proto_node(first, count, "", write_json_proto_node_value, pdata);
         }
 
         if (has_children) {
@@ -852,7 +1034,7 @@ write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
             char *suffix = has_value ? "_tree": "";
 
             if (is_filtered) {
-                write_json_proto_node(node_values_list, suffix, write_json_proto_node_filtered, pdata);
+                write_json_proto_node(first, count, suffix, write_json_proto_node_filtered, pdata);
             } else {
                 // Remove protocol filter for children, if children should be included. This functionality is enabled
                 // with the "-J" command line option. We save the filter so it can be reenabled when we are done with
@@ -865,7 +1047,7 @@ write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
 
                 // has_children is true if any of the nodes have children. So we're not 100% sure whether this
                 // particular node has children or not => use the 'dynamic' version of 'write_json_proto_node'
-                write_json_proto_node(node_values_list, suffix, write_json_proto_node_dynamic, pdata);
+                write_json_proto_node(first, count, suffix, write_json_proto_node_dynamic, pdata);
 
                 // Put protocol filter back
                 if ((filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
@@ -875,10 +1057,10 @@ write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
         }
 
         if (!has_value && !has_children && (pdata->print_text || (pdata->print_hex && is_pseudo_text_field))) {
-            write_json_proto_node(node_values_list, "", write_json_proto_node_no_value, pdata);
+            write_json_proto_node(first, count, "", write_json_proto_node_no_value, pdata);
         }
 
-        current_node = current_node->next;
+        first += count + 1;
     }
     json_dumper_end_object(pdata->dumper);
 }
@@ -886,46 +1068,51 @@ write_json_proto_node_list(GSList *proto_node_list_head, write_json_data *pdata)
 /**
  * Writes a single node as a key:value pair. The value_writer param can be used to specify how the node's value should
  * be written.
- * @param node_values_head Linked list containing all nodes associated with the same json key in this object.
+ * @param first Index in pdata->node_groups of the first node associated with the json key in this object.
+ * @param count Number of nodes associated with the json key.
  * @param suffix Suffix that should be added to the json key.
  * @param value_writer A function which writes the actual values of the node json key.
  * @param pdata json writing metadata
  */
 static void
-write_json_proto_node(GSList *node_values_head,
+write_json_proto_node(unsigned first, unsigned count,
                       const char *suffix,
                       proto_node_value_writer value_writer,
                       write_json_data *pdata)
 {
     // Retrieve json key from first value.
-    proto_node *first_value = (proto_node *) node_values_head->data;
+    proto_node *first_value = JSON_GROUP_NODE(pdata, first);
     const char *json_key = proto_node_to_json_key(first_value);
-    char* json_key_suffix = ws_strdup_printf("%s%s", json_key, suffix);
-    json_dumper_set_member_name(pdata->dumper, json_key_suffix);
-    g_free(json_key_suffix);
-    write_json_proto_node_value_list(node_values_head, value_writer, pdata);
+    if (*suffix == '\0') {
+        json_dumper_set_member_name(pdata->dumper, json_key);
+    } else {
+        char* json_key_suffix = ws_strdup_printf("%s%s", json_key, suffix);
+        json_dumper_set_member_name(pdata->dumper, json_key_suffix);
+        g_free(json_key_suffix);
+    }
+    write_json_proto_node_value_list(first, count, value_writer, pdata);
 }
 
 /**
  * Writes a list of values of a single json key. If multiple values are passed they are wrapped in a json array.
- * @param node_values_head Linked list containing all values that should be written.
+ * @param first Index in pdata->node_groups of the first value that should be written.
+ * @param count Number of values that should be written.
  * @param value_writer Function which writes the separate values.
  * @param pdata json writing metadata
  */
 static void
-write_json_proto_node_value_list(GSList *node_values_head, proto_node_value_writer value_writer, write_json_data *pdata)
+write_json_proto_node_value_list(unsigned first, unsigned count, proto_node_value_writer value_writer, write_json_data *pdata)
 {
-    GSList *current_value = node_values_head;
-
     // Write directly if only a single value is passed. Wrap in json array otherwise.
-    if (current_value->next == NULL) {
-        value_writer((proto_node *) current_value->data, pdata);
+    if (count == 1) {
+        value_writer(JSON_GROUP_NODE(pdata, first), pdata);
     } else {
         json_dumper_begin_array(pdata->dumper);
 
-        while (current_value != NULL) {
-            value_writer((proto_node *) current_value->data, pdata);
-            current_value = current_value->next;
+        // The values' children are added to the end of pdata->node_groups while they're written, which may move the
+        // array, so look each value up afresh.
+        for (unsigned i = first; i < first + count; i++) {
+            value_writer(JSON_GROUP_NODE(pdata, i), pdata);
         }
         json_dumper_end_array(pdata->dumper);
     }
@@ -1021,9 +1208,36 @@ write_json_proto_node_dynamic(proto_node *node, write_json_data *data)
 static void
 write_json_proto_node_children(proto_node *node, write_json_data *data)
 {
-    GSList *grouped_children_list = data->node_children_grouper(node);
-    write_json_proto_node_list(grouped_children_list, data);
-    g_slist_free_full(grouped_children_list, (GDestroyNotify) g_slist_free);
+    unsigned groups_start = data->node_groups->len;
+    proto_node *current_child;
+
+    // The two groupers of our own are done without building lists of lists.
+    if (data->node_children_grouper == proto_node_group_children_by_unique) {
+        for (current_child = node->first_child; current_child != NULL; current_child = current_child->next) {
+            g_ptr_array_add(data->node_groups, current_child);
+            g_ptr_array_add(data->node_groups, NULL);
+        }
+    } else if (data->node_children_grouper == proto_node_group_children_by_json_key) {
+        for (current_child = node->first_child; current_child != NULL; current_child = current_child->next) {
+            json_add_key_node(data, proto_node_to_json_key(current_child), current_child);
+        }
+        json_group_key_nodes(data);
+    } else {
+        GSList *grouped_children_list = data->node_children_grouper(node);
+        for (GSList *group = grouped_children_list; group != NULL; group = group->next) {
+            if (group->data == NULL) {
+                continue;
+            }
+            for (GSList *value = (GSList *) group->data; value != NULL; value = value->next) {
+                g_ptr_array_add(data->node_groups, value->data);
+            }
+            g_ptr_array_add(data->node_groups, NULL);
+        }
+        g_slist_free_full(grouped_children_list, (GDestroyNotify) g_slist_free);
+    }
+
+    write_json_proto_node_list(groups_start, data);
+    g_ptr_array_set_size(data->node_groups, groups_start);
 }
 
 /**
@@ -1033,6 +1247,13 @@ static void
 write_json_proto_node_value(proto_node *node, write_json_data *pdata)
 {
     field_info *fi = node->finfo;
+    char integer_buf[JSON_INTEGER_BUF_LEN];
+
+    if (json_format_integer_value(fi, integer_buf)) {
+        json_dumper_value_string(pdata->dumper, integer_buf);
+        return;
+    }
+
     // Get the actual value of the node as a string.
     char *value_string_repr = fvalue_to_string_repr(NULL, fi->value, FTREPR_JSON, fi->hfinfo->display);
 
@@ -1202,10 +1423,9 @@ write_ek_summary(column_info *cinfo, write_json_data* pdata)
 /* Write out a tree's data, and any child nodes, as JSON for EK */
 static void
 // NOLINTNEXTLINE(misc-no-recursion)
-ek_fill_attr(proto_node *node, GHashTable *attr_table, write_json_data *pdata)
+ek_fill_attr(proto_node *node, write_json_data *pdata)
 {
     field_info *fi         = NULL;
-    GSList *attr_instances = NULL;
 
     proto_node *current_node = node->first_child;
     while (current_node != NULL) {
@@ -1214,10 +1434,7 @@ ek_fill_attr(proto_node *node, GHashTable *attr_table, write_json_data *pdata)
         /* dissection with an invisible proto tree? */
         ws_assert(fi);
 
-        attr_instances = (GSList *) g_hash_table_lookup(attr_table, fi->hfinfo->abbrev);
-        attr_instances = g_slist_append(attr_instances, current_node);
-        // Update instance list for this attr in hash table
-        g_hash_table_insert(attr_table, g_strdup(fi->hfinfo->abbrev), attr_instances);
+        json_add_key_node(pdata, fi->hfinfo->abbrev, current_node);
 
         /* Field, recurse through children*/
         if (fi->hfinfo->type != FT_PROTOCOL && current_node->first_child != NULL) {
@@ -1232,7 +1449,7 @@ ek_fill_attr(proto_node *node, GHashTable *attr_table, write_json_data *pdata)
                     }
 
                     // We recurse here, but we're limited by our tree depth checks in proto.c
-                    ek_fill_attr(current_node, attr_table, pdata);
+                    ek_fill_attr(current_node, pdata);
 
                     /* Put protocol filter back */
                     if ((filter_flags&PF_INCLUDE_CHILDREN) == PF_INCLUDE_CHILDREN) {
@@ -1243,7 +1460,7 @@ ek_fill_attr(proto_node *node, GHashTable *attr_table, write_json_data *pdata)
                 }
             } else {
                 // We recurse here, but we're limited by our tree depth checks in proto.c
-                ek_fill_attr(current_node, attr_table, pdata);
+                ek_fill_attr(current_node, pdata);
             }
         } else {
             // Will descend into object at another point
@@ -1316,6 +1533,7 @@ ek_write_field_value(field_info *fi, write_json_data* pdata)
     char *dfilter_string;
     char time_buf[NSTIME_ISO8601_BUFSIZE];
     size_t time_len;
+    char integer_buf[JSON_INTEGER_BUF_LEN];
 
     /* Text label */
     if (fi->hfinfo->id == hf_text_only && fi->rep) {
@@ -1350,6 +1568,10 @@ ek_write_field_value(field_info *fi, write_json_data* pdata)
             }
             break;
         default:
+            if (json_format_integer_value(fi, integer_buf)) {
+                json_dumper_value_string(pdata->dumper, integer_buf);
+                break;
+            }
             dfilter_string = fvalue_to_string_repr(NULL, fi->value, FTREPR_DISPLAY, fi->hfinfo->display);
             if (dfilter_string != NULL) {
                 json_dumper_value_string(pdata->dumper, dfilter_string);
@@ -1361,57 +1583,55 @@ ek_write_field_value(field_info *fi, write_json_data* pdata)
 }
 
 static void
-ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
+ek_write_attr_hex(unsigned first, unsigned count, write_json_data *pdata)
 {
-    GSList *current_node = attr_instances;
-    proto_node *pnode    = (proto_node *) current_node->data;
+    proto_node *pnode    = JSON_GROUP_NODE(pdata, first);
     field_info *fi       = NULL;
 
     // Raw name
     ek_write_name(pnode, "_raw", pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (count > 1) {
         json_dumper_begin_array(pdata->dumper);
     }
 
     // Raw value(s)
-    while (current_node != NULL) {
-        pnode = (proto_node *) current_node->data;
+    for (unsigned i = first; i < first + count; i++) {
+        pnode = JSON_GROUP_NODE(pdata, i);
         fi    = PNODE_FINFO(pnode);
 
         ek_write_hex(fi, pdata);
-
-        current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (count > 1) {
         json_dumper_end_array(pdata->dumper);
     }
 }
 
 static void
 // NOLINTNEXTLINE(misc-no-recursion)
-ek_write_attr(GSList *attr_instances, write_json_data *pdata)
+ek_write_attr(unsigned first, unsigned count, write_json_data *pdata)
 {
-    GSList *current_node  = attr_instances;
-    proto_node *pnode     = (proto_node *) current_node->data;
+    proto_node *pnode     = JSON_GROUP_NODE(pdata, first);
     field_info *fi        = PNODE_FINFO(pnode);
     pf_flags filter_flags = PF_NONE;
 
     // Hex dump -x
     if (pdata->print_hex && fi && fi->length > 0 && fi->hfinfo->id != hf_text_only) {
-        ek_write_attr_hex(attr_instances, pdata);
+        ek_write_attr_hex(first, count, pdata);
     }
 
     // Print attr name
     ek_write_name(pnode, NULL, pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (count > 1) {
         json_dumper_begin_array(pdata->dumper);
     }
 
-    while (current_node != NULL) {
-        pnode = (proto_node *) current_node->data;
+    // Writing an object adds its attributes to the end of pdata->node_groups, which may move the array, so look each
+    // instance up afresh.
+    for (unsigned i = first; i < first + count; i++) {
+        pnode = JSON_GROUP_NODE(pdata, i);
         fi    = PNODE_FINFO(pnode);
 
         /* Field */
@@ -1457,48 +1677,34 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
 
             json_dumper_end_object(pdata->dumper);
         }
-
-        current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (count > 1) {
         json_dumper_end_array(pdata->dumper);
     }
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
-void process_ek_attrs(gpointer key _U_, gpointer value, gpointer pdata)
-{
-    GSList *attr_instances = (GSList *) value;
-    ek_write_attr(attr_instances, pdata);
-}
-
 /* Write out a tree's data, and any child nodes, as JSON for EK */
 static void
 // NOLINTNEXTLINE(misc-no-recursion)
 proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
 {
-    GHashTable *attr_table  = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-    GHashTableIter iter;
-    gpointer key, value;
-    ek_fill_attr(node, attr_table, pdata);
-
-    // Print attributes
-    g_hash_table_iter_init(&iter, attr_table);
-    while (g_hash_table_iter_next (&iter, &key, &value)) {
-        process_ek_attrs(key, value, pdata);
-        g_hash_table_iter_remove(&iter);
-        /* We lookup a list in the table, append to it, and re-insert it; as
-         * g_slist_append() can change the start pointer of the list we can't
-         * just append to the list without replacing the old value. In turn,
-         * that means we can't set the value_destroy_func when creating
-         * the hash table, because on re-insertion that would destroy the
-         * nodes of the old list, which are still being used by the new list.
-         * So free it here.
-         */
-        g_slist_free((GSList*)value);
+    unsigned groups_start = pdata->node_groups->len;
+    unsigned groups_end;
+    unsigned first, count;
+
+    ek_fill_attr(node, pdata);
+    json_group_key_nodes(pdata);
+
+    // Print attributes. Writing an object adds the groups of its own
+    // attributes after ours, and removes them again when done.
+    groups_end = pdata->node_groups->len;
+    for (first = groups_start; first < groups_end; first += count + 1) {
+        for (count = 0; JSON_GROUP_NODE(pdata, first + count) != NULL; count++)
+            ;
+        ek_write_attr(first, count, pdata);
     }
-    g_hash_table_destroy(attr_table);
+    g_ptr_array_set_size(pdata->node_groups, groups_start);
 }
 
 /* Print info for a 'geninfo' pseudo-protocol. This is required by
@@ -2054,6 +2260,9 @@ void output_fields_free(output_fields_t* fields)
             g_hash_table_destroy(fields->field_indicies);
         }
 
+        g_free(fields->field_hfids);
+        g_free(fields->field_walk);
+
         if (NULL != fields->field_dfilters) {
             g_ptr_array_unref(fields->field_dfilters);
         }
@@ -2474,6 +2683,16 @@ static void proto_tree_get_node_field_values(proto_node *node, void *data)
             );
     }
 
+    for (size_t j = 0; j < call_data->walk_count; ++j) {
+        size_t i = call_data->fields->field_walk[j];
+
+        if (call_data->fields->field_hfids[i] == fi->hfinfo->id) {
+            format_field_values(call_data->fields, GUINT_TO_POINTER(i + 1),
+                                get_node_field_value(fi, call_data->edt) /* g_ alloc'd string */
+                );
+        }
+    }
+
     /* Recurse here. */
     if (node->first_child != NULL) {
         proto_tree_children_foreach(node, proto_tree_get_node_field_values,
@@ -2481,6 +2700,33 @@ static void proto_tree_get_node_field_values(proto_node *node, void *data)
     }
 }
 
+/*
+ * Add the value of a field that has an abbreviation of its own. Every
+ * field named on the command line is primed for printing, so the tree
+ * keeps track of each instance of it and, when there's only one, there's
+ * no need to walk the whole tree looking for it.
+ *
+ * The instances are kept in the order they were added, which isn't the
+ * tree order if one was added to a subtree after another was added
+ * further on in the tree, so returns false, leaving the field to the
+ * tree walk, if there's more than one.
+ */
+static bool get_primed_field_values(output_fields_t *fields, size_t field_index, epan_dissect_t *edt)
+{
+    GPtrArray  *finfos;
+
+    finfos = proto_get_finfo_ptr_array(edt->tree, fields->field_hfids[field_index]);
+    if (finfos == NULL || g_ptr_array_len(finfos) == 0)
+        return true;
+    if (g_ptr_array_len(finfos) > 1)
+        return false;
+
+    format_field_values(fields, GUINT_TO_POINTER(field_index + 1),
+                        get_node_field_value((field_info *)g_ptr_array_index(finfos, 0), edt) /* g_ alloc'd string */
+        );
+    return true;
+}
+
 static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo _U_, FILE *fh, json_dumper *dumper)
 {
     size_t    i;
@@ -2499,19 +2745,35 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
 
     data.fields = fields;
     data.edt = edt;
+    data.walk_count = 0;
 
     if (NULL == fields->field_indicies) {
         /* Prepare a lookup table from string abbreviation for field to its index. */
         fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
+        fields->field_hfids = g_new(int, fields->fields->len);
+        fields->field_walk = g_new(size_t, fields->fields->len);
 
         i = 0;
         while (i < fields->fields->len) {
             char *field = (char *)g_ptr_array_index(fields->fields, i);
+            header_field_info *hfinfo = proto_registrar_get_byname(field);
+
+            /* Fields whose abbreviation is shared by several hf's are
+             * still looked up by name while walking the tree, so that
+             * their values come out in tree order.
+             */
+            fields->field_hfids[i] = -1;
+            if (hfinfo && hfinfo->same_name_prev_id == -1 &&
+                hfinfo->same_name_next == NULL &&
+                strcmp(hfinfo->abbrev, field) == 0) {
+                fields->field_hfids[i] = hfinfo->id;
+            }
+
             /* Store field indicies +1 so that zero is not a valid value,
              * and can be distinguished from NULL as a pointer.
              */
             ++i;
-            if (proto_registrar_get_byname(field)) {
+            if (hfinfo && fields->field_hfids[i - 1] == -1) {
                 g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
             }
         }
@@ -2554,8 +2816,16 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
         }
     }
 
-    proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
-                                &data);
+    for (i = 0; i < fields->fields->len; ++i) {
+        if (fields->field_hfids[i] != -1 && !get_primed_field_values(fields, i, edt)) {
+            fields->field_walk[data.walk_count++] = i;
+        }
+    }
+
+    if (g_hash_table_size(fields->field_indicies) != 0 || data.walk_count != 0) {
+        proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
+                                    &data);
+    }
 
     switch (format) {
     case FORMAT_CSV:
@@ -2809,6 +3079,8 @@ output_fields_t* output_fields_new(void)
     fields->fields              = NULL; /*Do lazy initialisation */
     fields->field_dfilters      = NULL;
     fields->field_indicies      = NULL;
+    fields->field_hfids         = NULL;
+    fields->field_walk          = NULL;
     fields->field_values        = NULL;
     fields->protocolfilter      = NULL;
     fields->quote               ='\0';
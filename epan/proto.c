@@ -192,6 +192,19 @@ struct ptvcursor {
 		 * us to generate the protocol item's string representation */ \
 		return; \
 	}
+/* Same as above, but also fakes the label of an item that is only in a
+ * tree which isn't visible because it's being printed; see
+ * proto_item_label_unused(). Only for use when setting the text of an
+ * item, as the length of such items is needed. */
+#define TRY_TO_FAKE_THIS_LABEL_VOID(pi)	\
+	if (!pi)			\
+		return;			\
+	if (!(PTREE_DATA(pi)->visible) && \
+	      proto_item_label_unused(pi)) { \
+		/* If the tree (GUI) or item isn't visible it's pointless for \
+		 * us to generate the protocol item's string representation */ \
+		return; \
+	}
 /* Similar to above, but allows a NULL tree */
 #define TRY_TO_FAKE_THIS_REPR_NESTED(pi)	\
 	if ((pi == NULL) || (!(PTREE_DATA(pi)->visible) && \
@@ -6779,6 +6792,30 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 	return fi;
 }
 
+/* Is there no point in generating the label of an item? That's the case
+   for hidden items, and for the items of a tree that isn't visible that
+   are only there because they're being printed, as only the labels of
+   protocols and text items are printed (see get_node_field_value()).
+   Items referenced otherwise keep their labels, as do all items when
+   there are Lua field extractors, whose FieldInfo.display, and value
+   for FT_NONE fields, come from the label. */
+static bool
+proto_item_label_unused(proto_item *pi)
+{
+	field_info *fi = PITEM_FINFO(pi);
+
+	if (fi == NULL || proto_item_is_hidden(pi))
+		return true;
+
+	if (PTREE_DATA(pi)->visible)
+		return false;
+
+	if (fi->hfinfo->ref_type != HF_REF_TYPE_PRINT || have_field_extractors())
+		return false;
+
+	return fi->hfinfo->type != FT_PROTOCOL && fi->hfinfo->id != hf_text_only;
+}
+
 /* If the protocol tree is to be visible, set the representation of a
    proto_tree entry with the name of the field for the item and with
    the value formatted with the supplied printf-style format and
@@ -6845,7 +6882,7 @@ proto_tree_set_representation(proto_item *pi, const char *format, va_list ap)
 
 	DISSECTOR_ASSERT(fi);
 
-	if (!proto_item_is_hidden(pi)) {
+	if (!proto_item_label_unused(pi)) {
 		ITEM_LABEL_NEW(PNODE_POOL(pi), fi->rep);
 
 		str = wmem_strdup_vprintf(PNODE_POOL(pi), format, ap);
@@ -7572,7 +7609,7 @@ proto_item_set_text(proto_item *pi, const char *format, ...)
 	field_info *fi = NULL;
 	va_list     ap;
 
-	TRY_TO_FAKE_THIS_REPR_VOID(pi);
+	TRY_TO_FAKE_THIS_LABEL_VOID(pi);
 
 	fi = PITEM_FINFO(pi);
 	if (fi == NULL)
@@ -7597,7 +7634,7 @@ proto_item_append_text(proto_item *pi, const char *format, ...)
 	char       *str;
 	va_list     ap;
 
-	TRY_TO_FAKE_THIS_REPR_VOID(pi);
+	TRY_TO_FAKE_THIS_LABEL_VOID(pi);
 
 	fi = PITEM_FINFO(pi);
 	if (fi == NULL) {
@@ -7650,7 +7687,7 @@ proto_item_prepend_text(proto_item *pi, const char *format, ...)
 	char       *str;
 	va_list     ap;
 
-	TRY_TO_FAKE_THIS_REPR_VOID(pi);
+	TRY_TO_FAKE_THIS_LABEL_VOID(pi);
 
 	fi = PITEM_FINFO(pi);
 	if (fi == NULL) {
@@ -31,6 +31,7 @@
 #include "strutil.h"
 #include "stats_tree.h"
 #include <wsutil/ws_assert.h>
+#include <wsutil/wmem/wmem_map.h>
 
 enum _stat_tree_columns {
     COL_NAME,
@@ -48,6 +49,104 @@ enum _stat_tree_columns {
 /* used to contain the registered stat trees */
 static GHashTable *registry;
 
+/* The children of a node, looked up by name or by key with linear probing.
+ * Nodes are never removed from it, only freed all together with their
+ * parent, and the table is kept at most three quarters full. */
+struct _stat_node_table {
+    stat_node **slots;
+    unsigned    mask;       /* number of slots - 1 */
+    unsigned    count;
+};
+
+#define STAT_NODE_TABLE_MIN_SIZE 8
+
+static stat_node_table *
+stat_node_table_new(void)
+{
+    stat_node_table *table = g_new(stat_node_table, 1);
+
+    table->slots = g_new0(stat_node *, STAT_NODE_TABLE_MIN_SIZE);
+    table->mask = STAT_NODE_TABLE_MIN_SIZE - 1;
+    table->count = 0;
+
+    return table;
+}
+
+static void
+stat_node_table_free(stat_node_table *table)
+{
+    g_free(table->slots);
+    g_free(table);
+}
+
+static inline unsigned
+stat_node_name_hash(const char *name)
+{
+    return wmem_strong_hash((const uint8_t *)name, strlen(name));
+}
+
+static stat_node *
+stat_node_table_lookup_name(const stat_node_table *table, const char *name, unsigned hash)
+{
+    stat_node *node;
+    unsigned i;
+
+    for (i = hash & table->mask; (node = table->slots[i]) != NULL; i = (i + 1) & table->mask) {
+        if (node->key_hash == hash && node->key == NULL && strcmp(node->name, name) == 0)
+            return node;
+    }
+    return NULL;
+}
+
+static stat_node *
+stat_node_table_lookup_key(const stat_node_table *table, const void *key, unsigned key_len, unsigned hash)
+{
+    stat_node *node;
+    unsigned i;
+
+    for (i = hash & table->mask; (node = table->slots[i]) != NULL; i = (i + 1) & table->mask) {
+        if (node->key_hash == hash && node->key != NULL && node->key_len == key_len &&
+            memcmp(node->key, key, key_len) == 0)
+            return node;
+    }
+    return NULL;
+}
+
+/* Adds a node, replacing one with the same name or key */
+static void
+stat_node_table_insert(stat_node_table *table, stat_node *node)
+{
+    stat_node *other;
+    unsigned i;
+
+    if ((table->count + 1) * 4 > (table->mask + 1) * 3) {
+        stat_node **old_slots = table->slots;
+        unsigned old_size = table->mask + 1;
+        unsigned j;
+
+        table->mask = old_size * 2 - 1;
+        table->slots = g_new0(stat_node *, old_size * 2);
+        for (j = 0; j < old_size; j++) {
+            if (old_slots[j]) {
+                for (i = old_slots[j]->key_hash & table->mask; table->slots[i]; i = (i + 1) & table->mask) ;
+                table->slots[i] = old_slots[j];
+            }
+        }
+        g_free(old_slots);
+    }
+
+    for (i = node->key_hash & table->mask; (other = table->slots[i]) != NULL; i = (i + 1) & table->mask) {
+        if (other->key_hash == node->key_hash && (node->key ?
+                (other->key != NULL && other->key_len == node->key_len && memcmp(other->key, node->key, node->key_len) == 0) :
+                (other->key == NULL && strcmp(other->name, node->name) == 0))) {
+            table->slots[i] = node;
+            return;
+        }
+    }
+    table->slots[i] = node;
+    table->count++;
+}
+
 /* a text representation of a node
 if buffer is NULL returns a newly allocated string */
 extern char*
@@ -110,7 +209,7 @@ free_stat_node(stat_node *node)
     }
     }
 
-    if (node->hash) g_hash_table_destroy(node->hash);
+    if (node->hash) stat_node_table_free(node->hash);
 
     while (node->bh) {
         bucket = node->bh;
@@ -222,6 +321,7 @@ stats_tree_reinit(void *p)
     }
 
     st->root.children = NULL;
+    st->root.last_child = NULL;
     st->root.counter = 0;
     switch (st->root.datatype)
     {
@@ -475,14 +575,15 @@ stats_tree_presentation(void (*registry_iterator)(void *,void *,void *),
 *    parent_name: the name of the ALREADY REGISTERED parent
 *    with_hash: whether or not it should keep a hash with its children names
 *    as_named_node: whether or not it has to be registered in the root namespace
+*    key, key_len: the key the node is looked up by in its parent, if not by name
+*    key_hash: the hash of the key or name
 */
 static stat_node*
-new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatype datatype,
-          bool with_hash, bool as_parent_node)
+new_stat_node_with_key(stats_tree *st, const char *name, int parent_id, stat_node_datatype datatype,
+          bool with_hash, bool as_parent_node, const void *key, unsigned key_len, unsigned key_hash)
 {
-
-    stat_node *node = g_new0(stat_node, 1);
-    stat_node *last_chld = NULL;
+    /* the key is kept right after the node */
+    stat_node *node = (stat_node *)g_malloc0(sizeof(stat_node) + (key ? key_len : 0));
 
     node->datatype = datatype;
     switch (datatype)
@@ -504,7 +605,14 @@ new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatyp
 
     node->name = g_strdup(name);
     node->st = st;
-    node->hash = with_hash ? g_hash_table_new(g_str_hash,g_str_equal) : NULL;
+    node->hash = with_hash ? stat_node_table_new() : NULL;
+
+    if (key) {
+        node->key = (const uint8_t *)(node + 1);
+        node->key_len = key_len;
+        memcpy(node + 1, key, key_len);
+    }
+    node->key_hash = key_hash;
 
     if (as_parent_node) {
         g_hash_table_insert(st->names,
@@ -527,20 +635,15 @@ new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatyp
 
     if (node->parent->children) {
         /* insert as last child */
-
-        for (last_chld = node->parent->children;
-             last_chld->next;
-             last_chld = last_chld->next ) ;
-
-        last_chld->next = node;
-
+        node->parent->last_child->next = node;
     } else {
         /* insert as first child */
         node->parent->children = node;
     }
+    node->parent->last_child = node;
 
     if(node->parent->hash) {
-        g_hash_table_replace(node->parent->hash,node->name,node);
+        stat_node_table_insert(node->parent->hash,node);
     }
 
     if (st->cfg->setup_node_pr) {
@@ -551,6 +654,14 @@ new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatyp
 
     return node;
 }
+
+static stat_node*
+new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatype datatype,
+          bool with_hash, bool as_parent_node)
+{
+    return new_stat_node_with_key(st, name, parent_id, datatype, with_hash, as_parent_node,
+                                  NULL, 0, stat_node_name_hash(name));
+}
 /***/
 
 extern int
@@ -659,32 +770,10 @@ update_burst_calc(stat_node *node, int value)
     }
 }
 
-/*
- * Increases by delta the counter of the node whose name is given
- * if the node does not exist yet it's created (with counter=1)
- * using parent_name as parent node.
- * with_hash=true to indicate that the created node will have a parent
- */
-int
-stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
-              int parent_id, bool with_hash, int value)
+/* Updates the counter, values or flags of a node as given by mode */
+static void
+manip_stat_node_int(manip_node_mode mode, stat_node *node, int value)
 {
-    stat_node *node = NULL;
-    stat_node *parent = NULL;
-
-    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
-
-    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
-
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
-
-    if ( node == NULL )
-        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
-
     switch (mode) {
         case MN_INCREASE:
             node->counter += value;
@@ -714,11 +803,75 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
             node->st_flags &= ~value;
             break;
     }
+}
 
-    if (node)
-        return node->id;
-    else
-        return -1;
+/*
+ * Increases by delta the counter of the node whose name is given
+ * if the node does not exist yet it's created (with counter=1)
+ * using parent_name as parent node.
+ * with_hash=true to indicate that the created node will have a parent
+ */
+int
+stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
+              int parent_id, bool with_hash, int value)
+{
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+    unsigned name_hash;
+
+    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    name_hash = stat_node_name_hash(name);
+    if( parent->hash ) {
+        node = stat_node_table_lookup_name(parent->hash,name,name_hash);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if ( node == NULL )
+        node = new_stat_node_with_key(st,name,parent_id,STAT_DT_INT,with_hash,with_hash,NULL,0,name_hash);
+
+    manip_stat_node_int(mode, node, value);
+
+    return node->id;
+}
+
+int
+stats_tree_manip_node_by_key(manip_node_mode mode, stats_tree *st, int parent_id,
+              const void *key, unsigned key_len,
+              stats_tree_node_name_func name_func, const void *name_data,
+              bool with_children, int value)
+{
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+    unsigned key_hash;
+
+    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    /* only the tables of children can be searched by key */
+    ws_assert( parent->hash );
+
+    /* an empty key is still a key */
+    if (key == NULL)
+        key = "";
+
+    key_hash = wmem_strong_hash((const uint8_t *)key, key_len);
+    node = stat_node_table_lookup_key(parent->hash,key,key_len,key_hash);
+
+    if ( node == NULL ) {
+        char *name = name_func(name_data);
+
+        node = new_stat_node_with_key(st,name,parent_id,STAT_DT_INT,with_children,with_children,key,key_len,key_hash);
+        g_free(name);
+    }
+
+    manip_stat_node_int(mode, node, value);
+
+    return node->id;
 }
 
 /*
@@ -739,7 +892,7 @@ stats_tree_manip_node_float(manip_node_mode mode, stats_tree *st, const char *na
     parent = (stat_node *)g_ptr_array_index(st->parents, parent_id);
 
     if (parent->hash) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash, name);
+        node = stat_node_table_lookup_name(parent->hash, name, stat_node_name_hash(name));
     }
     else {
         node = (stat_node *)g_hash_table_lookup(st->names, name);
@@ -945,7 +1098,7 @@ stats_tree_tick_range(stats_tree *st, const char *name, int parent_id,
     }
 
     if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+        node = stat_node_table_lookup_name(parent->hash,name,stat_node_name_hash(name));
     } else {
         node = (stat_node *)g_hash_table_lookup(st->names,name);
     }
@@ -211,12 +211,36 @@ WS_DLL_PUBLIC int stats_tree_manip_node_float(manip_node_mode mode,
                                         bool with_children,
                                         float value);
 
+/* returns the name of a new node, in memory allocated with g_malloc */
+typedef char *(*stats_tree_node_name_func)(const void *name_data);
+
+/*
+ * manipulates the value of the child of parent_id that is identified by
+ * key, key_len bytes of data such as an address or an integer id, instead
+ * of by its name. This saves formatting and hashing the name of the node
+ * each time: name_func is only called, with name_data, to name the node
+ * when it's created.
+ * The parent must have been created with with_children=true.
+ */
+WS_DLL_PUBLIC int stats_tree_manip_node_by_key(manip_node_mode mode,
+                                        stats_tree *st,
+                                        int parent_id,
+                                        const void *key,
+                                        unsigned key_len,
+                                        stats_tree_node_name_func name_func,
+                                        const void *name_data,
+                                        bool with_children,
+                                        int value);
+
 #define increase_stat_node(st,name,parent_id,with_children,value)       \
     (stats_tree_manip_node_int(MN_INCREASE,(st),(name),(parent_id),(with_children),(value)))
 
 #define tick_stat_node(st,name,parent_id,with_children)                 \
     (stats_tree_manip_node_int(MN_INCREASE,(st),(name),(parent_id),(with_children),1))
 
+#define tick_stat_node_by_key(st,parent_id,key,key_len,name_func,name_data,with_children) \
+    (stats_tree_manip_node_by_key(MN_INCREASE,(st),(parent_id),(key),(key_len),(name_func),(name_data),(with_children),1))
+
 #define set_stat_node(st,name,parent_id,with_children,value)            \
     (stats_tree_manip_node_int(MN_SET,(st),(name),(parent_id),(with_children),value))
 
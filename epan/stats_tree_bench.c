@@ -0,0 +1,161 @@
+/* stats_tree_bench.c
+ * Standalone program to measure how fast a stats_tree counts a large
+ * number of distinct hosts, with nodes looked up by name or by key.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <glib.h>
+
+#include <epan/stats_tree_priv.h>
+#include <wsutil/time_util.h>
+#include <wsutil/wmem/wmem.h>
+
+#define DEFAULT_KEY_COUNT       10000000
+
+/* Each key is counted this many times, as if seen in several packets */
+#define TICKS_PER_KEY           2
+
+static long
+max_resident_kb(void)
+{
+#ifndef _WIN32
+    struct rusage ru;
+
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#ifdef __APPLE__
+        return ru.ru_maxrss / 1024;
+#else
+        return ru.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+static char *
+host_node_name(const void *host)
+{
+    uint32_t addr = *(const uint32_t *)host;
+
+    return g_strdup_printf("%u.%u.%u.%u", addr >> 24, (addr >> 16) & 0xff,
+                           (addr >> 8) & 0xff, addr & 0xff);
+}
+
+int
+main(int argc, char **argv)
+{
+    stats_tree_cfg cfg;
+    stats_tree *st;
+    int hosts_node;
+    uint32_t key_count = DEFAULT_KEY_COUNT;
+    bool by_name = false;
+    uint32_t i, host;
+    int tick, arg;
+    char name[16];
+    double start_user, start_sys, end_user, end_sys;
+    long start_rss, end_rss;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--by-name") == 0) {
+            by_name = true;
+        } else {
+            key_count = (uint32_t)strtoul(argv[arg], NULL, 10);
+            if (key_count == 0) {
+                fprintf(stderr, "Usage: %s [--by-name] [key count]\n", argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    wmem_init();
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.abbr = (char *)"bench";
+    cfg.path = (char *)"Bench";
+
+    start_rss = max_resident_kb();
+    get_resource_usage(&start_user, &start_sys);
+
+    st = stats_tree_new(&cfg, NULL, NULL);
+    hosts_node = stats_tree_create_node(st, "Hosts", 0, STAT_DT_INT, true);
+
+    for (tick = 0; tick < TICKS_PER_KEY; tick++) {
+        for (i = 0; i < key_count; i++) {
+            /* spread the hosts over the address space */
+            host = i * 2654435761U;
+            if (by_name) {
+                snprintf(name, sizeof(name), "%u.%u.%u.%u", host >> 24, (host >> 16) & 0xff,
+                         (host >> 8) & 0xff, host & 0xff);
+                tick_stat_node(st, name, hosts_node, false);
+            } else {
+                tick_stat_node_by_key(st, hosts_node, &host, sizeof(host), host_node_name, &host, false);
+            }
+        }
+    }
+
+    get_resource_usage(&end_user, &end_sys);
+    end_rss = max_resident_kb();
+
+    /* Make sure every host got its own node, ticked every time. */
+    {
+        stat_node *parent = (stat_node *)g_ptr_array_index(st->parents, hosts_node);
+        stat_node *node;
+        uint32_t nodes = 0;
+
+        for (node = parent->children; node; node = node->next) {
+            if (node->counter != TICKS_PER_KEY) {
+                fprintf(stderr, "Node %s was counted %d times\n", node->name, node->counter);
+                stats_tree_free(st);
+                return 1;
+            }
+            nodes++;
+        }
+        if (nodes != key_count) {
+            fprintf(stderr, "%u nodes for %u keys\n", nodes, key_count);
+            stats_tree_free(st);
+            return 1;
+        }
+    }
+
+    printf("keys:                %u, looked up %s\n", key_count, by_name ? "by name" : "by key");
+    printf("ticks:               %u\n", key_count * TICKS_PER_KEY);
+    if (start_rss >= 0 && end_rss >= 0) {
+        printf("max resident growth: %.1f MiB (%.1f bytes/key)\n",
+               (end_rss - start_rss) / 1024.0,
+               (end_rss - start_rss) * 1024.0 / key_count);
+    }
+    printf("time:                %.3f s user, %.3f s system\n",
+           end_user - start_user, end_sys - start_sys);
+
+    stats_tree_free(st);
+    wmem_cleanup();
+    return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
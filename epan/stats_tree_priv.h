@@ -38,6 +38,9 @@ typedef struct _tree_cfg_pres tree_cfg_pres;
 typedef struct _stat_node stat_node;
 typedef struct _stats_tree_cfg stats_tree_cfg;
 
+/** an open addressing table of the children of a node */
+typedef struct _stat_node_table stat_node_table;
+
 typedef struct _range_pair {
 	int floor;
 	int ceil;
@@ -57,6 +60,12 @@ struct _stat_node {
 	int					id;
 	stat_node_datatype	datatype;
 
+	/** key given to stats_tree_manip_node_by_key(), NULL for nodes looked up by name */
+	const uint8_t		*key;
+	unsigned			key_len;
+	/** hash of the key or name, for the parent's table of children */
+	unsigned			key_hash;
+
 	/** the counter it keeps */
 	int			counter;
 	/** total of all values submitted - for computing averages */
@@ -81,8 +90,8 @@ struct _stat_node {
 	int			max_burst;
 	double			burst_time;
 
-	/** children nodes by name */
-	GHashTable		*hash;
+	/** children nodes by name or key */
+	stat_node_table		*hash;
 
 	/** the owner of this node */
 	stats_tree		*st;
@@ -90,6 +99,7 @@ struct _stat_node {
 	/** relatives */
 	stat_node		*parent;
 	stat_node		*children;
+	stat_node		*last_child;
 	stat_node		*next;
 
 	/** used to check if value is within range */
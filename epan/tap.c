@@ -74,9 +74,13 @@ typedef struct _tap_packet_t {
 
 #define TAP_PACKET_IS_ERROR_PACKET	0x00000001	/* packet being queued is an error packet */
 
-#define TAP_PACKET_QUEUE_LEN 5000
-static tap_packet_t tap_packet_array[TAP_PACKET_QUEUE_LEN];
-static unsigned tap_packet_index;
+/*
+ * The queue grows as needed and keeps its storage between packets, so a
+ * packet with many tapped PDUs (e.g. a large reassembled PDU) costs
+ * allocations only the first time it is seen.
+ */
+#define TAP_PACKET_QUEUE_INITIAL_LEN 256
+static GArray *tap_packet_array;
 
 typedef struct _tap_listener_t {
 	struct _tap_listener_t *next;
@@ -95,6 +99,15 @@ typedef struct _tap_listener_t {
 
 static tap_listener_t *tap_listener_queue;
 
+/*
+ * Index of the listeners by tap id; entry tap_id is a GPtrArray of the
+ * listeners for that tap, in the same order as in tap_listener_queue,
+ * or NULL if there are none. Rebuilt whenever a listener is added or
+ * removed so that pushing the queued packets doesn't have to walk
+ * every listener for every packet.
+ */
+static GPtrArray *tap_listener_index;
+
 static GSList *tap_plugins;
 
 #ifdef HAVE_PLUGINS
@@ -150,7 +163,7 @@ register_all_tap_listeners(tap_reg_t const *tap_reg_listeners)
 void
 tap_init(void)
 {
-	tap_packet_index=0;
+	tap_packet_array = g_array_sized_new(false, false, sizeof(tap_packet_t), TAP_PACKET_QUEUE_INITIAL_LEN);
 }
 
 /* **********************************************************************
@@ -233,23 +246,15 @@ tap_queue_packet(int tap_id, packet_info *pinfo, const void *tap_specific_data)
 	if(!tapping_is_active){
 		return;
 	}
-	/*
-	 * XXX - should we allocate this with an ep_allocator,
-	 * rather than having a fixed maximum number of entries?
-	 */
-	if(tap_packet_index >= TAP_PACKET_QUEUE_LEN){
-		ws_warning("Too many taps queued");
-		return;
-	}
 
-	tpt=&tap_packet_array[tap_packet_index];
+	g_array_set_size(tap_packet_array, tap_packet_array->len + 1);
+	tpt=&g_array_index(tap_packet_array, tap_packet_t, tap_packet_array->len - 1);
 	tpt->tap_id=tap_id;
 	tpt->flags = 0;
 	if (pinfo->flags.in_error_pkt)
 		tpt->flags |= TAP_PACKET_IS_ERROR_PACKET;
 	tpt->pinfo=pinfo;
 	tpt->tap_specific_data=tap_specific_data;
-	tap_packet_index++;
 }
 
 
@@ -292,7 +297,7 @@ tap_queue_init(epan_dissect_t *edt)
 
 	tapping_is_active=true;
 
-	tap_packet_index=0;
+	g_array_set_size(tap_packet_array, 0);
 
 	tap_build_interesting (edt);
 }
@@ -305,7 +310,8 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 {
 	tap_packet_t *tp;
 	tap_listener_t *tl;
-	unsigned i;
+	GPtrArray *listeners;
+	unsigned i, j;
 
 	/* nothing to do, just return */
 	if(!tapping_is_active){
@@ -315,71 +321,77 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 	tapping_is_active=false;
 
 	/* nothing to do, just return */
-	if(!tap_packet_index){
+	if(!tap_packet_array->len){
 		return;
 	}
 
-	/* loop over all tap listeners and call the listener callback
-	   for all packets that match the filter. */
-	for(i=0;i<tap_packet_index;i++){
-		for(tl=tap_listener_queue;tl;tl=tl->next){
-			tp=&tap_packet_array[i];
+	/* loop over all queued packets and call the listener callback
+	   of all the listeners of that tap that match the filter. */
+	for(i=0;i<tap_packet_array->len;i++){
+		tp=&g_array_index(tap_packet_array, tap_packet_t, i);
+		if(tp->tap_id <= 0 || (unsigned)tp->tap_id >= tap_listener_index->len){
+			continue;
+		}
+		listeners=(GPtrArray *)g_ptr_array_index(tap_listener_index, tp->tap_id);
+		if(!listeners){
+			continue;
+		}
+		for(j=0;j<listeners->len;j++){
+			tl=(tap_listener_t *)g_ptr_array_index(listeners, j);
 			/* Don't tap the packet if it's an "error packet"
 			 * unless the listener has requested that we do so.
 			 */
-			if (!(tp->flags & TAP_PACKET_IS_ERROR_PACKET) || (tl->flags & TL_REQUIRES_ERROR_PACKETS))
-			{
-				if(tp->tap_id==tl->tap_id){
-					if(!tl->packet){
-						/* There isn't a per-packet
-						 * routine for this tap.
-						 */
-						continue;
-					}
-					if(tl->failed){
-						/* A previous call failed,
-						 * meaning "stop running this
-						 * tap", so don't call the
-						 * packet routine.
-						 */
+			if ((tp->flags & TAP_PACKET_IS_ERROR_PACKET) && !(tl->flags & TL_REQUIRES_ERROR_PACKETS)){
+				continue;
+			}
+			if(!tl->packet){
+				/* There isn't a per-packet
+				 * routine for this tap.
+				 */
+				continue;
+			}
+			if(tl->failed){
+				/* A previous call failed,
+				 * meaning "stop running this
+				 * tap", so don't call the
+				 * packet routine.
+				 */
+				continue;
+			}
+
+			/* If we have a filter, see if the
+			 * packet passes.
+			 */
+			unsigned flags = tl->flags;
+			if(tl->code){
+				if (!dfilter_apply_edt(tl->code, edt)){
+					/* The packet didn't
+					 * pass the filter. */
+					if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
+						flags |= TL_DISPLAY_FILTER_IGNORED;
+					else
 						continue;
-					}
-
-					/* If we have a filter, see if the
-					 * packet passes.
-					 */
-					unsigned flags = tl->flags;
-					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
-							/* The packet didn't
-							 * pass the filter. */
-							if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
-								flags |= TL_DISPLAY_FILTER_IGNORED;
-							else
-								continue;
-						}
-					}
-
-					/* So call the per-packet routine. */
-					tap_packet_status status;
-
-					status = tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
-
-					switch (status) {
-
-					case TAP_PACKET_DONT_REDRAW:
-						break;
-
-					case TAP_PACKET_REDRAW:
-						tl->needs_redraw=true;
-						break;
-
-					case TAP_PACKET_FAILED:
-						tl->failed=true;
-						break;
-					}
 				}
 			}
+
+			/* So call the per-packet routine. */
+			tap_packet_status status;
+
+			status = tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
+
+			switch (status) {
+
+			case TAP_PACKET_DONT_REDRAW:
+				break;
+
+			case TAP_PACKET_REDRAW:
+				tl->needs_redraw=true;
+				break;
+
+			case TAP_PACKET_FAILED:
+				tl->failed=true;
+				break;
+			}
 		}
 	}
 }
@@ -411,13 +423,13 @@ fetch_tapped_data(int tap_id, int idx)
 	}
 
 	/* nothing to do, just return */
-	if(!tap_packet_index){
+	if(!tap_packet_array->len){
 		return NULL;
 	}
 
 	/* loop over all tapped packets and return the one with index idx */
-	for(i=0;i<tap_packet_index;i++){
-		tp=&tap_packet_array[i];
+	for(i=0;i<tap_packet_array->len;i++){
+		tp=&g_array_index(tap_packet_array, tap_packet_t, i);
 		if(tp->tap_id==tap_id){
 			if(!idx--){
 				return tp->tap_specific_data;
@@ -509,6 +521,46 @@ find_tap_id(const char *name)
 	return 0;
 }
 
+static void
+free_tap_listener_index(void)
+{
+	unsigned i;
+
+	if(!tap_listener_index){
+		return;
+	}
+	for(i=0;i<tap_listener_index->len;i++){
+		if(g_ptr_array_index(tap_listener_index, i)){
+			g_ptr_array_free((GPtrArray *)g_ptr_array_index(tap_listener_index, i), true);
+		}
+	}
+	g_ptr_array_free(tap_listener_index, true);
+	tap_listener_index = NULL;
+}
+
+/* (Re)build the index of the listeners by tap id. */
+static void
+rebuild_tap_listener_index(void)
+{
+	tap_listener_t *tl;
+	GPtrArray *listeners;
+
+	free_tap_listener_index();
+	tap_listener_index = g_ptr_array_new();
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if((unsigned)tl->tap_id >= tap_listener_index->len){
+			g_ptr_array_set_size(tap_listener_index, tl->tap_id + 1);
+		}
+		listeners=(GPtrArray *)g_ptr_array_index(tap_listener_index, tl->tap_id);
+		if(!listeners){
+			listeners=g_ptr_array_new();
+			g_ptr_array_index(tap_listener_index, tl->tap_id)=listeners;
+		}
+		g_ptr_array_add(listeners, tl);
+	}
+}
+
 static void
 free_tap_listener(tap_listener_t *tl)
 {
@@ -577,6 +629,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->next=tap_listener_queue;
 
 	tap_listener_queue=tl;
+	rebuild_tap_listener_index();
 
 	return NULL;
 }
@@ -685,6 +738,7 @@ remove_tap_listener(void *tapdata)
 			return;
 		}
 	}
+	rebuild_tap_listener_index();
 	free_tap_listener(tl);
 }
 
@@ -735,16 +789,10 @@ tap_listeners_require_columns(void)
 bool
 have_tap_listener(int tap_id)
 {
-	tap_listener_t *tap_queue = tap_listener_queue;
-
-	while(tap_queue) {
-		if(tap_queue->tap_id == tap_id)
-			return true;
+	if(!tap_listener_index || tap_id <= 0 || (unsigned)tap_id >= tap_listener_index->len)
+		return false;
 
-		tap_queue = tap_queue->next;
-	}
-
-	return false;
+	return g_ptr_array_index(tap_listener_index, tap_id) != NULL;
 }
 
 /*
@@ -803,6 +851,7 @@ void tap_cleanup(void)
 		free_tap_listener(elem_lq);
 	}
 	tap_listener_queue = NULL;
+	free_tap_listener_index();
 
 	while(head_dl){
 		elem_dl = head_dl;
@@ -814,6 +863,9 @@ void tap_cleanup(void)
 
 	g_slist_free(tap_plugins);
 	tap_plugins = NULL;
+
+	g_array_free(tap_packet_array, true);
+	tap_packet_array = NULL;
 }
 
 /*
@@ -1222,48 +1222,63 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
         epan_dissect_t *edt, dfilter_t *dfcode, column_info *cinfo,
         wtap_rec *rec, Buffer *buf, bool add_to_packet_list)
 {
+    bool dissect;
+
     frame_data_set_before_dissect(fdata, &cf->elapsed_time,
             &cf->provider.ref, cf->provider.prev_dis);
     cf->provider.prev_cap = fdata;
 
-    if (dfcode != NULL) {
-        epan_dissect_prime_with_dfilter(edt, dfcode);
-    }
+    /*
+     * If the frame has already been dissected once, it has left all the
+     * state later frames need, so if the display filter can't match it
+     * on its frame_data alone, and no tap wants to see it, there's no
+     * need to dissect it again.
+     */
+    dissect = !fdata->visited || add_to_packet_list ||
+            dfilter_apply_frame_checks(dfcode, fdata, rec) ||
+            tap_listeners_require_dissection();
+    if (dissect) {
+        if (dfcode != NULL) {
+            epan_dissect_prime_with_dfilter(edt, dfcode);
+        }
 #if 0
-    /* Prepare coloring rules, this ensures that display filter rules containing
-     * frame.color_rule references are still processed.
-     * TODO: actually detect that situation or maybe apply other optimizations? */
-    if (edt->tree && color_filters_used()) {
-        color_filters_prime_edt(edt);
-        fdata->need_colorize = 1;
-    }
+        /* Prepare coloring rules, this ensures that display filter rules containing
+         * frame.color_rule references are still processed.
+         * TODO: actually detect that situation or maybe apply other optimizations? */
+        if (edt->tree && color_filters_used()) {
+            color_filters_prime_edt(edt);
+            fdata->need_colorize = 1;
+        }
 #endif
 
-    if (!fdata->visited) {
-        /* This is the first pass, so prime the epan_dissect_t with the
-           hfids postdissectors want on the first pass. */
-        prime_epan_dissect_with_postdissector_wanted_hfids(edt);
-    }
+        if (!fdata->visited) {
+            /* This is the first pass, so prime the epan_dissect_t with the
+               hfids postdissectors want on the first pass. */
+            prime_epan_dissect_with_postdissector_wanted_hfids(edt);
+        }
 
-    /* Initialize passed_dfilter here so that dissectors can hide packets. */
-    /* XXX We might want to add a separate "visible" bit to frame_data instead. */
-    fdata->passed_dfilter = 1;
+        /* Initialize passed_dfilter here so that dissectors can hide packets. */
+        /* XXX We might want to add a separate "visible" bit to frame_data instead. */
+        fdata->passed_dfilter = 1;
 
-    /* Dissect the frame. */
-    epan_dissect_run_with_taps(edt, cf->cd_t, rec,
-            frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
-            fdata, cinfo);
+        /* Dissect the frame. */
+        epan_dissect_run_with_taps(edt, cf->cd_t, rec,
+                frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
+                fdata, cinfo);
 
-    if (fdata->passed_dfilter && dfcode != NULL) {
-        fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
+        if (fdata->passed_dfilter && dfcode != NULL) {
+            fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
 
-        if (fdata->passed_dfilter && edt->pi.fd->dependent_frames) {
-            /* This frame passed the display filter but it may depend on other
-             * (potentially not displayed) frames.  Find those frames and mark them
-             * as depended upon.
-             */
-            g_hash_table_foreach(edt->pi.fd->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+            if (fdata->passed_dfilter && frame_data_get_dependent_frames(edt->pi.fd)) {
+                /* This frame passed the display filter but it may depend on other
+                 * (potentially not displayed) frames.  Find those frames and mark them
+                 * as depended upon.
+                 */
+                g_hash_table_foreach(frame_data_get_dependent_frames(edt->pi.fd), find_and_mark_frame_depended_upon, cf->provider.frames);
+            }
         }
+    } else {
+        fdata->passed_dfilter = 0;
     }
 
     if (fdata->passed_dfilter || fdata->ref_time)
@@ -1296,7 +1311,8 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
         cf->last_displayed = fdata->num;
     }
 
-    epan_dissect_reset(edt);
+    if (dissect)
+        epan_dissect_reset(edt);
 }
 
 /*
@@ -2489,6 +2505,7 @@ typedef struct {
     int          *col_widths;
     int           num_visible_cols;
     int          *visible_cols;
+    bool         *needed_cols;
     epan_dissect_t edt;
 } print_callback_args_t;
 
@@ -2514,7 +2531,8 @@ print_packet(capture_file *cf, frame_data *fdata, wtap_rec *rec, Buffer *buf,
         epan_dissect_run(&args->edt, cf->cd_t, rec,
                 frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
                 fdata, &cf->cinfo);
-        epan_dissect_fill_in_columns(&args->edt, false, true);
+        /* Only the visible columns get formatted, as they're printed. */
+        epan_dissect_fill_in_columns_lazy(&args->edt, false, true, args->needed_cols);
     } else
         epan_dissect_run(&args->edt, cf->cd_t, rec,
                 frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
@@ -2679,6 +2697,7 @@ cf_print_packets(capture_file *cf, print_args_t *print_args,
     callback_args.col_widths = NULL;
     callback_args.num_visible_cols = 0;
     callback_args.visible_cols = NULL;
+    callback_args.needed_cols = NULL;
 
     if (!print_preamble(print_args->stream, cf->filename, get_ws_vcs_version_info())) {
         destroy_print_stream(print_args->stream);
@@ -2716,6 +2735,7 @@ cf_print_packets(capture_file *cf, print_args_t *print_args,
         callback_args.num_visible_cols = num_visible_col;
         callback_args.col_widths = g_new(int, num_visible_col);
         callback_args.visible_cols = g_new(int, num_visible_col);
+        callback_args.needed_cols = g_new0(bool, cf->cinfo.num_cols);
         cp = &callback_args.header_line_buf[0];
         line_len = 0;
         visible_col_count = 0;
@@ -2731,6 +2751,7 @@ cf_print_packets(capture_file *cf, print_args_t *print_args,
 
             /* Save the order of visible columns */
             callback_args.visible_cols[visible_col_count] = i;
+            callback_args.needed_cols[i] = true;
 
             /* Don't pad the last column. */
             if (i == last_visible_col)
@@ -2796,6 +2817,7 @@ cf_print_packets(capture_file *cf, print_args_t *print_args,
     g_free(callback_args.line_buf);
     g_free(callback_args.col_widths);
     g_free(callback_args.visible_cols);
+    g_free(callback_args.needed_cols);
 
     switch (ret) {
 
@@ -5245,9 +5267,9 @@ save_record(capture_file *cf, frame_data *fdata, wtap_rec *rec,
     new_rec.block  = pkt_block;
     new_rec.block_was_modified = fdata->has_modified_block ? true : false;
 
-    if (!nstime_is_zero(&fdata->shift_offset)) {
+    if (!nstime_is_zero(frame_data_get_shift_offset(fdata))) {
         if (new_rec.presence_flags & WTAP_HAS_TS) {
-            nstime_add(&new_rec.ts, &fdata->shift_offset);
+            nstime_add(&new_rec.ts, frame_data_get_shift_offset(fdata));
         }
     }
 
@@ -5270,7 +5292,8 @@ save_record(capture_file *cf, frame_data *fdata, wtap_rec *rec,
      * If we're exporting to a different file, then don't do that.
      */
     if (!args->export && new_rec.presence_flags & WTAP_HAS_TS) {
-        nstime_set_zero(&fdata->shift_offset);
+        nstime_t nulltime = NSTIME_INIT_ZERO;
+        frame_data_set_shift_offset(fdata, &nulltime);
     }
 
     return true;
@@ -96,6 +96,34 @@ static void uat_plen_record_post_update_cb(void) {
 
 UAT_RANGE_CB_DEF(uat_plen_records, packet_range, uat_plen_record_t)
 
+/* Names the nodes of addresses, which are looked up by address_key() */
+static char *address_node_name(const void *addr) {
+	return address_to_str(NULL, (const address *)addr);
+}
+
+/* Addresses of different types can have the same data, so the key of
+   an address's node is its type and length followed by its data */
+struct address_key_hdr {
+	int type;
+	int len;
+};
+
+static int tick_address_node(stats_tree *st, packet_info *pinfo, int parent_id, const address *addr, bool with_children) {
+	struct address_key_hdr *key;
+	unsigned key_len = (unsigned)sizeof(*key) + addr->len;
+
+	key = (struct address_key_hdr *)wmem_alloc(pinfo->pool, key_len);
+	key->type = addr->type;
+	key->len = addr->len;
+	if (addr->len > 0)
+		memcpy(key + 1, addr->data, addr->len);
+	return tick_stat_node_by_key(st, parent_id, key, key_len, address_node_name, addr, with_children);
+}
+
+static char *port_node_name(const void *port) {
+	return g_strdup_printf("%u", *(const uint32_t *)port);
+}
+
 /* ip host stats_tree -- basic test */
 static int st_node_ipv4 = -1;
 static int st_node_ipv6 = -1;
@@ -112,8 +140,8 @@ static void ipv6_hosts_stats_tree_init(stats_tree *st) {
 
 static tap_packet_status ip_hosts_stats_tree_packet(stats_tree *st, packet_info *pinfo, int st_node, const char *st_str) {
 	tick_stat_node(st, st_str, 0, false);
-	tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_src), st_node, false);
-	tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_dst), st_node, false);
+	tick_address_node(st, pinfo, st_node, &pinfo->net_src, false);
+	tick_address_node(st, pinfo, st_node, &pinfo->net_dst, false);
 	return TAP_PACKET_REDRAW;
 }
 
@@ -166,10 +194,10 @@ static tap_packet_status ip_srcdst_stats_tree_packet(stats_tree *st,
 						     const char *st_str_dst) {
 	/* update source branch */
 	tick_stat_node(st, st_str_src, 0, false);
-	tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_src), st_node_src, false);
+	tick_address_node(st, pinfo, st_node_src, &pinfo->net_src, false);
 	/* update destination branch */
 	tick_stat_node(st, st_str_dst, 0, false);
-	tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_dst), st_node_dst, false);
+	tick_address_node(st, pinfo, st_node_dst, &pinfo->net_dst, false);
 	return TAP_PACKET_REDRAW;
 }
 
@@ -225,15 +253,13 @@ static void ipv6_dsts_stats_tree_init(stats_tree *st) {
 }
 
 static tap_packet_status dsts_stats_tree_packet(stats_tree *st, packet_info *pinfo, int st_node, const char *st_str) {
-	static char str[128];
 	int ip_dst_node;
 	int protocol_node;
 
 	tick_stat_node(st, st_str, 0, false);
-	ip_dst_node = tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_dst), st_node, true);
+	ip_dst_node = tick_address_node(st, pinfo, st_node, &pinfo->net_dst, true);
 	protocol_node = tick_stat_node(st, port_type_to_str(pinfo->ptype), ip_dst_node, true);
-	snprintf(str, sizeof(str) - 1, "%u", pinfo->destport);
-	tick_stat_node(st, str, protocol_node, true);
+	tick_stat_node_by_key(st, protocol_node, &pinfo->destport, sizeof(pinfo->destport), port_node_name, &pinfo->destport, true);
 	return TAP_PACKET_REDRAW;
 }
 
@@ -73,6 +73,9 @@ capture_file cfile;
 static uint32_t cum_bytes;
 static frame_data ref_frame;
 
+/* Is the sequential side kept open to read records added to the file later? */
+static bool tailing;
+
 static void sharkd_cmdarg_err(const char *msg_format, va_list ap);
 static void sharkd_cmdarg_err_cont(const char *msg_format, va_list ap);
 
@@ -290,8 +293,8 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
          * if a display filter was given and it matches this packet.
          */
         if (edt && cf->dfcode) {
-            if (dfilter_apply_edt(cf->dfcode, edt) && edt->pi.fd->dependent_frames) {
-                g_hash_table_foreach(edt->pi.fd->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+            if (dfilter_apply_edt(cf->dfcode, edt) && frame_data_get_dependent_frames(edt->pi.fd)) {
+                g_hash_table_foreach(frame_data_get_dependent_frames(edt->pi.fd), find_and_mark_frame_depended_upon, cf->provider.frames);
             }
         }
 
@@ -309,8 +312,26 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
 }
 
 
+/*
+ * When tailing a file that's still being written, a record cut short at
+ * the end of the file isn't an error: go back to its start, to read it
+ * again once the rest of it has been written.
+ */
+static int
+tail_short_read(capture_file *cf, int err, char **err_info, int64_t record_offset)
+{
+    if (err != WTAP_ERR_SHORT_READ)
+        return err;
+
+    g_free(*err_info);
+    *err_info = NULL;
+    if (!wtap_sequential_seek(cf->provider.wth, record_offset, &err))
+        return err;
+    return 0;
+}
+
 static int
-load_cap_file(capture_file *cf, int max_packet_count, int64_t max_byte_count)
+load_cap_file(capture_file *cf, int max_packet_count, int64_t max_byte_count, bool tail)
 {
     int          err;
     char        *err_info = NULL;
@@ -371,15 +392,24 @@ load_cap_file(capture_file *cf, int max_packet_count, int64_t max_byte_count)
         wtap_rec_cleanup(&rec);
         ws_buffer_free(&buf);
 
-        /* Close the sequential I/O side, to free up memory it requires. */
-        wtap_sequential_close(cf->provider.wth);
+        if (tail)
+            err = tail_short_read(cf, err, &err_info, data_offset);
+
+        if (tail && err == 0) {
+            /* Keep the sequential side, and where the first pass got to,
+             * for sharkd_continue_tail(). */
+            tailing = true;
+        } else {
+            /* Close the sequential I/O side, to free up memory it requires. */
+            wtap_sequential_close(cf->provider.wth);
 
-        /* Allow the protocol dissectors to free up memory that they
-         * don't need after the sequential run-through of the packets. */
-        postseq_cleanup_all_protocols();
+            /* Allow the protocol dissectors to free up memory that they
+             * don't need after the sequential run-through of the packets. */
+            postseq_cleanup_all_protocols();
 
-        cf->provider.prev_dis = NULL;
-        cf->provider.prev_cap = NULL;
+            cf->provider.prev_dis = NULL;
+            cf->provider.prev_cap = NULL;
+        }
     }
 
     if (err != 0) {
@@ -425,6 +455,7 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile
     cf->provider.ref = NULL;
     cf->provider.prev_dis = NULL;
     cf->provider.prev_cap = NULL;
+    tailing = false;
 
     /* Create new epan session for dissection. */
     epan_free(cf->epan);
@@ -473,7 +504,104 @@ sharkd_cf_open(const char *fname, unsigned int type, bool is_tempfile, int *err)
 int
 sharkd_load_cap_file(void)
 {
-    return load_cap_file(&cfile, 0, 0);
+    return load_cap_file(&cfile, 0, 0, false);
+}
+
+/*
+ * Can records added to the file later be read? Only pcap and pcapng files,
+ * such as dumpcap writes, are tailed, as their readers give the start of a
+ * record that was cut short, see wtap_sequential_seek().
+ */
+bool
+sharkd_can_tail(void)
+{
+    int file_type_subtype = wtap_file_type_subtype(cfile.provider.wth);
+
+    if (wtap_get_compression_type(cfile.provider.wth) != WTAP_UNCOMPRESSED)
+        return false;
+
+    return file_type_subtype == wtap_pcapng_file_type_subtype() ||
+        file_type_subtype == wtap_pcap_file_type_subtype() ||
+        file_type_subtype == wtap_pcap_nsec_file_type_subtype();
+}
+
+/*
+ * Like sharkd_load_cap_file(), but keep the file open for reading records
+ * added to it later with sharkd_continue_tail(), until sharkd_finish_tail().
+ */
+int
+sharkd_load_cap_file_tail(void)
+{
+    return load_cap_file(&cfile, 0, 0, true);
+}
+
+/*
+ * Read the records added to the file since it was last read, as cf_continue_tail()
+ * does for a live capture. The number of new frames is put in *new_frames.
+ */
+int
+sharkd_continue_tail(uint32_t *new_frames)
+{
+    capture_file *cf = &cfile;
+    uint32_t     count = cf->count;
+    int          err;
+    char        *err_info = NULL;
+    int64_t      data_offset = 0;
+    wtap_rec     rec;
+    Buffer       buf;
+    epan_dissect_t *edt;
+
+    *new_frames = 0;
+    if (!tailing)
+        return 0;
+
+    edt = epan_dissect_new(cf->epan,
+            (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids()), false);
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+
+    wtap_cleareof(cf->provider.wth);
+    while (wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        process_packet(cf, edt, data_offset, &rec, &buf);
+        wtap_rec_reset(&rec);
+    }
+    err = tail_short_read(cf, err, &err_info, data_offset);
+
+    epan_dissect_free(edt);
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+
+    if (err != 0) {
+        cfile_read_failure_message(cf->filename, err, err_info);
+        sharkd_finish_tail();
+    }
+
+    *new_frames = cf->count - count;
+    return err;
+}
+
+/*
+ * Stop reading records added to the file, and free up what the sequential
+ * side needed, as sharkd_load_cap_file() does once it has read the file.
+ */
+void
+sharkd_finish_tail(void)
+{
+    if (!tailing)
+        return;
+
+    tailing = false;
+    wtap_sequential_close(cfile.provider.wth);
+    postseq_cleanup_all_protocols();
+    cfile.provider.prev_dis = NULL;
+    cfile.provider.prev_cap = NULL;
+}
+
+bool
+sharkd_is_tailing(void)
+{
+    return tailing;
 }
 
 frame_data *
@@ -543,6 +671,16 @@ sharkd_dissect_request(uint32_t framenum, uint32_t frame_ref_num,
 
 int
 sharkd_retap(void)
+{
+    return sharkd_retap_from(1);
+}
+
+/*
+ * Run the tap listeners over the frames from first_frame on; they're only
+ * reset if that's all of them.
+ */
+int
+sharkd_retap_from(uint32_t first_frame)
 {
     uint32_t         framenum;
     frame_data      *fdata;
@@ -577,9 +715,10 @@ sharkd_retap(void)
     ws_buffer_init(&buf, 1514);
     epan_dissect_init(&edt, cfile.epan, create_proto_tree, false);
 
-    reset_tap_listeners();
+    if (first_frame <= 1)
+        reset_tap_listeners();
 
-    for (framenum = 1; framenum <= cfile.count; framenum++) {
+    for (framenum = MAX(first_frame, 1); framenum <= cfile.count; framenum++) {
         fdata = sharkd_get_frame(framenum);
 
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
@@ -606,6 +745,18 @@ sharkd_retap(void)
 
 int
 sharkd_filter(const char *dftext, uint8_t **result)
+{
+    *result = NULL;
+    return sharkd_filter_from(dftext, 1, result);
+}
+
+/*
+ * Like sharkd_filter(), but only for the frames from first_frame on;
+ * *result holds the results for the frames before it, and is extended
+ * to cover the rest.
+ */
+int
+sharkd_filter_from(const char *dftext, uint32_t first_frame, uint8_t **result)
 {
     dfilter_t  *dfcode = NULL;
 
@@ -617,7 +768,7 @@ sharkd_filter(const char *dftext, uint8_t **result)
     char *err_info = NULL;
 
     uint8_t *result_bits;
-    uint8_t passed_bits;
+    size_t result_len;
 
     epan_dissect_t edt;
 
@@ -627,6 +778,7 @@ sharkd_filter(const char *dftext, uint8_t **result)
 
     /* if dfilter_compile() success, but (dfcode == NULL) all frames are matching */
     if (dfcode == NULL) {
+        g_free(*result);
         *result = NULL;
         return 0;
     }
@@ -637,17 +789,28 @@ sharkd_filter(const char *dftext, uint8_t **result)
     ws_buffer_init(&buf, 1514);
     epan_dissect_init(&edt, cfile.epan, true, false);
 
-    passed_bits = 0;
-    result_bits = (uint8_t *) g_malloc(2 + (frames_count / 8));
+    /* Frame n is bit n % 8 of byte n / 8. */
+    result_len = 2 + (frames_count / 8);
+    if (*result == NULL || first_frame <= 1) {
+        first_frame = 1;
+        result_bits = (uint8_t *) g_realloc(*result, result_len);
+        memset(result_bits, 0, result_len);
+    } else {
+        result_bits = (uint8_t *) g_realloc(*result, result_len);
+        result_bits[first_frame / 8] &= (1 << (first_frame % 8)) - 1;
+        memset(&result_bits[first_frame / 8 + 1], 0, result_len - (first_frame / 8 + 1));
+
+        for (framenum = first_frame - 1; framenum > 0; framenum--) {
+            if (result_bits[framenum / 8] & (1 << (framenum % 8))) {
+                prev_dis_num = framenum;
+                break;
+            }
+        }
+    }
 
-    for (framenum = 1; framenum <= frames_count; framenum++) {
+    for (framenum = first_frame; framenum <= frames_count; framenum++) {
         frame_data *fdata = sharkd_get_frame(framenum);
 
-        if ((framenum & 7) == 0) {
-            result_bits[(framenum / 8) - 1] = passed_bits;
-            passed_bits = 0;
-        }
-
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
             break;
 
@@ -662,7 +825,7 @@ sharkd_filter(const char *dftext, uint8_t **result)
                 fdata, NULL);
 
         if (dfilter_apply_edt(dfcode, &edt)) {
-            passed_bits |= (1 << (framenum % 8));
+            result_bits[framenum / 8] |= (1 << (framenum % 8));
             prev_dis_num = framenum;
         }
 
@@ -672,10 +835,6 @@ sharkd_filter(const char *dftext, uint8_t **result)
         epan_dissect_reset(&edt);
     }
 
-    if ((framenum & 7) == 0)
-        framenum--;
-    result_bits[framenum / 8] = passed_bits;
-
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
     epan_dissect_cleanup(&edt);
@@ -31,8 +31,15 @@ typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, str
 /* sharkd.c */
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, bool is_tempfile, int *err);
 int sharkd_load_cap_file(void);
+bool sharkd_can_tail(void);
+int sharkd_load_cap_file_tail(void);
+int sharkd_continue_tail(uint32_t *new_frames);
+void sharkd_finish_tail(void);
+bool sharkd_is_tailing(void);
 int sharkd_retap(void);
+int sharkd_retap_from(uint32_t first_frame);
 int sharkd_filter(const char *dftext, uint8_t **result);
+int sharkd_filter_from(const char *dftext, uint32_t first_frame, uint8_t **result);
 frame_data *sharkd_get_frame(uint32_t framenum);
 enum dissect_request_status {
   DISSECT_REQUEST_SUCCESS,
@@ -55,6 +62,7 @@ int sharkd_init(int argc, char **argv);
 int sharkd_loop(int argc _U_, char* argv[] _U_);
 
 /* sharkd_session.c */
+void sharkd_session_start(int mode_setting);
 int sharkd_session_main(int mode_setting);
 
 #endif /* __SHARKD_H */
@@ -34,7 +34,11 @@
 
 #ifndef _WIN32
 #include <sys/un.h>
+#include <sys/wait.h>
 #include <netinet/tcp.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 #include <wsutil/strtoi.h>
@@ -50,8 +54,12 @@
 # define SHARKD_UNIX_SUPPORT
 #endif
 
+/* Most session processes kept ready for connections with --pool-size */
+#define SHARKD_MAX_POOL_SIZE    256
+
 static int mode;
 static socket_handle_t _server_fd = INVALID_SOCKET;
+static uint32_t pool_size;
 
 static socket_handle_t
 socket_init(char *path)
@@ -183,11 +191,19 @@ print_usage(FILE* output)
     fprintf(output, "  -v, --version            show version information\n");
     fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
     fprintf(output, "                           start with specified configuration profile\n");
+#ifndef _WIN32
+    fprintf(output, "  -p <count>, --pool-size <count>\n");
+    fprintf(output, "                           with -a, keep <count> session processes ready\n");
+    fprintf(output, "                           for new connections (default: 0, fork on connect)\n");
+#endif
 
     fprintf(output, "\n");
     fprintf(output, "  Examples:\n");
     fprintf(output, "    sharkd -C myprofile\n");
     fprintf(output, "    sharkd -a tcp:127.0.0.1:4446 -C myprofile\n");
+#ifndef _WIN32
+    fprintf(output, "    sharkd -a unix:/tmp/sharkd.sock -p 4\n");
+#endif
 
     fprintf(output, "\n");
     fprintf(output, "See the sharkd page of the Wireshark wiki for full details.\n");
@@ -217,7 +233,7 @@ sharkd_init(int argc, char **argv)
      * platform-dependent.
      */
 
-#define OPTSTRING "+" "a:hmvC:"
+#define OPTSTRING "+" "a:hmp:vC:"
 
     static const char    optstring[] = OPTSTRING;
 
@@ -227,6 +243,7 @@ sharkd_init(int argc, char **argv)
         {"help", ws_no_argument, NULL, 'h'},
         {"version", ws_no_argument, NULL, 'v'},
         {"config-profile", ws_required_argument, NULL, 'C'},
+        {"pool-size", ws_required_argument, NULL, 'p'},
         {0, 0, 0, 0 }
     };
 
@@ -322,6 +339,14 @@ sharkd_init(int argc, char **argv)
                     mode = SHARKD_MODE_GOLD_CONSOLE;
                     break;
 
+                case 'p':        /* Number of pre-forked session processes */
+                    if (!ws_strtou32(ws_optarg, NULL, &pool_size) || pool_size > SHARKD_MAX_POOL_SIZE) {
+                        fprintf(stderr, "Invalid pool size \"%s\", it must be between 0 and %u\n",
+                                ws_optarg, SHARKD_MAX_POOL_SIZE);
+                        return -1;
+                    }
+                    break;
+
                 case 'v':         /* Show version and exit */
                     show_version();
                     exit(0);
@@ -356,6 +381,159 @@ sharkd_init(int argc, char **argv)
     return 0;
 }
 
+#ifndef _WIN32
+/*
+ * Session process pool.
+ *
+ * A session process forked from here starts out with everything this
+ * process has initialized (dissectors, plugins, preferences, name
+ * resolution tables) shared copy-on-write, so all it has left to do is
+ * get ready for a session. With a pool that's done before there's a
+ * connection for it: each idle session process waits in accept(), and
+ * when it gets a connection it writes its pid to a pipe so that we fork
+ * another one to take its place.
+ *
+ * A session changes process-wide state (the capture file, preferences,
+ * taps) that can't be reset, so a session process still exits when its
+ * session ends; it's the idle ones that are kept for the next connection.
+ *
+ * Idle session processes also watch the read end of a "lifeline" pipe
+ * whose write end only we hold. When we exit, for whatever reason, it
+ * reads as end of file and they exit too, rather than keeping the
+ * listening socket open and taking connections for a daemon that's gone.
+ * Sessions that already have a connection carry on until they end, as
+ * they do without a pool.
+ */
+static pid_t
+pool_fork_session(int notify[2], int lifeline[2])
+{
+    socket_handle_t fd;
+    struct pollfd pfd[2];
+    int flags;
+    pid_t pid;
+
+    pid = fork();
+    if (pid != 0)
+    {
+        if (pid == -1)
+            fprintf(stderr, "cannot fork(): %s\n", g_strerror(errno));
+        return pid;
+    }
+
+    /* child */
+    close(notify[0]);
+    close(lifeline[1]);
+    sharkd_session_start(mode);
+
+    /*
+     * The listening socket is non-blocking, as all of the idle session
+     * processes are woken up for a connection and only one gets it.
+     */
+    pfd[0].fd = _server_fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = lifeline[0];
+    pfd[1].events = POLLIN;
+    do {
+        if (poll(pfd, 2, -1) == -1)
+        {
+            if (errno != EINTR)
+            {
+                fprintf(stderr, "cannot poll(): %s\n", g_strerror(errno));
+                _exit(1);
+            }
+            continue;
+        }
+        if (pfd[1].revents != 0)
+        {
+            /* the daemon has exited */
+            _exit(0);
+        }
+        fd = accept(_server_fd, NULL, NULL);
+        if (fd == INVALID_SOCKET && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+            fprintf(stderr, "cannot accept(): %s\n", g_strerror(errno));
+    } while (fd == INVALID_SOCKET);
+
+    closesocket(_server_fd);
+    close(lifeline[0]);
+
+    /* some systems pass O_NONBLOCK on to the accepted socket */
+    flags = fcntl(fd, F_GETFL);
+    if (flags != -1)
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+
+    pid = getpid();
+    if (write(notify[1], &pid, sizeof(pid)) != sizeof(pid))
+        fprintf(stderr, "cannot notify the session pool: %s\n", g_strerror(errno));
+    close(notify[1]);
+
+    /* redirect stdin, stdout to socket */
+    dup2(fd, 0);
+    dup2(fd, 1);
+    close(fd);
+
+    exit(sharkd_session_main(mode));
+}
+
+/* Only returns if the pool can't be set up; after that it runs until we're killed. */
+static int
+pool_loop(void)
+{
+    int notify[2];
+    int lifeline[2];
+    GHashTable *idle;   /* pids of the session processes waiting for a connection */
+    struct pollfd pfd;
+    pid_t pid;
+    int status;
+    int flags;
+
+    if (pipe(notify) == -1)
+    {
+        fprintf(stderr, "cannot create the session pool pipe: %s\n", g_strerror(errno));
+        return -1;
+    }
+
+    if (pipe(lifeline) == -1)
+    {
+        fprintf(stderr, "cannot create the session pool pipe: %s\n", g_strerror(errno));
+        return -1;
+    }
+
+    flags = fcntl(_server_fd, F_GETFL);
+    if (flags == -1 || fcntl(_server_fd, F_SETFL, flags | O_NONBLOCK) == -1)
+    {
+        fprintf(stderr, "cannot make the listening socket non-blocking: %s\n", g_strerror(errno));
+        return -1;
+    }
+
+    idle = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    while (1)
+    {
+        while (g_hash_table_size(idle) < pool_size)
+        {
+            pid = pool_fork_session(notify, lifeline);
+            if (pid == -1)
+                break;  /* try again after a while */
+            g_hash_table_add(idle, GINT_TO_POINTER(pid));
+        }
+
+        /*
+         * Wait for a session process to take a connection, waking up now
+         * and then to reap the ones that have finished and to notice idle
+         * ones that died without a connection.
+         */
+        pfd.fd = notify[0];
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 1000) > 0 && read(notify[0], &pid, sizeof(pid)) == sizeof(pid))
+            g_hash_table_remove(idle, GINT_TO_POINTER(pid));
+
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+            g_hash_table_remove(idle, GINT_TO_POINTER(pid));
+    }
+}
+#endif
+
 int
 #ifndef _WIN32
 sharkd_loop(int argc _U_, char* argv[] _U_)
@@ -368,6 +546,14 @@ sharkd_loop(int argc _U_, char* argv[])
         return sharkd_session_main(mode);
     }
 
+#ifndef _WIN32
+    if (pool_size > 0)
+        return pool_loop();
+#else
+    if (pool_size > 0)
+        fprintf(stderr, "Session process pools aren't supported on Windows, ignoring --pool-size\n");
+#endif
+
     while (1)
     {
 #ifndef _WIN32
@@ -19,6 +19,11 @@
 #include <errno.h>
 #include <inttypes.h>
 
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 #include <glib.h>
 
 #include <wsutil/wsjson.h>
@@ -86,6 +91,13 @@ struct sharkd_filter_item
 
 static GHashTable *filter_table;
 
+/* Bucket pyramids of earlier iograph requests, by graph and filter, see struct sharkd_iograph_cached. */
+static GHashTable *iograph_table;
+
+/* Column text of frames from earlier frames requests, by column, see sharkd_column_cache_key(). */
+static GHashTable *column_cache_table;
+static size_t column_cache_bytes;
+
 static int mode;
 static uint32_t rpcid;
 
@@ -219,6 +231,23 @@ sharkd_json_response_close(void)
     fflush(stdout);
 }
 
+/* A JSON-RPC notification, which is a request without an id that isn't answered. */
+static void
+sharkd_json_notification_prologue(const char *method)
+{
+    json_dumper_begin_object(&dumper);  // start the message
+    sharkd_json_value_string("jsonrpc", "2.0");
+    sharkd_json_value_string("method", method);
+    sharkd_json_object_open("params");  // start the params object
+}
+
+static void
+sharkd_json_notification_epilogue(void)
+{
+    json_dumper_end_object(&dumper);  // end the params object
+    sharkd_json_response_close();
+}
+
 static void
 sharkd_json_result_prologue(uint32_t id)
 {
@@ -388,6 +417,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"method",     "setcomment",     1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "setconf",        1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "status",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "tail",           1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "tap",            1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
 
         // Parameters and their method context
@@ -413,6 +443,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"frames",     "skip",           2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frames",     "limit",          2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frames",     "refs",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"frames",     "cursor",         2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"intervals",  "interval",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"intervals",  "filter",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"iograph",    "interval",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
@@ -449,10 +480,12 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"iograph",    "aot8",           2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"iograph",    "aot9",           2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"load",       "file",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
+        {"load",       "tail",           2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"setcomment", "frame",          2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
         {"setcomment", "comment",        2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"setconf",    "name",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"setconf",    "value",          2, JSMN_UNDEFINED,    SHARKD_JSON_ANY,      SHARKD_MANDATORY},
+        {"tail",       "stop",           2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"tap",        "tap0",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"tap",        "tap1",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"tap",        "tap2",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
@@ -764,6 +797,31 @@ sharkd_session_filter_data(const char *filter)
     return l;
 }
 
+/*
+ * Extend the results of earlier filters over the frames from first_frame
+ * on, which have been read since, rather than filtering all the frames
+ * again when they're next asked for.
+ */
+static void
+sharkd_session_filter_add_frames(uint32_t first_frame)
+{
+    GHashTableIter iter;
+    void *key, *value;
+
+    g_hash_table_iter_init(&iter, filter_table);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        struct sharkd_filter_item *l = (struct sharkd_filter_item *) value;
+
+        /* NULL, all frames are matching, stays that way. */
+        if (l->filtered == NULL)
+            continue;
+
+        if (sharkd_filter_from((const char *) key, first_frame, &l->filtered) == -1)
+            g_hash_table_iter_remove(&iter);
+    }
+}
+
 static bool
 sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
 {
@@ -1173,6 +1231,8 @@ sharkd_session_process_info(void)
  *
  * Input:
  *   (m) file - file to be loaded
+ *   (o) tail - if true, keep reading records added to the file while it's being written, see sharkd_session_process_tail();
+ *              the file must be an uncompressed pcap or pcapng file
  *
  * Output object with attributes:
  *   (m) err - error code
@@ -1181,6 +1241,8 @@ static void
 sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 {
     const char *tok_file = json_find_attr(buf, tokens, count, "file");
+    const char *tok_tail = json_find_attr(buf, tokens, count, "tail");
+    bool tail = (tok_tail && !strcmp(tok_tail, "true"));
     int err = 0;
 
     if (!tok_file)
@@ -1188,6 +1250,9 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
     fprintf(stderr, "load: filename=%s\n", tok_file);
 
+    g_hash_table_remove_all(iograph_table);
+    g_hash_table_remove_all(column_cache_table);
+
     if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, false, &err) != CF_OK)
     {
         sharkd_json_error(
@@ -1197,9 +1262,20 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
         return;
     }
 
+    if (tail && !sharkd_can_tail())
+    {
+        /* Don't leave the file half loaded; as when it can't be opened, there's no file now. */
+        cf_close(&cfile);
+        sharkd_json_error(
+                rpcid, -2002, NULL,
+                "Only uncompressed pcap and pcapng files can be tailed"
+                );
+        return;
+    }
+
     TRY
     {
-        err = sharkd_load_cap_file();
+        err = tail ? sharkd_load_cap_file_tail() : sharkd_load_cap_file();
     }
     CATCH(OutOfMemoryError)
     {
@@ -1486,12 +1562,158 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
     return cinfo;
 }
 
+#define SHARKD_COLUMN_CACHE_MAX_BYTES (512 * 1024 * 1024)
+
+struct sharkd_column_cache
+{
+    GArray *offsets;    /* by frame number: 1 + offset of the frame's text in text, or 0 if not cached */
+    GByteArray *text;   /* NUL-terminated column texts */
+    uint32_t last;      /* offsets entry of the text added last */
+};
+
 static void
-sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
-        struct epan_column_info *cinfo, const GSList *data_src _U_, void *data _U_)
+sharkd_column_cache_free(void *data)
+{
+    struct sharkd_column_cache *cache = (struct sharkd_column_cache *) data;
+
+    column_cache_bytes -= cache->text->len + cache->offsets->len * sizeof(uint32_t);
+    g_array_free(cache->offsets, true);
+    g_byte_array_free(cache->text, true);
+    g_free(cache);
+}
+
+/*
+ * Text of time columns, and of custom columns with frame fields such as
+ * frame.time_relative or frame.time_delta_displayed, depends on the time
+ * references and on which frame was displayed before, so those are only
+ * shared by requests with the same references and filter. The text of
+ * any column also depends on whether the column in that position is
+ * resolved, see get_column_text().
+ */
+static char *
+sharkd_column_cache_key(const column_info *cinfo, int col, const char *filter, const char *refs)
+{
+    const col_item_t *col_item = &cinfo->columns[col];
+    bool per_view;
+
+    switch (col_item->col_fmt)
+    {
+        case COL_CLS_TIME:
+        case COL_REL_TIME:
+        case COL_DELTA_TIME_DIS:
+            per_view = true;
+            break;
+
+        case COL_CUSTOM:
+            per_view = (col_item->col_custom_fields == NULL || strstr(col_item->col_custom_fields, "frame.") != NULL);
+            break;
+
+        default:
+            per_view = false;
+            break;
+    }
+
+    return ws_strdup_printf("%d:%s:%d:%c\n%s\n%s",
+            col_item->col_fmt,
+            col_item->col_custom_fields ? col_item->col_custom_fields : "",
+            col_item->col_custom_occurrence,
+            get_column_resolved(col) ? 'R' : 'U',
+            (per_view && filter) ? filter : "",
+            (per_view && refs) ? refs : "");
+}
+
+static struct sharkd_column_cache *
+sharkd_column_cache_lookup(const column_info *cinfo, int col, const char *filter, const char *refs)
+{
+    struct sharkd_column_cache *cache;
+    char *key;
+
+    key = sharkd_column_cache_key(cinfo, col, filter, refs);
+    cache = (struct sharkd_column_cache *) g_hash_table_lookup(column_cache_table, key);
+    if (cache)
+    {
+        g_free(key);
+        return cache;
+    }
+
+    cache = g_new0(struct sharkd_column_cache, 1);
+    cache->offsets = g_array_sized_new(false, true, sizeof(uint32_t), cfile.count + 1);
+    g_array_set_size(cache->offsets, cfile.count + 1);
+    cache->text = g_byte_array_new();
+    column_cache_bytes += cache->offsets->len * sizeof(uint32_t);
+
+    g_hash_table_insert(column_cache_table, key, cache);
+    return cache;
+}
+
+static const char *
+sharkd_column_cache_get(const struct sharkd_column_cache *cache, uint32_t framenum)
+{
+    uint32_t offset;
+
+    if (framenum >= cache->offsets->len)
+        return NULL;
+
+    offset = g_array_index(cache->offsets, uint32_t, framenum);
+    if (offset == 0)
+        return NULL;
+
+    return (const char *) &cache->text->data[offset - 1];
+}
+
+static void
+sharkd_column_cache_add(struct sharkd_column_cache *cache, uint32_t framenum, const char *text)
+{
+    size_t len = strlen(text) + 1;
+
+    if (framenum >= cache->offsets->len)
+    {
+        /* frames added since the cache was created */
+        column_cache_bytes += (framenum + 1 - cache->offsets->len) * sizeof(uint32_t);
+        g_array_set_size(cache->offsets, framenum + 1);
+    }
+
+    if (g_array_index(cache->offsets, uint32_t, framenum) != 0)
+        return;
+
+    /* Neighbouring frames often have the same text, e.g. in the Protocol column. */
+    if (cache->last != 0 && !strcmp(text, (const char *) &cache->text->data[cache->last - 1]))
+    {
+        g_array_index(cache->offsets, uint32_t, framenum) = cache->last;
+        return;
+    }
+
+    if (cache->text->len + len >= UINT32_MAX)
+        return;
+
+    cache->last = cache->text->len + 1;
+    g_byte_array_append(cache->text, (const uint8_t *) text, (unsigned) len);
+    g_array_index(cache->offsets, uint32_t, framenum) = cache->last;
+    column_cache_bytes += len;
+}
+
+static bool
+sharkd_column_cache_has_frame(struct sharkd_column_cache **caches, int num_cols, uint32_t framenum)
+{
+    if (num_cols == 0)
+        return false;
+
+    for (int col = 0; col < num_cols; col++)
+    {
+        if (!sharkd_column_cache_get(caches[col], framenum))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Write one frame of a frames request, with the column text from cinfo
+ * (which is added to the column caches), or if cinfo is NULL from the
+ * column caches.
+ */
+static void
+sharkd_session_write_frame(frame_data *fdata, column_info *cinfo, struct sharkd_column_cache **caches, int num_cols)
 {
-    packet_info *pi = &edt->pi;
-    frame_data *fdata = pi->fd;
     wtap_block_t pkt_block = NULL;
     unsigned int i;
     char *comment = NULL;
@@ -1499,13 +1721,23 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
     json_dumper_begin_object(&dumper);
 
     sharkd_json_array_open("c");
-    for (int col = 0; col < cinfo->num_cols; ++col)
+    for (int col = 0; col < num_cols; ++col)
     {
-        sharkd_json_value_string(NULL, get_column_text(cinfo, col));
+        if (cinfo)
+        {
+            const char *text = get_column_text(cinfo, col);
+
+            sharkd_json_value_string(NULL, text);
+            sharkd_column_cache_add(caches[col], fdata->num, text);
+        }
+        else
+        {
+            sharkd_json_value_string(NULL, sharkd_column_cache_get(caches[col], fdata->num));
+        }
     }
     sharkd_json_array_close();
 
-    sharkd_json_value_anyf("num", "%u", pi->num);
+    sharkd_json_value_anyf("num", "%u", fdata->num);
 
     /*
      * Get the block for this record, if it has one.
@@ -1543,6 +1775,13 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
     json_dumper_end_object(&dumper);
 }
 
+static void
+sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
+        struct epan_column_info *cinfo, const GSList *data_src _U_, void *data)
+{
+    sharkd_session_write_frame(edt->pi.fd, cinfo, (struct sharkd_column_cache **) data, cinfo->num_cols);
+}
+
 /**
  * sharkd_session_process_frames()
  *
@@ -1555,6 +1794,12 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
  *   (o) skip=N   - skip N frames
  *   (o) limit=N  - show only N frames
  *   (o) refs  - list (comma separated) with sorted time reference frame numbers.
+ *   (o) cursor=N - start after frame N, e.g. the last frame of the previous page, instead of at the first frame;
+ *                  skip counts from there.
+ *
+ * Column text is kept for later requests with the same columns, so that
+ * paging through the frames, or going back to an earlier page, doesn't
+ * have to dissect the frames again.
  *
  * Output array of frames with attributes:
  *   (m) c   - array of column data
@@ -1574,6 +1819,8 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
     const char *tok_skip   = json_find_attr(buf, tokens, count, "skip");
     const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
     const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
+    const char *tok_cursor = json_find_attr(buf, tokens, count, "cursor");
+    const char *refs = tok_refs;
 
     const uint8_t *filter_data = NULL;
 
@@ -1581,6 +1828,8 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
     uint32_t current_ref_frame = 0, next_ref_frame = UINT32_MAX;
     uint32_t skip;
     uint32_t limit;
+    uint32_t cursor;
+    struct sharkd_column_cache **caches;
 
     wtap_rec rec; /* Record metadata */
     Buffer rec_buf;   /* Record data */
@@ -1632,18 +1881,39 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
             return;
     }
 
+    cursor = 0;
+    if (tok_cursor)
+    {
+        if (!ws_strtou32(tok_cursor, NULL, &cursor))
+            return;
+
+        /* find the frame displayed last before the first one after the cursor */
+        for (prev_dis_num = MIN(cursor, cfile.count); prev_dis_num > 0; prev_dis_num--)
+        {
+            if (!filter_data || (filter_data[prev_dis_num / 8] & (1 << (prev_dis_num % 8))))
+                break;
+        }
+    }
+
     if (tok_refs)
     {
         if (!ws_strtou32(tok_refs, &tok_refs, &next_ref_frame))
             return;
     }
 
+    if (column_cache_bytes >= SHARKD_COLUMN_CACHE_MAX_BYTES)
+        g_hash_table_remove_all(column_cache_table);
+
+    caches = g_new(struct sharkd_column_cache *, cinfo->num_cols);
+    for (int col = 0; col < cinfo->num_cols; col++)
+        caches[col] = sharkd_column_cache_lookup(cinfo, col, tok_filter, refs);
+
     sharkd_json_result_array_prologue(rpcid);
 
     wtap_rec_init(&rec);
     ws_buffer_init(&rec_buf, 1514);
 
-    for (uint32_t framenum = 1; framenum <= cfile.count; framenum++)
+    for (uint32_t framenum = cursor + 1; framenum <= cfile.count; framenum++)
     {
         frame_data *fdata;
         uint32_t ref_frame = (framenum != 1) ? 1 : 0;
@@ -1693,11 +1963,26 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
         }
 
         fdata = sharkd_get_frame(framenum);
+
+        /*
+         * Frames with cached columns were colorized when the columns
+         * were added to the cache.
+         */
+        if (sharkd_column_cache_has_frame(caches, cinfo->num_cols, framenum))
+        {
+            sharkd_session_write_frame(fdata, NULL, caches, cinfo->num_cols);
+            prev_dis_num = framenum;
+
+            if (limit && --limit == 0)
+                break;
+            continue;
+        }
+
         status = sharkd_dissect_request(framenum,
                 ref_frame, prev_dis_num,
                 &rec, &rec_buf, cinfo,
                 (fdata->color_filter == NULL) ? SHARKD_DISSECT_FLAG_COLOR : SHARKD_DISSECT_FLAG_NULL,
-                &sharkd_session_process_frames_cb, NULL,
+                &sharkd_session_process_frames_cb, caches,
                 &err, &err_info);
         switch (status) {
 
@@ -1724,6 +2009,8 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
     }
     sharkd_json_result_array_epilogue();
 
+    g_free(caches);
+
     if (cinfo != &cfile.cinfo)
         col_cleanup(cinfo);
 
@@ -4407,6 +4694,7 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
 }
 
 #define SHARKD_IOGRAPH_MAX_ITEMS 1 << 25 /* 33,554,432 limit of items, same as max_io_items_ in ui/qt/io_graph_dialog.h */
+#define SHARKD_IOGRAPH_MAX_CACHED 32
 
 struct sharkd_iograph
 {
@@ -4414,49 +4702,44 @@ struct sharkd_iograph
     int hf_index;
     io_graph_item_unit_t calc_type;
     uint32_t interval;
+    int base_interval;
     bool aot;
+    const char *filter;
 
     /* result */
-    int space_items;
-    int num_items;
-    io_graph_item_t *items;
+    char *key;
+    io_graph_pyramid_t *pyramid;
+    bool tapped;
     GString *error;
 };
 
+/* The items of an earlier iograph request, with what's needed to add frames to them. */
+struct sharkd_iograph_cached
+{
+    io_graph_pyramid_t *pyramid;
+    io_graph_item_unit_t calc_type;
+    uint32_t interval;          /* interval of the request the items were tapped for */
+    int base_interval;
+    char *filter;
+};
+
+static void
+sharkd_session_iograph_free(void *data)
+{
+    struct sharkd_iograph_cached *cached = (struct sharkd_iograph_cached *) data;
+
+    io_graph_pyramid_free(cached->pyramid);
+    g_free(cached->filter);
+    g_free(cached);
+}
+
 static tap_packet_status
 sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
 {
     struct sharkd_iograph *graph = (struct sharkd_iograph *) g;
-    int idx;
     bool update_succeeded;
 
-    int64_t tmp_idx = get_io_graph_index(pinfo, graph->interval);
-    if (tmp_idx < 0 || tmp_idx >= SHARKD_IOGRAPH_MAX_ITEMS)
-        return TAP_PACKET_DONT_REDRAW;
-
-    idx = (int)tmp_idx;
-
-    if (idx + 1 > graph->num_items)
-    {
-        if (idx + 1 > graph->space_items)
-        {
-            int new_size = idx + 1024;
-
-            graph->items = (io_graph_item_t *) g_realloc(graph->items, sizeof(io_graph_item_t) * new_size);
-            reset_io_graph_items(&graph->items[graph->space_items], new_size - graph->space_items, graph->hf_index);
-
-            graph->space_items = new_size;
-        }
-        else if (graph->items == NULL)
-        {
-            graph->items = g_new(io_graph_item_t, graph->space_items);
-            reset_io_graph_items(graph->items, graph->space_items, graph->hf_index);
-        }
-
-        graph->num_items = idx + 1;
-    }
-
-    update_succeeded = update_io_graph_item(graph->items, idx, pinfo, edt, graph->hf_index, graph->calc_type, graph->interval);
+    update_succeeded = io_graph_pyramid_update(graph->pyramid, pinfo, edt, graph->calc_type);
     /* XXX - TAP_PACKET_FAILED if the item couldn't be updated, with an error message? */
     return update_succeeded ? TAP_PACKET_REDRAW : TAP_PACKET_DONT_REDRAW;
 }
@@ -4477,6 +4760,11 @@ sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const vo
  * Graph requests can be one of: "packets", "bytes", "bits", "sum:<field>", "frames:<field>", "max:<field>", "min:<field>", "avg:<field>", "load:<field>",
  * if you use variant with <field>, you need to pass field name in filter request.
  *
+ * The items of each graph and filter are kept at a base interval of a power of
+ * ten microseconds, and at multiples of 10 of it, so that later requests with
+ * the same graph and filter at an interval that is a multiple of the base
+ * interval are answered without reading the packets again.
+ *
  * Output object with attributes:
  *   (m) iograph - array of graph results with attributes:
  *                  errmsg - graph cannot be constructed
@@ -4583,9 +4871,10 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         graph->hf_index = -1;
         graph->error = check_field_unit(field_name, &graph->hf_index, graph->calc_type);
 
-        graph->space_items = 0; /* TODO, can avoid realloc()s in sharkd_iograph_packet() by calculating: capture_time / interval */
-        graph->num_items = 0;
-        graph->items = NULL;
+        graph->filter = tok_filter;
+        graph->key = NULL;
+        graph->pyramid = NULL;
+        graph->tapped = false;
 
         snprintf(tok_format_buf, sizeof(tok_format_buf), "aot%d", i);
         tok_aot = json_find_attr(buf, tokens, count, tok_format_buf);
@@ -4597,7 +4886,26 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         }
 
         if (!graph->error)
-            graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
+        {
+            struct sharkd_iograph_cached *cached;
+
+            /* The items only depend on the field and filter, except that LOAD
+             * is added to the items differently. */
+            graph->key = ws_strdup_printf("%d:%d:%s", graph->hf_index,
+                    graph->calc_type == IOG_ITEM_UNIT_CALC_LOAD, tok_filter ? tok_filter : "");
+            cached = (struct sharkd_iograph_cached *) g_hash_table_lookup(iograph_table, graph->key);
+            graph->pyramid = cached ? cached->pyramid : NULL;
+
+            if (!graph->pyramid || !io_graph_pyramid_has_interval(graph->pyramid, graph->interval))
+            {
+                graph->base_interval = io_graph_pyramid_base_interval(graph->interval, &cfile.elapsed_time);
+                graph->pyramid = io_graph_pyramid_new(SHARKD_IOGRAPH_MAX_ITEMS);
+                io_graph_pyramid_reset(graph->pyramid, graph->base_interval, graph->hf_index);
+                graph->tapped = true;
+
+                graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
+            }
+        }
 
         graph_count++;
 
@@ -4608,14 +4916,24 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
                     "%s", graph->error->str
                     );
             g_string_free(graph->error, TRUE);
+            for (i = 0; i < graph_count; i++)
+            {
+                if (graphs[i].tapped)
+                {
+                    if (&graphs[i] != graph)
+                        remove_tap_listener(&graphs[i]);
+                    io_graph_pyramid_free(graphs[i].pyramid);
+                }
+                g_free(graphs[i].key);
+            }
             return;
         }
 
-        if (graph->error == NULL)
+        if (graph->tapped)
             is_any_ok = true;
     }
 
-    /* retap only if we have at least one ok */
+    /* retap only if some graph isn't cached at a suitable interval */
     if (is_any_ok)
         sharkd_retap();
 
@@ -4638,13 +4956,17 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         {
             int idx;
             int next_idx = 0;
+            int num_items;
+            const io_graph_item_t *items;
+
+            items = io_graph_pyramid_items(graph->pyramid, graph->interval, &num_items);
 
             sharkd_json_array_open("items");
-            for (idx = 0; idx < graph->num_items; idx++)
+            for (idx = 0; idx < num_items; idx++)
             {
                 double val;
 
-                val = get_io_graph_item(graph->items, graph->calc_type, idx, graph->hf_index, &cfile, graph->interval, graph->num_items, graph->aot);
+                val = get_io_graph_item(items, graph->calc_type, idx, graph->hf_index, &cfile, graph->interval, num_items, graph->aot);
 
                 /* if it's zero, don't display */
                 if (val == 0.0)
@@ -4661,14 +4983,101 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         }
         json_dumper_end_object(&dumper);
 
-        remove_tap_listener(graph);
-        g_free(graph->items);
+        if (graph->tapped)
+            remove_tap_listener(graph);
     }
     sharkd_json_array_close();
 
+    /* Keep the newly tapped items for later requests. This frees the
+     * items of an earlier request for the same graph, so it's done after
+     * all the graphs have been written. */
+    for (i = 0; i < graph_count; i++)
+    {
+        struct sharkd_iograph *graph = &graphs[i];
+
+        if (graph->tapped)
+        {
+            struct sharkd_iograph_cached *cached = g_new(struct sharkd_iograph_cached, 1);
+
+            cached->pyramid = graph->pyramid;
+            cached->calc_type = graph->calc_type;
+            cached->interval = graph->interval;
+            cached->base_interval = graph->base_interval;
+            cached->filter = g_strdup(graph->filter);
+
+            if (g_hash_table_size(iograph_table) >= SHARKD_IOGRAPH_MAX_CACHED)
+                g_hash_table_remove_all(iograph_table);
+            g_hash_table_insert(iograph_table, graph->key, cached);
+        }
+        else
+        {
+            g_free(graph->key);
+        }
+    }
+
     sharkd_json_result_epilogue();
 }
 
+/*
+ * Add the frames from first_frame on, which have been read since, to the
+ * items of earlier iograph requests, so that they don't have to be tapped
+ * again from the first frame.
+ */
+static void
+sharkd_session_iograph_add_frames(uint32_t first_frame)
+{
+    GHashTableIter iter;
+    void *value;
+    struct sharkd_iograph *graphs;
+    unsigned graph_count = 0;
+
+    if (g_hash_table_size(iograph_table) == 0)
+        return;
+
+    graphs = g_new0(struct sharkd_iograph, g_hash_table_size(iograph_table));
+
+    g_hash_table_iter_init(&iter, iograph_table);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+        struct sharkd_iograph_cached *cached = (struct sharkd_iograph_cached *) value;
+        struct sharkd_iograph *graph = &graphs[graph_count];
+        GString *error;
+
+        /*
+         * The base interval was made as fine as the capture's duration
+         * allowed when the items were tapped. Once the capture has grown
+         * too long for it, tap the items again when they're next asked
+         * for, at a coarser base interval, rather than letting the number
+         * of items at the base interval keep growing.
+         */
+        if (io_graph_pyramid_base_interval(cached->interval, &cfile.elapsed_time) != cached->base_interval)
+        {
+            g_hash_table_iter_remove(&iter);
+            continue;
+        }
+
+        graph->pyramid = cached->pyramid;
+        graph->calc_type = cached->calc_type;
+
+        error = register_tap_listener("frame", graph, cached->filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
+        if (error)
+        {
+            /* The items can't be kept up to date, forget them. */
+            g_string_free(error, TRUE);
+            g_hash_table_iter_remove(&iter);
+            continue;
+        }
+        graph_count++;
+    }
+
+    if (graph_count)
+        sharkd_retap_from(first_frame);
+
+    for (unsigned i = 0; i < graph_count; i++)
+        remove_tap_listener(&graphs[i]);
+    g_free(graphs);
+}
+
 /**
  * sharkd_session_process_intervals()
  *
@@ -5230,6 +5639,8 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
     else
     {
         sharkd_set_modified_block(fdata, pkt_block);
+        /* Comment columns and the expert info column are cached. */
+        g_hash_table_remove_all(column_cache_table);
         sharkd_json_simple_ok(rpcid);
     }
 }
@@ -5281,6 +5692,9 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
     switch (ret)
     {
         case PREFS_SET_OK:
+            /* The preference might change how packets are dissected. */
+            g_hash_table_remove_all(iograph_table);
+            g_hash_table_remove_all(column_cache_table);
             sharkd_json_simple_ok(rpcid);
             break;
 
@@ -5921,6 +6335,104 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
     }
 }
 
+/* How often a session looks for records added to a tailed file */
+#define SHARKD_TAIL_INTERVAL_MS 1000
+
+/* When sharkd_session_tail_update() last ran, in g_get_monotonic_time() microseconds */
+static int64_t tail_checked;
+
+/*
+ * Read the records added to a file loaded with tail set, if there are any,
+ * and tell the client how many frames there are now with a "tail"
+ * notification:
+ *
+ *   (m) frames   - number of frames
+ *   (m) added    - number of frames added
+ *   (m) duration - capture duration
+ *
+ * Frame numbers, filter results and the items of iograph requests are
+ * only added to; the new frames are filtered and tapped, not all of them.
+ */
+static uint32_t
+sharkd_session_tail_update(void)
+{
+    uint32_t first_frame = cfile.count + 1;
+    uint32_t new_frames = 0;
+
+    if (!sharkd_is_tailing())
+        return 0;
+
+    tail_checked = g_get_monotonic_time();
+
+    TRY
+    {
+        sharkd_continue_tail(&new_frames);
+    }
+    CATCH(OutOfMemoryError)
+    {
+        fprintf(stderr, "tail: OutOfMemoryError\n");
+        sharkd_finish_tail();
+    }
+    ENDTRY;
+
+    if (new_frames == 0)
+        return 0;
+
+    sharkd_session_filter_add_frames(first_frame);
+    sharkd_session_iograph_add_frames(first_frame);
+
+    sharkd_json_notification_prologue("tail");
+    sharkd_json_value_anyf("frames", "%u", cfile.count);
+    sharkd_json_value_anyf("added", "%u", new_frames);
+    sharkd_json_value_anyf("duration", "%.9f", nstime_to_sec(&cfile.elapsed_time));
+    sharkd_json_notification_epilogue();
+
+    return new_frames;
+}
+
+/**
+ * sharkd_session_process_tail()
+ *
+ * Process tail request - read the records added to a file loaded with tail set
+ *
+ * Except on Windows, records are also read, and notified, every second
+ * while the session is waiting for requests or has requests waiting.
+ *
+ * Input:
+ *   (o) stop - if true, stop reading the records added to the file
+ *
+ * Output object with attributes:
+ *   (m) frames  - number of frames
+ *   (m) added   - number of frames added by this request
+ *   (m) tailing - if records added to the file later will be read
+ */
+static void
+sharkd_session_process_tail(char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_stop = json_find_attr(buf, tokens, count, "stop");
+    uint32_t new_frames;
+
+    if (!sharkd_is_tailing())
+    {
+        sharkd_json_error(
+                rpcid, -14001, NULL,
+                "No file is being tailed"
+                );
+        return;
+    }
+
+    new_frames = sharkd_session_tail_update();
+
+    if (tok_stop && !strcmp(tok_stop, "true"))
+        sharkd_finish_tail();
+
+    sharkd_json_result_prologue(rpcid);
+    sharkd_json_value_anyf("frames", "%u", cfile.count);
+    sharkd_json_value_anyf("added", "%u", new_frames);
+    sharkd_json_value_anyf("tailing", sharkd_is_tailing() ? "true" : "false");
+    sharkd_json_result_epilogue();
+}
+
 static void
 sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 {
@@ -5970,6 +6482,8 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
             sharkd_session_process_dumpconf(buf, tokens, count);
         else if (!strcmp(tok_method, "download"))
             sharkd_session_process_download(buf, tokens, count);
+        else if (!strcmp(tok_method, "tail"))
+            sharkd_session_process_tail(buf, tokens, count);
         else if (!strcmp(tok_method, "bye"))
         {
             sharkd_json_simple_ok(rpcid);
@@ -5985,20 +6499,99 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
     }
 }
 
-int
-sharkd_session_main(int mode_setting)
+#ifndef _WIN32
+/* What has been read from stdin but not processed yet, see sharkd_session_read_request() */
+static char request_buf[8 * 1024];
+static size_t request_len;
+#endif
+
+/*
+ * Read the next request, a line of JSON, from stdin into buf, like fgets().
+ *
+ * Except on Windows, stdin is read without stdio, so that poll() can tell
+ * whether there's a request to read, and while a file is being tailed the
+ * records added to it are read in between.
+ */
+static bool
+sharkd_session_read_request(char *buf, size_t size)
 {
-    char buf[8 * 1024];
-    jsmntok_t *tokens = NULL;
-    int tokens_max = -1;
+#ifndef _WIN32
+    while (1)
+    {
+        char *eol;
+        size_t len;
+        ssize_t n;
 
-    mode = mode_setting;
+        if (sharkd_is_tailing() &&
+                g_get_monotonic_time() - tail_checked >= SHARKD_TAIL_INTERVAL_MS * INT64_C(1000))
+            sharkd_session_tail_update();
 
-    fprintf(stderr, "Hello in child.\n");
+        eol = (char *) memchr(request_buf, '\n', request_len);
+        if (eol || request_len >= size - 1)
+        {
+            len = eol ? (size_t) (eol - request_buf) + 1 : size - 1;
+            if (len > size - 1)
+                len = size - 1;
+
+            memcpy(buf, request_buf, len);
+            buf[len] = '\0';
+            request_len -= len;
+            memmove(request_buf, request_buf + len, request_len);
+            return true;
+        }
 
-    dumper.output_file = stdout;
+        if (sharkd_is_tailing())
+        {
+            struct pollfd pfd;
+            int64_t wait_ms = SHARKD_TAIL_INTERVAL_MS - (g_get_monotonic_time() - tail_checked) / 1000;
+
+            pfd.fd = STDIN_FILENO;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, (int) MAX(wait_ms, 0)) <= 0)
+                continue;   /* time to look at the file again, or interrupted */
+        }
+
+        n = read(STDIN_FILENO, request_buf + request_len, sizeof(request_buf) - request_len);
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+        {
+            /* like fgets(), return the last line even without a newline */
+            if (request_len == 0)
+                return false;
+
+            memcpy(buf, request_buf, request_len);
+            buf[request_len] = '\0';
+            request_len = 0;
+            return true;
+        }
+        request_len += n;
+    }
+#else
+    return fgets(buf, (int) size, stdin) != NULL;
+#endif
+}
+
+static bool session_started;
+
+/*
+ * Get ready for a session, without reading anything from stdin yet; a
+ * pre-forked session process does this while it waits for a connection.
+ */
+void
+sharkd_session_start(int mode_setting)
+{
+    if (session_started)
+        return;
+    session_started = true;
+
+    mode = mode_setting;
 
     filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+    iograph_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_iograph_free);
+    column_cache_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_column_cache_free);
 
 #ifdef HAVE_MAXMINDDB
     /* mmdbresolve was stopped before fork(), force starting it */
@@ -6006,8 +6599,22 @@ sharkd_session_main(int mode_setting)
 #endif
 
     set_resolution_synchrony(true);
+}
+
+int
+sharkd_session_main(int mode_setting)
+{
+    char buf[8 * 1024];
+    jsmntok_t *tokens = NULL;
+    int tokens_max = -1;
+
+    sharkd_session_start(mode_setting);
+
+    fprintf(stderr, "Hello in child.\n");
+
+    dumper.output_file = stdout;
 
-    while (fgets(buf, sizeof(buf), stdin))
+    while (sharkd_session_read_request(buf, sizeof(buf)))
     {
         /* every command is line separated JSON */
         int ret;
@@ -6049,6 +6656,8 @@ sharkd_session_main(int mode_setting)
     }
 
     g_hash_table_destroy(filter_table);
+    g_hash_table_destroy(iograph_table);
+    g_hash_table_destroy(column_cache_table);
     g_free(tokens);
 
     return 0;
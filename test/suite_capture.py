@@ -29,15 +29,16 @@ testout_pcapng = 'testout.pcapng'
 snapshot_len = 96
 
 class UdpTrafficGenerator(threading.Thread):
-    def __init__(self):
+    def __init__(self, port=9):
         super().__init__(daemon=True)
         self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.port = port
         self.stopped = False
 
     def run(self):
         while not self.stopped:
             time.sleep(.05)
-            self.sock.sendto(b'Wireshark test\n', ('127.0.0.1', 9))
+            self.sock.sendto(b'Wireshark test\n', ('127.0.0.1', self.port))
 
     def stop(self):
         if not self.stopped:
@@ -551,6 +552,37 @@ class TestDumpcapCapture:
         '''Capture truncated packets using Dumpcap'''
         check_capture_snapshot_len(self, cmd=cmd_dumpcap, env=base_env)
 
+    def test_dumpcap_tpacket_v3_capture_filter(self, capture_interface, cmd_dumpcap, cmd_tshark, result_file, base_env):
+        '''Capture only packets that pass the filter from TPACKET_V3 rings using Dumpcap'''
+        if not sys.platform.startswith('linux'):
+            pytest.skip('TPACKET_V3 capture is only supported on Linux')
+        # The other traffic is already flowing when the sockets are
+        # bound, before the capture filter is compiled.
+        generators = [UdpTrafficGenerator(port) for port in (7, 9)]
+        for generator in generators:
+            generator.start()
+        testout_file = result_file(testout_pcap)
+        try:
+            subprocesstest.check_run((cmd_dumpcap,
+                '-i', capture_interface,
+                '-p',
+                '-t',
+                '--tpacket-v3', '2',
+                '-w', testout_file,
+                '-a', 'duration:{}'.format(capture_duration),
+                '-f', 'udp dst port 9',
+            ), env=base_env)
+        finally:
+            for generator in generators:
+                generator.stop()
+        def count(dfilter):
+            return count_output(subprocess.check_output((cmd_tshark,
+                '-r', testout_file,
+                '-Y', dfilter,
+            ), encoding='utf-8', env=base_env))
+        assert count('udp.dstport == 9') > 0
+        assert count('!(udp.dstport == 9)') == 0
+
 
 class TestDumpcapAutostop:
     # duration, filesize, packets, files
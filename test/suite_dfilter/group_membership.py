@@ -86,6 +86,34 @@ class TestDfilterMembership:
         dfilter = 'ip.addr in { 10.0.0.5 .. 10.0.0.9 , 10.0.0.1..10.0.0.1 }'
         checkDFilterCount(dfilter, 1)
 
+    def test_membership_ip_subnet_1(self, checkDFilterCount):
+        dfilter = 'ip.addr in {10.0.0.0/24}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_ip_subnet_2(self, checkDFilterCount):
+        dfilter = 'ip.src in {10.0.0.6/32, 192.168.0.0/16}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_ip_subnet_all(self, checkDFilterCount):
+        dfilter = 'all ip.addr in {10.0.0.0/8, 207.46.134.94}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_overlapping_ranges_1(self, checkDFilterCount):
+        dfilter = 'tcp.srcport in {1 .. 100, 50 .. 3266, 3000 .. 3100}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_overlapping_ranges_2(self, checkDFilterCount):
+        dfilter = 'tcp.srcport in {3268 .. 4000, 100 .. 3267, 80, 200 .. 300}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_empty_range(self, checkDFilterCount):
+        dfilter = 'tcp.srcport in {4000 .. 3000}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_not_in(self, checkDFilterCount):
+        dfilter = 'tcp.srcport not in {80, 3268, 1 .. 3266}'
+        checkDFilterCount(dfilter, 1)
+
     def test_membership_9_range_invalid_float(self, checkDFilterFail):
         # expression should be parsed as "0.1 .. .7"
         # .7 is the identifier (protocol) named "7"
@@ -226,6 +226,92 @@ class TestDfilterEquality:
         dfilter = 'frame contains fc:'
         checkDFilterSucceed(dfilter)
 
+class TestDfilterReorder:
+    trace_file = "http.pcap"
+
+    @staticmethod
+    def instructions(cmd, dfilter_env):
+        proc = subprocesstest.run(cmd,
+                                capture_output=True,
+                                universal_newlines=True,
+                                env=dfilter_env)
+        assert proc.returncode == 0
+        return proc.stdout[proc.stdout.index('Instructions:'):]
+
+    def test_and_1(self, checkDFilterCount):
+        dfilter = 'http.request.uri matches "^/" && tcp.port == 80'
+        checkDFilterCount(dfilter, 1)
+
+    def test_and_2(self, checkDFilterCount):
+        dfilter = 'http.request.uri matches "^/" && tcp.port == 81'
+        checkDFilterCount(dfilter, 0)
+
+    def test_or_1(self, checkDFilterCount):
+        dfilter = 'http.request.uri matches "^/" || tcp.port == 81'
+        checkDFilterCount(dfilter, 1)
+
+    def test_or_2(self, checkDFilterCount):
+        dfilter = '!(http.request.uri contains "x" || tcp.port == 81) && ip'
+        checkDFilterCount(dfilter, 1)
+
+    def test_cheap_first(self, dftest_cmd, dfilter_env):
+        # The port comparison is cheaper than the regular expression.
+        dfilter = 'http.request.uri matches "^/" && tcp.port == 80'
+        insns = self.instructions(dftest_cmd(dfilter), dfilter_env)
+        assert insns.index('tcp.port') < insns.index('http.request.uri')
+
+    def test_not_optimized(self, cmd_dftest, dfilter_env):
+        # Without optimization the operands are tested as written.
+        dfilter = 'http.request.uri matches "^/" && tcp.port == 80'
+        insns = self.instructions([cmd_dftest, '-0', '--', dfilter], dfilter_env)
+        assert insns.index('http.request.uri') < insns.index('tcp.port')
+
+class TestDfilterFrameChecks:
+    trace_file = "dhcp.pcap"
+
+    def test_number_1(self, checkDFilterCount):
+        dfilter = 'frame.number >= 2 && frame.number <= 3'
+        checkDFilterCount(dfilter, 2)
+
+    def test_number_2(self, checkDFilterCount):
+        dfilter = '3 > frame.number'
+        checkDFilterCount(dfilter, 2)
+
+    def test_number_3(self, checkDFilterCountWithSelectedFrame):
+        # Two passes
+        dfilter = 'frame.number != 2 && dhcp'
+        checkDFilterCountWithSelectedFrame(dfilter, 3, 1)
+
+    def test_len_1(self, checkDFilterCount):
+        dfilter = 'frame.len == 342 && dhcp'
+        checkDFilterCount(dfilter, 2)
+
+    def test_cap_len_1(self, checkDFilterCount):
+        dfilter = 'frame.cap_len < 314'
+        checkDFilterCount(dfilter, 0)
+
+    def test_time_1(self, checkDFilterCount):
+        dfilter = 'frame.time >= 1102274184.35 && frame.time < 1102274185'
+        checkDFilterCount(dfilter, 2)
+
+    def test_second_pass_output(self, cmd_tshark, capture_file, dfilter_env):
+        # Packets rejected by the frame checks aren't dissected in the
+        # second pass; that mustn't change what the others look like.
+        # Under "not" the same tests aren't frame checks.
+        def run(dfilter):
+            return subprocesstest.check_run((cmd_tshark, '-n', '-2',
+                    '-r', capture_file('grpc_web.pcapng.gz'),
+                    '-Y', dfilter,
+                    '-T', 'fields',
+                    '-e', 'frame.number', '-e', 'frame.time_delta_displayed',
+                    '-e', 'tcp.stream', '-e', 'tcp.seq', '-e', 'tcp.analysis.flags',
+                    '-e', 'tcp.reassembled_in', '-e', '_ws.col.info'),
+                capture_output=True, universal_newlines=True, env=dfilter_env).stdout
+        with_checks = run('frame.number >= 100 && frame.len > 100 && tcp')
+        without_checks = run('!(frame.number < 100) && !(frame.len <= 100) && tcp')
+        assert with_checks
+        assert with_checks == without_checks
+
 class TestDfilterBitwise:
     trace_file = "http.pcap"
 
@@ -262,3 +262,29 @@ class TestFileFormatMime:
                 '-e', 'pcapng.block.length_trailer',
             ), encoding='utf-8', env=test_env)
         assert proc_stdout.strip() == '480\t128,88,132,132\t128,88,132,132'
+
+
+class TestEditcapDedup:
+    @pytest.fixture
+    def dup_capture(self, cmd_mergecap, capture_file, result_file, test_env):
+        '''dhcp.pcap followed by a copy of itself.'''
+        outfile = result_file('dhcp-dup.pcap')
+        subprocess.run((cmd_mergecap,
+            '-a', '-F', 'pcap', '-w', outfile,
+            capture_file('dhcp.pcap'), capture_file('dhcp.pcap'),
+        ), check=True, env=test_env)
+        return outfile
+
+    def test_editcap_dedup_window(self, cmd_editcap, cmd_tshark, dup_capture, result_file, test_env):
+        '''Duplicates within the window are removed.'''
+        outfile = result_file('dhcp-dedup.pcap')
+        subprocess.run((cmd_editcap, '-D', '8', dup_capture, outfile), check=True, env=test_env)
+        stdout = subprocess.check_output((cmd_tshark, '-r', outfile), encoding='utf-8', env=test_env)
+        assert count_output(stdout) == 4
+
+    def test_editcap_dedup_outside_window(self, cmd_editcap, cmd_tshark, dup_capture, result_file, test_env):
+        '''Duplicates that have left the window are kept.'''
+        outfile = result_file('dhcp-dedup.pcap')
+        subprocess.run((cmd_editcap, '-D', '3', dup_capture, outfile), check=True, env=test_env)
+        stdout = subprocess.check_output((cmd_tshark, '-r', outfile), encoding='utf-8', env=test_env)
+        assert count_output(stdout) == 8
@@ -8,8 +8,10 @@
 #
 '''File I/O tests'''
 
+import gzip
 import io
 import os.path
+import shutil
 import subprocess
 from subprocesstest import cat_dhcp_command, check_packet_count
 import sys
@@ -67,6 +69,82 @@ class TestTsharkIO:
         '''Read direct and write direct using TShark'''
         check_io_4_packets(capture_file, result_file, cmd_tshark, cmd_capinfos, env=test_env)
 
+    def test_tshark_io_compressed_bytes(self, cmd_tshark, capture_file, result_file, test_env):
+        '''Packet bytes read from a compressed file match those read from the uncompressed file'''
+        # Single-pass reads don't copy the packet data of uncompressed
+        # files, and must copy that of compressed ones, where more of a
+        # record is read after the data.
+        compressed_file = capture_file('netperfmeter.pcapng.gz')
+        uncompressed_file = result_file('netperfmeter.pcapng')
+        with gzip.open(compressed_file, 'rb') as fin, open(uncompressed_file, 'wb') as fout:
+            shutil.copyfileobj(fin, fout)
+        compressed = subprocess.check_output((cmd_tshark, '-r', compressed_file, '-x'),
+            encoding='utf-8', env=test_env)
+        uncompressed = subprocess.check_output((cmd_tshark, '-r', uncompressed_file, '-x'),
+            encoding='utf-8', env=test_env)
+        assert compressed == uncompressed
+
+
+class TestTsharkShardsIO:
+    if sys.platform.startswith('win32'):
+        pytest.skip('--shards is not supported on Windows')
+
+    def test_tshark_shards_text(self, cmd_tshark, capture_file, test_env):
+        '''Sharded dissection prints the same packets in the same order'''
+        fields_args = ('-T', 'fields',
+            '-e', 'frame.number', '-e', 'frame.time_relative', '-e', 'frame.time_delta',
+            '-e', 'ip.src', '-e', 'ip.dst', '-e', '_ws.col.info')
+        for pcap in ('dhcp.pcap', 'dns+icmp.pcapng.gz', 'http.pcap'):
+            single = subprocess.check_output((cmd_tshark, '-r', capture_file(pcap)) + fields_args,
+                encoding='utf-8', env=test_env)
+            sharded = subprocess.check_output((cmd_tshark, '-r', capture_file(pcap), '--shards', '4') + fields_args,
+                encoding='utf-8', env=test_env)
+            assert single == sharded
+
+    def test_tshark_shards_display_filter(self, cmd_tshark, capture_file, test_env):
+        '''Sharded dissection prints the same packets that pass a display filter'''
+        args = ('-r', capture_file('dns+icmp.pcapng.gz'), '-Y', 'dns',
+            '-T', 'fields', '-e', 'frame.number', '-e', 'frame.time_delta', '-e', '_ws.col.info')
+        single = subprocess.check_output((cmd_tshark,) + args, encoding='utf-8', env=test_env)
+        sharded = subprocess.check_output((cmd_tshark, '--shards', '3') + args, encoding='utf-8', env=test_env)
+        assert single
+        assert single == sharded
+
+    def test_tshark_shards_write(self, cmd_tshark, cmd_capinfos, capture_file, result_file, test_env):
+        '''Sharded dissection writes the packets that pass the display filter'''
+        testout_file = result_file(testout_pcap)
+        subprocess.check_call((cmd_tshark,
+            '-r', capture_file('dhcp.pcap'),
+            '-Y', 'dhcp.option.dhcp == 3',
+            '--shards', '2',
+            '-w', testout_file,
+        ), env=test_env)
+        check_packet_count(cmd_capinfos, 1, testout_file)
+
+    def test_tshark_shards_refused(self, cmd_tshark, capture_file, test_env):
+        '''Sharded dissection refuses output that would differ from a single process'''
+        # The time since the previous displayed frame and conversation
+        # indexes depend on frames other workers dissect.
+        for args, message in (
+                (('-Y', 'dhcp', '-T', 'fields', '-e', 'frame.time_delta_displayed'), '"frame.time_delta_displayed"'),
+                (('-Y', 'frame.cum_bytes > 1000'), '"frame.cum_bytes"'),
+                (('-Y', 'dhcp', '-t', 'dd'), 'previous displayed frame'),
+                (('-V',), 'packet details'),
+                (('-T', 'fields', '-e', 'frame.number', '-e', 'udp.stream'), '"udp.stream"'),
+                (('-o', 'gui.column.format:"Stream","%Cus:tcp.stream || udp.stream"'), '"tcp.stream"'),
+            ):
+            proc = subprocess.run((cmd_tshark, '-r', capture_file('dhcp.pcap'), '--shards', '2') + args,
+                capture_output=True, env=test_env)
+            assert proc.returncode != 0
+            assert message in proc.stderr.decode('utf-8', 'replace')
+
+    def test_tshark_shards_stdin(self, cmd_tshark, capture_file, test_env):
+        '''Sharded dissection needs a file it can read more than once'''
+        proc = subprocess.run((cmd_tshark, '-r', '-', '--shards', '2'),
+            input=b'', capture_output=True, env=test_env)
+        assert proc.returncode != 0
+        assert '--shards requires a capture file' in proc.stderr.decode('utf-8', 'replace')
+
 
 class TestRawsharkIO:
     if sys.byteorder != 'little':
@@ -9,6 +9,7 @@
 '''Mergecap tests'''
 
 import re
+import struct
 import subprocess
 from subprocesstest import grep_output
 
@@ -268,3 +269,44 @@ class TestMergecapPcapng:
         ), capture_output=True, encoding='utf-8', env=test_env)
         # check for 11 IDBs, 88*3=264 total pkts, 86*3=258 in first IDB
         check_mergecap(mergecap_proc, 'pcapng', 'Per packet', 264, 11, 258, cmd_capinfos, testout_file, test_env)
+
+
+def write_synthetic_pcap(path, file_num, num_files, num_packets):
+    '''Write a pcap file whose packets interleave with those of the other files.'''
+    with open(path, 'wb') as f:
+        # Magic, version 2.4, thiszone, sigfigs, snaplen, LINKTYPE_ETHERNET
+        f.write(struct.pack('<IHHiIII', 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1))
+        for packet_num in range(num_packets):
+            usecs = packet_num * num_files + (file_num * 37) % num_files
+            data = struct.pack('>6s6sHII', b'\xff' * 6, b'\x00' * 6, 0x88b5, file_num, packet_num)
+            f.write(struct.pack('<IIII', usecs // 1000000, usecs % 1000000, len(data), len(data)))
+            f.write(data)
+
+
+class TestMergecapManyInputs:
+    def test_mergecap_256_pcap(self, cmd_mergecap, result_file, test_env):
+        '''Merge 256 interleaved pcap files in chronological order'''
+        num_files = 256
+        num_packets = 32
+        testin_files = []
+        for file_num in range(num_files):
+            testin_file = result_file('testin-{}.pcap'.format(file_num))
+            write_synthetic_pcap(testin_file, file_num, num_files, num_packets)
+            testin_files.append(testin_file)
+
+        testout_file = result_file(testout_pcap)
+        subprocess.run([cmd_mergecap, '-F', 'pcap', '-w', testout_file] + testin_files,
+            check=True, env=test_env)
+
+        with open(testout_file, 'rb') as f:
+            f.read(24)
+            timestamps = []
+            while True:
+                hdr = f.read(16)
+                if not hdr:
+                    break
+                secs, usecs, caplen, _ = struct.unpack('<IIII', hdr)
+                f.read(caplen)
+                timestamps.append(secs * 1000000 + usecs)
+        assert len(timestamps) == num_files * num_packets
+        assert timestamps == list(range(num_files * num_packets))
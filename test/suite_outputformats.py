@@ -54,6 +54,48 @@ class TestOutputFormats:
         '''Decode some captures into jsonraw'''
         check_outputformat("jsonraw", expected="dhcp.jsonraw", env=base_env)
 
+    def test_outputformat_json_shards(self, cmd_tshark, capture_file, base_env):
+        '''Decode some captures into json fields in several worker processes'''
+        # Packet details include conversation indexes, which each worker
+        # would number by itself, so --shards refuses them; fields are fine.
+        fields_args = ['-T', 'json', '-e', 'frame.number', '-e', 'ip.src', '-e', 'ip.dst', '-e', '_ws.col.info']
+        for pcap in ('dhcp.pcap', 'dns+icmp.pcapng.gz'):
+            outputs = []
+            for extra_args in ([], ['--shards', '3']):
+                tshark_proc = subprocess.run([cmd_tshark, '-r', capture_file(pcap)] + fields_args + extra_args,
+                                             check=True, capture_output=True, encoding='utf-8', env=base_env)
+                outputs.append(json.loads(tshark_proc.stdout))
+            assert len(outputs[0]) > 0
+            assert outputs[0] == outputs[1]
+
+    def test_outputformat_json_no_duplicate_keys(self, cmd_tshark, capture_file, base_env):
+        '''Decode some captures into json, grouping fields with the same name'''
+        def unique_keys(pairs):
+            keys = [key for key, _ in pairs]
+            assert len(keys) == len(set(keys))
+            return dict(pairs)
+
+        def first_seen_keys(pairs):
+            return list(dict.fromkeys(key for key, _ in pairs))
+
+        outputs = []
+        for extra_args in ([], ['--no-duplicate-keys']):
+            tshark_proc = subprocess.run([cmd_tshark, '-r', capture_file('dhcp.pcap'), '-T', 'json'] + extra_args,
+                                         check=True, capture_output=True, encoding='utf-8', env=base_env)
+            outputs.append(tshark_proc.stdout)
+
+        grouped = json.loads(outputs[1], object_pairs_hook=unique_keys)
+        assert len(grouped) == 4
+        # The protocols come out in the same order either way.
+        layer_keys = json.loads(outputs[0], object_pairs_hook=lambda pairs: pairs)
+        for packet, packet_keys in zip(grouped, layer_keys):
+            source = dict(dict(packet_keys)['_source'])
+            assert list(packet['_source']['layers'].keys()) == first_seen_keys(source['layers'])
+            # Every DHCP message has several options, which are grouped together.
+            options = packet['_source']['layers']['dhcp']['dhcp.option.type']
+            assert isinstance(options, list) and len(options) > 1
+            assert options[0] == '53'
+
     def test_outputformat_ek(self, check_outputformat, base_env):
         '''Decode some captures into ek'''
         check_outputformat("ek", expected="dhcp.ek", multiline=True, env=base_env)
@@ -90,3 +132,42 @@ class TestOutputFormats:
         ''' Check that the option -j works with -Tek.'''
         check_outputformat("ek", extra_args=['-j', 'dhcp'], expected="dhcp-filter.ek",
             multiline=True, env=base_env)
+
+    def test_outputformat_fields_occurrence(self, cmd_tshark, capture_file, base_env):
+        '''Checks that -E occurrence picks the right values of repeated fields.'''
+        def tshark_fields(occurrence):
+            tshark_proc = subprocess.run([cmd_tshark, '-r', capture_file('dhcp.pcap'), '-T', 'fields',
+                                          '-E', 'occurrence=' + occurrence, '-E', 'aggregator=/',
+                                          '-e', 'dhcp.option.type', '-e', 'dhcp', '-e', 'dhcp.option.type'],
+                                         check=True, capture_output=True, encoding='utf-8', env=base_env)
+            return [line.split('\t') for line in tshark_proc.stdout.splitlines()]
+
+        all_values = tshark_fields('a')
+        assert len(all_values) == 4
+        for line in all_values:
+            # Every DHCP message starts with the Message Type option.
+            assert line[0].split('/')[0] == '53'
+            assert len(line[0].split('/')) > 1
+            # Protocols are printed with their label.
+            assert line[1].startswith('Dynamic Host Configuration Protocol (')
+            assert line[2] == line[0]
+        for occurrence, pick in (('f', 0), ('l', -1)):
+            values = tshark_fields(occurrence)
+            assert values == [[line[0].split('/')[pick], line[1], line[0].split('/')[pick]] for line in all_values]
+
+    def test_outputformat_summary_hidden_columns(self, cmd_tshark, capture_file, base_env):
+        '''Checks that hidden columns, custom or not, don't change the summary lines.'''
+        def tshark_summary(*args):
+            tshark_proc = subprocess.run([cmd_tshark, '-r', capture_file('dhcp.pcap')] + list(args),
+                                         check=True, capture_output=True, encoding='utf-8', env=base_env)
+            return tshark_proc.stdout
+
+        # Custom columns on either side of a hidden one that isn't custom.
+        with_hidden = tshark_summary(
+            '-o', 'gui.column.format:"No.","%m","Source","%Cus:ip.src","Protocol","%p",'
+                  '"Destination","%Cus:ip.dst","Length","%Cus:frame.len","Info","%i"',
+            '-o', 'gui.column.hide:2,3,5')
+        visible_only = tshark_summary(
+            '-o', 'gui.column.format:"No.","%m","Destination","%Cus:ip.dst","Info","%i"')
+        assert with_hidden == visible_only
+        assert len(visible_only.splitlines()) == 4
@@ -9,7 +9,13 @@
 '''sharkd tests'''
 
 import json
+import os
+import signal
+import socket
 import subprocess
+import sys
+import tempfile
+import time
 import pytest
 from matchers import *
 
@@ -237,6 +243,29 @@ class TestSharkd:
             },
         ))
 
+    def test_sharkd_req_frames_cursor(self, run_sharkd_session, capture_file):
+        # Pages after the first one start at the cursor, and are served
+        # from the column cache the second time around.
+        columns = {"column0": "0", "column1": "ip.src:0", "column2": "frame.time_delta_displayed:0"}
+        outputs = run_sharkd_session([json.dumps(x) for x in (
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap')}
+             },
+            {"jsonrpc":"2.0", "id":2, "method":"frames", "params":dict(columns, filter="frame.number!=2")},
+            {"jsonrpc":"2.0", "id":3, "method":"frames", "params":dict(columns, filter="frame.number!=2", limit=1)},
+            {"jsonrpc":"2.0", "id":4, "method":"frames", "params":dict(columns, filter="frame.number!=2", cursor=1)},
+            {"jsonrpc":"2.0", "id":5, "method":"frames", "params":dict(columns, filter="frame.number!=2")},
+            {"jsonrpc":"2.0", "id":6, "method":"frames", "params":dict(columns, cursor=2, limit=1)},
+        )])
+        frames = outputs[1]["result"]
+        assert [f["num"] for f in frames] == [1, 3, 4]
+        assert outputs[2]["result"] + outputs[3]["result"] == frames
+        assert outputs[4]["result"] == frames
+        # Without the filter, frame 3 is displayed after frame 2.
+        assert outputs[5]["result"][0]["num"] == 3
+        assert outputs[5]["result"][0]["c"][:2] == frames[1]["c"][:2]
+        assert outputs[5]["result"][0]["c"][2] != frames[1]["c"][2]
+
     def test_sharkd_req_frames_comments(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -1265,6 +1294,41 @@ class TestSharkd:
             ]}},
         ))
 
+    def test_sharkd_req_iograph_zoom(self, check_sharkd_session, capture_file):
+        # Later requests at multiples of the interval tapped at are made
+        # from the items of earlier ones.
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"iograph",
+             "params":{"graph0": "max:udp.length", "filter0": "udp.length", "graph1": "min:udp.length", "filter1": "udp.length"}
+             },
+            {"jsonrpc":"2.0", "id":3, "method":"iograph",
+             "params":{"graph0": "max:udp.length", "filter0": "udp.length", "graph1": "min:udp.length", "filter1": "udp.length",
+                       "interval": 10}
+             },
+            {"jsonrpc":"2.0", "id":4, "method":"iograph",
+             "params":{"graph0": "packets", "interval": 3}
+             },
+            {"jsonrpc":"2.0", "id":5, "method":"iograph",
+             "params":{"graph0": "packets", "interval": 100, "interval_units": "us"}
+             },
+            {"jsonrpc":"2.0", "id":6, "method":"iograph",
+             "params":{"graph0": "packets", "graph1": "bytes", "interval": 1, "interval_units": "s"}
+             },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"iograph": [{"items": [308.0]}, {"items": [280.0]}]}},
+            {"jsonrpc":"2.0","id":3,"result":{"iograph": [
+                {"items": [308.0, '7', 308.0]},
+                {"items": [280.0, '7', 280.0]},
+            ]}},
+            {"jsonrpc":"2.0","id":4,"result":{"iograph": [{"items": [2.0, '17', 2.0]}]}},
+            {"jsonrpc":"2.0","id":5,"result":{"iograph": [{"items": [1.0, '2', 1.0, '2bc', 1.0, '2bf', 1.0]}]}},
+            {"jsonrpc":"2.0","id":6,"result":{"iograph": [{"items": [4.0]}, {"items": [1312.0]}]}},
+        ))
+
     def test_sharkd_req_intervals_bad(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -1387,6 +1451,22 @@ class TestSharkd:
             {"jsonrpc":"2.0","id":4,"result":{"comment":["foo\nbar"],"fol": MatchAny(list), "followers": MatchAny(list)}},
         ))
 
+    def test_sharkd_req_setcomment_frames(self, run_sharkd_session, capture_file):
+        # Cached column text has to be updated when a comment is set.
+        params = {"column0": "frame.comment:0", "filter": "frame.number==3"}
+        outputs = run_sharkd_session([json.dumps(x) for x in (
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap')}
+             },
+            {"jsonrpc":"2.0", "id":2, "method":"frames", "params":params},
+            {"jsonrpc":"2.0", "id":3, "method":"setcomment",
+             "params":{"frame": 3, "comment": "foo"}
+             },
+            {"jsonrpc":"2.0", "id":4, "method":"frames", "params":params},
+        )])
+        assert outputs[1]["result"][0]["c"] == [""]
+        assert outputs[3]["result"][0]["c"] == ["foo"]
+
     def test_sharkd_req_setconf_bad(self, check_sharkd_session):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"setconf",
@@ -1543,6 +1623,86 @@ class TestSharkd:
                 "file":"eo:http_2","mime":"application/octet-stream","data":"MA0KDQo="}},
             {"jsonrpc":"2.0","id":5,"result":{}},
         ))
+    def test_sharkd_req_tail(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"tail"},
+            {"jsonrpc":"2.0", "id":2, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap'), "tail": True}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"tail"},
+            {"jsonrpc":"2.0", "id":4, "method":"tail", "params":{"stop": True}},
+            {"jsonrpc":"2.0", "id":5, "method":"tail"},
+        ), (
+            {"jsonrpc":"2.0","id":1,"error":{"code":-14001,"message":"No file is being tailed"}},
+            {"jsonrpc":"2.0","id":2,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":3,"result":{"frames":4,"added":0,"tailing":True}},
+            {"jsonrpc":"2.0","id":4,"result":{"frames":4,"added":0,"tailing":False}},
+            {"jsonrpc":"2.0","id":5,"error":{"code":-14001,"message":"No file is being tailed"}},
+        ))
+
+    def test_sharkd_req_tail_growing(self, cmd_sharkd, base_env, capture_file, result_file):
+        # dhcp.pcap is a 24 byte file header followed by four records,
+        # which end at these offsets.
+        record_ends = (354, 712, 1042, 1400)
+        with open(capture_file('dhcp.pcap'), 'rb') as f:
+            pcap = f.read()
+        tail_file = result_file('tail.pcap')
+        with open(tail_file, 'wb') as f:
+            f.write(pcap[:record_ends[1]])
+
+        def append(data):
+            with open(tail_file, 'ab') as f:
+                f.write(data)
+
+        sharkd_proc = subprocess.Popen(
+            (cmd_sharkd, '-'), stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, encoding='utf-8', env=base_env)
+        notifications = []
+
+        def request(rpcid, method, params=None):
+            req = {"jsonrpc":"2.0", "id":rpcid, "method":method}
+            if params:
+                req["params"] = params
+            sharkd_proc.stdin.write(json.dumps(req) + '\n')
+            sharkd_proc.stdin.flush()
+            # Records added to the file may be read, and notified, while
+            # sharkd waits for the request as well as by the request.
+            while True:
+                line = sharkd_proc.stdout.readline()
+                if not line:
+                    pytest.fail('sharkd exited')
+                jdata = json.loads(line)
+                if 'id' not in jdata:
+                    notifications.append(jdata)
+                    continue
+                assert jdata['id'] == rpcid
+                return jdata['result']
+
+        try:
+            assert request(1, "load", {"file": tail_file, "tail": True}) == {"status":"OK"}
+            assert request(2, "iograph", {"graph0": "packets"}) == {"iograph": [{"items": [2.0]}]}
+            assert request(3, "tail") == {"frames":2, "added":0, "tailing":True}
+            assert notifications == []
+
+            # The last record is only partly written at first.
+            append(pcap[record_ends[1]:record_ends[2] + 100])
+            assert request(4, "tail")["frames"] == 3
+            assert notifications == [
+                {"jsonrpc":"2.0","method":"tail","params":{"frames":3,"added":1,"duration":0.070031}},
+            ]
+
+            append(pcap[record_ends[2] + 100:])
+            assert request(5, "tail")["frames"] == 4
+            assert notifications[1:] == [
+                {"jsonrpc":"2.0","method":"tail","params":{"frames":4,"added":1,"duration":0.070345}},
+            ]
+
+            assert [f["num"] for f in request(6, "frames")] == [1, 2, 3, 4]
+            assert request(7, "iograph", {"graph0": "packets"}) == {"iograph": [{"items": [4.0]}]}
+            assert request(8, "tail", {"stop": True}) == {"frames":4, "added":0, "tailing":False}
+        finally:
+            sharkd_proc.stdin.close()
+            sharkd_proc.communicate()
+
     def test_sharkd_req_bye(self, check_sharkd_session):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"bye"},
@@ -1610,6 +1770,80 @@ class TestSharkd:
             {"jsonrpc":"2.0","id":5,"result":{"prefs":{"wlan.ignore_wep":{"e":[{"v":0,"s":1,"d":"No"},{"v":1,"d":"Yes - without IV"},{"v":2,"d":"Yes - with IV"}]}}}},
         ))
 
+    @pytest.mark.skipif(not sys.platform.startswith('linux'), reason='Looks for the session processes in /proc')
+    def test_sharkd_pool(self, cmd_sharkd, base_env):
+        '''Serve connections from a pool of session processes, which exit with the daemon.'''
+        def group_processes(pgid):
+            '''Map the pid of each live process in a process group to its parent's.'''
+            processes = {}
+            for entry in os.listdir('/proc'):
+                if not entry.isdigit():
+                    continue
+                try:
+                    with open(os.path.join('/proc', entry, 'stat')) as stat_file:
+                        stat = stat_file.read()
+                except OSError:
+                    continue
+                # state, ppid and pgrp follow the command name, which is in parentheses.
+                state, ppid, pgrp = stat[stat.rindex(')') + 2:].split()[:3]
+                if state != 'Z' and int(pgrp) == pgid:
+                    processes[int(entry)] = int(ppid)
+            return processes
+
+        sock_dir = tempfile.mkdtemp()
+        sock_path = os.path.join(sock_dir, 'sharkd.sock')
+        conns = []
+        daemon_pid = None
+        try:
+            # sharkd forks the daemon into the background and exits; its own
+            # session makes the daemon and its session processes easy to find.
+            launcher = subprocess.Popen(
+                (cmd_sharkd, '-a', 'unix:' + sock_path, '-p', '2'),
+                stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                env=base_env, start_new_session=True)
+            assert launcher.wait(timeout=60) == 0
+            pgid = launcher.pid
+
+            for rpcid in (1, 2):
+                conn = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+                conn.settimeout(60)
+                conn.connect(sock_path)
+                conn.sendall(json.dumps({"jsonrpc":"2.0", "id":rpcid, "method":"status"}).encode() + b'\n')
+                conns.append(conn)
+            # Both connections are open at once, so each has its own session.
+            for rpcid, conn in enumerate(conns, 1):
+                reply = json.loads(conn.makefile('r', encoding='utf-8').readline())
+                assert reply['id'] == rpcid
+                assert reply['result']['frames'] == 0
+            for conn in conns:
+                conn.close()
+            conns = []
+
+            processes = group_processes(pgid)
+            daemon_pids = [pid for pid, ppid in processes.items() if ppid not in processes]
+            assert len(daemon_pids) == 1
+            daemon_pid = daemon_pids[0]
+            # The pool has been filled up again.
+            deadline = time.monotonic() + 60
+            while len([ppid for ppid in group_processes(pgid).values() if ppid == daemon_pid]) < 2:
+                assert time.monotonic() < deadline
+                time.sleep(0.1)
+
+            os.kill(daemon_pid, signal.SIGTERM)
+            daemon_pid = None
+            deadline = time.monotonic() + 60
+            while group_processes(pgid):
+                assert time.monotonic() < deadline, 'idle session processes outlived the daemon'
+                time.sleep(0.1)
+        finally:
+            for conn in conns:
+                conn.close()
+            if daemon_pid is not None:
+                os.kill(daemon_pid, signal.SIGTERM)
+            if os.path.exists(sock_path):
+                os.unlink(sock_path)
+            os.rmdir(sock_dir)
+
     def test_sharkd_nested_file(self, check_sharkd_session, capture_file):
         '''Request a frame from a file with a deep level of nesting.'''
         check_sharkd_session((
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+'''Measure how fast tshark applies a "matches" display filter.
+
+Runs "tshark -n -q -r <capture> -Y 'frame matches <pattern>'" over some
+captures and reports the number of bytes of capture read per second. If a
+second tshark is given with --baseline, it's run over the same captures,
+so that regular expression matching in one build can be compared with
+that in another.
+
+A large capture gives the most meaningful numbers; with small ones the
+time is mostly tshark starting up.
+
+Example:
+    tools/bench_dfilter_matches.py --tshark build/run/tshark \\
+        --baseline ../wireshark-master/build/run/tshark big.pcapng
+'''
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+import time
+
+
+DEFAULT_PATTERNS = [
+    # Usually fails early on each packet, with a literal prefix to look for.
+    r'(?i)user-agent: *mozilla',
+    # Has to be tried at every offset of every packet.
+    r'[0-9]{3}-[0-9]{4}',
+]
+
+
+def run_tshark(tshark, capture, pattern):
+    '''Run tshark once and return the seconds taken.'''
+    dfilter = 'frame matches "{}"'.format(pattern.replace('\\', '\\\\').replace('"', '\\"'))
+    cmd = [tshark, '-n', '-q', '-r', capture, '-Y', dfilter]
+    start = time.perf_counter()
+    proc = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    elapsed = time.perf_counter() - start
+    if proc.returncode != 0:
+        sys.exit(f'{" ".join(cmd)} failed with exit status {proc.returncode}:\n{proc.stderr.decode(errors="replace")}')
+    return elapsed
+
+
+def best_time(tshark, capture, pattern, repeat):
+    '''Return the shortest time over several runs.'''
+    return min(run_tshark(tshark, capture, pattern) for _ in range(repeat))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Measure the speed of the display filter "matches" operator in tshark.')
+    parser.add_argument('--tshark', required=True, help='tshark to measure')
+    parser.add_argument('--baseline', help='tshark to compare with')
+    parser.add_argument('-p', dest='patterns', action='append',
+                        help='regular expression to match against each frame (may be given more than once)')
+    parser.add_argument('--repeat', type=int, default=3, help='runs per capture; the best one counts (default 3)')
+    parser.add_argument('captures', nargs='*', help='captures to read (default: the test suite captures)')
+    args = parser.parse_args()
+
+    patterns = args.patterns or DEFAULT_PATTERNS
+    captures = args.captures
+    if not captures:
+        captures_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'test', 'captures')
+        captures = sorted(glob.glob(os.path.join(captures_dir, '*.pcap')) +
+                          glob.glob(os.path.join(captures_dir, '*.pcapng')))
+
+    tsharks = [('tshark', args.tshark)]
+    if args.baseline:
+        tsharks.append(('baseline', args.baseline))
+
+    for pattern in patterns:
+        totals = {name: [0, 0.0] for name, _ in tsharks}
+        print(f'frame matches "{pattern}"')
+        for capture in captures:
+            size = os.path.getsize(capture)
+            line = f'  {os.path.basename(capture):40}'
+            for name, tshark in tsharks:
+                seconds = best_time(tshark, capture, pattern, args.repeat)
+                totals[name][0] += size
+                totals[name][1] += seconds
+                rate = size / seconds if seconds > 0 else 0.0
+                line += f' {name} {rate / (1024 * 1024):8.1f} MiB/s'
+            print(line)
+
+        line = f'  {"total":40}'
+        rates = []
+        for name, _ in tsharks:
+            size, seconds = totals[name]
+            rate = size / seconds if seconds > 0 else 0.0
+            rates.append(rate)
+            line += f' {name} {rate / (1024 * 1024):8.1f} MiB/s'
+        if len(rates) == 2 and rates[1] > 0:
+            line += f'  ({rates[0] / rates[1]:.2f}x)'
+        print(line)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+'''Measure how fast tshark writes JSON and EK output.
+
+Runs "tshark -r <capture> -T <format>" over some captures and reports the
+number of bytes of output written per second. If a second tshark is given
+with --baseline, it's run over the same captures, so that the output
+writer of one build can be compared with that of another.
+
+Example:
+    tools/bench_json_output.py --tshark build/run/tshark \\
+        --baseline ../wireshark-master/build/run/tshark -T json -T ek
+'''
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+import time
+
+
+def run_tshark(tshark, capture, output_format, extra_args):
+    '''Run tshark once and return (bytes written, seconds taken).'''
+    cmd = [tshark, '-n', '-r', capture, '-T', output_format] + extra_args
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    written = 0
+    while True:
+        chunk = proc.stdout.read(1024 * 1024)
+        if not chunk:
+            break
+        written += len(chunk)
+    proc.wait()
+    elapsed = time.perf_counter() - start
+    if proc.returncode != 0:
+        sys.exit(f'{" ".join(cmd)} failed with exit status {proc.returncode}')
+    return written, elapsed
+
+
+def best_rate(tshark, capture, output_format, extra_args, repeat):
+    '''Return (bytes written, best bytes per second) over several runs.'''
+    written = 0
+    best = 0.0
+    for _ in range(repeat):
+        written, elapsed = run_tshark(tshark, capture, output_format, extra_args)
+        if elapsed > 0:
+            best = max(best, written / elapsed)
+    return written, best
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Measure the throughput of the tshark JSON and EK writers.')
+    parser.add_argument('--tshark', required=True, help='tshark to measure')
+    parser.add_argument('--baseline', help='tshark to compare with')
+    parser.add_argument('-T', dest='formats', action='append', choices=['json', 'jsonraw', 'ek'],
+                        help='output format (may be given more than once; default json)')
+    parser.add_argument('-x', dest='hex', action='store_true', help='include raw bytes (-x)')
+    parser.add_argument('--no-duplicate-keys', action='store_true', help='pass --no-duplicate-keys (json only)')
+    parser.add_argument('--repeat', type=int, default=3, help='runs per capture; the best one counts (default 3)')
+    parser.add_argument('captures', nargs='*', help='captures to read (default: the test suite captures)')
+    args = parser.parse_args()
+
+    formats = args.formats or ['json']
+    captures = args.captures
+    if not captures:
+        captures_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'test', 'captures')
+        captures = sorted(glob.glob(os.path.join(captures_dir, '*.pcap')) +
+                          glob.glob(os.path.join(captures_dir, '*.pcapng')))
+
+    tsharks = [('tshark', args.tshark)]
+    if args.baseline:
+        tsharks.append(('baseline', args.baseline))
+
+    for output_format in formats:
+        extra_args = []
+        if args.hex:
+            extra_args.append('-x')
+        if args.no_duplicate_keys and output_format != 'ek':
+            extra_args.append('--no-duplicate-keys')
+
+        totals = {name: [0, 0.0] for name, _ in tsharks}
+        print(f'-T {output_format} {" ".join(extra_args)}')
+        for capture in captures:
+            line = f'  {os.path.basename(capture):40}'
+            for name, tshark in tsharks:
+                written, rate = best_rate(tshark, capture, output_format, extra_args, args.repeat)
+                if rate > 0:
+                    totals[name][0] += written
+                    totals[name][1] += written / rate
+                line += f' {name} {rate / (1024 * 1024):8.1f} MiB/s'
+            print(line)
+
+        line = f'  {"total":40}'
+        rates = []
+        for name, _ in tsharks:
+            written, seconds = totals[name]
+            rate = written / seconds if seconds > 0 else 0.0
+            rates.append(rate)
+            line += f' {name} {rate / (1024 * 1024):8.1f} MiB/s'
+        if len(rates) == 2 and rates[1] > 0:
+            line += f'  ({rates[0] / rates[1]:.2f}x)'
+        print(line)
+
+
+if __name__ == '__main__':
+    main()
@@ -30,6 +30,9 @@
 
 #ifndef _WIN32
 #include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #endif
 
 #include <glib.h>
@@ -51,6 +54,7 @@
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/pint.h>
 #include <cli_main.h>
 #include <wsutil/version_info.h>
 #include <wiretap/wtap_opttypes.h>
@@ -134,6 +138,9 @@
 #define INVALID_TAP             2
 #define INVALID_CAPTURE         2
 
+/* Size of the stdout buffer for JSON and EK output */
+#define JSON_OUTPUT_BUFFER_SIZE (1024 * 1024)
+
 #define LONGOPT_EXPORT_OBJECTS          LONGOPT_BASE_APPLICATION+1
 #define LONGOPT_COLOR                   LONGOPT_BASE_APPLICATION+2
 #define LONGOPT_NO_DUPLICATE_KEYS       LONGOPT_BASE_APPLICATION+3
@@ -145,6 +152,7 @@
 #define LONGOPT_PRINT_TIMERS            LONGOPT_BASE_APPLICATION+9
 #define LONGOPT_GLOBAL_PROFILE          LONGOPT_BASE_APPLICATION+10
 #define LONGOPT_COMPRESS                LONGOPT_BASE_APPLICATION+11
+#define LONGOPT_SHARDS                  LONGOPT_BASE_APPLICATION+12
 
 capture_file cfile;
 
@@ -175,6 +183,7 @@ typedef enum {
 
 static output_action_e output_action;
 static bool do_dissection;     /* true if we have to dissect each packet */
+static bool frame_checks;      /* true if the display filter's frame checks can spare second-pass dissections */
 static bool print_packet_info; /* true if we're to print packet information */
 static bool print_summary;     /* true if we're to print packet summary information */
 static bool print_details;     /* true if we're to print packet details information */
@@ -199,6 +208,53 @@ static proto_node_children_grouper_func node_children_grouper = proto_node_group
 
 static json_dumper jdumper;
 
+/*
+ * Number of worker processes to dissect in (--shards).  Each worker
+ * reads the whole file but dissects only the records that hash to its
+ * shard; the parent puts their output back in frame order.
+ */
+static unsigned shard_count = 1;
+#ifndef _WIN32
+static unsigned shard_index;      /* Worker: the shard we dissect */
+static FILE *shard_out;           /* Worker: pipe to the parent, or NULL if we're not a worker */
+static GArray *shard_pending;     /* Worker: frames whose output hasn't been sent yet */
+static json_dumper shard_jdumper; /* Worker: JSON dumper state before any packet was written */
+static uint32_t shard_through;    /* Worker: the last frame we've processed */
+static uint32_t shard_reported;   /* Worker: the last frame the parent knows we've processed */
+static const char *shard_conversation_field; /* First -e field that numbers conversations */
+static const char *shard_displayed_field;    /* First -e field that depends on the displayed frames */
+
+/*
+ * Fields that number conversations in the order they're first seen.
+ * A worker sees only some of the conversations, so it would number
+ * them differently.
+ */
+static const char *conversation_index_fields[] = {
+    "eth.stream",
+    "ip.stream",
+    "ipv6.stream",
+    "tcp.stream",
+    "udp.stream",
+    "dccp.stream",
+    "sctp.assoc_index",
+    "mptcp.stream",
+    "quic.connection.number",
+    "wg.stream",
+    NULL
+};
+
+/*
+ * Fields that depend on which of the earlier frames the display filter
+ * passed.  A worker doesn't know which of the other workers' frames
+ * passed.
+ */
+static const char *displayed_frame_fields[] = {
+    "frame.time_delta_displayed",
+    "frame.cum_bytes",
+    NULL
+};
+#endif
+
 /* The line separator used between packets, changeable via the -S option */
 static const char *separator = "";
 
@@ -257,7 +313,7 @@ typedef enum {
 static process_file_status_t process_cap_file(capture_file *, char *, int, bool, int, int64_t, int, wtap_compression_type);
 
 static bool process_packet_single_pass(capture_file *cf,
-        epan_dissect_t *edt, int64_t offset, wtap_rec *rec, Buffer *buf,
+        epan_dissect_t *edt, int64_t offset, wtap_rec *rec, const uint8_t *pd,
         unsigned tap_flags);
 static void show_print_file_io_error(void);
 static bool write_preamble(capture_file *cf);
@@ -457,6 +513,10 @@ print_usage(FILE *output)
     fprintf(output, "  -y <link type>, --linktype <link type>\n");
     fprintf(output, "                           link layer type (def: first appropriate)\n");
     fprintf(output, "  --time-stamp-type <type> timestamp method for interface\n");
+#ifdef CAN_USE_TPACKET_V3
+    fprintf(output, "  --tpacket-v3 <threads>   capture from a TPACKET_V3 ring read by <threads>\n");
+    fprintf(output, "                           fanout threads instead of libpcap (def: 0, off)\n");
+#endif
     fprintf(output, "  -D, --list-interfaces    print list of interfaces and exit\n");
     fprintf(output, "  -L, --list-data-link-types\n");
     fprintf(output, "                           print list of link-layer types of iface and exit\n");
@@ -495,6 +555,8 @@ print_usage(FILE *output)
     fprintf(output, "Processing:\n");
     fprintf(output, "  -2                       perform a two-pass analysis\n");
     fprintf(output, "  -M <packet count>        perform session auto reset\n");
+    fprintf(output, "  --shards <count>         dissect in <count> worker processes, each handling\n");
+    fprintf(output, "                           the traffic between a subset of host pairs\n");
     fprintf(output, "  -R <read filter>, --read-filter <read filter>\n");
     fprintf(output, "                           packet Read filter in Wireshark display filter syntax\n");
     fprintf(output, "                           (requires -2)\n");
@@ -757,6 +819,80 @@ _compile_dfilter(const char *text, dfilter_t **dfp, const char *caller)
 
 #define compile_dfilter(text, dfp)      _compile_dfilter(text, dfp, __func__)
 
+#ifndef _WIN32
+/*
+ * If a compiled filter or field expression refers to one of a list of
+ * fields, return that field's name.
+ */
+static const char *
+dfilter_shard_field(const dfilter_t *df, const char **fields)
+{
+    header_field_info *hfinfo;
+
+    for (unsigned i = 0; fields[i] != NULL; i++) {
+        hfinfo = proto_registrar_get_byname(fields[i]);
+        if (hfinfo != NULL && dfilter_interested_in_field(df, hfinfo->id))
+            return fields[i];
+    }
+    return NULL;
+}
+
+/*
+ * Note whether a -e field refers to fields that workers can't get
+ * right.  Fields that don't compile are reported later, with all the
+ * others.
+ */
+static void
+shard_check_output_field(const char *field)
+{
+    dfilter_t  *df;
+
+    if (!dfilter_compile_full(field, &df, NULL, DF_EXPAND_MACROS|DF_RETURN_VALUES, __func__))
+        return;
+    if (shard_conversation_field == NULL)
+        shard_conversation_field = dfilter_shard_field(df, conversation_index_fields);
+    if (shard_displayed_field == NULL)
+        shard_displayed_field = dfilter_shard_field(df, displayed_frame_fields);
+    dfilter_free(df);
+}
+
+/*
+ * Likewise for the custom columns.
+ */
+static const char *
+custom_cols_shard_field(column_info *cinfo, const char **fields)
+{
+    const char *field;
+
+    for (int i = 0; i < cinfo->num_cols; i++) {
+        if (cinfo->columns[i].col_custom_dfilter == NULL)
+            continue;
+        field = dfilter_shard_field(cinfo->columns[i].col_custom_dfilter, fields);
+        if (field != NULL)
+            return field;
+    }
+    return NULL;
+}
+
+/*
+ * Do any of the columns show something that depends on the displayed
+ * frames?
+ */
+static bool
+cols_depend_on_displayed_frames(column_info *cinfo)
+{
+    for (int i = 0; i < cinfo->num_cols; i++) {
+        if (cinfo->columns[i].fmt_matx[COL_DELTA_TIME_DIS] ||
+                cinfo->columns[i].fmt_matx[COL_CUMULATIVE_BYTES])
+            return true;
+        if (cinfo->columns[i].fmt_matx[COL_CLS_TIME] &&
+                timestamp_get_type() == TS_DELTA_DIS)
+            return true;
+    }
+    return false;
+}
+#endif
+
 static bool
 protocolfilter_add_opt(const char* arg, pf_flags filter_flags)
 {
@@ -981,6 +1117,7 @@ main(int argc, char *argv[])
         {"print-timers", ws_no_argument, NULL, LONGOPT_PRINT_TIMERS},
         {"global-profile", ws_no_argument, NULL, LONGOPT_GLOBAL_PROFILE},
         {"compress", ws_required_argument, NULL, LONGOPT_COMPRESS},
+        {"shards", ws_required_argument, NULL, LONGOPT_SHARDS},
         {0, 0, 0, 0}
     };
     bool                 arg_error = false;
@@ -1468,6 +1605,9 @@ main(int argc, char *argv[])
             case LONGOPT_COMPRESS_TYPE:        /* compress type */
             case LONGOPT_CAPTURE_TMPDIR:       /* capture temp directory */
             case LONGOPT_UPDATE_INTERVAL:      /* sync pipe update interval */
+#ifdef CAN_USE_TPACKET_V3
+            case LONGOPT_TPACKET_V3:           /* capture with a TPACKET_V3 ring */
+#endif
                 /* These are options only for packet capture. */
 #ifdef HAVE_LIBPCAP
                 exit_status = capture_opts_add_opt(&global_capture_opts, opt, ws_optarg);
@@ -1546,6 +1686,9 @@ main(int argc, char *argv[])
                             output_fields_add(output_fields, hfi->abbrev);
                         else
                             output_fields_add(output_fields, ws_optarg);
+#ifndef _WIN32
+                        shard_check_output_field(hfi ? hfi->abbrev : ws_optarg);
+#endif
                     }
                 }
                 break;
@@ -1929,6 +2072,9 @@ main(int argc, char *argv[])
             case LONGOPT_GLOBAL_PROFILE:
                 /* already processed; just ignore it now */
                 break;
+            case LONGOPT_SHARDS:          /* number of dissection workers */
+                shard_count = get_positive_int(ws_optarg, "number of shards");
+                break;
             case LONGOPT_COMPRESS:        /* compress type */
                 compression_type = wtap_name_to_compression_type(ws_optarg);
                 if (compression_type == WTAP_UNKNOWN_COMPRESSION) {
@@ -1979,6 +2125,16 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    /*
+     * JSON and EK are written a few bytes at a time; have the standard
+     * I/O library hand them to the OS in large chunks, unless we're
+     * flushing after every packet anyway.
+     */
+    if (!line_buffered &&
+        (output_action == WRITE_JSON || output_action == WRITE_JSON_RAW || output_action == WRITE_EK)) {
+        setvbuf(stdout, NULL, _IOFBF, JSON_OUTPUT_BUFFER_SIZE);
+    }
+
     /* If we specified output fields, but not the output field type... */
     /* XXX: If we specfied both output fields with -e *and* protocol filters
      * with -j/-J, only the former are used. Should we warn or abort?
@@ -2144,6 +2300,43 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (shard_count > 1) {
+#ifdef _WIN32
+        cmdarg_err("--shards isn't supported on Windows.");
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+#else
+        /* Each worker reads the file for itself. */
+        if (cf_name == NULL || strcmp(cf_name, "-") == 0) {
+            cmdarg_err("--shards requires a capture file to be read with -r.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (perform_two_pass_analysis) {
+            cmdarg_err("--shards can't be used with two-pass analysis (-2).");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (pdu_export_arg != NULL || tls_session_keys_file != NULL) {
+            cmdarg_err("--shards can't be used with -U or --export-tls-session-keys.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        /* Packet details include conversation indexes. */
+        if (print_packet_info && print_details && output_fields_num_fields(output_fields) == 0) {
+            cmdarg_err("--shards can't be used to print packet details.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (shard_conversation_field != NULL) {
+            cmdarg_err("--shards can't be used with the field \"%s\"; each worker numbers only the conversations it sees.",
+                    shard_conversation_field);
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+#endif
+    }
+
 #ifdef HAVE_LIBPCAP
     if (caps_queries) {
         /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -2424,6 +2617,19 @@ main(int argc, char *argv[])
     /* Build the column format array */
     build_column_format_array(&cfile.cinfo, prefs_p->num_cols, true);
 
+#ifndef _WIN32
+    if (shard_count > 1) {
+        const char *conversation_field = custom_cols_shard_field(&cfile.cinfo, conversation_index_fields);
+
+        if (conversation_field != NULL) {
+            cmdarg_err("--shards can't be used with a column showing \"%s\"; each worker numbers only the conversations it sees.",
+                    conversation_field);
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+    }
+#endif
+
 #ifdef HAVE_LIBPCAP
     capture_opts_trim_snaplen(&global_capture_opts, MIN_PACKET_SIZE);
     capture_opts_trim_ring_num_files(&global_capture_opts);
@@ -2461,6 +2667,33 @@ main(int argc, char *argv[])
     }
     cfile.dfcode = dfcode;
 
+#ifndef _WIN32
+    if (shard_count > 1 && dfcode != NULL) {
+        /*
+         * A worker doesn't know which of the other workers' frames the
+         * display filter passed, so it can't get anything that depends
+         * on the previous displayed frame right.
+         */
+        const char *displayed_field = shard_displayed_field;
+
+        if (displayed_field == NULL)
+            displayed_field = dfilter_shard_field(dfcode, displayed_frame_fields);
+        if (displayed_field == NULL)
+            displayed_field = custom_cols_shard_field(&cfile.cinfo, displayed_frame_fields);
+        if (displayed_field != NULL) {
+            cmdarg_err("--shards can't be used with a display filter (-Y) and \"%s\".", displayed_field);
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (((print_packet_info && print_summary) || output_fields_has_cols(output_fields)) &&
+                cols_depend_on_displayed_frames(&cfile.cinfo)) {
+            cmdarg_err("--shards can't be used with a display filter (-Y) and a column relative to the previous displayed frame.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+    }
+#endif
+
     if (print_packet_info) {
         /* If we're printing as text or PostScript, we have
            to create a print stream. */
@@ -2565,12 +2798,33 @@ main(int argc, char *argv[])
            filter. */
         start_requested_stats();
 
+        /* The workers' tap results would have to be merged; we don't
+           know how to do that. */
+        if (shard_count > 1 && tap_listeners_require_dissection()) {
+            cmdarg_err("--shards can't be used with -z or --export-objects.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+
         /* Do we need to do dissection of packets?  That depends on, among
            other things, what taps are listening, so determine that after
            starting the statistics taps. */
         do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
         ws_debug("tshark: do_dissection = %s", do_dissection ? "TRUE" : "FALSE");
 
+        /* In the second of two passes, a packet that the display filter
+           rejects on its frame number, length, time stamp or interface
+           alone needn't be dissected again, unless a tap or postdissector
+           wants to see it; the first pass has left all the state that
+           later packets need. A single pass must dissect every packet,
+           as skipping one would lose its share of that state (TCP
+           sequence analysis, reassembly, stream and conversation
+           numbers, and so on). */
+        frame_checks = perform_two_pass_analysis &&
+            dfilter_has_frame_checks(dfcode) &&
+            !tap_listeners_require_dissection() && !postdissectors_want_hfids();
+        ws_debug("tshark: frame_checks = %s", frame_checks ? "TRUE" : "FALSE");
+
         /* Process the packets in the file */
         ws_debug("tshark: invoking process_cap_file() to process the packets");
         TRY {
@@ -3204,8 +3458,8 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
                 wtap_close(cf->provider.wth);
                 cf->provider.wth = NULL;
             } else {
-                ret = process_packet_single_pass(cf, edt, data_offset, &rec, &buf,
-                        tap_flags);
+                ret = process_packet_single_pass(cf, edt, data_offset, &rec,
+                        ws_buffer_start_ptr(&buf), tap_flags);
             }
             if (ret != false) {
                 /* packet successfully read and gone through the "Read Filter" */
@@ -3462,8 +3716,8 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
          */
         if (edt && cf->dfcode) {
             elapsed_start = g_get_monotonic_time();
-            if (dfilter_apply_edt(cf->dfcode, edt) && edt->pi.fd->dependent_frames) {
-                g_hash_table_foreach(edt->pi.fd->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+            if (dfilter_apply_edt(cf->dfcode, edt) && frame_data_get_dependent_frames(edt->pi.fd)) {
+                g_hash_table_foreach(frame_data_get_dependent_frames(edt->pi.fd), find_and_mark_frame_depended_upon, cf->provider.frames);
             }
 
             if (selected_frame_number != 0 && selected_frame_number == cf->count + 1) {
@@ -3643,6 +3897,20 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
        that all packets can be marked as 'passed'. */
     passed = true;
 
+    if (edt && frame_checks &&
+            !dfilter_apply_frame_checks(cf->dfcode, fdata, rec)) {
+        /* The display filter can't match this packet, so don't
+           bother dissecting it. */
+        frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                &cf->provider.ref, cf->provider.prev_dis);
+        if (cf->provider.ref == fdata) {
+            ref_frame = *fdata;
+            cf->provider.ref = &ref_frame;
+        }
+        cf->provider.prev_cap = fdata;
+        return fdata->dependent_of_displayed;
+    }
+
     /* If we're going to print packet information, or we're going to
        run a read filter, or we're going to process taps, set up to
        do a dissection and do so.  (This is the second pass of two
@@ -3879,6 +4147,243 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
     return status;
 }
 
+#ifndef _WIN32
+/*
+ * Messages from a shard worker to the parent.  There's one for every
+ * frame the worker dissected, followed by "len" bytes of output for that
+ * frame, and a final one, with a frame number of 0, giving the worker's
+ * pass_status_t in "flags" and its error, followed by "len" bytes of
+ * error information.
+ *
+ * A worker that's been skipping other workers' frames also says how far
+ * it's got, with SHARD_MSG_PROGRESS in "flags" and no output, so that
+ * the parent needn't wait for its next frame to write out earlier ones.
+ */
+typedef struct {
+    uint32_t framenum;
+    uint32_t flags;
+    int32_t  err;
+    uint32_t len;
+} shard_msg_hdr;
+
+#define SHARD_MSG_PASSED    0x00000001  /* The frame passed the display filter */
+#define SHARD_MSG_PROGRESS  0x00000002  /* We've processed every frame up to this one */
+
+typedef struct {
+    uint32_t framenum;
+    uint32_t flags;
+    off_t    end;       /* Offset of the end of its output */
+} shard_pending_frame;
+
+/* Send output to the parent once we have this much, or this many frames. */
+#define SHARD_BATCH_BYTES   (256 * 1024)
+#define SHARD_BATCH_FRAMES  256
+
+static unsigned
+shard_of_addresses(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    const uint8_t *lo = a, *hi = b;
+    uint32_t hash = 2166136261U;
+    size_t i;
+
+    /* Both directions of a conversation go to the same shard. */
+    if (memcmp(a, b, len) > 0) {
+        lo = b;
+        hi = a;
+    }
+    for (i = 0; i < len; i++)
+        hash = (hash ^ lo[i]) * 16777619U;
+    for (i = 0; i < len; i++)
+        hash = (hash ^ hi[i]) * 16777619U;
+    return hash % shard_count;
+}
+
+static unsigned
+shard_of_ip(const uint8_t *pd, uint32_t len)
+{
+    if (len >= 20 && (pd[0] >> 4) == 4)
+        return shard_of_addresses(pd + 12, pd + 16, 4);
+    if (len >= 40 && (pd[0] >> 4) == 6)
+        return shard_of_addresses(pd + 8, pd + 24, 16);
+    return 0;
+}
+
+/*
+ * Pick the shard that dissects a record.
+ *
+ * We shard on the outermost IP source and destination addresses, not on
+ * ports, so that all fragments of a datagram, everything carried in a
+ * tunnel, and both directions of a conversation are seen by the same
+ * worker.  Non-IP Ethernet traffic is sharded on the MAC addresses;
+ * anything we don't understand is dissected by the first shard.
+ */
+static unsigned
+shard_of_record(const wtap_rec *rec, const uint8_t *pd)
+{
+    uint32_t caplen;
+    uint32_t offset;
+    uint16_t ethertype;
+
+    if (rec->rec_type != REC_TYPE_PACKET)
+        return 0;
+    caplen = rec->rec_header.packet_header.caplen;
+
+    switch (rec->rec_header.packet_header.pkt_encap) {
+
+    case WTAP_ENCAP_ETHERNET:
+        if (caplen < 14)
+            return 0;
+        offset = 12;
+        ethertype = pntoh16(pd + offset);
+        /* Skip VLAN tags */
+        while ((ethertype == 0x8100 || ethertype == 0x88a8 || ethertype == 0x9100) &&
+                offset + 6 <= caplen) {
+            offset += 4;
+            ethertype = pntoh16(pd + offset);
+        }
+        offset += 2;
+        if (ethertype != 0x0800 && ethertype != 0x86dd)
+            return shard_of_addresses(pd, pd + 6, 6);
+        break;
+
+    case WTAP_ENCAP_SLL:
+        offset = 16;
+        break;
+
+    case WTAP_ENCAP_SLL2:
+        offset = 20;
+        break;
+
+    case WTAP_ENCAP_NULL:
+    case WTAP_ENCAP_LOOP:
+        offset = 4;
+        break;
+
+    case WTAP_ENCAP_RAW_IP:
+    case WTAP_ENCAP_RAW_IP4:
+    case WTAP_ENCAP_RAW_IP6:
+        offset = 0;
+        break;
+
+    default:
+        return 0;
+    }
+    if (offset >= caplen)
+        return 0;
+    return shard_of_ip(pd + offset, caplen - offset);
+}
+
+/*
+ * Tell the parent about the frames we've skipped since the last one we
+ * told it about.
+ */
+static void
+shard_send_progress(void)
+{
+    shard_msg_hdr hdr;
+
+    if (shard_through != shard_reported) {
+        hdr.framenum = shard_through;
+        hdr.flags = SHARD_MSG_PROGRESS;
+        hdr.err = 0;
+        hdr.len = 0;
+        fwrite(&hdr, sizeof hdr, 1, shard_out);
+        shard_reported = shard_through;
+    }
+    /* If the parent has gone away, there's nobody to do this for. */
+    if (fflush(shard_out) != 0)
+        _exit(2);
+}
+
+/*
+ * Send the output for the frames we've dissected so far to the parent,
+ * and empty our output file.
+ */
+static void
+shard_flush_output(void)
+{
+    shard_msg_hdr hdr;
+    shard_pending_frame *pending;
+    char    *output = NULL;
+    off_t    start = 0;
+    off_t    end;
+    unsigned i;
+
+    if (shard_pending->len == 0) {
+        shard_send_progress();
+        return;
+    }
+
+    end = g_array_index(shard_pending, shard_pending_frame, shard_pending->len - 1).end;
+    if (fflush(stdout) != 0 || end < 0) {
+        show_print_file_io_error();
+        _exit(2);
+    }
+    if (end > 0) {
+        output = (char *)g_malloc(end);
+        if (pread(ws_fileno(stdout), output, end, 0) != end) {
+            show_print_file_io_error();
+            _exit(2);
+        }
+    }
+
+    for (i = 0; i < shard_pending->len; i++) {
+        pending = &g_array_index(shard_pending, shard_pending_frame, i);
+        hdr.framenum = pending->framenum;
+        hdr.flags = pending->flags;
+        hdr.err = 0;
+        hdr.len = (uint32_t)(pending->end - start);
+        fwrite(&hdr, sizeof hdr, 1, shard_out);
+        if (hdr.len != 0)
+            fwrite(output + start, 1, hdr.len, shard_out);
+        start = pending->end;
+    }
+    shard_reported = pending->framenum;
+    shard_send_progress();
+    g_free(output);
+    g_array_set_size(shard_pending, 0);
+
+    if (end > 0) {
+        if (ftruncate(ws_fileno(stdout), 0) != 0 || fseeko(stdout, 0, SEEK_SET) != 0) {
+            show_print_file_io_error();
+            _exit(2);
+        }
+    }
+}
+
+/*
+ * Note that we've finished with a frame we dissected; everything written
+ * to the standard output since the previous one is its output.
+ */
+static void
+shard_frame_done(uint32_t framenum, bool passed)
+{
+    shard_pending_frame pending;
+
+    pending.framenum = framenum;
+    pending.flags = passed ? SHARD_MSG_PASSED : 0;
+    pending.end = ftello(stdout);
+    g_array_append_val(shard_pending, pending);
+    shard_through = framenum;
+    if (pending.end < 0 || pending.end >= SHARD_BATCH_BYTES ||
+            shard_pending->len >= SHARD_BATCH_FRAMES)
+        shard_flush_output();
+}
+
+/*
+ * Note that we've skipped a frame another worker dissects.  If we
+ * haven't told the parent anything for a batch's worth of frames, do so
+ * now; it can't write out any frame after the last one we told it about.
+ */
+static void
+shard_frame_skipped(uint32_t framenum)
+{
+    shard_through = framenum;
+    if (framenum - shard_reported >= SHARD_BATCH_FRAMES)
+        shard_flush_output();
+}
+#endif /* _WIN32 */
+
 static pass_status_t
 process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         int max_packet_count, int64_t max_byte_count,
@@ -3895,6 +4400,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     int             write_framenum = 0;
     epan_dissect_t *edt = NULL;
     int64_t         data_offset;
+    const uint8_t  *pd;
     pass_status_t   status = PASS_SUCCEEDED;
 
     wtap_rec_init(&rec);
@@ -3951,7 +4457,9 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     set_resolution_synchrony(true);
 
     *err = 0;
-    while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+    /* Each packet is done with before the next one is read, so its data
+       needn't be copied out of the file. */
+    while (wtap_read_ptr(cf->provider.wth, &rec, &buf, &pd, err, err_info, &data_offset)) {
         if (read_interrupted) {
             status = PASS_INTERRUPTED;
             break;
@@ -3971,7 +4479,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 
         reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
 
-        if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
+        if (process_packet_single_pass(cf, edt, data_offset, &rec, pd, tap_flags)) {
             /* Either there's no read filtering or this packet passed the
                filter, so, if we're writing to a capture file, write
                this packet out. */
@@ -3979,7 +4487,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             if (pdh != NULL) {
                 ws_debug("tshark: writing packet #%d to outfile as #%d",
                         framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
+                if (!wtap_dump(pdh, &rec, pd, err, err_info)) {
                     /* Error writing to the output file. */
                     ws_debug("tshark: error writing to a capture file (%d)", *err);
                     *err_framenum = framenum;
@@ -4031,6 +4539,417 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     return status;
 }
 
+#ifndef _WIN32
+
+/*
+ * Run a shard worker; this is called in the child process and never
+ * returns.
+ */
+static void G_GNUC_NORETURN
+shard_worker_run(capture_file *cf, unsigned index, int out_fd,
+        int max_packet_count, int64_t max_byte_count)
+{
+    FILE          *output_file;
+    pass_status_t  status;
+    int            err = 0;
+    char          *err_info = NULL;
+    volatile uint32_t err_framenum;
+    shard_msg_hdr  hdr;
+
+    shard_index = index;
+    shard_pending = g_array_new(false, false, sizeof(shard_pending_frame));
+    shard_jdumper = jdumper;
+
+    /*
+     * Collect our output in a file, rather than sending it straight to
+     * the parent, so that we can tell how much of it belongs to each
+     * frame.
+     */
+    shard_out = ws_fdopen(out_fd, "wb");
+    output_file = tmpfile();
+    if (shard_out == NULL || output_file == NULL ||
+            dup2(ws_fileno(output_file), 1) == -1) {
+        cmdarg_err("Can't set up shard worker %u: %s.", index, g_strerror(errno));
+        _exit(2);
+    }
+
+    /*
+     * Open the file for ourselves; the parent's wtap shares its file
+     * offset with the parent, so leave it alone.
+     */
+    cf->provider.wth = wtap_open_offline(cf->filename, cf->open_type, &err, &err_info, false);
+    if (cf->provider.wth == NULL) {
+        status = PASS_READ_ERROR;
+    } else {
+        wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
+        wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+        wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+        status = process_cap_file_single_pass(cf, NULL, max_packet_count,
+                max_byte_count, 0, &err, &err_info, &err_framenum);
+        shard_flush_output();
+    }
+
+    hdr.framenum = 0;
+    hdr.flags = status;
+    hdr.err = err;
+    hdr.len = err_info ? (uint32_t)strlen(err_info) : 0;
+    fwrite(&hdr, sizeof hdr, 1, shard_out);
+    if (hdr.len != 0)
+        fwrite(err_info, 1, hdr.len, shard_out);
+    fclose(shard_out);
+    _exit(0);
+}
+
+typedef enum {
+    SHARD_HEAD_WAIT,    /* No complete message yet */
+    SHARD_HEAD_FRAME,   /* A frame's output */
+    SHARD_HEAD_PROGRESS, /* How far the worker has got */
+    SHARD_HEAD_FINAL,   /* The worker's final status */
+    SHARD_HEAD_LOST     /* The worker went away without a final status */
+} shard_head_t;
+
+typedef struct {
+    pid_t          pid;
+    int            fd;
+    GByteArray    *rx;      /* What we've read from the worker */
+    unsigned       rx_pos;  /* Start of the first unprocessed message */
+    shard_msg_hdr  hdr;     /* Header of that message */
+    uint32_t       through; /* It has no more frames up to this one */
+    bool           waiting; /* We need more from it to write out the next frame */
+    bool           eof;
+    bool           finished;
+} shard_worker;
+
+static shard_head_t
+shard_worker_head(shard_worker *worker)
+{
+    unsigned avail = worker->rx->len - worker->rx_pos;
+
+    if (avail >= sizeof(shard_msg_hdr)) {
+        memcpy(&worker->hdr, worker->rx->data + worker->rx_pos, sizeof worker->hdr);
+        if (avail - sizeof(shard_msg_hdr) >= worker->hdr.len) {
+            if (worker->hdr.framenum == 0)
+                return SHARD_HEAD_FINAL;
+            return (worker->hdr.flags & SHARD_MSG_PROGRESS) ? SHARD_HEAD_PROGRESS : SHARD_HEAD_FRAME;
+        }
+    }
+    return worker->eof ? SHARD_HEAD_LOST : SHARD_HEAD_WAIT;
+}
+
+static void
+shard_worker_consume(shard_worker *worker)
+{
+    worker->through = worker->hdr.framenum;
+    worker->rx_pos += (unsigned)sizeof(shard_msg_hdr) + worker->hdr.len;
+}
+
+static void
+shard_workers_stop(shard_worker *workers)
+{
+    for (unsigned i = 0; i < shard_count; i++) {
+        if (workers[i].pid > 0 && !workers[i].finished)
+            kill(workers[i].pid, SIGTERM);
+    }
+}
+
+/*
+ * Process the file in shard_count worker processes, and write out their
+ * output, and the records they let through to the output file, in
+ * frame order.
+ */
+static pass_status_t
+process_cap_file_sharded(capture_file *cf, wtap_dumper *pdh,
+        int max_packet_count, int64_t max_byte_count,
+        int max_write_packet_count,
+        int *err, char **err_info,
+        volatile uint32_t *err_framenum)
+{
+    shard_worker   *workers;
+    struct pollfd  *pfds;
+    unsigned       *pfd_workers;
+    unsigned        npfds;
+    unsigned        remaining = 0;
+    bool            stopping = false;
+    bool            json = (output_action == WRITE_JSON || output_action == WRITE_JSON_RAW);
+    uint32_t        json_elements = 0;
+    wtap_rec        rec;
+    Buffer          buf;
+    int64_t         data_offset;
+    uint32_t        read_framenum = 0;
+    int             write_framenum = 0;
+    pass_status_t   status = PASS_SUCCEEDED;
+    unsigned        i;
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+
+    *err = 0;
+    workers = g_new0(shard_worker, shard_count);
+    pfds = g_new(struct pollfd, shard_count);
+    pfd_workers = g_new(unsigned, shard_count);
+
+    /* Don't have the workers inherit buffered output. */
+    fflush(stdout);
+    fflush(stderr);
+
+    for (i = 0; i < shard_count; i++) {
+        int fds[2];
+
+        if (pipe(fds) == -1) {
+            *err = WTAP_ERR_INTERNAL;
+            *err_info = ws_strdup_printf("can't create a pipe for shard worker %u: %s",
+                    i, g_strerror(errno));
+            status = PASS_READ_ERROR;
+            break;
+        }
+        workers[i].pid = fork();
+        if (workers[i].pid == 0) {
+            for (unsigned j = 0; j < i; j++)
+                close(workers[j].fd);
+            close(fds[0]);
+            shard_worker_run(cf, i, fds[1], max_packet_count, max_byte_count);
+        }
+        close(fds[1]);
+        if (workers[i].pid == -1) {
+            close(fds[0]);
+            *err = WTAP_ERR_INTERNAL;
+            *err_info = ws_strdup_printf("can't start shard worker %u: %s",
+                    i, g_strerror(errno));
+            status = PASS_READ_ERROR;
+            break;
+        }
+        workers[i].fd = fds[0];
+        workers[i].rx = g_byte_array_new();
+        remaining++;
+    }
+    if (status != PASS_SUCCEEDED) {
+        shard_workers_stop(workers);
+        stopping = true;
+    }
+
+    while (remaining > 0) {
+        /*
+         * Write out frames in order as long as every worker that's
+         * still running has told us about its next frame, or told us
+         * it's past it.
+         */
+        for (;;) {
+            shard_worker *next = NULL;
+            bool          waiting = false;
+
+            for (i = 0; i < shard_count; i++) {
+                shard_worker *worker = &workers[i];
+
+                if (worker->rx == NULL || worker->finished)
+                    continue;
+                while (shard_worker_head(worker) == SHARD_HEAD_PROGRESS)
+                    shard_worker_consume(worker);
+                switch (shard_worker_head(worker)) {
+
+                case SHARD_HEAD_WAIT:
+                case SHARD_HEAD_PROGRESS:
+                    break;
+
+                case SHARD_HEAD_FRAME:
+                    if (next == NULL || worker->hdr.framenum < next->hdr.framenum)
+                        next = worker;
+                    break;
+
+                case SHARD_HEAD_FINAL:
+                    if (status == PASS_SUCCEEDED && !stopping &&
+                            worker->hdr.flags != PASS_SUCCEEDED) {
+                        status = (pass_status_t)worker->hdr.flags;
+                        *err = worker->hdr.err;
+                        if (worker->hdr.len != 0)
+                            *err_info = g_strndup((const char *)worker->rx->data +
+                                    worker->rx_pos + sizeof(shard_msg_hdr),
+                                    worker->hdr.len);
+                    }
+                    worker->finished = true;
+                    remaining--;
+                    break;
+
+                case SHARD_HEAD_LOST:
+                    if (status == PASS_SUCCEEDED && !stopping) {
+                        status = PASS_READ_ERROR;
+                        *err = WTAP_ERR_INTERNAL;
+                        *err_info = ws_strdup_printf("shard worker %u exited unexpectedly", i);
+                    }
+                    worker->finished = true;
+                    remaining--;
+                    break;
+                }
+            }
+            for (i = 0; i < shard_count; i++) {
+                shard_worker *worker = &workers[i];
+
+                worker->waiting = worker->rx != NULL && !worker->finished &&
+                        shard_worker_head(worker) == SHARD_HEAD_WAIT &&
+                        (next == NULL || worker->through < next->hdr.framenum);
+                if (worker->waiting)
+                    waiting = true;
+            }
+            if (waiting || next == NULL)
+                break;
+
+            if (!stopping) {
+                cf->count = next->hdr.framenum;
+
+                if (pdh != NULL) {
+                    /* Read up to the frame in our own copy of the file. */
+                    while (read_framenum < next->hdr.framenum) {
+                        wtap_rec_reset(&rec);
+                        if (!wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+                            if (*err == 0) {
+                                *err = WTAP_ERR_INTERNAL;
+                                *err_info = g_strdup("the capture file ended before the shard workers did");
+                            }
+                            status = PASS_READ_ERROR;
+                            break;
+                        }
+                        read_framenum++;
+                        if (!process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
+                            *err_framenum = read_framenum;
+                            status = PASS_WRITE_ERROR;
+                            break;
+                        }
+                    }
+                    if (status == PASS_SUCCEEDED && (next->hdr.flags & SHARD_MSG_PASSED)) {
+                        write_framenum++;
+                        ws_debug("tshark: writing packet #%u to outfile as #%d",
+                                read_framenum, write_framenum);
+                        if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
+                            *err_framenum = read_framenum;
+                            status = PASS_WRITE_ERROR;
+                        } else if (max_write_packet_count > 0 && write_framenum >= max_write_packet_count) {
+                            ws_debug("tshark: max_write_packet_count (%d) reached", max_write_packet_count);
+                            stopping = true;
+                        }
+                    }
+                }
+
+                if (status == PASS_SUCCEEDED && next->hdr.len != 0) {
+                    /* Each worker wrote its JSON packets as if they were the first. */
+                    if (json && json_elements++ != 0)
+                        putchar(',');
+                    fwrite(next->rx->data + next->rx_pos + sizeof(shard_msg_hdr),
+                            1, next->hdr.len, stdout);
+                    if (line_buffered)
+                        fflush(stdout);
+                    if (ferror(stdout)) {
+                        show_print_file_io_error();
+                        shard_workers_stop(workers);
+                        exit(2);
+                    }
+                }
+
+                if (status != PASS_SUCCEEDED)
+                    stopping = true;
+                if (stopping)
+                    shard_workers_stop(workers);
+            }
+            shard_worker_consume(next);
+        }
+
+        if (remaining == 0)
+            break;
+
+        if (read_interrupted && !stopping) {
+            status = PASS_INTERRUPTED;
+            shard_workers_stop(workers);
+            stopping = true;
+        }
+
+        /*
+         * Wait for more from the workers we're waiting on.  Leave the
+         * others be, so that their output stays in their pipes rather
+         * than piling up here.
+         */
+        npfds = 0;
+        for (i = 0; i < shard_count; i++) {
+            if (!workers[i].waiting)
+                continue;
+            pfds[npfds].fd = workers[i].fd;
+            pfds[npfds].events = POLLIN;
+            pfds[npfds].revents = 0;
+            pfd_workers[npfds] = i;
+            npfds++;
+        }
+        if (poll(pfds, npfds, -1) == -1 && errno != EINTR) {
+            *err = WTAP_ERR_INTERNAL;
+            *err_info = ws_strdup_printf("can't wait for the shard workers: %s", g_strerror(errno));
+            status = PASS_READ_ERROR;
+            shard_workers_stop(workers);
+            break;
+        }
+        for (unsigned p = 0; p < npfds; p++) {
+            shard_worker *worker = &workers[pfd_workers[p]];
+            ssize_t       nread;
+            unsigned      len;
+
+            if (pfds[p].revents == 0)
+                continue;
+            /* Discard what we've processed before reading more. */
+            if (worker->rx_pos != 0 && worker->rx_pos >= worker->rx->len / 2) {
+                g_byte_array_remove_range(worker->rx, 0, worker->rx_pos);
+                worker->rx_pos = 0;
+            }
+            len = worker->rx->len;
+            g_byte_array_set_size(worker->rx, len + 65536);
+            nread = read(worker->fd, worker->rx->data + len, 65536);
+            if (nread < 0) {
+                g_byte_array_set_size(worker->rx, len);
+                if (errno != EINTR && errno != EAGAIN)
+                    worker->eof = true;
+                continue;
+            }
+            g_byte_array_set_size(worker->rx, len + (unsigned)nread);
+            if (nread == 0)
+                worker->eof = true;
+        }
+    }
+
+    for (i = 0; i < shard_count; i++) {
+        if (workers[i].rx == NULL)
+            continue;
+        close(workers[i].fd);
+        waitpid(workers[i].pid, NULL, 0);
+        g_byte_array_free(workers[i].rx, true);
+    }
+    g_free(workers);
+    g_free(pfds);
+    g_free(pfd_workers);
+
+    /*
+     * Let our JSON dumper know that the array isn't empty, so that it
+     * closes it the way it would have had it written the packets itself.
+     */
+    if (json && json_elements != 0) {
+        FILE *output_file = jdumper.output_file;
+
+        jdumper.output_file = NULL;
+        json_dumper_begin_object(&jdumper);
+        json_dumper_end_object(&jdumper);
+        jdumper.output_file = output_file;
+    }
+
+    if (status == PASS_SUCCEEDED && pdh != NULL) {
+        /*
+         * Process whatever IDBs we haven't seen yet.
+         */
+        if (!process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
+            *err_framenum = read_framenum;
+            status = PASS_WRITE_ERROR;
+        }
+    }
+
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+
+    return status;
+}
+#endif /* _WIN32 */
+
 static process_file_status_t
 process_cap_file(capture_file *cf, char *save_file, int out_file_type,
         bool out_file_name_res, int max_packet_count, int64_t max_byte_count,
@@ -4155,6 +5074,25 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
             ws_debug("tshark: done with second pass");
         }
     }
+#ifndef _WIN32
+    else if (shard_count > 1) {
+        ws_debug("tshark: perform sharded analysis in %u workers, do_dissection=%s",
+                shard_count, do_dissection ? "TRUE" : "FALSE");
+
+        first_pass_status = PASS_SUCCEEDED; /* There is no first pass */
+
+        elapsed_start = g_get_monotonic_time();
+        second_pass_status = process_cap_file_sharded(cf, pdh,
+                max_packet_count,
+                max_byte_count,
+                max_write_packet_count,
+                &err, &err_info,
+                &err_framenum);
+        tshark_elapsed.elapsed_first_pass = g_get_monotonic_time() - elapsed_start;
+
+        ws_debug("tshark: done with sharded analysis");
+    }
+#endif
     else {
         /* !perform_two_pass_analysis */
         ws_debug("tshark: perform one pass analysis, do_dissection=%s", do_dissection ? "TRUE" : "FALSE");
@@ -4318,7 +5256,7 @@ out:
 
 static bool
 process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, int64_t offset,
-        wtap_rec *rec, Buffer *buf, unsigned tap_flags _U_)
+        wtap_rec *rec, const uint8_t *pd, unsigned tap_flags _U_)
 {
     frame_data      fdata;
     column_info    *cinfo;
@@ -4329,6 +5267,34 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, int64_t offset
     /* Count this packet. */
     cf->count++;
 
+#ifndef _WIN32
+    if (shard_out != NULL) {
+        if (shard_of_record(rec, pd) != shard_index) {
+            /* Another worker dissects this one; just keep the frame
+               numbers, byte counts and time references in step with it,
+               as if it had been displayed.  With a display filter, we
+               refuse to print anything that depends on whether it was. */
+            frame_data_init(&fdata, cf->count, rec, offset, cum_bytes);
+            frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
+                    &cf->provider.ref, cf->provider.prev_dis);
+            if (cf->provider.ref == &fdata) {
+                ref_frame = fdata;
+                cf->provider.ref = &ref_frame;
+            }
+            frame_data_set_after_dissect(&fdata, &cum_bytes);
+            prev_dis_frame = fdata;
+            cf->provider.prev_dis = &prev_dis_frame;
+            prev_cap_frame = fdata;
+            cf->provider.prev_cap = &prev_cap_frame;
+            frame_data_destroy(&fdata);
+            shard_frame_skipped(cf->count);
+            return false;
+        }
+        /* The parent puts the separators between JSON packets. */
+        jdumper = shard_jdumper;
+    }
+#endif
+
     /* If we're not running a display filter and we're not printing any
        packet information, we don't need to do a dissection. This means
        that all packets can be marked as 'passed'. */
@@ -4391,7 +5357,7 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, int64_t offset
         block = wtap_block_ref(rec->block);
         elapsed_start = g_get_monotonic_time();
         epan_dissect_run_with_taps(edt, cf->cd_t, rec,
-                frame_tvbuff_new_buffer(&cf->provider, &fdata, buf),
+                frame_tvbuff_new(&cf->provider, &fdata, pd),
                 &fdata, cinfo);
         tshark_elapsed.first_pass.dissect += g_get_monotonic_time() - elapsed_start;
 
@@ -4438,6 +5404,11 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, int64_t offset
         frame_data_destroy(&fdata);
         rec->block = block;
     }
+
+#ifndef _WIN32
+    if (shard_out != NULL)
+        shard_frame_done(cf->count, passed);
+#endif
     return passed;
 }
 
@@ -4766,12 +5737,28 @@ print_columns(capture_file *cf, const epan_dissect_t *edt)
         return print_line(print_stream, 0, line_bufp);
 }
 
+/* The columns that print_columns() prints, so that only they get formatted. */
+static const bool *
+print_columns_needed(capture_file *cf)
+{
+    static bool *needed;
+    int i;
+
+    if (needed == NULL && cf->cinfo.num_cols > 0) {
+        needed = g_new(bool, cf->cinfo.num_cols);
+        for (i = 0; i < cf->cinfo.num_cols; i++)
+            needed[i] = get_column_visible(i);
+    }
+    return needed;
+}
+
 static bool
 print_packet(capture_file *cf, epan_dissect_t *edt)
 {
     if (print_summary || output_fields_has_cols(output_fields))
-        /* Just fill in the columns. */
-        epan_dissect_fill_in_columns(edt, false, true);
+        /* Just fill in the columns; each is formatted when it's printed. */
+        epan_dissect_fill_in_columns_lazy(edt, false, true,
+            output_action == WRITE_TEXT ? print_columns_needed(cf) : NULL);
 
     /* Print summary columns and/or protocol tree */
     switch (output_action) {
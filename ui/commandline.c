@@ -94,6 +94,10 @@ commandline_print_usage(bool for_help_option) {
     fprintf(output, "  -y <link type>, --linktype <link type>\n");
     fprintf(output, "                           link layer type (def: first appropriate)\n");
     fprintf(output, "  --time-stamp-type <type> timestamp method for interface\n");
+#ifdef CAN_USE_TPACKET_V3
+    fprintf(output, "  --tpacket-v3 <threads>   capture from a TPACKET_V3 ring read by <threads>\n");
+    fprintf(output, "                           fanout threads instead of libpcap (def: 0, off)\n");
+#endif
     fprintf(output, "  -D, --list-interfaces    print list of interfaces and exit\n");
     fprintf(output, "  -L, --list-data-link-types\n");
     fprintf(output, "                           print list of link-layer types of iface and exit\n");
@@ -547,6 +551,9 @@ void commandline_other_options(int argc, char *argv[], bool opt_reset)
             case LONGOPT_SET_TSTAMP_TYPE: /* Set capture timestamp type */
             case LONGOPT_CAPTURE_TMPDIR: /* capture temp directory */
             case LONGOPT_UPDATE_INTERVAL: /* sync pipe update interval */
+#ifdef CAN_USE_TPACKET_V3
+            case LONGOPT_TPACKET_V3:           /* capture with a TPACKET_V3 ring */
+#endif
 #ifdef HAVE_PCAP_CREATE
             case 'I':        /* Capture in monitor mode, if available */
 #endif
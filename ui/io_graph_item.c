@@ -12,6 +12,7 @@
 
 #include "config.h"
 
+#include <limits.h>
 
 #include <epan/epan_dissect.h>
 
@@ -22,6 +23,36 @@
 // XXX - constant defined elsewhere, any benefit to store it in a global .h ?
 #define MICROSECS_PER_SEC 1000000
 
+// Each level of a bucket pyramid has intervals this many times as long
+// as the level below it.
+#define PYRAMID_FACTOR 10
+#define PYRAMID_MAX_LEVELS 10
+
+// Don't choose a base interval finer than the requested one unless the
+// capture fits in this many items, and never finer than 1 ms. Items are
+// about 88 bytes each.
+#define PYRAMID_BASE_MAX_ITEMS (1 << 16)
+#define PYRAMID_MIN_BASE_INTERVAL 1000
+
+typedef struct {
+    io_graph_item_t *items;
+    int num_items;
+    int space_items;
+    int64_t interval;   /* in μs */
+    int stale_from;     /* first base interval item changed since this level was built, or -1 */
+} io_graph_level_t;
+
+struct _io_graph_pyramid_t {
+    int max_items;
+    int hf_index;
+    unsigned num_levels;
+    io_graph_level_t levels[PYRAMID_MAX_LEVELS];
+    /* Items at an interval between levels, see io_graph_pyramid_items */
+    io_graph_level_t view;
+    uint64_t generation;
+    uint64_t view_generation;
+};
+
 int64_t get_io_graph_index(packet_info *pinfo, int interval) {
     nstime_t time_delta;
 
@@ -310,3 +341,306 @@ double get_io_graph_item(const io_graph_item_t *items_, io_graph_item_unit_t val
     }
     return value;
 }
+
+/* Should the min or max of src replace that of dst? cmp is > 0 if the
+ * value of src is more extreme. On ties the earlier frame is kept, as
+ * update_io_graph_item does.
+ */
+static inline bool
+replace_extreme(const io_graph_item_t *dst, int cmp, uint32_t src_frame, uint32_t dst_frame)
+{
+    return dst->fields == 0 || cmp > 0 || (cmp == 0 && src_frame < dst_frame);
+}
+
+#define CMP_VALUES(a, b) (((a) > (b)) - ((a) < (b)))
+
+void merge_io_graph_item(io_graph_item_t *dst, const io_graph_item_t *src, int hf_index)
+{
+    if (src->frames == 0 && src->fields == 0) {
+        return;
+    }
+
+    /* Frames are tapped in order, so the first frame is the lowest. */
+    if (src->first_frame_in_invl != 0 &&
+        (dst->first_frame_in_invl == 0 || src->first_frame_in_invl < dst->first_frame_in_invl)) {
+        dst->first_frame_in_invl = src->first_frame_in_invl;
+    }
+    if (src->last_frame_in_invl > dst->last_frame_in_invl) {
+        dst->last_frame_in_invl = src->last_frame_in_invl;
+    }
+    dst->frames += src->frames;
+    dst->bytes += src->bytes;
+
+    if (src->fields == 0 || hf_index < 0) {
+        dst->fields += src->fields;
+        return;
+    }
+
+    switch (proto_registrar_get_ftype(hf_index)) {
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+        if (replace_extreme(dst, CMP_VALUES(src->uint_max, dst->uint_max), src->max_frame_in_invl, dst->max_frame_in_invl)) {
+            dst->uint_max = src->uint_max;
+            dst->max_frame_in_invl = src->max_frame_in_invl;
+        }
+        if (replace_extreme(dst, CMP_VALUES(dst->uint_min, src->uint_min), src->min_frame_in_invl, dst->min_frame_in_invl)) {
+            dst->uint_min = src->uint_min;
+            dst->min_frame_in_invl = src->min_frame_in_invl;
+        }
+        dst->double_tot += src->double_tot;
+        break;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        if (replace_extreme(dst, CMP_VALUES(src->int_max, dst->int_max), src->max_frame_in_invl, dst->max_frame_in_invl)) {
+            dst->int_max = src->int_max;
+            dst->max_frame_in_invl = src->max_frame_in_invl;
+        }
+        if (replace_extreme(dst, CMP_VALUES(dst->int_min, src->int_min), src->min_frame_in_invl, dst->min_frame_in_invl)) {
+            dst->int_min = src->int_min;
+            dst->min_frame_in_invl = src->min_frame_in_invl;
+        }
+        dst->double_tot += src->double_tot;
+        break;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        if (replace_extreme(dst, CMP_VALUES(src->double_max, dst->double_max), src->max_frame_in_invl, dst->max_frame_in_invl)) {
+            dst->double_max = src->double_max;
+            dst->max_frame_in_invl = src->max_frame_in_invl;
+        }
+        if (replace_extreme(dst, CMP_VALUES(dst->double_min, src->double_min), src->min_frame_in_invl, dst->min_frame_in_invl)) {
+            dst->double_min = src->double_min;
+            dst->min_frame_in_invl = src->min_frame_in_invl;
+        }
+        dst->double_tot += src->double_tot;
+        break;
+    case FT_RELATIVE_TIME:
+        if (replace_extreme(dst, nstime_cmp(&src->time_max, &dst->time_max), src->max_frame_in_invl, dst->max_frame_in_invl)) {
+            dst->time_max = src->time_max;
+            dst->max_frame_in_invl = src->max_frame_in_invl;
+        }
+        if (replace_extreme(dst, nstime_cmp(&dst->time_min, &src->time_min), src->min_frame_in_invl, dst->min_frame_in_invl)) {
+            dst->time_min = src->time_min;
+            dst->min_frame_in_invl = src->min_frame_in_invl;
+        }
+        nstime_add(&dst->time_tot, &src->time_tot);
+        break;
+    default:
+        /* Only counted. */
+        break;
+    }
+    dst->fields += src->fields;
+}
+
+/* Make room for num_items items in a level, zeroing any new ones. */
+static bool
+io_graph_level_grow(io_graph_level_t *level, int num_items, int max_items)
+{
+    if (num_items > level->space_items) {
+        int new_size = MAX(num_items, MAX(level->space_items / 2 * 3, 1024));
+        io_graph_item_t *items;
+
+        new_size = MIN(new_size, max_items);
+        items = g_try_renew(io_graph_item_t, level->items, new_size);
+        if (items == NULL) {
+            return false;
+        }
+        level->items = items;
+        level->space_items = new_size;
+    }
+    if (num_items > level->num_items) {
+        reset_io_graph_items(&level->items[level->num_items], num_items - level->num_items, -1);
+        level->num_items = num_items;
+    }
+    return true;
+}
+
+/* Aggregate a level from the items of the level below it. */
+static bool
+io_graph_level_build(io_graph_level_t *level, const io_graph_level_t *below, int factor, int from, int hf_index, int max_items)
+{
+    int num_items = (below->num_items + factor - 1) / factor;
+    int idx;
+
+    if (num_items < level->num_items) {
+        /* The pyramid was reset. */
+        level->num_items = 0;
+        from = 0;
+    }
+    if (!io_graph_level_grow(level, num_items, max_items)) {
+        return false;
+    }
+    for (idx = from; idx < num_items; idx++) {
+        int below_idx = idx * factor;
+        int below_end = MIN(below_idx + factor, below->num_items);
+
+        reset_io_graph_items(&level->items[idx], 1, hf_index);
+        for (; below_idx < below_end; below_idx++) {
+            merge_io_graph_item(&level->items[idx], &below->items[below_idx], hf_index);
+        }
+    }
+    return true;
+}
+
+io_graph_pyramid_t *io_graph_pyramid_new(int max_items)
+{
+    io_graph_pyramid_t *pyramid = g_new0(io_graph_pyramid_t, 1);
+
+    pyramid->max_items = max_items;
+    pyramid->hf_index = -1;
+    io_graph_pyramid_reset(pyramid, MICROSECS_PER_SEC, -1);
+    return pyramid;
+}
+
+void io_graph_pyramid_free(io_graph_pyramid_t *pyramid)
+{
+    if (!pyramid) {
+        return;
+    }
+    for (unsigned i = 0; i < PYRAMID_MAX_LEVELS; i++) {
+        g_free(pyramid->levels[i].items);
+    }
+    g_free(pyramid->view.items);
+    g_free(pyramid);
+}
+
+int io_graph_pyramid_base_interval(int interval, const nstime_t *duration)
+{
+    int base = 1;
+
+    ws_return_val_if(interval <= 0, interval);
+
+    while (base <= interval / PYRAMID_FACTOR && interval % (base * PYRAMID_FACTOR) == 0) {
+        base *= PYRAMID_FACTOR;
+    }
+
+    if (duration && duration->secs >= 0) {
+        int64_t duration_us = duration->secs * INT64_C(1000000) + duration->nsecs / 1000;
+
+        while (base / PYRAMID_FACTOR >= PYRAMID_MIN_BASE_INTERVAL &&
+               duration_us / (base / PYRAMID_FACTOR) < PYRAMID_BASE_MAX_ITEMS) {
+            base /= PYRAMID_FACTOR;
+        }
+    }
+    return base;
+}
+
+void io_graph_pyramid_reset(io_graph_pyramid_t *pyramid, int base_interval, int hf_index)
+{
+    int64_t interval = base_interval;
+
+    pyramid->hf_index = hf_index;
+    pyramid->num_levels = 0;
+    for (unsigned i = 0; i < PYRAMID_MAX_LEVELS; i++) {
+        io_graph_level_t *level = &pyramid->levels[i];
+
+        level->num_items = 0;
+        level->stale_from = -1;
+        level->interval = interval;
+        if (interval <= INT_MAX) {
+            pyramid->num_levels++;
+        }
+        interval *= PYRAMID_FACTOR;
+    }
+    pyramid->view.num_items = 0;
+    pyramid->view.interval = 0;
+    pyramid->generation++;
+}
+
+bool io_graph_pyramid_update(io_graph_pyramid_t *pyramid, packet_info *pinfo, epan_dissect_t *edt, int item_unit)
+{
+    io_graph_level_t *base = &pyramid->levels[0];
+    int64_t tmp_idx = get_io_graph_index(pinfo, (int)base->interval);
+    int idx, stale_from;
+
+    if (tmp_idx < 0 || tmp_idx >= pyramid->max_items) {
+        return false;
+    }
+    idx = (int)tmp_idx;
+
+    if (!io_graph_level_grow(base, idx + 1, pyramid->max_items)) {
+        return false;
+    }
+    if (!update_io_graph_item(base->items, idx, pinfo, edt, pyramid->hf_index, item_unit, (uint32_t)base->interval)) {
+        return false;
+    }
+
+    /* LOAD spreads the time of a call over earlier intervals too. */
+    stale_from = item_unit == IOG_ITEM_UNIT_CALC_LOAD ? 0 : idx;
+    for (unsigned i = 1; i < pyramid->num_levels; i++) {
+        io_graph_level_t *level = &pyramid->levels[i];
+
+        if (level->stale_from < 0 || stale_from < level->stale_from) {
+            level->stale_from = stale_from;
+        }
+    }
+    pyramid->generation++;
+
+    return true;
+}
+
+bool io_graph_pyramid_has_interval(const io_graph_pyramid_t *pyramid, int interval)
+{
+    return interval > 0 && interval % pyramid->levels[0].interval == 0;
+}
+
+int io_graph_pyramid_base_items(const io_graph_pyramid_t *pyramid)
+{
+    return pyramid->levels[0].num_items;
+}
+
+const io_graph_item_t *io_graph_pyramid_items(io_graph_pyramid_t *pyramid, int interval, int *num_items)
+{
+    io_graph_level_t *level;
+    unsigned l = 0;
+
+    *num_items = 0;
+    if (!io_graph_pyramid_has_interval(pyramid, interval)) {
+        return NULL;
+    }
+
+    /* Find the coarsest level that divides the interval, bringing the
+     * levels up to it up to date.
+     */
+    while (l + 1 < pyramid->num_levels && interval % pyramid->levels[l + 1].interval == 0) {
+        io_graph_level_t *above = &pyramid->levels[l + 1];
+
+        if (above->stale_from >= 0) {
+            int from = (int)(above->stale_from / (above->interval / pyramid->levels[0].interval));
+
+            if (!io_graph_level_build(above, &pyramid->levels[l], PYRAMID_FACTOR, from, pyramid->hf_index, pyramid->max_items)) {
+                return NULL;
+            }
+            above->stale_from = -1;
+        }
+        l++;
+    }
+    level = &pyramid->levels[l];
+
+    if (interval != level->interval) {
+        if (pyramid->view.interval != interval || pyramid->view_generation != pyramid->generation) {
+            pyramid->view.interval = interval;
+            pyramid->view.num_items = 0;
+            if (!io_graph_level_build(&pyramid->view, level, (int)(interval / level->interval), 0, pyramid->hf_index, pyramid->max_items)) {
+                pyramid->view.interval = 0;
+                return NULL;
+            }
+            pyramid->view_generation = pyramid->generation;
+        }
+        level = &pyramid->view;
+    }
+
+    *num_items = level->num_items;
+    return level->num_items ? level->items : NULL;
+}
@@ -426,6 +426,99 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
     return true;
 }
 
+/** Add the values of one io_graph_item_t to another, so that dst covers
+ * the packets of both intervals.
+ *
+ * @param dst [in,out] Item to update.
+ * @param src [in] Item to add.
+ * @param hf_index [in] Header field index for advanced statistics.
+ */
+void merge_io_graph_item(io_graph_item_t *dst, const io_graph_item_t *src, int hf_index);
+
+/*
+ * A bucket pyramid holds a graph's items at a base interval plus
+ * aggregates of them at 10, 100, 1000... times that interval. Any
+ * interval that's a multiple of the base interval can be made from
+ * those without tapping the packets again, so changing the interval
+ * only requires tapping again if the new interval is finer than the
+ * base interval.
+ */
+typedef struct _io_graph_pyramid_t io_graph_pyramid_t;
+
+/** Create an empty bucket pyramid.
+ *
+ * @param max_items [in] Maximum number of items at the base interval.
+ * @return A new pyramid, to be freed with io_graph_pyramid_free.
+ */
+io_graph_pyramid_t *io_graph_pyramid_new(int max_items);
+
+/** Free a bucket pyramid.
+ *
+ * @param pyramid [in] The pyramid to free. May be NULL.
+ */
+void io_graph_pyramid_free(io_graph_pyramid_t *pyramid);
+
+/** Choose the base interval to tap at.
+ *
+ * The base interval is a power of ten that divides interval. If the
+ * duration of the capture is known it's made finer, down to 1 ms, as
+ * long as the capture fits in a modest number of items, so that the
+ * interval can later be made smaller without tapping again.
+ *
+ * @param interval [in] Interval to be shown, in μs.
+ * @param duration [in] Duration of the capture, or NULL if unknown (e.g.,
+ *                      a live capture.)
+ * @return The base interval in μs.
+ */
+int io_graph_pyramid_base_interval(int interval, const nstime_t *duration);
+
+/** Empty a bucket pyramid before tapping.
+ *
+ * @param pyramid [in,out] The pyramid to reset.
+ * @param base_interval [in] Interval of the items to tap, in μs.
+ * @param hf_index [in] Header field index for advanced statistics.
+ */
+void io_graph_pyramid_reset(io_graph_pyramid_t *pyramid, int base_interval, int hf_index);
+
+/** Add a packet to a bucket pyramid. See update_io_graph_item.
+ *
+ * @param pyramid [in,out] The pyramid to update.
+ * @param pinfo [in] Packet containing update information.
+ * @param edt [in] Dissection information for advanced statistics. May be NULL.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @return true if the update was successful, otherwise false.
+ */
+bool io_graph_pyramid_update(io_graph_pyramid_t *pyramid, packet_info *pinfo, epan_dissect_t *edt, int item_unit);
+
+/** Check if a bucket pyramid can provide items at an interval.
+ *
+ * @param pyramid [in] The pyramid.
+ * @param interval [in] Interval in μs.
+ * @return true if interval is a multiple of the base interval.
+ */
+bool io_graph_pyramid_has_interval(const io_graph_pyramid_t *pyramid, int interval);
+
+/** Get the number of items at the base interval.
+ *
+ * @param pyramid [in] The pyramid.
+ * @return The number of items.
+ */
+int io_graph_pyramid_base_items(const io_graph_pyramid_t *pyramid);
+
+/** Get the items of a bucket pyramid at an interval.
+ *
+ * The items are aggregated from the coarsest level of the pyramid whose
+ * interval divides the requested one. They're kept until the pyramid is
+ * updated or items at another interval are requested.
+ *
+ * @param pyramid [in,out] The pyramid.
+ * @param interval [in] Interval in μs. Must be a multiple of the base interval.
+ * @param num_items [out] Set to the number of items returned.
+ * @return The items, or NULL if there are none or the interval can't be
+ *         provided.
+ */
+const io_graph_item_t *io_graph_pyramid_items(io_graph_pyramid_t *pyramid, int interval, int *num_items);
+
 
 #ifdef __cplusplus
 }
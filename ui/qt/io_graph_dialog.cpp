@@ -53,13 +53,12 @@
 #include <QTimer>
 #include <QVariant>
 
-#include <new> // std::bad_alloc
-
 // Bugs and uncertainties:
 // - Regular (non-stacked) bar graphs are drawn on top of each other on the Z axis.
 //   The QCP forum suggests drawing them side by side:
 //   https://www.qcustomplot.com/index.php/support/forum/62
-// - We retap and redraw more than we should.
+// - We retap and redraw more than we should. (Changing the interval to a
+//   multiple of the one the graphs were tapped at doesn't retap, though.)
 // - Smoothing doesn't seem to match GTK+
 // - Closing the color picker on macOS sends the dialog to the background.
 // - X-axis time buckets are based on the file relative time, even in
@@ -1497,6 +1496,14 @@ void IOGraphDialog::updateStatistics()
      */
     if (need_retap_ && !file_closed_ && !retapDepth() && prefs.gui_io_graph_automatic_update) {
         need_retap_ = false;
+        // If the whole file has been read, the graphs can be tapped at a
+        // finer interval than shown, so that it can be reduced later on
+        // without retapping.
+        capture_file *cf = cap_file_.capFile();
+        bool read_done = cf && cf->state == FILE_READ_DONE;
+        foreach(IOGraph* iog, ioGraphs_) {
+            iog->setCaptureDuration(read_done ? &cf->elapsed_time : NULL);
+        }
         QTimer::singleShot(0, &cap_file_, &CaptureFile::retapPackets);
         // The user might have closed the window while tapping, which means
         // we might no longer exist.
@@ -1584,6 +1591,7 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 {
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
     bool need_retap = false;
+    bool need_recalc = false;
 
     precision_ = ceil(log10(SCALE_F / interval));
     if (precision_ < 0) {
@@ -1606,7 +1614,10 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
                 iog->setInterval(interval);
-                if (iog->visible()) {
+                if (iog->hasInterval(interval)) {
+                    // Made from the items already tapped at a finer interval
+                    need_recalc = need_recalc || iog->visible();
+                } else if (iog->visible()) {
                     need_retap = true;
                 } else {
                     iog->setNeedRetap(true);
@@ -1617,6 +1628,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else if (need_recalc) {
+        scheduleRecalc(true);
     }
 }
 
@@ -2183,7 +2196,9 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     interval_(0),
     start_time_(NSTIME_INIT_ZERO),
     asAOT_(false),
-    cur_idx_(-1)
+    pyramid_(io_graph_pyramid_new(max_io_items_)),
+    has_duration_(false),
+    duration_(NSTIME_INIT_ZERO)
 {
     Q_ASSERT(parent_ != NULL);
     graph_ = parent_->addGraph(parent_->xAxis, parent_->yAxis);
@@ -2215,6 +2230,7 @@ IOGraph::~IOGraph() {
     if (bars_) {
         parent_->removePlottable(bars_);
     }
+    io_graph_pyramid_free(pyramid_);
 }
 
 void IOGraph::removeTapListener()
@@ -2615,15 +2631,17 @@ nstime_t IOGraph::startTime() const
 
 int IOGraph::packetFromTime(double ts) const
 {
+    int num_items;
+    const io_graph_item_t *items = this->items(&num_items);
     int idx = ts * SCALE_F / interval_;
-    if (idx >= 0 && idx <= cur_idx_) {
+    if (idx >= 0 && idx < num_items) {
         switch (val_units_) {
         case IOG_ITEM_UNIT_CALC_MAX:
-            return items_[idx].max_frame_in_invl;
+            return items[idx].max_frame_in_invl;
         case IOG_ITEM_UNIT_CALC_MIN:
-            return items_[idx].min_frame_in_invl;
+            return items[idx].min_frame_in_invl;
         default:
-            return items_[idx].last_frame_in_invl;
+            return items[idx].last_frame_in_invl;
         }
     }
     return -1;
@@ -2631,10 +2649,7 @@ int IOGraph::packetFromTime(double ts) const
 
 void IOGraph::clearAllData()
 {
-    cur_idx_ = -1;
-    if (items_.size()) {
-        reset_io_graph_items(&items_[0], items_.size(), hf_index_);
-    }
+    io_graph_pyramid_reset(pyramid_, io_graph_pyramid_base_interval(interval_, has_duration_ ? &duration_ : NULL), hf_index_);
     if (graph_) {
         graph_->data()->clear();
     }
@@ -2650,6 +2665,7 @@ void IOGraph::recalcGraphData(capture_file *cap_file)
     unsigned int mavg_in_average_count = 0, mavg_left = 0;
     unsigned int mavg_to_remove = 0, mavg_to_add = 0;
     double mavg_cumulated = 0;
+    int cur_idx = maxInterval();
 
     if (graph_) {
         graph_->data()->clear();
@@ -2658,7 +2674,7 @@ void IOGraph::recalcGraphData(capture_file *cap_file)
         bars_->data()->clear();
     }
 
-    if (moving_avg_period_ > 0 && cur_idx_ >= 0) {
+    if (moving_avg_period_ > 0 && cur_idx >= 0) {
         /* "Warm-up phase" - calculate average on some data not displayed;
          * just to make sure average on leftmost and rightmost displayed
          * values is as reliable as possible
@@ -2674,7 +2690,7 @@ void IOGraph::recalcGraphData(capture_file *cap_file)
         mavg_in_average_count++;
         for (warmup_interval = interval_;
             ((warmup_interval < (0 + (moving_avg_period_ / 2) * (uint64_t)interval_)) &&
-             (warmup_interval <= (cur_idx_ * (uint64_t)interval_)));
+             (warmup_interval <= (cur_idx * (uint64_t)interval_)));
              warmup_interval += interval_) {
 
             mavg_cumulated += getItemValue((int)warmup_interval / interval_, cap_file);
@@ -2684,7 +2700,7 @@ void IOGraph::recalcGraphData(capture_file *cap_file)
     }
 
     double ts_offset = startOffset();
-    for (int i = 0; i <= cur_idx_; i++) {
+    for (int i = 0; i <= cur_idx; i++) {
         double ts = (double) i * interval_ / SCALE_F + ts_offset;
         double val = getItemValue(i, cap_file);
 
@@ -2697,7 +2713,7 @@ void IOGraph::recalcGraphData(capture_file *cap_file)
                     mavg_cumulated -= getItemValue((int)mavg_to_remove / interval_, cap_file);
                     mavg_to_remove += interval_;
                 }
-                if (mavg_to_add <= (unsigned int) cur_idx_ * interval_) {
+                if (mavg_to_add <= (unsigned int) cur_idx * interval_) {
                     mavg_in_average_count++;
                     mavg_cumulated += getItemValue((int)mavg_to_add / interval_, cap_file);
                     mavg_to_add += interval_;
@@ -2837,11 +2853,14 @@ bool IOGraph::showsZero() const
 // Check if a packet is available at the given interval (idx).
 bool IOGraph::hasItemToShow(int idx, double value) const
 {
-    ws_assert(idx < max_io_items_);
+    int num_items;
+    const io_graph_item_t *items = this->items(&num_items);
+
+    ws_assert(idx < num_items);
 
     bool result = false;
 
-    const io_graph_item_t *item = &items_[idx];
+    const io_graph_item_t *item = &items[idx];
 
     switch (val_units_) {
     case IOG_ITEM_UNIT_PACKETS:
@@ -2884,12 +2903,44 @@ void IOGraph::setInterval(int interval)
     }
 }
 
+// Can the items at the given interval be made from those already tapped?
+bool IOGraph::hasInterval(int interval) const
+{
+    return io_graph_pyramid_has_interval(pyramid_, interval);
+}
+
+// The duration of the capture, if known, lets the next tap be done at an
+// interval finer than the current one.
+void IOGraph::setCaptureDuration(const nstime_t *duration)
+{
+    has_duration_ = duration != NULL;
+    if (duration) {
+        duration_ = *duration;
+    }
+}
+
+int IOGraph::maxInterval() const
+{
+    int num_items;
+    items(&num_items);
+    return num_items - 1;
+}
+
+// The items at the current interval.
+const io_graph_item_t *IOGraph::items(int *num_items) const
+{
+    return io_graph_pyramid_items(pyramid_, interval_, num_items);
+}
+
 // Get the value at the given interval (idx) for the current value unit.
 double IOGraph::getItemValue(int idx, const capture_file *cap_file) const
 {
-    ws_assert(idx < max_io_items_);
+    int num_items;
+    const io_graph_item_t *items = this->items(&num_items);
 
-    return get_io_graph_item(&items_[0], val_units_, idx, hf_index_, cap_file, interval_, cur_idx_, asAOT_);
+    ws_assert(idx < num_items);
+
+    return get_io_graph_item(items, val_units_, idx, hf_index_, cap_file, interval_, num_items - 1, asAOT_);
 }
 
 // "tap_reset" callback for register_tap_listener
@@ -2910,16 +2961,6 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         return TAP_PACKET_DONT_REDRAW;
     }
 
-    int64_t tmp_idx = get_io_graph_index(pinfo, iog->interval_);
-    bool recalc = false;
-
-    /* some sanity checks */
-    if ((tmp_idx < 0) || (tmp_idx >= max_io_items_)) {
-        iog->cur_idx_ = (int)iog->items_.size() - 1;
-        return TAP_PACKET_DONT_REDRAW;
-    }
-
-    int idx = (int)tmp_idx;
     /* If the graph isn't visible, don't do the work or redraw, but mark
      * the graph in need of a retap if it is ever enabled. The alternative
      * is to do the work, but clear pending retaps when the taps are reset
@@ -2929,37 +2970,13 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
      * enabled/disabled taps.
      */
     if (!iog->visible()) {
-        if (idx > iog->cur_idx_) {
+        if (get_io_graph_index(pinfo, iog->interval_) >= 0) {
             iog->need_retap_ = true;
         }
         return TAP_PACKET_DONT_REDRAW;
     }
 
-    if ((size_t)idx >= iog->items_.size()) {
-        const size_t old_size = iog->items_.size();
-        size_t new_size;
-        if (old_size == 0) {
-            new_size = 1024;
-        } else {
-            new_size = MIN((old_size * 3) / 2, max_io_items_);
-        }
-        new_size = MAX(new_size, (size_t)idx + 1);
-        try {
-            iog->items_.resize(new_size);
-        } catch (std::bad_alloc&) {
-            // std::vector.resize() has strong exception safety
-            ws_warning("Failed memory allocation!");
-            return TAP_PACKET_DONT_REDRAW;
-        }
-        // resize zero-initializes new items, which is what we want
-        //reset_io_graph_items(&iog->items_[old_size], new_size - old_size);
-    }
-
-    /* update num_items */
-    if (idx > iog->cur_idx_) {
-        iog->cur_idx_ = idx;
-        recalc = true;
-    }
+    int num_items = io_graph_pyramid_base_items(iog->pyramid_);
 
     /* set start time */
     if (nstime_is_zero(&iog->start_time_)) {
@@ -2972,13 +2989,14 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         adv_edt = edt;
     }
 
-    if (!update_io_graph_item(&iog->items_[0], idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
+    /* This also does the sanity checks on the interval index */
+    if (!io_graph_pyramid_update(iog->pyramid_, pinfo, adv_edt, iog->val_units_)) {
         return TAP_PACKET_DONT_REDRAW;
     }
 
-//    qDebug() << "=tapPacket" << iog->name_ << idx << iog->hf_index_ << iog->val_units_ << iog->num_items_;
+//    qDebug() << "=tapPacket" << iog->name_ << iog->hf_index_ << iog->val_units_ << num_items;
 
-    if (recalc) {
+    if (io_graph_pyramid_base_items(iog->pyramid_) > num_items) {
         emit iog->requestRecalc();
     }
     return TAP_PACKET_REDRAW;
@@ -91,6 +91,8 @@ public:
     void setValueUnitField(const QString &vu_field);
     unsigned int movingAveragePeriod() const { return moving_avg_period_; }
     void setInterval(int interval);
+    bool hasInterval(int interval) const;
+    void setCaptureDuration(const nstime_t *duration);
     bool addToLegend();
     bool removeFromLegend();
     QCPGraph *graph() const { return graph_; }
@@ -100,7 +102,7 @@ public:
     int packetFromTime(double ts) const;
     bool hasItemToShow(int idx, double value) const;
     double getItemValue(int idx, const capture_file *cap_file) const;
-    int maxInterval () const { return cur_idx_; }
+    int maxInterval () const;
 
     void clearAllData();
 
@@ -126,6 +128,7 @@ private:
     void removeTapListener();
 
     bool showsZero() const;
+    const io_graph_item_t *items(int *num_items) const;
 
     template<class DataMap> double maxValueFromGraphData(const DataMap &map);
     template<class DataMap> void scaleGraphData(DataMap &map, int scalar);
@@ -149,9 +152,12 @@ private:
     bool asAOT_; // Average Over Time interpretation
 
     // Cached data. We should be able to change the Y axis without retapping as
-    // much as is feasible.
-    std::vector<io_graph_item_t> items_;
-    int cur_idx_;
+    // much as is feasible. The items are tapped at a base interval that can
+    // be finer than interval_, so that the interval can be changed to any
+    // multiple of it without retapping.
+    io_graph_pyramid_t *pyramid_;
+    bool has_duration_;
+    nstime_t duration_; // Of the capture when last tapped, to choose the base interval
 };
 
 namespace Ui {
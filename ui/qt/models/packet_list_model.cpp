@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <numeric>
 #include <stdexcept>
 
 #include "packet_list_model.h"
@@ -78,6 +79,8 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     number_to_row_(QVector<int>()),
     max_row_height_(0),
     max_line_count_(1),
+    sort_keys_column_(-1),
+    sort_keys_ver_(0),
     idle_dissection_row_(0)
 {
     Q_ASSERT(glbl_plist_model == Q_NULLPTR);
@@ -179,6 +182,10 @@ void PacketListModel::clear() {
     endResetModel();
     max_row_height_ = 0;
     max_line_count_ = 1;
+    sort_keys_column_ = -1;
+    sort_key_ids_.clear();
+    sort_key_strings_.clear();
+    sort_key_string_ids_.clear();
     idle_dissection_timer_->invalidate();
     idle_dissection_row_ = 0;
 }
@@ -578,27 +585,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     QString col_title = get_column_title(column);
 
-    if (text_sort_column_ >= 0 && (unsigned)visible_rows_.count() > prefs.gui_packet_list_cached_rows_max) {
-        /* Column not based on frame data but by column text that requires
-         * dissection, so to sort in a reasonable amount of time the column
-         * text needs to be cached.
-         */
-        /* If the sort is being triggered because the columns were already
-         * sorted and the filter is being cleared (or changed to something
-         * else with more rows than fit in the cache), then the temporary
-         * message will be immediately overwritten with the standard capture
-         * statistics by the packets_bar_update() call after thawing the rows.
-         * It will still blink yellow, and the user will get the message if
-         * they then click on the header file (wondering why it didn't sort.)
-         */
-        if (col_title.isEmpty()) {
-            col_title = tr("Column");
-        }
-        QString temp_msg = tr("%1 can only be sorted with %2 or fewer visible rows; increase cache size in Layout preferences").arg(col_title).arg(prefs.gui_packet_list_cached_rows_max);
-        mainApp->pushStatus(MainApplication::TemporaryStatus, temp_msg);
-        return;
-    }
-
     /* If we are currently in the middle of reading the capture file, don't
      * sort. PacketList::captureFileReadFinished invalidates all the cached
      * column strings and then tries to sort again.
@@ -623,13 +609,17 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     }
     stop_flag_ = false;
     comps_ = 0;
-    /* XXX: The expected number of comparisons is O(N log N), but this could
-     * be a pretty significant overestimate of the amount of time it takes,
-     * if there are lots of identical entries. (Especially with string
-     * comparisons, some comparisons are faster than others.) Better to
-     * overestimate?
-     */
-    exp_comps_ = log2(visible_rows_.count()) * visible_rows_.count();
+    if (text_sort_column_ >= 0) {
+        /* Getting the column text of each row is what takes the time. */
+        exp_comps_ = visible_rows_.count();
+    } else {
+        /* XXX: The expected number of comparisons is O(N log N), but this
+         * could be a pretty significant overestimate of the amount of time
+         * it takes, if there are lots of identical entries. Better to
+         * overestimate?
+         */
+        exp_comps_ = log2(visible_rows_.count()) * visible_rows_.count();
+    }
     progress_frame_ = nullptr;
     if (qobject_cast<MainWindow *>(mainApp->mainWindow())) {
         MainWindow *mw = qobject_cast<MainWindow *>(mainApp->mainWindow());
@@ -645,7 +635,12 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
     QVector<PacketListRecord *> sorted_visible_rows_ = visible_rows_;
     try {
-        std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+        if (text_sort_column_ >= 0) {
+            fillSortKeys();
+            sortByKeys(sorted_visible_rows_);
+        } else {
+            std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+        }
 
         beginResetModel();
         visible_rows_.resize(0);
@@ -683,6 +678,118 @@ void PacketListModel::stopSorting()
     stop_flag_ = true;
 }
 
+// Get the text of the sort column for each visible row that doesn't
+// have it yet. Rows are dissected at most once here, rather than each
+// time they're compared, which with more rows than the column string
+// cache holds meant dissecting most of them O(log N) times.
+void PacketListModel::fillSortKeys()
+{
+    if (sort_keys_column_ != sort_column_ || sort_keys_ver_ != PacketListRecord::columnTextVersion()) {
+        sort_key_ids_.clear();
+        sort_key_strings_.clear();
+        sort_key_string_ids_.clear();
+        sort_keys_column_ = sort_column_;
+        sort_keys_ver_ = PacketListRecord::columnTextVersion();
+    }
+    if (sort_key_ids_.size() <= physical_rows_.count()) {
+        sort_key_ids_.resize(physical_rows_.count() + 1);
+    }
+
+    foreach (PacketListRecord *record, visible_rows_) {
+        comps_++;
+        if (busy_timer_.elapsed() > busy_timeout_) {
+            if (progress_frame_) {
+                progress_frame_->setValue(static_cast<int>(comps_/exp_comps_ * 100));
+            }
+            mainApp->processEvents(QEventLoop::ExcludeSocketNotifiers, 1);
+            if (stop_flag_) {
+                throw SortAbort("Sorting aborted");
+            }
+            busy_timer_.restart();
+        }
+
+        uint32_t num = record->frameData()->num;
+        if (sort_key_ids_.size() <= static_cast<qsizetype>(num)) {
+            sort_key_ids_.resize(num + 10000);
+        }
+        if (sort_key_ids_[num] != 0) {
+            continue;
+        }
+
+        QString text = record->columnString(sort_cap_file_, sort_column_);
+        uint32_t id = sort_key_string_ids_.value(text);
+        if (id == 0) {
+            sort_key_strings_ << text;
+            id = static_cast<uint32_t>(sort_key_strings_.count());
+            sort_key_string_ids_.insert(text, id);
+        }
+        sort_key_ids_[num] = id;
+    }
+}
+
+void PacketListModel::sortByKeys(QVector<PacketListRecord *> &rows)
+{
+    // Rank the distinct strings so that rows can be compared by number.
+    // XXX: The naive string comparison compares Unicode code points.
+    // Proper collation is more expensive
+    qsizetype count = sort_key_strings_.count();
+    QVector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return sort_key_strings_[a].compare(sort_key_strings_[b]) < 0;
+    });
+    QVector<uint32_t> ranks(count + 1);
+    for (qsizetype i = 0; i < count; i++) {
+        ranks[order[i] + 1] = static_cast<uint32_t>(i);
+    }
+
+    // Custom column with numeric data (or something like a port number).
+    // Convert each distinct string to a number once.
+    QVector<double> values;
+    QVector<bool> valid;
+    if (sort_column_is_numeric_) {
+        values.resize(count + 1);
+        valid.resize(count + 1);
+        for (qsizetype i = 0; i < count; i++) {
+            bool ok;
+            values[i + 1] = parseNumericColumn(sort_key_strings_[i], &ok);
+            valid[i + 1] = ok;
+        }
+    }
+
+    std::sort(rows.begin(), rows.end(), [&](PacketListRecord *r1, PacketListRecord *r2) {
+        uint32_t id1 = sort_key_ids_[r1->frameData()->num];
+        uint32_t id2 = sort_key_ids_[r2->frameData()->num];
+        int cmp_val = 0;
+
+        if (id1 != id2) {
+            cmp_val = ranks[id1] < ranks[id2] ? -1 : 1;
+            if (sort_column_is_numeric_) {
+                if (!valid[id1] && !valid[id2]) {
+                    cmp_val = 0;
+                } else if (!valid[id1] || (valid[id2] && values[id1] < values[id2])) {
+                    // either r1 is invalid (and sort it before others) or both
+                    // r1 and r2 are valid (sort normally)
+                    cmp_val = -1;
+                } else if (!valid[id2] || (values[id1] > values[id2])) {
+                    cmp_val = 1;
+                }
+            }
+        }
+
+        if (cmp_val == 0) {
+            // All else being equal, compare column numbers.
+            cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
+        }
+
+        if (sort_order_ == Qt::AscendingOrder) {
+            return cmp_val < 0;
+        } else {
+            return cmp_val > 0;
+        }
+    });
+}
+
 bool PacketListModel::isNumericColumn(int column)
 {
     /* XXX - Should this and ui/packet_list_utils.c right_justify_column()
@@ -784,41 +891,10 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
     if (sort_column_ < 0) {
         // No column.
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-    } else if (text_sort_column_ < 0) {
-        // Column comes directly from frame data
+    } else {
+        // Column comes directly from frame data; those that don't are
+        // sorted by sortByKeys.
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
-    } else  {
-        QString r1String = r1->columnString(sort_cap_file_, sort_column_);
-        QString r2String = r2->columnString(sort_cap_file_, sort_column_);
-        // XXX: The naive string comparison compares Unicode code points.
-        // Proper collation is more expensive
-        cmp_val = r1String.compare(r2String);
-        if (cmp_val != 0 && sort_column_is_numeric_) {
-            // Custom column with numeric data (or something like a port number).
-            // Attempt to convert to numbers.
-            // XXX This is slow. Can we avoid doing this? Perhaps the actual
-            // values used for sorting should be cached too as QVariant[List].
-            // If so, we could consider using QCollatorSortKeys or similar
-            // for strings as well.
-            bool ok_r1, ok_r2;
-            double num_r1 = parseNumericColumn(r1String, &ok_r1);
-            double num_r2 = parseNumericColumn(r2String, &ok_r2);
-
-            if (!ok_r1 && !ok_r2) {
-                cmp_val = 0;
-            } else if (!ok_r1 || (ok_r2 && num_r1 < num_r2)) {
-                // either r1 is invalid (and sort it before others) or both
-                // r1 and r2 are valid (sort normally)
-                cmp_val = -1;
-            } else if (!ok_r2 || (num_r1 > num_r2)) {
-                cmp_val = 1;
-            }
-        }
-
-        if (cmp_val == 0) {
-            // All else being equal, compare column numbers.
-            cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-        }
     }
 
     if (sort_order_ == Qt::AscendingOrder) {
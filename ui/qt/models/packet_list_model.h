@@ -18,6 +18,7 @@
 
 #include <QAbstractItemModel>
 #include <QFont>
+#include <QHash>
 #include <QVector>
 
 #include <ui/qt/progress_frame.h>
@@ -117,6 +118,18 @@ private:
     static double exp_comps_;
     static double comps_;
 
+    // Text of the last sorted column that requires dissection, kept so
+    // that sorting by it again (in the other order, or after changing
+    // the filter) doesn't dissect every frame again. Each frame's text
+    // is stored as the number of a distinct string.
+    int sort_keys_column_;
+    unsigned sort_keys_ver_;
+    QVector<uint32_t> sort_key_ids_; // By frame number; 0 if not known yet
+    QVector<QString> sort_key_strings_; // By ID - 1
+    QHash<QString, uint32_t> sort_key_string_ids_;
+    void fillSortKeys();
+    void sortByKeys(QVector<PacketListRecord *> &rows);
+
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
 
@@ -25,6 +25,7 @@
 #include <QStringList>
 
 QCache<uint32_t, QStringList> PacketListRecord::col_text_cache_(500);
+unsigned PacketListRecord::col_text_ver_ = 1;
 QMap<int, int> PacketListRecord::cinfo_column_;
 unsigned PacketListRecord::rows_color_ver_ = 1;
 
@@ -44,8 +44,10 @@ public:
     int columnTextSize(const char *str);
 
     void invalidateColorized() { colorized_ = false; }
-    void invalidateRecord() { col_text_cache_.remove(fdata_->num); }
-    static void invalidateAllRecords() { col_text_cache_.clear(); }
+    void invalidateRecord() { col_text_cache_.remove(fdata_->num); col_text_ver_++; }
+    static void invalidateAllRecords() { col_text_cache_.clear(); col_text_ver_++; }
+    // Changes whenever column text might have changed.
+    static unsigned columnTextVersion() { return col_text_ver_; }
     /* In Qt 6, QCache maxCost is a qsizetype, but the QAbstractItemModel
      * number of rows is still an int, so we're limited to INT_MAX anyway.
      */
@@ -59,6 +61,7 @@ public:
 private:
     /** The column text for some columns */
     static QCache<uint32_t, QStringList> col_text_cache_;
+    static unsigned col_text_ver_;
 
     frame_data *fdata_;
     int lines_;
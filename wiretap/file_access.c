@@ -1041,6 +1041,20 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 
 		file_set_random_access(wth->fh, false, wth->fast_seek);
 		file_set_random_access(wth->random_fh, true, wth->fast_seek);
+
+		/*
+		 * If asked to, use an index of fast seek points saved by
+		 * an earlier read of this file, and save one when the file
+		 * has been read to the end; see wtap_sequential_close().
+		 */
+		if (g_getenv("WIRESHARK_FAST_SEEK_INDEX") != NULL) {
+			wth->fast_seek_index = ws_strdup_printf("%s.wsidx", filename);
+			wth->fast_seek_file_size = statb.st_size;
+			wth->fast_seek_file_mtime = statb.st_mtime;
+			if (file_fast_seek_index_load(wth->fast_seek, wth->fast_seek_index,
+			    wth->fast_seek_file_size, wth->fast_seek_file_mtime))
+				wth->fast_seek_index_count = wth->fast_seek->len;
+		}
 	}
 
 	/* Find a file format handler which can read the file. */
@@ -27,6 +27,13 @@
 
 #include <wsutil/file_util.h>
 
+#ifndef _WIN32
+#define USE_MMAP
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif /* _WIN32 */
+
 #if defined(HAVE_ZLIB) && !defined(HAVE_ZLIBNG)
 #define USE_ZLIB_OR_ZLIBNG
 #define ZLIB_CONST
@@ -224,6 +231,7 @@ struct wtap_reader {
     int64_t raw_pos;            /* current position in file (just to not call lseek()) */
     int64_t pos;                /* current position in uncompressed data */
     unsigned size;              /* buffer size */
+    unsigned out_size;          /* output buffer size, at least size * 2 */
 
     struct wtap_reader_buf in;  /* input buffer, containing compressed data */
     struct wtap_reader_buf out; /* output buffer, containing uncompressed data */
@@ -265,6 +273,19 @@ struct wtap_reader {
     /* fast seeking */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
+
+    /* decompression ahead of the reader */
+    bool read_ahead_ok;         /* true if decompressing ahead may be used */
+    struct read_ahead *read_ahead; /* read-ahead state, if running */
+
+    /* memory mapping of uncompressed input */
+    unsigned char *out_mem;     /* allocated output buffer; out.buf points into the mapping while there is one */
+    bool map_ok;                /* true if the file may be mapped */
+    unsigned char *map;         /* mapping of the whole file, or NULL */
+    int64_t map_size;           /* size of the mapping */
+    int map_guard;              /* SIGBUS guard slot for the mapping */
+    GSList *old_maps;           /* mappings given up on, still to be unmapped */
+    bool map_ptrs;              /* true if file_read_ptr() has returned pointers into the mapping since file_release_ptrs() */
 };
 
 /* Current read offset within a buffer. */
@@ -353,6 +374,269 @@ fill_in_buffer(FILE_T state)
     return 0;
 }
 
+#ifdef USE_MMAP
+/*
+ * Memory-mapped reading of uncompressed files.
+ *
+ * Once a regular file turns out not to be compressed, it's mapped into
+ * memory, and the output buffer is pointed at a window of the mapping
+ * instead of being filled with read(), so that getting at a record costs
+ * at most a page fault, and file_read_ptr() can return pointers into the
+ * file's data without copying it. raw_pos is where the window ends, as
+ * usual, but the file offset isn't kept at raw_pos while the file is
+ * mapped; map_stop() puts it back there.
+ *
+ * If the file grows past the end of the mapping, it's still being
+ * written, as a live capture's temporary file is, so it isn't mapped
+ * again; the rest of it is read with read(), as a file that couldn't be
+ * mapped is. A mapping that's given up on is unmapped straight away,
+ * unless file_read_ptr() has returned pointers into it that the caller
+ * might still be using; then it's kept until file_release_ptrs().
+ *
+ * If the file is truncated while it's mapped, touching a page past the
+ * new end of the file raises SIGBUS, where read() would return a short
+ * read, and the pages are touched by whoever has been handed pointers
+ * into them. So every mapping is registered with a SIGBUS handler, which
+ * puts zero-filled pages in place of the ones that are gone, so that the
+ * faulting access can carry on, and marks the mapping as tripped; the
+ * next refill of the buffer then stops mapping the file, and read()
+ * finds its real end.
+ */
+struct old_map {
+    unsigned char *map;
+    int64_t size;
+    int guard;
+};
+
+#define MAP_GUARD_SLOTS 64
+
+/*
+ * Mappings the SIGBUS handler may repair. A slot is claimed with
+ * in_use, and start is set last, so the handler never sees a slot
+ * that's only half filled in; start is cleared before the mapping
+ * is unmapped.
+ */
+static struct map_guard {
+    int in_use;
+    int tripped;
+    void *start;
+    void *end;
+} map_guards[MAP_GUARD_SLOTS];
+
+static struct sigaction map_guard_old_action;
+static uintptr_t map_guard_page_mask;
+
+static void
+map_guard_handler(int sig, siginfo_t *info, void *context)
+{
+    uintptr_t addr = (uintptr_t)info->si_addr;
+    uintptr_t start, end, page;
+    int i;
+
+    for (i = 0; i < MAP_GUARD_SLOTS; i++) {
+        start = (uintptr_t)g_atomic_pointer_get(&map_guards[i].start);
+        if (start == 0)
+            continue;
+        end = (uintptr_t)map_guards[i].end;
+        if (addr < start || addr >= end)
+            continue;
+        page = addr & map_guard_page_mask;
+        if (mmap((void *)page, end - page, PROT_READ,
+                 MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED, -1, 0) == MAP_FAILED)
+            break;
+        g_atomic_int_set(&map_guards[i].tripped, 1);
+        return;
+    }
+
+    /* Not one of ours; do whatever would have been done without us. */
+    if (map_guard_old_action.sa_flags & SA_SIGINFO) {
+        map_guard_old_action.sa_sigaction(sig, info, context);
+    } else if (map_guard_old_action.sa_handler == SIG_DFL ||
+               map_guard_old_action.sa_handler == SIG_IGN) {
+        /* The access is retried on return, and faults again. */
+        sigaction(SIGBUS, &map_guard_old_action, NULL);
+    } else {
+        map_guard_old_action.sa_handler(sig);
+    }
+}
+
+/*
+ * Register a mapping with the SIGBUS handler, installing the handler
+ * the first time. Returns the slot, or -1 if the mapping can't be
+ * guarded, in which case it mustn't be used.
+ */
+static int
+map_guard_add(void *map, size_t size)
+{
+    static gsize installed;
+    struct sigaction sa;
+    int i;
+
+    if (g_once_init_enter(&installed)) {
+        gsize ok = 1;
+
+        map_guard_page_mask = ~((uintptr_t)sysconf(_SC_PAGESIZE) - 1);
+        memset(&sa, 0, sizeof sa);
+        sa.sa_sigaction = map_guard_handler;
+        sa.sa_flags = SA_SIGINFO|SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(SIGBUS, &sa, &map_guard_old_action) < 0)
+            ok = 2;
+        g_once_init_leave(&installed, ok);
+    }
+    if (installed != 1)
+        return -1;
+
+    for (i = 0; i < MAP_GUARD_SLOTS; i++) {
+        if (g_atomic_int_compare_and_exchange(&map_guards[i].in_use, 0, 1)) {
+            g_atomic_int_set(&map_guards[i].tripped, 0);
+            map_guards[i].end = (unsigned char *)map + size;
+            g_atomic_pointer_set(&map_guards[i].start, map);
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void
+map_guard_remove(int slot)
+{
+    g_atomic_pointer_set(&map_guards[slot].start, NULL);
+    g_atomic_int_set(&map_guards[slot].in_use, 0);
+}
+
+/* Unmap a mapping, once the SIGBUS handler has stopped looking at it. */
+static void
+map_unmap(unsigned char *map, int64_t size, int guard)
+{
+    map_guard_remove(guard);
+    munmap(map, (size_t)size);
+}
+
+static void
+map_free_old(FILE_T state)
+{
+    GSList *item;
+    struct old_map *old;
+
+    for (item = state->old_maps; item != NULL; item = item->next) {
+        old = (struct old_map *)item->data;
+        map_unmap(old->map, old->size, old->guard);
+        g_free(old);
+    }
+    g_slist_free(state->old_maps);
+    state->old_maps = NULL;
+}
+
+static void
+map_retire(FILE_T state)
+{
+    struct old_map *old;
+
+    if (state->map == NULL)
+        return;
+    if (!state->map_ptrs) {
+        map_unmap(state->map, state->map_size, state->map_guard);
+        state->map = NULL;
+        state->map_size = 0;
+        return;
+    }
+    old = g_new(struct old_map, 1);
+    old->map = state->map;
+    old->size = state->map_size;
+    old->guard = state->map_guard;
+    state->old_maps = g_slist_prepend(state->old_maps, old);
+    state->map = NULL;
+    state->map_size = 0;
+}
+
+/*
+ * Go back to reading into the output buffer. The output buffer must be
+ * empty.
+ */
+static void
+map_stop(FILE_T state)
+{
+    if (state->map == NULL)
+        return;
+    map_retire(state);
+    state->out.buf = state->out_mem;
+    buf_reset(&state->out);
+    if (state->fd != -1)
+        (void)ws_lseek64(state->fd, state->raw_pos, SEEK_SET);
+}
+
+/*
+ * Map the file. Returns false if it can't be mapped, or shouldn't be
+ * any more, because it has grown past the end of the mapping.
+ */
+static bool
+map_file(FILE_T state)
+{
+    ws_statb64 st;
+    void *map;
+    int guard;
+
+    if (state->fd == -1 || ws_fstat64(state->fd, &st) < 0)
+        return false;
+    if (state->map != NULL)
+        return st.st_size <= state->map_size;
+
+    /* On 32-bit platforms a big file won't fit in the address space. */
+    if (st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX)
+        return false;
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, state->fd, 0);
+    if (map == MAP_FAILED)
+        return false;
+    guard = map_guard_add(map, (size_t)st.st_size);
+    if (guard == -1) {
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+    /* The same files are worth reading ahead as are worth mapping. */
+    if (state->read_ahead_ok)
+        (void)posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    state->map = (unsigned char *)map;
+    state->map_size = st.st_size;
+    state->map_guard = guard;
+    return true;
+}
+
+/* Has the file been cut short under the mapping? */
+static bool
+map_tripped(FILE_T state)
+{
+    return state->map != NULL &&
+        g_atomic_int_get(&map_guards[state->map_guard].tripped);
+}
+
+static bool
+mapped_fill_out_buffer(FILE_T state)
+{
+    unsigned n;
+
+    if ((state->raw_pos >= state->map_size && !map_file(state)) ||
+        map_tripped(state)) {
+        /* Just read the file. */
+        state->map_ok = false;
+        map_stop(state);
+        return buf_read(state, &state->out) == 0;
+    }
+    if (state->raw_pos >= state->map_size) {
+        state->eof = true;
+        return true;
+    }
+
+    n = (unsigned)MIN(state->map_size - state->raw_pos, MAX_READ_BUF_SIZE);
+    state->out.buf = state->map + state->raw_pos;
+    state->out.next = state->out.buf;
+    state->out.avail = n;
+    state->raw_pos += n;
+    return true;
+}
+#endif /* USE_MMAP */
+
 #define ZLIB_WINSIZE 32768
 #define  LZ4_WINSIZE 65536
 
@@ -451,6 +735,133 @@ fast_seek_header(FILE_T file, int64_t in_pos, int64_t out_pos,
     }
 }
 
+/*
+ * Fast seek index files.
+ *
+ * The fast seek points built while reading a compressed file
+ * sequentially can be saved to an index file, so that the next time
+ * the file is opened seeking in it is fast from the start. Only the
+ * points are saved, not the offsets of the records, which belong to
+ * whoever read them, so opening the file still means reading it all
+ * once; the index doesn't make that any quicker.
+ *
+ * The points are written in the host's native layout; the
+ * index is a local cache, not an interchange format, so the header
+ * only has to let us reject files that don't match this build or the
+ * capture file.
+ */
+#define FAST_SEEK_INDEX_MAGIC   0x58444957  /* "WIDX" in host byte order */
+#define FAST_SEEK_INDEX_VERSION 1
+
+struct fast_seek_index_hdr {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t point_size;    /* sizeof (struct fast_seek_point) */
+    uint32_t count;         /* number of fast seek points */
+    int64_t  file_size;     /* size of the capture file */
+    int64_t  file_mtime;    /* modification time of the capture file */
+};
+
+bool
+file_fast_seek_index_load(GPtrArray *seek, const char *path,
+                          int64_t file_size, int64_t file_mtime)
+{
+    struct fast_seek_index_hdr hdr;
+    struct fast_seek_point *item, *prev = NULL;
+    FILE *fp;
+    uint32_t i;
+
+    if (!seek || seek->len != 0)
+        return false;
+
+    if ((fp = ws_fopen(path, "rb")) == NULL)
+        return false;
+
+    if (fread(&hdr, sizeof hdr, 1, fp) != 1 ||
+        hdr.magic != FAST_SEEK_INDEX_MAGIC ||
+        hdr.version != FAST_SEEK_INDEX_VERSION ||
+        hdr.point_size != sizeof (struct fast_seek_point) ||
+        hdr.file_size != file_size ||
+        hdr.file_mtime != file_mtime) {
+        fclose(fp);
+        return false;
+    }
+
+    for (i = 0; i < hdr.count; i++) {
+        item = g_new(struct fast_seek_point, 1);
+        /*
+         * Points must be in increasing order of uncompressed offset,
+         * for fast_seek_find(), and within the capture file.
+         */
+        if (fread(item, sizeof *item, 1, fp) != 1 ||
+            item->in < 0 || item->in > file_size || item->out < 0 ||
+            (prev && (item->out <= prev->out || item->in < prev->in)) ||
+            (item->compression != UNCOMPRESSED && item->compression != ZLIB &&
+             item->compression != GZIP_AFTER_HEADER && item->compression != ZSTD &&
+             item->compression != LZ4)) {
+            g_free(item);
+            break;
+        }
+        g_ptr_array_add(seek, item);
+        prev = item;
+    }
+    fclose(fp);
+
+    if (i != hdr.count) {
+        /* Truncated or corrupt; don't use any of it. */
+        for (i = 0; i < seek->len; i++)
+            g_free(seek->pdata[i]);
+        g_ptr_array_set_size(seek, 0);
+        return false;
+    }
+    ws_debug("loaded %u fast seek points from %s", hdr.count, path);
+    return true;
+}
+
+bool
+file_fast_seek_index_save(GPtrArray *seek, const char *path,
+                          int64_t file_size, int64_t file_mtime)
+{
+    struct fast_seek_index_hdr hdr;
+    char *tmp_path;
+    FILE *fp;
+    unsigned i;
+    bool ok;
+
+    if (!seek || seek->len == 0)
+        return false;
+
+    memset(&hdr, 0, sizeof hdr);
+    hdr.magic = FAST_SEEK_INDEX_MAGIC;
+    hdr.version = FAST_SEEK_INDEX_VERSION;
+    hdr.point_size = sizeof (struct fast_seek_point);
+    hdr.count = seek->len;
+    hdr.file_size = file_size;
+    hdr.file_mtime = file_mtime;
+
+    /* Write to a temporary file, so that readers never see a partial index. */
+    tmp_path = ws_strdup_printf("%s.tmp", path);
+    if ((fp = ws_fopen(tmp_path, "wb")) == NULL) {
+        g_free(tmp_path);
+        return false;
+    }
+    ok = fwrite(&hdr, sizeof hdr, 1, fp) == 1;
+    for (i = 0; ok && i < seek->len; i++)
+        ok = fwrite(seek->pdata[i], sizeof (struct fast_seek_point), 1, fp) == 1;
+    if (fclose(fp) != 0)
+        ok = false;
+    /*
+     * ws_rename() replaces an index that's already there, on Windows
+     * too, where it's MoveFileEx() with MOVEFILE_REPLACE_EXISTING.
+     */
+    if (ok)
+        ok = ws_rename(tmp_path, path) == 0;
+    if (!ok)
+        ws_unlink(tmp_path);
+    g_free(tmp_path);
+    return ok;
+}
+
 static void
 fast_seek_reset(FILE_T state)
 {
@@ -509,6 +920,11 @@ fast_seek_reset(FILE_T state)
 static bool
 uncompressed_fill_out_buffer(FILE_T state)
 {
+#ifdef USE_MMAP
+    /* A file that's compressed in part doesn't map directly to our output. */
+    if (state->map_ok && !state->is_compressed)
+        return mapped_fill_out_buffer(state);
+#endif /* USE_MMAP */
     if (buf_read(state, &state->out) < 0)
         return false;
     return true;
@@ -713,7 +1129,7 @@ zlib_fill_out_buffer(FILE_T state)
     z_streamp strm = &(state->strm);
 #endif /* HAVE_ZLIBNG */
     unsigned char *buf = state->out.buf;
-    unsigned int count = state->size << 1;
+    unsigned int count = state->out_size;
 
     unsigned char *buf2 = buf;
     unsigned int count2 = count;
@@ -1021,7 +1437,7 @@ zstd_fill_out_buffer(FILE_T state)
     if (state->in.avail == 0 && fill_in_buffer(state) == -1)
         return false;
 
-    ZSTD_outBuffer output = {state->out.buf, state->size << 1, 0};
+    ZSTD_outBuffer output = {state->out.buf, state->out_size, 0};
     ZSTD_inBuffer input = {state->in.next, state->in.avail, 0};
     const size_t ret = ZSTD_decompressStream(state->zstd_dctx, &output, &input);
     if (ZSTD_isError(ret)) {
@@ -1225,7 +1641,7 @@ lz4_fill_out_buffer(FILE_T state)
             break;
         }
 
-        outBufSize = (state->size << 1) - offset_in_buffer(&state->out);
+        outBufSize = state->out_size - offset_in_buffer(&state->out);
         inBufSize = MIN(state->in.avail, compressedSize);
         ret = LZ4F_decompress(state->lz4_dctx, state->out.next, &outBufSize, state->in.next, &inBufSize, NULL);
 
@@ -1250,7 +1666,7 @@ lz4_fill_out_buffer(FILE_T state)
      * to handle linked blocks, because the Frame API doesn't have
      * a method to reset the dictionary / window.
      */
-    int outBufSize = state->size << 1;
+    int outBufSize = state->out_size;
     uint32_t compressedSize;
     if (gz_next4(state, &compressedSize) == -1) {
         return false;
@@ -1530,7 +1946,7 @@ check_for_compression(FILE_T state)
  * Based on what gz_make() in zlib does.
  */
 static int
-fill_out_buffer(FILE_T state)
+decompress_fill_out_buffer(FILE_T state)
 {
     if (state->compression == UNKNOWN) {
         /*
@@ -1586,6 +2002,352 @@ fill_out_buffer(FILE_T state)
     return 0;
 }
 
+/*
+ * Decompression ahead of the reader.
+ *
+ * Decompression is done on the thread reading the file, one output
+ * buffer at a time as the reader asks for more data, so a reader of a
+ * compressed file spends much of its time decompressing rather than
+ * doing something with the data. When a regular file turns out to be
+ * compressed and is being read sequentially, a thread takes over the
+ * decompression, and reads and decompresses the file ahead of the
+ * reader into a small ring of output buffers; fill_out_buffer() then
+ * just hands the reader the next buffer from the ring. The buffers are
+ * bigger than the reader's own output buffer, which is only a couple of
+ * disk blocks, so that handing one over is rare enough not to matter.
+ *
+ * The thread works on its own copy of the wtap_reader. Along with each
+ * buffer it passes on the state of the decompression after filling it,
+ * such as raw_pos and any error, and the fast seek points found while
+ * filling it, so that the fast seek array, which is shared with the
+ * random-access handle, is only changed on the reader's thread.
+ *
+ * When the thread reaches the end of the file or an error, it stops,
+ * and once the reader has caught up with it the decompression state is
+ * handed back, so that if the file grows or the error is cleared the
+ * reader carries on from there. Anything else that moves the file
+ * offset must call read_ahead_stop() first, which throws away whatever
+ * was decompressed ahead of the reader, and then start decompressing
+ * afresh, as file_seek() does.
+ */
+#define READ_AHEAD_NBUFS    3
+#define READ_AHEAD_BUF_SIZE (1024 * 1024)
+
+struct read_ahead_buf {
+    unsigned char *data;        /* output buffer of buf_size bytes */
+    unsigned char *next;        /* start of the uncompressed data */
+    unsigned avail;             /* amount of uncompressed data */
+    int ret;                    /* decompress_fill_out_buffer() return value */
+    bool last;                  /* the thread stopped after filling this */
+    GPtrArray *fast_seek;       /* fast seek points found, or NULL */
+
+    /* decompression state after filling this buffer */
+    int64_t raw_pos;
+    int64_t raw;
+    bool eof;
+    int err;
+    const char *err_info;
+    compression_t compression;
+    compression_t last_compression;
+    bool is_compressed;
+};
+
+struct read_ahead {
+    GThread *thread;
+    GMutex mutex;
+    GCond cond;
+    struct wtap_reader reader;  /* the thread's copy of the file state */
+    struct read_ahead_buf bufs[READ_AHEAD_NBUFS];
+    unsigned buf_size;          /* size of each buffer */
+    unsigned head;              /* buffer being used, or to be used next */
+    unsigned count;             /* number of filled buffers */
+    bool in_use;                /* the head buffer is being used */
+    bool caught_up;             /* the last buffer has been used */
+    bool stop;                  /* the thread should stop */
+};
+
+static void *
+read_ahead_thread(void *data)
+{
+    struct read_ahead *ra = (struct read_ahead *)data;
+    FILE_T reader = &ra->reader;
+    struct read_ahead_buf *rb;
+    unsigned i;
+    bool last;
+
+    do {
+        g_mutex_lock(&ra->mutex);
+        while (ra->count == READ_AHEAD_NBUFS && !ra->stop)
+            g_cond_wait(&ra->cond, &ra->mutex);
+        if (ra->stop) {
+            g_mutex_unlock(&ra->mutex);
+            break;
+        }
+        /* The reader doesn't look at buffers past the filled ones. */
+        rb = &ra->bufs[(ra->head + ra->count) % READ_AHEAD_NBUFS];
+        g_mutex_unlock(&ra->mutex);
+
+        reader->out.buf = rb->data;
+        buf_reset(&reader->out);
+        rb->ret = decompress_fill_out_buffer(reader);
+        rb->next = reader->out.next;
+        rb->avail = reader->out.avail;
+        /* Nobody reads the data here, so pos is where the next buffer starts. */
+        reader->pos += reader->out.avail;
+
+        rb->raw_pos = reader->raw_pos;
+        rb->raw = reader->raw;
+        /* The thread has the input buffer, so the reader's stays empty. */
+        rb->eof = reader->eof && reader->in.avail == 0;
+        rb->err = reader->err;
+        rb->err_info = reader->err_info;
+        rb->compression = reader->compression;
+        rb->last_compression = reader->last_compression;
+        rb->is_compressed = reader->is_compressed;
+
+        /*
+         * Pass on any new fast seek points, keeping the last one, as
+         * new points are only added some distance after it.
+         */
+        rb->fast_seek = NULL;
+        if (reader->fast_seek != NULL && reader->fast_seek->len > 1) {
+            rb->fast_seek = g_ptr_array_sized_new(reader->fast_seek->len - 1);
+            for (i = 1; i < reader->fast_seek->len; i++)
+                g_ptr_array_add(rb->fast_seek, reader->fast_seek->pdata[i]);
+            g_ptr_array_remove_range(reader->fast_seek, 0, reader->fast_seek->len - 1);
+        }
+
+        /* Stop where the reader would stop asking for more data. */
+        last = rb->ret == -1 || reader->err != 0 ||
+               (reader->eof && reader->in.avail == 0);
+        rb->last = last;
+
+        g_mutex_lock(&ra->mutex);
+        ra->count++;
+        g_cond_signal(&ra->cond);
+        g_mutex_unlock(&ra->mutex);
+    } while (!last);
+    return NULL;
+}
+
+static void
+read_ahead_free_buffers(struct read_ahead *ra)
+{
+    unsigned i;
+
+    for (i = 0; i < READ_AHEAD_NBUFS; i++)
+        g_free(ra->bufs[i].data);
+}
+
+static void
+read_ahead_start(FILE_T state)
+{
+    struct read_ahead *ra = g_new0(struct read_ahead, 1);
+    FILE_T reader = &ra->reader;
+    unsigned i;
+
+    ra->buf_size = MAX(state->out_size, READ_AHEAD_BUF_SIZE);
+    for (i = 0; i < READ_AHEAD_NBUFS; i++) {
+        ra->bufs[i].data = (unsigned char *)g_try_malloc(ra->buf_size);
+        if (ra->bufs[i].data == NULL)
+            goto fail;
+    }
+
+    /*
+     * The thread gets the decompression state, the input buffer and
+     * the position in the file; the reader's output buffer is empty.
+     */
+    *reader = *state;
+    reader->out_size = ra->buf_size;
+#ifdef USE_ZLIB_OR_ZLIBNG
+    /* A zlib stream can't just be copied. */
+    if (ZLIB_PREFIX(inflateCopy)(&reader->strm, &state->strm) != Z_OK)
+        goto fail;
+#endif /* USE_ZLIB_OR_ZLIBNG */
+    reader->read_ahead_ok = false;
+    reader->map_ok = false;
+    reader->fast_seek = NULL;
+    if (state->fast_seek != NULL) {
+        reader->fast_seek = g_ptr_array_new();
+        if (state->fast_seek->len != 0)
+            g_ptr_array_add(reader->fast_seek, state->fast_seek->pdata[state->fast_seek->len - 1]);
+    }
+    state->in.avail = 0;
+    state->fast_seek_cur = NULL;
+
+    g_mutex_init(&ra->mutex);
+    g_cond_init(&ra->cond);
+    ra->thread = g_thread_try_new("wtap read-ahead", read_ahead_thread, ra, NULL);
+    if (ra->thread == NULL) {
+        /* Take the state back and just decompress here. */
+        state->in = reader->in;
+        state->fast_seek_cur = reader->fast_seek_cur;
+        if (reader->fast_seek != NULL)
+            g_ptr_array_free(reader->fast_seek, true);
+#ifdef USE_ZLIB_OR_ZLIBNG
+        ZLIB_PREFIX(inflateEnd)(&reader->strm);
+#endif /* USE_ZLIB_OR_ZLIBNG */
+        g_mutex_clear(&ra->mutex);
+        g_cond_clear(&ra->cond);
+        goto fail;
+    }
+    state->read_ahead = ra;
+    return;
+
+fail:
+    read_ahead_free_buffers(ra);
+    g_free(ra);
+    state->read_ahead_ok = false;
+}
+
+/* Add the fast seek points found while filling a buffer. */
+static void
+read_ahead_add_fast_seek(FILE_T state, struct read_ahead_buf *rb)
+{
+    unsigned i;
+
+    if (rb->fast_seek == NULL)
+        return;
+    for (i = 0; i < rb->fast_seek->len; i++)
+        g_ptr_array_add(state->fast_seek, rb->fast_seek->pdata[i]);
+    g_ptr_array_free(rb->fast_seek, true);
+    rb->fast_seek = NULL;
+}
+
+static void
+read_ahead_stop(FILE_T state)
+{
+    struct read_ahead *ra = state->read_ahead;
+    FILE_T reader;
+    struct read_ahead_buf *rb;
+    unsigned char *out_mem;
+    unsigned i;
+
+    if (ra == NULL)
+        return;
+
+    g_mutex_lock(&ra->mutex);
+    ra->stop = true;
+    g_cond_signal(&ra->cond);
+    g_mutex_unlock(&ra->mutex);
+    g_thread_join(ra->thread);
+    reader = &ra->reader;
+
+    /* Keep whatever is left in the buffer being used. */
+    if (ra->in_use) {
+        rb = &ra->bufs[ra->head];
+        out_mem = state->out_mem;
+        state->out_mem = rb->data;
+        state->out_size = ra->buf_size;
+        rb->data = out_mem;
+    }
+    state->out.buf = state->out_mem;
+
+    /*
+     * The points found in buffers that weren't used are still good;
+     * everything else about those buffers is thrown away.
+     */
+    for (i = ra->in_use ? 1 : 0; i < ra->count; i++)
+        read_ahead_add_fast_seek(state, &ra->bufs[(ra->head + i) % READ_AHEAD_NBUFS]);
+
+    /* Take back the decompression state. */
+    state->in = reader->in;
+    state->fast_seek_cur = reader->fast_seek_cur;
+    if (ra->caught_up) {
+        /* Carry on from where the thread stopped. */
+        state->eof = reader->eof;
+#ifdef USE_LZ4
+        state->lz4_info = reader->lz4_info;
+        memcpy(state->lz4_hdr, reader->lz4_hdr, LZ4F_HEADER_SIZE_MAX);
+#endif /* USE_LZ4 */
+#ifdef USE_ZLIB_OR_ZLIBNG
+        ZLIB_PREFIX(inflateEnd)(&state->strm);
+        if (ZLIB_PREFIX(inflateCopy)(&state->strm, &reader->strm) != Z_OK &&
+            state->err == 0) {
+            state->err = ENOMEM;
+            state->err_info = NULL;
+        }
+#endif /* USE_ZLIB_OR_ZLIBNG */
+    } else {
+        /*
+         * The caller starts afresh at raw_pos. The lz4 context may be
+         * in a different frame, or past the end of one, so make sure a
+         * fast seek sets it up again.
+         */
+#ifdef USE_LZ4
+        memset(&state->lz4_info, 0, sizeof state->lz4_info);
+#endif /* USE_LZ4 */
+        if (state->fd != -1)
+            (void)ws_lseek64(state->fd, state->raw_pos, SEEK_SET);
+    }
+#ifdef USE_ZLIB_OR_ZLIBNG
+    ZLIB_PREFIX(inflateEnd)(&reader->strm);
+#endif /* USE_ZLIB_OR_ZLIBNG */
+    if (reader->fast_seek != NULL)
+        g_ptr_array_free(reader->fast_seek, true);
+
+    read_ahead_free_buffers(ra);
+    g_mutex_clear(&ra->mutex);
+    g_cond_clear(&ra->cond);
+    g_free(ra);
+    state->read_ahead = NULL;
+}
+
+/* Hand the reader the next buffer decompressed by the thread. */
+static int
+read_ahead_fill_out_buffer(FILE_T state)
+{
+    struct read_ahead *ra = state->read_ahead;
+    struct read_ahead_buf *rb;
+    int ret;
+
+    g_mutex_lock(&ra->mutex);
+    if (ra->in_use) {
+        /* Give the buffer we've used up back to the thread. */
+        ra->head = (ra->head + 1) % READ_AHEAD_NBUFS;
+        ra->count--;
+        ra->in_use = false;
+        g_cond_signal(&ra->cond);
+    }
+    while (ra->count == 0)
+        g_cond_wait(&ra->cond, &ra->mutex);
+    g_mutex_unlock(&ra->mutex);
+
+    rb = &ra->bufs[ra->head];
+    ra->in_use = true;
+    state->out.buf = rb->data;
+    state->out.next = rb->next;
+    state->out.avail = rb->avail;
+    state->raw_pos = rb->raw_pos;
+    state->raw = rb->raw;
+    state->eof = rb->eof;
+    state->err = rb->err;
+    state->err_info = rb->err_info;
+    state->compression = rb->compression;
+    state->last_compression = rb->last_compression;
+    state->is_compressed = rb->is_compressed;
+    read_ahead_add_fast_seek(state, rb);
+
+    ret = rb->ret;
+    if (rb->last) {
+        ra->caught_up = true;
+        read_ahead_stop(state);
+    }
+    return ret;
+}
+
+static int
+fill_out_buffer(FILE_T state)
+{
+    /* Decompressing ahead is only worth it for sequential reads of compressed files. */
+    if (state->read_ahead == NULL && state->read_ahead_ok &&
+        state->is_compressed && !state->eof)
+        read_ahead_start(state);
+    if (state->read_ahead != NULL)
+        return read_ahead_fill_out_buffer(state);
+    return decompress_fill_out_buffer(state);
+}
+
 static int
 gz_skip(FILE_T state, int64_t len)
 {
@@ -1625,6 +2387,9 @@ gz_skip(FILE_T state, int64_t len)
 static void
 gz_reset(FILE_T state)
 {
+#ifdef USE_MMAP
+    map_stop(state);              /* look at the start of the file afresh */
+#endif /* USE_MMAP */
     buf_reset(&state->out);       /* no output data available */
     state->eof = false;           /* not at end of file */
     state->compression = UNKNOWN; /* look for compression header */
@@ -1766,6 +2531,8 @@ file_fdopen(int fd)
     state->in.next = state->in.buf;
     state->in.avail = 0;
     state->out.buf = (unsigned char *)g_try_malloc(want << 1);
+    state->out_mem = state->out.buf;
+    state->out_size = want << 1;
     state->out.next = state->out.buf;
     state->out.avail = 0;
     state->size = want;
@@ -1827,6 +2594,7 @@ file_open(const char *path)
 {
     int fd;
     FILE_T ft;
+    ws_statb64 statb;
 #ifdef USE_ZLIB_OR_ZLIBNG
     const char *suffixp;
 #endif /* USE_ZLIB_OR_ZLIBNG */
@@ -1850,6 +2618,12 @@ file_open(const char *path)
         return NULL;
     }
 
+    /* Reading ahead or mapping is only worth it, and only safe, for regular files. */
+    if (ws_fstat64(fd, &statb) >= 0 && S_ISREG(statb.st_mode)) {
+        ft->read_ahead_ok = true;
+        ft->map_ok = true;
+    }
+
 #ifdef USE_ZLIB_OR_ZLIBNG
     /*
      * If this file's name ends in ".caz", it's probably a compressed
@@ -1875,9 +2649,14 @@ file_open(const char *path)
 }
 
 void
-file_set_random_access(FILE_T stream, bool random_flag _U_, GPtrArray *seek)
+file_set_random_access(FILE_T stream, bool random_flag, GPtrArray *seek)
 {
     stream->fast_seek = seek;
+    if (random_flag) {
+        /* Reads are at arbitrary offsets; reading ahead won't help. */
+        read_ahead_stop(stream);
+        stream->read_ahead_ok = false;
+    }
 }
 
 int64_t
@@ -2047,7 +2826,14 @@ file_seek(FILE_T file, int64_t offset, int whence, int *err)
             break;
         }
 
-        if (ws_lseek64(file->fd, off, SEEK_SET) == -1) {
+        read_ahead_stop(file);
+#ifdef USE_MMAP
+        /* Only uncompressed data is read through the mapping. */
+        if (here->compression != UNCOMPRESSED)
+            map_stop(file);
+#endif /* USE_MMAP */
+        /* A mapped file doesn't use the file offset. */
+        if (file->map == NULL && ws_lseek64(file->fd, off, SEEK_SET) == -1) {
             *err = errno;
             return -1;
         }
@@ -2183,7 +2969,9 @@ file_seek(FILE_T file, int64_t offset, int whence, int *err)
         /*
          * Yes.  Just seek there within the file.
          */
-        if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
+        read_ahead_stop(file);
+        if (file->map == NULL &&
+            ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
             *err = errno;
             return -1;
         }
@@ -2217,6 +3005,7 @@ file_seek(FILE_T file, int64_t offset, int whence, int *err)
         /* rewind, then skip to offset */
 
         /* back up and start over */
+        read_ahead_stop(file);
         if (ws_lseek64(file->fd, file->start, SEEK_SET) == -1) {
             *err = errno;
             return -1;
@@ -2372,6 +3161,78 @@ file_read(void *buf, unsigned int len, FILE_T file)
     return (int)got;
 }
 
+#ifdef USE_MMAP
+const uint8_t *
+file_read_ptr(FILE_T file, unsigned int len)
+{
+    const uint8_t *ptr;
+
+    /*
+     * The output buffer is refilled from the start when it's used up, so
+     * a pointer into it could be overwritten by a later read of the same
+     * record; only data in a mapping stays put.
+     */
+    if (len == 0 || file->err != 0 || file->map == NULL)
+        return NULL;
+    if (map_tripped(file)) {
+        /* Don't hand out any more of the zeroes; go and find the end. */
+        file->raw_pos -= file->out.avail;
+        buf_reset(&file->out);
+        file->map_ok = false;
+        map_stop(file);
+        return NULL;
+    }
+
+    /* process a skip request */
+    if (file->seek_pending) {
+        file->seek_pending = false;
+        if (gz_skip(file, file->skip) == -1)
+            return NULL;
+    }
+
+    if (file->out.avail == 0 && !(file->eof && file->in.avail == 0)) {
+        if (fill_out_buffer(file) == -1)
+            return NULL;
+    }
+    /* The file may have stopped being mapped. */
+    if (file->map == NULL)
+        return NULL;
+    if (file->out.avail < len) {
+        /* Start a new window here. */
+        file->raw_pos -= file->out.avail;
+        buf_reset(&file->out);
+        if (!mapped_fill_out_buffer(file) || file->map == NULL || file->out.avail < len)
+            return NULL;
+    }
+
+    ptr = file->out.next;
+    file->out.next += len;
+    file->out.avail -= len;
+    file->pos += len;
+    file->map_ptrs = true;
+    return ptr;
+}
+
+void
+file_release_ptrs(FILE_T file)
+{
+    map_free_old(file);
+    file->map_ptrs = false;
+}
+#else /* USE_MMAP */
+const uint8_t *
+file_read_ptr(FILE_T file _U_, unsigned int len _U_)
+{
+    /* Without a mapping, there's no data that stays put. */
+    return NULL;
+}
+
+void
+file_release_ptrs(FILE_T file _U_)
+{
+}
+#endif /* USE_MMAP */
+
 /*
  * XXX - this *peeks* at next byte, not a character.
  */
@@ -2554,6 +3415,7 @@ file_clearerr(FILE_T stream)
 void
 file_fdclose(FILE_T file)
 {
+    read_ahead_stop(file);
     if (file->fd != -1)
         ws_close(file->fd);
     file->fd = -1;
@@ -2573,7 +3435,14 @@ file_fdreopen(FILE_T file, const char *path)
 void
 file_close(FILE_T file)
 {
-    int fd = file->fd;
+    int fd;
+
+    read_ahead_stop(file);
+#ifdef USE_MMAP
+    map_retire(file);
+    map_free_old(file);
+#endif /* USE_MMAP */
+    fd = file->fd;
 
     /* free memory and close file */
     if (file->size) {
@@ -2586,7 +3455,7 @@ file_close(FILE_T file)
 #ifdef USE_LZ4
         LZ4F_freeDecompressionContext(file->lz4_dctx);
 #endif /* USE_LZ4 */
-        g_free(file->out.buf);
+        g_free(file->out_mem);
         g_free(file->in.buf);
     }
     g_free(file->fast_seek_cur);
@@ -16,12 +16,29 @@
 extern FILE_T file_open(const char *path);
 extern FILE_T file_fdopen(int fildes);
 extern void file_set_random_access(FILE_T stream, bool random_flag, GPtrArray *seek);
+extern bool file_fast_seek_index_load(GPtrArray *seek, const char *path, int64_t file_size, int64_t file_mtime);
+extern bool file_fast_seek_index_save(GPtrArray *seek, const char *path, int64_t file_size, int64_t file_mtime);
 WS_DLL_PUBLIC int64_t file_seek(FILE_T stream, int64_t offset, int whence, int *err);
 WS_DLL_PUBLIC int64_t file_tell(FILE_T stream);
 extern int64_t file_tell_raw(FILE_T stream);
 extern int file_fstat(FILE_T stream, ws_statb64 *statb, int *err);
 WS_DLL_PUBLIC bool file_iscompressed(FILE_T stream);
 WS_DLL_PUBLIC int file_read(void *buf, unsigned int count, FILE_T file);
+/*
+ * Like file_read(), but rather than copying the data, returns a pointer
+ * to it in the file's memory mapping. That's only possible if the file is
+ * uncompressed and has been mapped. The pointer stays valid across later
+ * reads and seeks, even if the file is mapped again, until
+ * file_release_ptrs() or file_close() is called. Returns NULL, having
+ * read nothing, if the data can't be got at that way; the caller should
+ * then use file_read().
+ */
+WS_DLL_PUBLIC const uint8_t *file_read_ptr(FILE_T file, unsigned int count);
+/*
+ * Say that no pointer returned by file_read_ptr() is still in use, so that
+ * mappings that have been given up on can be unmapped.
+ */
+extern void file_release_ptrs(FILE_T file);
 WS_DLL_PUBLIC int file_peekc(FILE_T stream);
 WS_DLL_PUBLIC int file_getc(FILE_T stream);
 WS_DLL_PUBLIC char *file_gets(char *buf, int len, FILE_T stream);
@@ -928,6 +928,7 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	int phdr_len;
 	libpcap_t *libpcap = (libpcap_t *)wth->priv;
 	bool is_nokia;
+	const uint8_t *pd;
 
 	if (!libpcap_read_header(wth, fh, err, err_info, &hdr))
 		return false;
@@ -1010,11 +1011,20 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	/*
 	 * Read the packet data.
 	 */
-	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
-		return false;	/* failed */
+	if (libpcap->byte_swapped) {
+		/* The pseudo-header might be byte-swapped in place. */
+		if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
+			return false;	/* failed */
+		pd = ws_buffer_start_ptr(buf);
+	} else {
+		if (!wtap_read_packet_bytes_ptr(wth, fh, buf, packet_size, &pd,
+		    err, err_info))
+			return false;	/* failed */
+	}
 
+	/* This only modifies the data if the file is byte-swapped. */
 	pcap_read_post_process(is_nokia, wth->file_encap, rec,
-	    ws_buffer_start_ptr(buf), libpcap->byte_swapped, libpcap->fcs_len);
+	    (uint8_t *)pd, libpcap->byte_swapped, libpcap->fcs_len);
 	return true;
 }
 
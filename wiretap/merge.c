@@ -323,6 +323,111 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
     return true;
 }
 
+/*
+ * Min-heap of the indices of the input files that have a record present,
+ * so that picking the next record doesn't need to look at every input file.
+ */
+typedef struct {
+    unsigned *files;
+    unsigned  count;
+    int       primed;   /* number of input files read from at least once */
+    int       refill;   /* file whose record was just returned, or -1 */
+} merge_heap_t;
+
+/*
+ * returns true if the record present in file l should be written before
+ * the one in file r
+ *
+ * Records with no time stamp are treated as earlier than all other
+ * records, in input file order; records with the same time stamp are
+ * taken from the last input file first.  That is the order in which
+ * the merge always picked them.
+ */
+static bool
+merge_record_precedes(merge_in_file_t in_files[], unsigned l, unsigned r)
+{
+    wtap_rec *lrec = &in_files[l].rec;
+    wtap_rec *rrec = &in_files[r].rec;
+    bool l_has_ts = (lrec->presence_flags & WTAP_HAS_TS) != 0;
+    bool r_has_ts = (rrec->presence_flags & WTAP_HAS_TS) != 0;
+
+    if (!l_has_ts || !r_has_ts) {
+        if (l_has_ts != r_has_ts)
+            return !l_has_ts;
+        return l < r;
+    }
+    if (!is_earlier(&lrec->ts, &rrec->ts))
+        return false;
+    if (!is_earlier(&rrec->ts, &lrec->ts))
+        return true;
+    /* Same time stamp */
+    return l > r;
+}
+
+static void
+merge_heap_push(merge_heap_t *heap, merge_in_file_t in_files[], unsigned file)
+{
+    unsigned i = heap->count++;
+
+    while (i > 0) {
+        unsigned parent = (i - 1) / 2;
+        if (!merge_record_precedes(in_files, file, heap->files[parent]))
+            break;
+        heap->files[i] = heap->files[parent];
+        i = parent;
+    }
+    heap->files[i] = file;
+}
+
+static unsigned
+merge_heap_pop(merge_heap_t *heap, merge_in_file_t in_files[])
+{
+    unsigned top = heap->files[0];
+    unsigned file = heap->files[--heap->count];
+    unsigned i = 0;
+
+    for (;;) {
+        unsigned child = 2 * i + 1;
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count &&
+            merge_record_precedes(in_files, heap->files[child + 1], heap->files[child]))
+            child++;
+        if (!merge_record_precedes(in_files, heap->files[child], file))
+            break;
+        heap->files[i] = heap->files[child];
+        i = child;
+    }
+    if (heap->count > 0)
+        heap->files[i] = file;
+    return top;
+}
+
+/*
+ * Read the next record from an input file and, if there is one, add the
+ * file to the heap.  Returns false on a read error.
+ */
+static bool
+merge_heap_read(merge_heap_t *heap, merge_in_file_t in_files[], unsigned file,
+                int *err, char **err_info)
+{
+    int64_t data_offset;
+
+    if (!wtap_read(in_files[file].wth, &in_files[file].rec,
+                   &in_files[file].frame_buffer, err, err_info,
+                   &data_offset)) {
+        if (*err != 0) {
+            in_files[file].state = GOT_ERROR;
+            return false;
+        }
+        in_files[file].state = AT_EOF;
+        return true;
+    }
+    in_files[file].state = RECORD_PRESENT;
+    merge_heap_push(heap, in_files, file);
+    return true;
+}
+
 /** Read the next packet, in chronological order, from the set of files to
  * be merged.
  *
@@ -337,6 +442,7 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  *
  * @param in_file_count number of entries in in_files
  * @param in_files input file array
+ * @param heap heap of the input files with a record present
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -345,69 +451,43 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  */
 static merge_in_file_t *
 merge_read_packet(int in_file_count, merge_in_file_t in_files[],
-                  int *err, char **err_info)
+                  merge_heap_t *heap, int *err, char **err_info)
 {
     int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
+    unsigned ei;
 
     /*
      * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
+     * EOF; after the first call, that's only the file from which we
+     * returned the previous record.  The heap then gives us the record
+     * with the earliest time stamp or with no time stamp (those records
+     * are treated as earlier than all other records).  Yes, this means
+     * you won't get a chronological merge of those records, but you
+     * obviously *can't* get that.
      */
-    for (i = 0; i < in_file_count; i++) {
-        int64_t data_offset;
-
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec,
-                           &in_files[i].frame_buffer, err, err_info,
-                           &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
-            }
-        }
+    while (heap->primed < in_file_count) {
+        i = heap->primed++;
+        if (!merge_heap_read(heap, in_files, i, err, err_info))
+            return &in_files[i];
+    }
+    if (heap->refill != -1) {
+        i = heap->refill;
+        heap->refill = -1;
+        if (!merge_heap_read(heap, in_files, i, err, err_info))
+            return &in_files[i];
     }
 
-    if (ei == -1) {
+    if (heap->count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    ei = merge_heap_pop(heap, in_files);
+
     /* We'll need to read another packet from this file. */
     in_files[ei].state = RECORD_NOT_PRESENT;
+    heap->refill = ei;
 
     /* Count this packet. */
     in_files[ei].packet_num++;
@@ -1035,6 +1115,12 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     int                 count = 0;
     bool                stop_flag = false;
     wtap_rec *rec,      snap_rec;
+    merge_heap_t        heap;
+
+    heap.files = g_new(unsigned, in_file_count);
+    heap.count = 0;
+    heap.primed = 0;
+    heap.refill = -1;
 
     for (;;) {
         *err = 0;
@@ -1044,8 +1130,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
-                                        err_info);
+            in_file = merge_read_packet(in_file_count, in_files, &heap,
+                                        err, err_info);
         }
 
         if (in_file == NULL) {
@@ -1167,6 +1253,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         wtap_rec_reset(rec);
     }
 
+    g_free(heap.files);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
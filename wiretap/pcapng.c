@@ -2123,7 +2123,7 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
 }
 
 static bool
-pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
+pcapng_read_packet_block(wtap *wth, FILE_T fh, pcapng_block_header_t *bh,
                          section_info_t *section_info,
                          wtapng_block_t *wblock,
                          int *err, char **err_info, bool enhanced)
@@ -2140,6 +2140,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     uint64_t ts;
     int pseudo_header_len;
     int fcslen;
+    const uint8_t *pd;
 
     wblock->block = wtap_block_create(WTAP_BLOCK_PACKET);
 
@@ -2313,9 +2314,17 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->ts.secs = (time_t)(wblock->rec->ts.secs + iface_info.tsoffset);
 
     /* "(Enhanced) Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                packet.cap_len - pseudo_header_len, err, err_info))
-        return false;
+    if (section_info->byte_swapped) {
+        /* The pseudo-header might be byte-swapped in place. */
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    packet.cap_len - pseudo_header_len, err, err_info))
+            return false;
+        pd = ws_buffer_start_ptr(wblock->frame_buffer);
+    } else {
+        if (!wtap_read_packet_bytes_ptr(wth, fh, wblock->frame_buffer,
+                                        packet.cap_len - pseudo_header_len, &pd, err, err_info))
+            return false;
+    }
     block_read += packet.cap_len - pseudo_header_len;
 
     /* jump over potential padding bytes at end of the packet data */
@@ -2357,8 +2366,9 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
         wtap_block_add_uint64_option(wblock->block, OPT_PKT_DROPCOUNT, (uint64_t)packet.drops_count);
     }
 
+    /* This only modifies the data if the section is byte-swapped. */
     pcap_read_post_process(false, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
+                           wblock->rec, (uint8_t *)pd,
                            section_info->byte_swapped, fcslen);
 
     /*
@@ -2380,7 +2390,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
 
 
 static bool
-pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
+pcapng_read_simple_packet_block(wtap *wth, FILE_T fh, pcapng_block_header_t *bh,
                                 const section_info_t *section_info,
                                 wtapng_block_t *wblock,
                                 int *err, char **err_info)
@@ -2389,6 +2399,7 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     pcapng_simple_packet_block_t spb;
     wtapng_simple_packet_t simple_packet;
     uint32_t padding;
+    const uint8_t *pd;
     int pseudo_header_len;
 
     /*
@@ -2497,9 +2508,17 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
 
     /* "Simple Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                simple_packet.cap_len, err, err_info))
-        return false;
+    if (section_info->byte_swapped) {
+        /* The pseudo-header might be byte-swapped in place. */
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    simple_packet.cap_len, err, err_info))
+            return false;
+        pd = ws_buffer_start_ptr(wblock->frame_buffer);
+    } else {
+        if (!wtap_read_packet_bytes_ptr(wth, fh, wblock->frame_buffer,
+                                        simple_packet.cap_len, &pd, err, err_info))
+            return false;
+    }
 
     /* jump over potential padding bytes at end of the packet data */
     if ((simple_packet.cap_len % 4) != 0) {
@@ -2507,8 +2526,9 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
             return false;
     }
 
+    /* This only modifies the data if the section is byte-swapped. */
     pcap_read_post_process(false, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
+                           wblock->rec, (uint8_t *)pd,
                            section_info->byte_swapped, iface_info.fcslen);
 
     /*
@@ -3583,15 +3603,15 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
                     return false;
                 break;
             case(BLOCK_TYPE_PB):
-                if (!pcapng_read_packet_block(fh, &bh, section_info, wblock, err, err_info, false))
+                if (!pcapng_read_packet_block(wth, fh, &bh, section_info, wblock, err, err_info, false))
                     return false;
                 break;
             case(BLOCK_TYPE_SPB):
-                if (!pcapng_read_simple_packet_block(fh, &bh, section_info, wblock, err, err_info))
+                if (!pcapng_read_simple_packet_block(wth, fh, &bh, section_info, wblock, err, err_info))
                     return false;
                 break;
             case(BLOCK_TYPE_EPB):
-                if (!pcapng_read_packet_block(fh, &bh, section_info, wblock, err, err_info, true))
+                if (!pcapng_read_packet_block(wth, fh, &bh, section_info, wblock, err, err_info, true))
                     return false;
                 break;
             case(BLOCK_TYPE_NRB):
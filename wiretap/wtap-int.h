@@ -77,6 +77,12 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;
     wtap_new_secrets_callback_t add_new_secrets;
     GPtrArray                   *fast_seek;
+    char                        *fast_seek_index;       /* fast seek index file, or NULL if not used */
+    unsigned                    fast_seek_index_count;  /* number of fast seek points loaded from it */
+    int64_t                     fast_seek_file_size;    /* size and modification time of the file, */
+    int64_t                     fast_seek_file_mtime;   /* to validate the fast seek index */
+    bool                        read_ptr;               /* true if the data needn't be copied, see wtap_read_ptr() */
+    const uint8_t               *packet_data;           /* the data, if it wasn't copied, or NULL */
 };
 
 struct wtap_dumper;
@@ -327,6 +333,20 @@ bool
 wtap_read_packet_bytes(FILE_T fh, Buffer *buf, unsigned length, int *err,
     char **err_info);
 
+/*
+ * Like wtap_read_packet_bytes(), but if the caller of wtap_read() or
+ * wtap_seek_read() asked for a pointer to the data, with wtap_read_ptr()
+ * or wtap_seek_read_ptr(), and the data can be got at in place, it isn't
+ * copied into the Buffer. Either way, *data is set to point to it.
+ *
+ * The data must not be modified; a file type that modifies the data
+ * after reading it must use wtap_read_packet_bytes().
+ */
+WS_DLL_PUBLIC
+bool
+wtap_read_packet_bytes_ptr(wtap *wth, FILE_T fh, Buffer *buf, unsigned length,
+    const uint8_t **data, int *err, char **err_info);
+
 /*
  * Implementation of wth->subtype_read that reads the full file contents
  * as a single packet.
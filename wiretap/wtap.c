@@ -1537,6 +1537,17 @@ wtap_sequential_close(wtap *wth)
 		(*wth->subtype_sequential_close)(wth);
 
 	if (wth->fh != NULL) {
+		/*
+		 * If we read a compressed file all the way through and
+		 * found fast seek points that weren't in the index, save
+		 * them for the next time the file is opened.
+		 */
+		if (wth->fast_seek_index != NULL && file_iscompressed(wth->fh) &&
+		    file_eof(wth->fh) && wth->fast_seek->len > wth->fast_seek_index_count) {
+			if (file_fast_seek_index_save(wth->fast_seek, wth->fast_seek_index,
+			    wth->fast_seek_file_size, wth->fast_seek_file_mtime))
+				wth->fast_seek_index_count = wth->fast_seek->len;
+		}
 		file_close(wth->fh);
 		wth->fh = NULL;
 	}
@@ -1582,6 +1593,7 @@ wtap_close(wtap *wth)
 		g_ptr_array_foreach(wth->fast_seek, g_fast_seek_item_free, NULL);
 		g_ptr_array_free(wth->fast_seek, true);
 	}
+	g_free(wth->fast_seek_index);
 
 	wtap_block_array_free(wth->shb_hdrs);
 	wtap_block_array_free(wth->nrbs);
@@ -1599,6 +1611,15 @@ wtap_cleareof(wtap *wth) {
 	file_clearerr(wth->fh);
 }
 
+bool
+wtap_sequential_seek(wtap *wth, int64_t offset, int *err)
+{
+	if (file_seek(wth->fh, offset, SEEK_SET, err) == -1)
+		return false;
+	file_clearerr(wth->fh);
+	return true;
+}
+
 static inline void
 wtapng_process_nrb_ipv4(wtap *wth, wtap_block_t nrb)
 {
@@ -1735,6 +1756,12 @@ wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 	wtap_init_rec(wth, rec);
 	ws_buffer_clean(buf);
 
+	/*
+	 * Data handed out by the last wtap_read_ptr() is no longer in
+	 * use.
+	 */
+	file_release_ptrs(wth->fh);
+
 	*err = 0;
 	*err_info = NULL;
 	if (!wth->subtype_read(wth, rec, buf, err, err_info, offset)) {
@@ -1860,6 +1887,54 @@ wtap_read_packet_bytes(FILE_T fh, Buffer *buf, unsigned length, int *err,
 	return rv;
 }
 
+bool
+wtap_read_packet_bytes_ptr(wtap *wth, FILE_T fh, Buffer *buf, unsigned length,
+    const uint8_t **data, int *err, char **err_info)
+{
+	const uint8_t *ptr;
+
+	if (wth->read_ptr && ws_buffer_length(buf) == 0 &&
+	    (ptr = file_read_ptr(fh, length)) != NULL) {
+		wth->packet_data = ptr;
+		*data = ptr;
+		return true;
+	}
+	if (!wtap_read_packet_bytes(fh, buf, length, err, err_info))
+		return false;
+	*data = ws_buffer_start_ptr(buf);
+	return true;
+}
+
+bool
+wtap_read_ptr(wtap *wth, wtap_rec *rec, Buffer *buf, const uint8_t **data,
+    int *err, char **err_info, int64_t *offset)
+{
+	bool ret;
+
+	wth->read_ptr = true;
+	wth->packet_data = NULL;
+	ret = wtap_read(wth, rec, buf, err, err_info, offset);
+	wth->read_ptr = false;
+	if (ret)
+		*data = wth->packet_data != NULL ? wth->packet_data : ws_buffer_start_ptr(buf);
+	return ret;
+}
+
+bool
+wtap_seek_read_ptr(wtap *wth, int64_t seek_off, wtap_rec *rec, Buffer *buf,
+    const uint8_t **data, int *err, char **err_info)
+{
+	bool ret;
+
+	wth->read_ptr = true;
+	wth->packet_data = NULL;
+	ret = wtap_seek_read(wth, seek_off, rec, buf, err, err_info);
+	wth->read_ptr = false;
+	if (ret)
+		*data = wth->packet_data != NULL ? wth->packet_data : ws_buffer_start_ptr(buf);
+	return ret;
+}
+
 /*
  * Return an approximation of the amount of data we've read sequentially
  * from the file so far.  (int64_t, in case that's 64 bits.)
@@ -1923,6 +1998,13 @@ wtap_seek_read(wtap *wth, int64_t seek_off, wtap_rec *rec, Buffer *buf,
 	wtap_init_rec(wth, rec);
 	ws_buffer_clean(buf);
 
+	/*
+	 * Data handed out by the last wtap_seek_read_ptr() is no longer
+	 * in use.
+	 */
+	if (wth->random_fh != NULL)
+		file_release_ptrs(wth->random_fh);
+
 	*err = 0;
 	*err_info = NULL;
 	if (!wth->subtype_seek_read(wth, seek_off, rec, buf, err, err_info)) {
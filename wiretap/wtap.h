@@ -1872,6 +1872,18 @@ struct wtap* wtap_open_offline(const char *filename, unsigned int type, int *err
 WS_DLL_PUBLIC
 void wtap_cleareof(wtap *wth);
 
+/**
+ * Go back to an earlier offset in the file being read sequentially.
+ *
+ * This is for tailing a file that's still being written: if wtap_read()
+ * fails with WTAP_ERR_SHORT_READ because the rest of the last record
+ * hasn't been written yet, going back to the offset it returned, which
+ * for pcap and pcapng files is the start of that record, lets a later
+ * wtap_read() read all of it.
+ */
+WS_DLL_PUBLIC
+bool wtap_sequential_seek(wtap *wth, int64_t offset, int *err);
+
 /**
  * Set callback functions to add new hostnames. Currently pcapng-only.
  * MUST match add_ipv4_name and add_ipv6_name in addr_resolv.c.
@@ -1931,6 +1943,30 @@ WS_DLL_PUBLIC
 bool wtap_seek_read(wtap *wth, int64_t seek_off, wtap_rec *rec,
     Buffer *buf, int *err, char **err_info);
 
+/** Like wtap_read(), but the record's data might not be copied into *buf.
+ *
+ * For file types that support it, if the file isn't compressed, the data
+ * is left where it is in the file's memory mapping; otherwise it's read
+ * into *buf as usual. Either way, *data is set to point to it. The data
+ * must not be modified, and is only valid until the next read, seek or
+ * close on wth, so a caller that needs to modify or keep it should use
+ * wtap_read() instead, or copy it.
+ *
+ * @param data set to point to the record's data, if the read succeeded.
+ * The other parameters are as for wtap_read().
+ * @return true on success, false on failure.
+ */
+WS_DLL_PUBLIC
+bool wtap_read_ptr(wtap *wth, wtap_rec *rec, Buffer *buf,
+    const uint8_t **data, int *err, char **err_info, int64_t *offset);
+
+/** Like wtap_seek_read(), but the record's data might not be copied into
+ * *buf; see wtap_read_ptr().
+ */
+WS_DLL_PUBLIC
+bool wtap_seek_read_ptr(wtap *wth, int64_t seek_off, wtap_rec *rec,
+    Buffer *buf, const uint8_t **data, int *err, char **err_info);
+
 /*** initialize a wtap_rec structure ***/
 WS_DLL_PUBLIC
 void wtap_rec_init(wtap_rec *rec);
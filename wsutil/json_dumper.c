@@ -127,24 +127,47 @@ json_puts_string(const json_dumper *dumper, const char *str, bool dot_to_undersc
         "u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
     };
 
+    /*
+     * Most strings need no escaping at all, so write the characters
+     * between the ones that do in one go rather than one at a time.
+     */
+    const char *run = str;
+
     jd_putc(dumper, '"');
     for (int i = 0; str[i]; i++) {
-        if ((unsigned)str[i] < 0x20) {
+        unsigned char c = (unsigned char)str[i];
+
+        if (c >= 0x20 && c != '\\' && c != '"' && c != '/' && c != '.') {
+            continue;
+        }
+        if (c == '/' && (i == 0 || str[i - 1] != '<')) {
+            continue;
+        }
+        if (c == '.' && !dot_to_underscore) {
+            continue;
+        }
+
+        if (run < &str[i]) {
+            jd_puts_len(dumper, run, &str[i] - run);
+        }
+        run = &str[i + 1];
+
+        if (c < 0x20) {
             jd_putc(dumper, '\\');
-            jd_puts(dumper, json_cntrl[(unsigned)str[i]]);
-        } else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
+            jd_puts(dumper, json_cntrl[c]);
+        } else if (c == '/') {
             // Convert </script> to <\/script> to avoid breaking web pages.
             jd_puts(dumper, "\\/");
+        } else if (c == '.') {
+            jd_putc(dumper, '_');
         } else {
-            if (str[i] == '\\' || str[i] == '"') {
-                jd_putc(dumper, '\\');
-            }
-            if (dot_to_underscore && str[i] == '.')
-                jd_putc(dumper, '_');
-            else
-                jd_putc(dumper, str[i]);
+            jd_putc(dumper, '\\');
+            jd_putc(dumper, c);
         }
     }
+    if (*run != '\0') {
+        jd_puts(dumper, run);
+    }
     jd_putc(dumper, '"');
 }
 
@@ -17,8 +17,34 @@
 struct _ws_regex {
     pcre2_code *code;
     char *pattern;
+    bool jit;           /* true if the pattern was compiled to machine code */
 };
 
+/*
+ * We only ever look at the offsets of the whole match, so a match data
+ * block with one pair of offsets does for any pattern. Rather than
+ * creating one for every match, each thread keeps one around.
+ */
+static void
+match_data_free(void *match_data)
+{
+    pcre2_match_data_free((pcre2_match_data *)match_data);
+}
+
+static GPrivate match_data_cache = G_PRIVATE_INIT(match_data_free);
+
+static pcre2_match_data *
+get_match_data(void)
+{
+    pcre2_match_data *match_data = g_private_get(&match_data_cache);
+
+    if (match_data == NULL) {
+        match_data = pcre2_match_data_create(1, NULL);
+        g_private_set(&match_data_cache, match_data);
+    }
+    return match_data;
+}
+
 #define ERROR_MAXLEN_IN_CODE_UNITS   128
 
 static char *
@@ -92,6 +118,16 @@ ws_regex_compile_ex(const char *patt, ssize_t size, char **errmsg, unsigned flag
     ws_regex_t *re = g_new(ws_regex_t, 1);
     re->code = code;
     re->pattern = ws_escape_string_len(NULL, patt, size, false);
+
+    /*
+     * A pattern is usually matched against many subjects (every field
+     * value of every packet, say), so it's worth compiling it to machine
+     * code. pcre2_match() uses that if it's there, and interprets the
+     * pattern if it isn't, e.g. if PCRE2 was built without JIT support or
+     * the system doesn't allow executable memory to be allocated.
+     */
+    re->jit = !(flags & WS_REGEX_NO_JIT) &&
+                pcre2_jit_compile(code, PCRE2_JIT_COMPLETE) == 0;
     return re;
 }
 
@@ -123,6 +159,22 @@ match_pcre2(pcre2_code *code, const char *subject, ssize_t subj_length,
                     match_data,
                     NULL);
 
+    /*
+     * The machine code runs on a stack of its own, 32 KiB by default,
+     * which a pattern that backtracks a lot can exhaust on a long
+     * subject. The interpreter keeps its backtracking frames on the heap,
+     * with a much higher limit, so let it try before giving up.
+     */
+    if (rc == PCRE2_ERROR_JIT_STACKLIMIT) {
+        rc = pcre2_match(code,
+                        subject,
+                        length,
+                        (PCRE2_SIZE)subj_offset,
+                        PCRE2_NO_JIT,
+                        match_data,
+                        NULL);
+    }
+
     if (rc < 0) {
         /* No match */
         if (rc != PCRE2_ERROR_NOMATCH) {
@@ -151,18 +203,12 @@ bool
 ws_regex_matches_length(const ws_regex_t *re,
                         const char *subj, ssize_t subj_length)
 {
-    bool matched;
-    pcre2_match_data *match_data;
-
     ws_return_val_if(!re, false);
     ws_return_val_if(!subj, false);
 
     /* We don't use the matched substring but pcre2_match requires
      * at least one pair of offsets. */
-    match_data = pcre2_match_data_create(1, NULL);
-    matched = match_pcre2(re->code, subj, subj_length, 0, match_data);
-    pcre2_match_data_free(match_data);
-    return matched;
+    return match_pcre2(re->code, subj, subj_length, 0, get_match_data());
 }
 
 
@@ -177,14 +223,13 @@ ws_regex_matches_pos(const ws_regex_t *re,
     ws_return_val_if(!re, false);
     ws_return_val_if(!subj, false);
 
-    match_data = pcre2_match_data_create(1, NULL);
+    match_data = get_match_data();
     matched = match_pcre2(re->code, subj, subj_length, subj_offset, match_data);
     if (matched && pos_vect) {
         PCRE2_SIZE *ovect = pcre2_get_ovector_pointer(match_data);
         pos_vect[0] = ovect[0];
         pos_vect[1] = ovect[1];
     }
-    pcre2_match_data_free(match_data);
     return matched;
 }
 
@@ -203,3 +248,10 @@ ws_regex_pattern(const ws_regex_t *re)
 {
     return re->pattern;
 }
+
+
+bool
+ws_regex_is_jit(const ws_regex_t *re)
+{
+    return re->jit;
+}
@@ -27,6 +27,9 @@ ws_regex_compile(const char *patt, char **errmsg);
  * turned on using a pattern option. */
 #define WS_REGEX_NEVER_UTF      (1U << 1)
 #define WS_REGEX_ANCHORED       (1U << 2)
+/* Patterns are compiled to machine code, where PCRE2 supports it, unless
+ * this is set. */
+#define WS_REGEX_NO_JIT         (1U << 3)
 
 WS_DLL_PUBLIC ws_regex_t *
 ws_regex_compile_ex(const char *patt, ssize_t size, char **errmsg, unsigned flags);
@@ -62,6 +65,10 @@ ws_regex_free(ws_regex_t *re);
 WS_DLL_PUBLIC const char *
 ws_regex_pattern(const ws_regex_t *re);
 
+/** Returns true if the pattern was compiled to machine code. */
+WS_DLL_PUBLIC bool
+ws_regex_is_jit(const ws_regex_t *re);
+
 #ifdef __cplusplus
 }
 #endif
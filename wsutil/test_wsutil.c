@@ -663,6 +663,39 @@ void test_nstime_from_iso8601(void)
     g_assert_cmpint(result.nsecs, ==, expect.nsecs);
 }
 
+#include "regex.h"
+
+static void test_regex_jit(void)
+{
+    ws_regex_t *jit, *interp;
+    char *errmsg = NULL;
+    char *subj;
+    size_t len = 200000;
+
+    jit = ws_regex_compile_ex("(a|b)*c", -1, &errmsg, 0);
+    g_assert_nonnull(jit);
+    interp = ws_regex_compile_ex("(a|b)*c", -1, &errmsg, WS_REGEX_NO_JIT);
+    g_assert_nonnull(interp);
+    g_assert_false(ws_regex_is_jit(interp));
+
+    g_assert_true(ws_regex_matches(jit, "abbac"));
+    g_assert_false(ws_regex_matches(jit, "abba"));
+    g_assert_true(ws_regex_matches(interp, "abbac"));
+    g_assert_false(ws_regex_matches(interp, "abba"));
+
+    /* Backtracks deeply enough to run out of the default JIT stack. */
+    subj = g_malloc(len + 2);
+    memset(subj, 'a', len);
+    subj[len] = 'c';
+    subj[len + 1] = '\0';
+    g_assert_true(ws_regex_matches(jit, subj));
+    g_assert_true(ws_regex_matches(interp, subj));
+    g_free(subj);
+
+    ws_regex_free(jit);
+    ws_regex_free(interp);
+}
+
 #include "ws_getopt.h"
 
 #define ARGV_MAX 31
@@ -881,6 +914,8 @@ int main(int argc, char **argv)
 
     g_test_add_func("/nstime/from_iso8601", test_nstime_from_iso8601);
 
+    g_test_add_func("/regex/jit", test_regex_jit);
+
     g_test_add_func("/ws_getopt/basic1", test_getopt_long_basic1);
     g_test_add_func("/ws_getopt/basic2", test_getopt_long_basic2);
     g_test_add_func("/ws_getopt/optional1", test_getopt_optional_argument1);
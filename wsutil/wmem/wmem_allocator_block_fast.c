@@ -41,6 +41,12 @@
  * also a nice power of two, of course. */
 #define WMEM_BLOCK_SIZE (2 * 1024 * 1024)
 
+/* Blocks released by free_all are kept for the next packet rather than
+ * handed back to the OS, up to this many (i.e. 16MB). A packet scope pool
+ * that needed several blocks for one packet will likely need them again
+ * for the next one. */
+#define WMEM_MAX_SPARE_BLOCKS 8
+
 /* The header for an entire OS-level 'block' of memory */
 typedef struct _wmem_block_fast_hdr {
     struct _wmem_block_fast_hdr *next;
@@ -62,17 +68,26 @@ typedef struct _wmem_block_fast_jumbo {
 
 typedef struct {
     wmem_block_fast_hdr_t   *block_list;
+    wmem_block_fast_hdr_t   *spare_list;
+    unsigned                 spare_count;
     wmem_block_fast_jumbo_t *jumbo_list;
 } wmem_block_fast_allocator_t;
 
-/* Creates a new block, and initializes it. */
+/* Creates a new block, or reuses a spare one, and initializes it. */
 static inline void
 wmem_block_fast_new_block(wmem_block_fast_allocator_t *allocator)
 {
     wmem_block_fast_hdr_t *block;
 
-    /* allocate/initialize the new block and add it to the block list */
-    block = (wmem_block_fast_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    /* get/initialize the new block and add it to the block list */
+    block = allocator->spare_list;
+    if (block) {
+        allocator->spare_list = block->next;
+        allocator->spare_count--;
+    }
+    else {
+        block = (wmem_block_fast_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    }
 
     block->pos  = WMEM_BLOCK_HEADER_SIZE;
     block->next = allocator->block_list;
@@ -180,8 +195,9 @@ wmem_block_fast_free_all(void *private_data)
     wmem_block_fast_hdr_t       *cur, *nxt;
     wmem_block_fast_jumbo_t     *cur_jum, *nxt_jum;
 
-    /* iterate through the blocks, freeing all but the first and reinitializing
-     * that one */
+    /* iterate through the blocks, keeping all but the first as spares (or
+     * freeing them if there are enough of those) and reinitializing the first
+     * one */
     cur = allocator->block_list;
 
     if (cur) {
@@ -193,7 +209,14 @@ wmem_block_fast_free_all(void *private_data)
 
     while (cur) {
         nxt  = cur->next;
-        wmem_free(NULL, cur);
+        if (allocator->spare_count < WMEM_MAX_SPARE_BLOCKS) {
+            cur->next = allocator->spare_list;
+            allocator->spare_list = cur;
+            allocator->spare_count++;
+        }
+        else {
+            wmem_free(NULL, cur);
+        }
         cur = nxt;
     }
 
@@ -208,9 +231,20 @@ wmem_block_fast_free_all(void *private_data)
 }
 
 static void
-wmem_block_fast_gc(void *private_data _U_)
+wmem_block_fast_gc(void *private_data)
 {
-    /* No-op */
+    wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
+    wmem_block_fast_hdr_t       *cur, *nxt;
+
+    /* Return the spare blocks to the OS */
+    cur = allocator->spare_list;
+    while (cur) {
+        nxt = cur->next;
+        wmem_free(NULL, cur);
+        cur = nxt;
+    }
+    allocator->spare_list = NULL;
+    allocator->spare_count = 0;
 }
 
 static void
@@ -221,6 +255,7 @@ wmem_block_fast_allocator_cleanup(void *private_data)
     /* wmem guarantees that free_all() is called directly before this, so
      * simply free the first block */
     wmem_free(NULL, allocator->block_list);
+    wmem_block_fast_gc(private_data);
 
     /* then just free the allocator structs */
     wmem_free(NULL, private_data);
@@ -243,8 +278,10 @@ wmem_block_fast_allocator_init(wmem_allocator_t *allocator)
 
     allocator->private_data = (void*) block_allocator;
 
-    block_allocator->block_list = NULL;
-    block_allocator->jumbo_list = NULL;
+    block_allocator->block_list  = NULL;
+    block_allocator->spare_list  = NULL;
+    block_allocator->spare_count = 0;
+    block_allocator->jumbo_list  = NULL;
 }
 
 /*
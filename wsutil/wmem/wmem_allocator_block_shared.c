@@ -0,0 +1,487 @@
+/* wmem_allocator_block_shared.c
+ * Wireshark Memory Manager Thread-Safe Block Allocator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_allocator.h"
+#include "wmem_allocator_block_shared.h"
+
+/* This is the fast block allocator (see wmem_allocator_block_fast.c) made
+ * safe to use from several threads at once. Each thread that allocates from
+ * the pool gets an arena of its own, in which it allocates without locking;
+ * the lock is only taken to find a thread's arena the first time, to get a
+ * new block for it, and for jumbo allocations. As with the fast block
+ * allocator, free is a no-op.
+ *
+ * wmem_free_all(), wmem_gc() and wmem_destroy_allocator() must not be
+ * called while other threads are using the pool.
+ *
+ * When a thread exits, its arenas are given up: blocks with nothing in them
+ * go back to the pool's spares straight away, and the rest, whose memory
+ * can still be in use until the pool is freed, at the next free_all.
+ */
+
+#define WMEM_ALIGN_AMOUNT (2 * sizeof (size_t))
+#define WMEM_ALIGN_SIZE(SIZE) ((~(WMEM_ALIGN_AMOUNT-1)) & \
+        ((SIZE) + (WMEM_ALIGN_AMOUNT-1)))
+
+#define WMEM_CHUNK_TO_DATA(CHUNK) ((void*)((uint8_t*)(CHUNK) + WMEM_CHUNK_HEADER_SIZE))
+#define WMEM_DATA_TO_CHUNK(DATA) ((wmem_block_shared_chunk_t*)((uint8_t*)(DATA) - WMEM_CHUNK_HEADER_SIZE))
+
+#define WMEM_BLOCK_MAX_ALLOC_SIZE (WMEM_BLOCK_SIZE - (WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE))
+
+/* The same block size as the fast block allocator. */
+#define WMEM_BLOCK_SIZE (2 * 1024 * 1024)
+
+/* Blocks freed by free_all are kept for reuse, up to this many. */
+#define WMEM_MAX_SPARE_BLOCKS 16
+
+/* The number of pools whose arena each thread remembers. */
+#define WMEM_THREAD_CACHE_SIZE 4
+
+typedef struct _wmem_block_shared_hdr {
+    struct _wmem_block_shared_hdr *next;
+
+    int32_t pos;
+} wmem_block_shared_hdr_t;
+#define WMEM_BLOCK_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_shared_hdr_t))
+
+typedef struct {
+    uint32_t len;
+} wmem_block_shared_chunk_t;
+#define WMEM_CHUNK_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_shared_chunk_t))
+
+#define JUMBO_MAGIC 0xFFFFFFFF
+typedef struct _wmem_block_shared_jumbo {
+    struct _wmem_block_shared_jumbo *prev, *next;
+} wmem_block_shared_jumbo_t;
+#define WMEM_JUMBO_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_shared_jumbo_t))
+
+struct _wmem_block_shared_allocator;
+
+/* The blocks one thread allocates from. */
+typedef struct _wmem_block_shared_arena {
+    struct _wmem_block_shared_arena *next;
+    GThread                 *owner;     /* NULL once the thread has exited */
+    struct _wmem_block_shared_allocator *allocator; /* NULL once the pool is destroyed */
+    wmem_block_shared_hdr_t *block_list;
+} wmem_block_shared_arena_t;
+
+typedef struct _wmem_block_shared_allocator {
+    GMutex                     lock;
+    unsigned                   id;
+    wmem_block_shared_arena_t *arenas;
+    wmem_block_shared_hdr_t   *spare_list;
+    unsigned                   spare_count;
+    wmem_block_shared_jumbo_t *jumbo_list;
+} wmem_block_shared_allocator_t;
+
+/* Each thread remembers its arena in the pools it used last. Pools are
+ * identified by a number that is never reused, so an entry for a pool
+ * that has been destroyed never matches. */
+typedef struct {
+    unsigned                   id;
+    wmem_block_shared_arena_t *arena;
+} wmem_block_shared_cache_t;
+
+static WS_THREAD_LOCAL wmem_block_shared_cache_t thread_cache[WMEM_THREAD_CACHE_SIZE];
+
+static volatile int last_allocator_id;
+
+/* Whichever of a thread and a pool goes last frees the arena the thread
+ * had in the pool; this lock is held while either goes. */
+static GMutex arena_lock;
+
+static void wmem_block_shared_thread_exit(void *data);
+
+/* The arenas of the calling thread, in all pools. */
+static GPrivate thread_arenas = G_PRIVATE_INIT(wmem_block_shared_thread_exit);
+
+/* Gives the blocks of an arena to the pool's spares, or frees them if
+ * there are enough of those. The pool's lock must be held, or the pool
+ * not be in use. */
+static void
+wmem_block_shared_spare_blocks(wmem_block_shared_allocator_t *allocator,
+        wmem_block_shared_hdr_t *cur)
+{
+    wmem_block_shared_hdr_t *nxt;
+
+    while (cur) {
+        nxt = cur->next;
+        if (allocator->spare_count < WMEM_MAX_SPARE_BLOCKS) {
+            cur->next = allocator->spare_list;
+            allocator->spare_list = cur;
+            allocator->spare_count++;
+        }
+        else {
+            wmem_free(NULL, cur);
+        }
+        cur = nxt;
+    }
+}
+
+/* Unlinks an arena from its pool and frees it. The pool's lock must be
+ * held, or the pool not be in use. */
+static void
+wmem_block_shared_free_arena(wmem_block_shared_allocator_t *allocator,
+        wmem_block_shared_arena_t *arena)
+{
+    wmem_block_shared_arena_t **link;
+
+    for (link = &allocator->arenas; *link != arena; link = &(*link)->next)
+        ;
+    *link = arena->next;
+    wmem_free(NULL, arena);
+}
+
+/* Gives up the arenas of a thread that is exiting. */
+static void
+wmem_block_shared_thread_exit(void *data)
+{
+    GSList                        *arenas = (GSList *)data;
+    GSList                        *item;
+    wmem_block_shared_arena_t     *arena;
+    wmem_block_shared_allocator_t *allocator;
+
+    g_mutex_lock(&arena_lock);
+    for (item = arenas; item; item = item->next) {
+        arena = (wmem_block_shared_arena_t *)item->data;
+        allocator = arena->allocator;
+        if (!allocator) {
+            /* The pool has gone, and freed the blocks. */
+            wmem_free(NULL, arena);
+            continue;
+        }
+
+        g_mutex_lock(&allocator->lock);
+        if (!arena->block_list ||
+                (!arena->block_list->next &&
+                 arena->block_list->pos == WMEM_BLOCK_HEADER_SIZE)) {
+            /* Nothing allocated since the last free_all. */
+            wmem_block_shared_spare_blocks(allocator, arena->block_list);
+            wmem_block_shared_free_arena(allocator, arena);
+        }
+        else {
+            /* Left for free_all. */
+            arena->owner = NULL;
+        }
+        g_mutex_unlock(&allocator->lock);
+    }
+    g_mutex_unlock(&arena_lock);
+
+    g_slist_free(arenas);
+}
+
+/* Finds or creates the arena of the calling thread. */
+static wmem_block_shared_arena_t *
+wmem_block_shared_get_arena(wmem_block_shared_allocator_t *allocator)
+{
+    wmem_block_shared_cache_t *cache = &thread_cache[allocator->id % WMEM_THREAD_CACHE_SIZE];
+    wmem_block_shared_arena_t *arena;
+    GThread                   *self;
+
+    if (cache->id == allocator->id) {
+        return cache->arena;
+    }
+
+    self = g_thread_self();
+
+    g_mutex_lock(&allocator->lock);
+    for (arena = allocator->arenas; arena; arena = arena->next) {
+        if (arena->owner == self) {
+            break;
+        }
+    }
+    if (!arena) {
+        arena = wmem_new(NULL, wmem_block_shared_arena_t);
+        arena->owner = self;
+        arena->allocator = allocator;
+        arena->block_list = NULL;
+        arena->next = allocator->arenas;
+        allocator->arenas = arena;
+        g_private_set(&thread_arenas,
+                g_slist_prepend((GSList *)g_private_get(&thread_arenas), arena));
+    }
+    g_mutex_unlock(&allocator->lock);
+
+    cache->id = allocator->id;
+    cache->arena = arena;
+
+    return arena;
+}
+
+/* Gives an arena a new block, a spare one if possible. */
+static void
+wmem_block_shared_new_block(wmem_block_shared_allocator_t *allocator,
+        wmem_block_shared_arena_t *arena)
+{
+    wmem_block_shared_hdr_t *block;
+
+    g_mutex_lock(&allocator->lock);
+    block = allocator->spare_list;
+    if (block) {
+        allocator->spare_list = block->next;
+        allocator->spare_count--;
+    }
+    g_mutex_unlock(&allocator->lock);
+
+    if (!block) {
+        block = (wmem_block_shared_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    }
+
+    block->pos  = WMEM_BLOCK_HEADER_SIZE;
+    block->next = arena->block_list;
+
+    arena->block_list = block;
+}
+
+/* API */
+
+static void *
+wmem_block_shared_alloc(void *private_data, const size_t size)
+{
+    wmem_block_shared_allocator_t *allocator = (wmem_block_shared_allocator_t*) private_data;
+    wmem_block_shared_arena_t     *arena;
+    wmem_block_shared_chunk_t     *chunk;
+    int32_t real_size;
+
+    if (size > WMEM_BLOCK_MAX_ALLOC_SIZE) {
+        wmem_block_shared_jumbo_t *block;
+
+        /* allocate/initialize a new block of the necessary size */
+        block = (wmem_block_shared_jumbo_t *)wmem_alloc(NULL,
+                size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+
+        g_mutex_lock(&allocator->lock);
+        block->next = allocator->jumbo_list;
+        if (block->next) {
+            block->next->prev = block;
+        }
+        block->prev = NULL;
+        allocator->jumbo_list = block;
+        g_mutex_unlock(&allocator->lock);
+
+        chunk = ((wmem_block_shared_chunk_t*)((uint8_t*)(block) + WMEM_JUMBO_HEADER_SIZE));
+        chunk->len = JUMBO_MAGIC;
+
+        return WMEM_CHUNK_TO_DATA(chunk);
+    }
+
+    arena = wmem_block_shared_get_arena(allocator);
+
+    real_size = (int32_t)(WMEM_ALIGN_SIZE(size) + WMEM_CHUNK_HEADER_SIZE);
+
+    /* Get a new block if necessary. */
+    if (!arena->block_list ||
+            (WMEM_BLOCK_SIZE - arena->block_list->pos) < real_size) {
+        wmem_block_shared_new_block(allocator, arena);
+    }
+
+    chunk = (wmem_block_shared_chunk_t *) ((uint8_t *) arena->block_list + arena->block_list->pos);
+    /* safe to cast, size smaller than WMEM_BLOCK_MAX_ALLOC_SIZE */
+    chunk->len = (uint32_t) size;
+
+    arena->block_list->pos += real_size;
+
+    /* and return the user's pointer */
+    return WMEM_CHUNK_TO_DATA(chunk);
+}
+
+static void
+wmem_block_shared_free(void *private_data _U_, void *ptr _U_)
+{
+   /* free is NOP */
+}
+
+static void *
+wmem_block_shared_realloc(void *private_data, void *ptr, const size_t size)
+{
+    wmem_block_shared_allocator_t *allocator = (wmem_block_shared_allocator_t*) private_data;
+    wmem_block_shared_chunk_t *chunk;
+
+    chunk = WMEM_DATA_TO_CHUNK(ptr);
+
+    if (chunk->len == JUMBO_MAGIC) {
+        wmem_block_shared_jumbo_t *block;
+
+        block = ((wmem_block_shared_jumbo_t*)((uint8_t*)(chunk) - WMEM_JUMBO_HEADER_SIZE));
+
+        /* The neighbours of the block in the list can be reallocated by
+         * other threads too. */
+        g_mutex_lock(&allocator->lock);
+        block =  (wmem_block_shared_jumbo_t*)wmem_realloc(NULL, block,
+                size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+        if (block->prev) {
+            block->prev->next = block;
+        }
+        else {
+            allocator->jumbo_list = block;
+        }
+        if (block->next) {
+            block->next->prev = block;
+        }
+        g_mutex_unlock(&allocator->lock);
+        return ((void*)((uint8_t*)(block) + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE));
+    }
+    else if (chunk->len < size) {
+        /* grow */
+        void *newptr;
+
+        /* need to alloc and copy; free is no-op, so don't call it */
+        newptr = wmem_block_shared_alloc(private_data, size);
+        memcpy(newptr, ptr, chunk->len);
+
+        return newptr;
+    }
+
+    /* shrink or same space - great we can do nothing */
+    return ptr;
+}
+
+static void
+wmem_block_shared_free_all(void *private_data)
+{
+    wmem_block_shared_allocator_t *allocator = (wmem_block_shared_allocator_t*) private_data;
+    wmem_block_shared_arena_t     *arena, *next;
+    wmem_block_shared_hdr_t       *cur, *nxt;
+    wmem_block_shared_jumbo_t     *cur_jum, *nxt_jum;
+
+    /* Each arena keeps its first block; the others are kept as spares
+     * for any arena, or freed if there are enough of those. The arenas
+     * of threads that have exited give up all of theirs. Those threads
+     * can be exiting now, so this needs the lock. */
+    g_mutex_lock(&allocator->lock);
+    for (arena = allocator->arenas; arena; arena = next) {
+        next = arena->next;
+        cur = arena->block_list;
+
+        if (!arena->owner) {
+            wmem_block_shared_spare_blocks(allocator, cur);
+            wmem_block_shared_free_arena(allocator, arena);
+            continue;
+        }
+
+        if (cur) {
+            cur->pos = WMEM_BLOCK_HEADER_SIZE;
+            nxt = cur->next;
+            cur->next = NULL;
+            cur = nxt;
+        }
+
+        wmem_block_shared_spare_blocks(allocator, cur);
+    }
+    g_mutex_unlock(&allocator->lock);
+
+    /* now do the jumbo blocks, freeing all of them */
+    cur_jum = allocator->jumbo_list;
+    while (cur_jum) {
+        nxt_jum  = cur_jum->next;
+        wmem_free(NULL, cur_jum);
+        cur_jum = nxt_jum;
+    }
+    allocator->jumbo_list = NULL;
+}
+
+static void
+wmem_block_shared_gc(void *private_data)
+{
+    wmem_block_shared_allocator_t *allocator = (wmem_block_shared_allocator_t*) private_data;
+    wmem_block_shared_hdr_t       *cur, *nxt;
+
+    /* Return the spare blocks to the OS */
+    cur = allocator->spare_list;
+    while (cur) {
+        nxt = cur->next;
+        wmem_free(NULL, cur);
+        cur = nxt;
+    }
+    allocator->spare_list = NULL;
+    allocator->spare_count = 0;
+}
+
+static void
+wmem_block_shared_allocator_cleanup(void *private_data)
+{
+    wmem_block_shared_allocator_t *allocator = (wmem_block_shared_allocator_t*) private_data;
+    wmem_block_shared_arena_t     *arena, *next;
+    GThread                       *self;
+
+    /* wmem guarantees that free_all() is called directly before this, so
+     * each arena has at most its first block left, and belongs to a thread
+     * that is still running. Another thread frees its arena when it exits. */
+    self = g_thread_self();
+    g_mutex_lock(&arena_lock);
+    for (arena = allocator->arenas; arena; arena = next) {
+        next = arena->next;
+        wmem_free(NULL, arena->block_list);
+        if (arena->owner == self) {
+            g_private_set(&thread_arenas,
+                    g_slist_remove((GSList *)g_private_get(&thread_arenas), arena));
+            wmem_free(NULL, arena);
+        }
+        else {
+            arena->block_list = NULL;
+            arena->allocator = NULL;
+        }
+    }
+    g_mutex_unlock(&arena_lock);
+    wmem_block_shared_gc(private_data);
+
+    g_mutex_clear(&allocator->lock);
+
+    /* then just free the allocator structs */
+    wmem_free(NULL, private_data);
+}
+
+void
+wmem_block_shared_allocator_init(wmem_allocator_t *allocator)
+{
+    wmem_block_shared_allocator_t *block_allocator;
+
+    block_allocator = wmem_new(NULL, wmem_block_shared_allocator_t);
+
+    allocator->walloc   = &wmem_block_shared_alloc;
+    allocator->wrealloc = &wmem_block_shared_realloc;
+    allocator->wfree    = &wmem_block_shared_free;
+
+    allocator->free_all = &wmem_block_shared_free_all;
+    allocator->gc       = &wmem_block_shared_gc;
+    allocator->cleanup  = &wmem_block_shared_allocator_cleanup;
+
+    allocator->private_data = (void*) block_allocator;
+
+    g_mutex_init(&block_allocator->lock);
+    /* Never 0, which is the id of an unused thread cache entry */
+    do {
+        block_allocator->id = (unsigned)g_atomic_int_add(&last_allocator_id, 1) + 1;
+    } while (block_allocator->id == 0);
+    block_allocator->arenas      = NULL;
+    block_allocator->spare_list  = NULL;
+    block_allocator->spare_count = 0;
+    block_allocator->jumbo_list  = NULL;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
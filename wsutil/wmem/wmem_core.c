@@ -21,6 +21,7 @@
 #include "wmem_allocator_simple.h"
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_block_fast.h"
+#include "wmem_allocator_block_shared.h"
 #include "wmem_allocator_strict.h"
 
 /* Set according to the WIRESHARK_DEBUG_WMEM_OVERRIDE environment variable in
@@ -153,6 +154,9 @@ wmem_allocator_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_BLOCK_FAST:
             wmem_block_fast_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_BLOCK_SHARED:
+            wmem_block_shared_allocator_init(allocator);
+            break;
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
@@ -183,15 +187,19 @@ wmem_init(void)
         if (strncmp(override_env, "simple", strlen("simple")) == 0) {
             override_type = WMEM_ALLOCATOR_SIMPLE;
         }
+        /* "block" is a prefix of the others, so it must come last */
+        else if (strncmp(override_env, "block_fast", strlen("block_fast")) == 0) {
+            override_type = WMEM_ALLOCATOR_BLOCK_FAST;
+        }
+        else if (strncmp(override_env, "block_shared", strlen("block_shared")) == 0) {
+            override_type = WMEM_ALLOCATOR_BLOCK_SHARED;
+        }
         else if (strncmp(override_env, "block", strlen("block")) == 0) {
             override_type = WMEM_ALLOCATOR_BLOCK;
         }
         else if (strncmp(override_env, "strict", strlen("strict")) == 0) {
             override_type = WMEM_ALLOCATOR_STRICT;
         }
-        else if (strncmp(override_env, "block_fast", strlen("block_fast")) == 0) {
-            override_type = WMEM_ALLOCATOR_BLOCK_FAST;
-        }
         else {
             g_warning("Unrecognized wmem override");
             do_override = false;
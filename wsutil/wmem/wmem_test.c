@@ -19,6 +19,7 @@
 #include "wmem_allocator.h"
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_block_fast.h"
+#include "wmem_allocator_block_shared.h"
 #include "wmem_allocator_simple.h"
 #include "wmem_allocator_strict.h"
 
@@ -54,6 +55,9 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_BLOCK_FAST:
             wmem_block_fast_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_BLOCK_SHARED:
+            wmem_block_shared_allocator_init(allocator);
+            break;
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
@@ -353,6 +357,72 @@ wmem_test_allocator_block_fast(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_BLOCK, NULL);
 }
 
+static void
+wmem_test_allocator_block_shared(void)
+{
+    wmem_test_allocator(WMEM_ALLOCATOR_BLOCK_SHARED, NULL,
+            MAX_SIMULTANEOUS_ALLOCS*4);
+    wmem_test_allocator_jumbo(WMEM_ALLOCATOR_BLOCK_SHARED, NULL);
+}
+
+#define SHARED_THREADS      8
+#define SHARED_THREAD_ITERS 20000
+
+static void *
+wmem_test_allocator_shared_thread(void *data)
+{
+    wmem_allocator_t *allocator = (wmem_allocator_t *)data;
+    uint8_t          *ptrs[64];
+    size_t            sizes[64];
+    uint8_t           tag;
+    int               i, j;
+    size_t            k;
+
+    /* Each thread fills its allocations with its own pattern, so that
+     * chunks handed out to more than one thread get noticed. */
+    tag = (uint8_t)g_random_int();
+    for (i = 0; i < SHARED_THREAD_ITERS; i++) {
+        j = i % G_N_ELEMENTS(ptrs);
+        if (i >= (int)G_N_ELEMENTS(ptrs)) {
+            for (k = 0; k < sizes[j]; k++) {
+                g_assert_cmpuint(ptrs[j][k], ==, (uint8_t)(tag + j));
+            }
+        }
+        sizes[j] = g_random_int_range(1, 512);
+        if (i % 10000 == 0) {
+            /* jumbo allocations are shared between all the threads */
+            sizes[j] += 3*1024*1024;
+        }
+        ptrs[j] = (uint8_t *)wmem_alloc(allocator, sizes[j]);
+        memset(ptrs[j], (uint8_t)(tag + j), sizes[j]);
+    }
+
+    return NULL;
+}
+
+static void
+wmem_test_allocator_block_shared_threads(void)
+{
+    wmem_allocator_t *allocator;
+    GThread          *threads[SHARED_THREADS];
+    int               i, round;
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_BLOCK_SHARED);
+
+    /* The blocks left over by the first round are reused in the second */
+    for (round = 0; round < 2; round++) {
+        for (i = 0; i < SHARED_THREADS; i++) {
+            threads[i] = g_thread_new("wmem_test", wmem_test_allocator_shared_thread, allocator);
+        }
+        for (i = 0; i < SHARED_THREADS; i++) {
+            g_thread_join(threads[i]);
+        }
+        wmem_free_all(allocator);
+    }
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_simple(void)
 {
@@ -628,6 +698,118 @@ wmem_test_stringperf(void)
     g_free(str_ptr);
 }
 
+/* Allocation patterns like those of dissecting packets in several threads:
+ * lots of small allocations that are all freed together at the end of the
+ * packet. They are done from a pool for each thread (as the packet scope),
+ * from one pool shared by all threads (as the file scope) and with
+ * g_malloc/g_free. */
+#define PERF_ROUNDS             10
+#define PERF_PACKETS            1000
+#define PERF_ALLOCS_PER_PACKET  32
+
+typedef struct {
+    wmem_allocator_type_t  type;
+    wmem_allocator_t      *shared;
+} wmem_test_allocperf_t;
+
+static void *
+wmem_test_allocperf_thread(void *data)
+{
+    wmem_test_allocperf_t *perf = (wmem_test_allocperf_t *)data;
+    wmem_allocator_t      *allocator = perf->shared;
+    void                  *ptrs[PERF_ALLOCS_PER_PACKET];
+    uint32_t               seed = GPOINTER_TO_UINT(g_thread_self());
+    int                    i, j;
+
+    if (!allocator && perf->type != WMEM_ALLOCATOR_SIMPLE) {
+        allocator = wmem_allocator_force_new(perf->type);
+    }
+
+    for (i = 0; i < PERF_PACKETS; i++) {
+        for (j = 0; j < PERF_ALLOCS_PER_PACKET; j++) {
+            /* sizes between 8 and 263 bytes, without taking glib's
+             * global random number lock */
+            seed = seed * 1103515245 + 12345;
+            ptrs[j] = wmem_alloc(allocator, 8 + ((seed >> 16) & 0xff));
+            memset(ptrs[j], 0, 8);
+        }
+        if (!allocator) {
+            for (j = 0; j < PERF_ALLOCS_PER_PACKET; j++) {
+                g_free(ptrs[j]);
+            }
+        }
+        else if (!perf->shared) {
+            wmem_free_all(allocator);
+        }
+    }
+
+    if (allocator && !perf->shared) {
+        wmem_destroy_allocator(allocator);
+    }
+
+    return NULL;
+}
+
+static double
+wmem_test_allocperf_run(wmem_allocator_type_t type, bool shared, int num_threads)
+{
+    wmem_test_allocperf_t  perf;
+    GThread              **threads = g_new(GThread *, num_threads);
+    int64_t                start;
+    int                    round, i;
+
+    perf.type   = type;
+    perf.shared = shared ? wmem_allocator_force_new(type) : NULL;
+
+    start = g_get_monotonic_time();
+    for (round = 0; round < PERF_ROUNDS; round++) {
+        for (i = 0; i < num_threads; i++) {
+            threads[i] = g_thread_new("wmem_perf", wmem_test_allocperf_thread, &perf);
+        }
+        for (i = 0; i < num_threads; i++) {
+            g_thread_join(threads[i]);
+        }
+        if (perf.shared) {
+            wmem_free_all(perf.shared);
+        }
+    }
+
+    if (perf.shared) {
+        wmem_destroy_allocator(perf.shared);
+    }
+    g_free(threads);
+
+    return (g_get_monotonic_time() - start) / 1000.0;
+}
+
+/* NOTE: You have to run "wmem_test -m perf" to run the performance tests. */
+static void
+wmem_test_allocperf(void)
+{
+    static const int thread_counts[] = { 1, 8, 32 };
+    double           elapsed_ms;
+    unsigned         i;
+
+    for (i = 0; i < G_N_ELEMENTS(thread_counts); i++) {
+        /* WMEM_ALLOCATOR_SIMPLE here means the NULL allocator */
+        elapsed_ms = wmem_test_allocperf_run(WMEM_ALLOCATOR_SIMPLE, false, thread_counts[i]);
+        g_test_minimized_result(elapsed_ms,
+            "%d threads, g_malloc/g_free: %.3f ms", thread_counts[i], elapsed_ms);
+
+        elapsed_ms = wmem_test_allocperf_run(WMEM_ALLOCATOR_BLOCK_FAST, false, thread_counts[i]);
+        g_test_minimized_result(elapsed_ms,
+            "%d threads, block_fast pool per thread: %.3f ms", thread_counts[i], elapsed_ms);
+
+        elapsed_ms = wmem_test_allocperf_run(WMEM_ALLOCATOR_BLOCK, false, thread_counts[i]);
+        g_test_minimized_result(elapsed_ms,
+            "%d threads, block pool per thread: %.3f ms", thread_counts[i], elapsed_ms);
+
+        elapsed_ms = wmem_test_allocperf_run(WMEM_ALLOCATOR_BLOCK_SHARED, true, thread_counts[i]);
+        g_test_minimized_result(elapsed_ms,
+            "%d threads, shared block_shared pool: %.3f ms", thread_counts[i], elapsed_ms);
+    }
+}
+
 /* DATA STRUCTURE TESTING FUNCTIONS (/wmem/datastruct/) */
 
 static void
@@ -1454,6 +1636,8 @@ main(int argc, char **argv)
 
     g_test_add_func("/wmem/allocator/block",     wmem_test_allocator_block);
     g_test_add_func("/wmem/allocator/blk_fast",  wmem_test_allocator_block_fast);
+    g_test_add_func("/wmem/allocator/blk_shared", wmem_test_allocator_block_shared);
+    g_test_add_func("/wmem/allocator/blk_shared/threads", wmem_test_allocator_block_shared_threads);
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
@@ -1463,6 +1647,7 @@ main(int argc, char **argv)
 
     if (g_test_perf()) {
         g_test_add_func("/wmem/utils/stringperf", wmem_test_stringperf);
+        g_test_add_func("/wmem/allocator/perf", wmem_test_allocperf);
     }
 
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);